@@ -0,0 +1,58 @@
+#pragma once
+#ifndef SYNTHETIC_OBJ_H_INCLUDED
+#define SYNTHETIC_OBJ_H_INCLUDED
+
+#include <fstream>
+#include <random>
+#include <string>
+
+// large OBJ files for the loader benchmarks, generated instead of checked in
+namespace SyntheticObj
+{
+    // a grid of quads with positions, texcoords and normals, written to the working
+    // directory once per size
+    inline std::string write(size_t triangles)
+    {
+        std::string path = "synthetic_" + std::to_string(triangles) + ".obj";
+        if (std::ifstream(path).good())
+        {
+            return path;
+        }
+
+        size_t side = 1;
+        while (side * side * 2 < triangles)
+        {
+            side++;
+        }
+        std::mt19937 rng(42);
+        std::uniform_real_distribution<float> height(-0.01f, 0.01f);
+        std::ofstream file(path);
+        file << "o grid\n";
+        for (size_t y = 0; y <= side; y++)
+        {
+            for (size_t x = 0; x <= side; x++)
+            {
+                file << "v " << x * 0.01f << ' ' << height(rng) << ' ' << y * 0.01f << '\n';
+                file << "vt " << (float) x / side << ' ' << (float) y / side << '\n';
+            }
+        }
+        file << "vn 0 1 0\n";
+        for (size_t y = 0; y < side; y++)
+        {
+            for (size_t x = 0; x < side; x++)
+            {
+                size_t corner = y * (side + 1) + x + 1;
+                size_t corners[4] = {corner, corner + 1, corner + side + 2, corner + side + 1};
+                file << 'f';
+                for (size_t c : corners)
+                {
+                    file << ' ' << c << '/' << c << "/1";
+                }
+                file << '\n';
+            }
+        }
+        return path;
+    }
+}
+
+#endif // SYNTHETIC_OBJ_H_INCLUDED
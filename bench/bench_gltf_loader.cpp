@@ -0,0 +1,123 @@
+#include <benchmark/benchmark.h>
+
+#include <fstream>
+#include <sstream>
+
+#include "GltfLoader.h"
+#include "ObjParser.h"
+#include "SyntheticObj.h"
+
+namespace
+{
+    const std::string RESOURCE_DIR = MY_GAMES_RESOURCE_DIR;
+
+    std::string objFile(benchmark::State &state)
+    {
+        switch (state.range(0))
+        {
+        case 0:
+            return RESOURCE_DIR + "sphere.obj";
+        case 1:
+            return RESOURCE_DIR + "chameleon_leg/Chameleon_leg.obj";
+        default:
+            return SyntheticObj::write(state.range(0));
+        }
+    }
+
+    // the same geometry as a GLB in the working directory: every shape as
+    // interleaved Vertex data with 32-bit indices, one node per shape
+    std::string glbFile(benchmark::State &state)
+    {
+        std::string path = "bench_gltf_loader_" + std::to_string(state.range(0)) + ".glb";
+        ObjModel obj;
+        if (std::ifstream(path).good() || !ObjParser::load(objFile(state), obj))
+        {
+            return path;
+        }
+
+        std::string bin;
+        std::ostringstream views, accessors, meshes, nodes;
+        for (size_t i = 0; i < obj.shapes.size(); i++)
+        {
+            const ObjShape &shape = obj.shapes[i];
+            size_t vertexOffset = bin.size();
+            bin.append((const char *) shape.vertices.data(), shape.vertices.size() * sizeof(Vertex));
+            size_t indexOffset = bin.size();
+            bin.append((const char *) shape.indices.data(), shape.indices.size() * sizeof(uint32_t));
+
+            glm::vec3 min(std::numeric_limits<float>::max()), max(-std::numeric_limits<float>::max());
+            for (const Vertex &vertex : shape.vertices)
+            {
+                min = glm::min(min, vertex.Position);
+                max = glm::max(max, vertex.Position);
+            }
+            const char *separator = i ? "," : "";
+            size_t view = i * 2, accessor = i * 4;
+            views << separator << "{\"buffer\": 0, \"byteOffset\": " << vertexOffset << ", \"byteLength\": " << indexOffset - vertexOffset
+                  << ", \"byteStride\": " << sizeof(Vertex) << "},"
+                  << "{\"buffer\": 0, \"byteOffset\": " << indexOffset << ", \"byteLength\": " << bin.size() - indexOffset << "}";
+            accessors << separator
+                      << "{\"bufferView\": " << view << ", \"componentType\": 5126, \"count\": " << shape.vertices.size() << ", \"type\": \"VEC3\","
+                      << " \"min\": [" << min.x << "," << min.y << "," << min.z << "], \"max\": [" << max.x << "," << max.y << "," << max.z << "]},"
+                      << "{\"bufferView\": " << view << ", \"byteOffset\": 12, \"componentType\": 5126, \"count\": " << shape.vertices.size() << ", \"type\": \"VEC3\"},"
+                      << "{\"bufferView\": " << view << ", \"byteOffset\": 24, \"componentType\": 5126, \"count\": " << shape.vertices.size() << ", \"type\": \"VEC2\"},"
+                      << "{\"bufferView\": " << view + 1 << ", \"componentType\": 5125, \"count\": " << shape.indices.size() << ", \"type\": \"SCALAR\"}";
+            meshes << separator << "{\"primitives\": [{\"attributes\": {\"POSITION\": " << accessor << ", \"NORMAL\": " << accessor + 1
+                   << ", \"TEXCOORD_0\": " << accessor + 2 << "}, \"indices\": " << accessor + 3 << "}]}";
+            nodes << separator << "{\"mesh\": " << i << "}";
+        }
+        std::string json = "{\"asset\": {\"version\": \"2.0\"}, \"buffers\": [{\"byteLength\": " + std::to_string(bin.size()) + "}],"
+                           "\"bufferViews\": [" + views.str() + "], \"accessors\": [" + accessors.str() + "],"
+                           "\"meshes\": [" + meshes.str() + "], \"nodes\": [" + nodes.str() + "]}";
+        json.resize((json.size() + 3) & ~(size_t) 3, ' ');
+        bin.resize((bin.size() + 3) & ~(size_t) 3, '\0');
+
+        std::ofstream file(path, std::ios::binary);
+        const uint32_t header[5] = {0x46546C67, 2, (uint32_t) (28 + json.size() + bin.size()), (uint32_t) json.size(), 0x4E4F534A};
+        const uint32_t binHeader[2] = {(uint32_t) bin.size(), 0x004E4942};
+        file.write((const char *) header, sizeof(header));
+        file << json;
+        file.write((const char *) binHeader, sizeof(binHeader));
+        file << bin;
+        return path;
+    }
+
+    void fileArgs(benchmark::internal::Benchmark *benchmark)
+    {
+        // 0 and 1 are the resource files, anything else a synthetic grid with that many triangles
+        benchmark->Arg(0)->Arg(1)->Arg(1 << 20)->Unit(benchmark::kMillisecond);
+    }
+}
+
+// both produce what Model uploads, the GL calls themselves are not measured
+static void BM_LoadModelObj(benchmark::State &state)
+{
+    std::string path = objFile(state);
+    for (auto _ : state)
+    {
+        ObjModel model;
+        if (!ObjParser::load(path, model))
+        {
+            state.SkipWithError("could not load the file");
+            break;
+        }
+        benchmark::DoNotOptimize(model.shapes.data());
+    }
+}
+BENCHMARK(BM_LoadModelObj)->Apply(fileArgs);
+
+static void BM_LoadModelGlb(benchmark::State &state)
+{
+    std::string path = glbFile(state);
+    for (auto _ : state)
+    {
+        GltfModel model;
+        if (!GltfLoader::load(path, model))
+        {
+            state.SkipWithError("could not load the file");
+            break;
+        }
+        benchmark::DoNotOptimize(model.primitives.data());
+    }
+}
+BENCHMARK(BM_LoadModelGlb)->Apply(fileArgs);
@@ -0,0 +1,97 @@
+#include <benchmark/benchmark.h>
+
+#include "ObjParser.h"
+#include "SyntheticObj.h"
+
+namespace
+{
+    const std::string RESOURCE_DIR = MY_GAMES_RESOURCE_DIR;
+
+    // what Model::loadModel did before ObjParser: tinyobj, then one Vertex per face corner
+    size_t loadWithTinyobj(const std::string &path)
+    {
+        tinyobj::ObjReader reader;
+        if (!reader.ParseFromFile(path, tinyobj::ObjReaderConfig()))
+        {
+            return 0;
+        }
+        const tinyobj::attrib_t &attribs = reader.GetAttrib();
+        size_t vertexCount = 0;
+        for (const tinyobj::shape_t &shape : reader.GetShapes())
+        {
+            std::vector<Vertex> vertices;
+            vertices.reserve(shape.mesh.indices.size());
+            for (const tinyobj::index_t &index : shape.mesh.indices)
+            {
+                Vertex vertex = {};
+                vertex.Position = glm::vec3(attribs.vertices[3 * index.vertex_index + 0],
+                                            attribs.vertices[3 * index.vertex_index + 1],
+                                            attribs.vertices[3 * index.vertex_index + 2]);
+                if (index.normal_index >= 0)
+                {
+                    vertex.Normal = glm::vec3(attribs.normals[3 * index.normal_index + 0],
+                                              attribs.normals[3 * index.normal_index + 1],
+                                              attribs.normals[3 * index.normal_index + 2]);
+                }
+                if (index.texcoord_index >= 0)
+                {
+                    vertex.TexCoord = glm::vec2(attribs.texcoords[2 * index.texcoord_index + 0],
+                                                attribs.texcoords[2 * index.texcoord_index + 1]);
+                }
+                vertices.push_back(vertex);
+            }
+            vertexCount += vertices.size();
+            benchmark::DoNotOptimize(vertices.data());
+        }
+        return vertexCount;
+    }
+
+    std::string benchmarkFile(benchmark::State &state)
+    {
+        switch (state.range(0))
+        {
+        case 0:
+            return RESOURCE_DIR + "sphere.obj";
+        case 1:
+            return RESOURCE_DIR + "chameleon_leg/Chameleon_leg.obj";
+        default:
+            return SyntheticObj::write(state.range(0));
+        }
+    }
+
+    void fileArgs(benchmark::internal::Benchmark *benchmark)
+    {
+        // 0 and 1 are the resource files, anything else a synthetic grid with that many triangles
+        benchmark->Arg(0)->Arg(1)->Arg(1 << 20)->Unit(benchmark::kMillisecond);
+    }
+}
+
+static void BM_LoadObjTinyobj(benchmark::State &state)
+{
+    std::string path = benchmarkFile(state);
+    for (auto _ : state)
+    {
+        if (loadWithTinyobj(path) == 0)
+        {
+            state.SkipWithError("could not load the file");
+            break;
+        }
+    }
+}
+BENCHMARK(BM_LoadObjTinyobj)->Apply(fileArgs);
+
+static void BM_LoadObjParser(benchmark::State &state)
+{
+    std::string path = benchmarkFile(state);
+    for (auto _ : state)
+    {
+        ObjModel model;
+        if (!ObjParser::load(path, model))
+        {
+            state.SkipWithError("could not load the file");
+            break;
+        }
+        benchmark::DoNotOptimize(model.shapes.data());
+    }
+}
+BENCHMARK(BM_LoadObjParser)->Apply(fileArgs);
@@ -0,0 +1,94 @@
+#include <benchmark/benchmark.h>
+
+#include <random>
+#include <stack>
+#include <vector>
+
+#include "SceneGraph.h"
+#include "glm/gtc/matrix_transform.hpp"
+
+namespace
+{
+    // a forest of small trees, four children per node, like characters made of parts
+    SceneGraph makeGraph(size_t count)
+    {
+        std::mt19937 rng(42);
+        std::uniform_real_distribution<float> value(0.5f, 2.0f);
+        SceneGraph graph;
+        for (size_t i = 0; i < count; i++)
+        {
+            // trees of 64 nodes, node j of a tree hangs under node (j - 1) / 4
+            size_t tree = i / 64 * 64;
+            size_t j = i - tree;
+            SceneGraph::NodeId parent = j == 0 ? SceneGraph::NONE : (SceneGraph::NodeId) (tree + (j - 1) / 4);
+            graph.addNode(parent, glm::vec3(value(rng), value(rng), value(rng)),
+                          glm::angleAxis(value(rng), glm::normalize(glm::vec3(value(rng), value(rng), value(rng)))),
+                          glm::vec3(value(rng)));
+        }
+        graph.update();
+        return graph;
+    }
+}
+
+// rebuilding every world matrix from chained translate/rotate/scale calls, as the
+// walk animation used to do, one matrix stack walk per node
+static void BM_ChainedTransforms(benchmark::State &state)
+{
+    SceneGraph graph = makeGraph(state.range(0));
+    std::vector<glm::mat4> worlds(graph.size());
+    for (auto _ : state)
+    {
+        for (size_t i = 0; i < graph.size(); i++)
+        {
+            std::stack<SceneGraph::NodeId> path;
+            for (SceneGraph::NodeId node = (SceneGraph::NodeId) i; node != SceneGraph::NONE; node = graph.getParent(node))
+            {
+                path.push(node);
+            }
+            glm::mat4 world(1.0f);
+            for (; !path.empty(); path.pop())
+            {
+                SceneGraph::NodeId node = path.top();
+                world = glm::translate(world, graph.getTranslation(node));
+                world = world * glm::mat4_cast(graph.getRotation(node));
+                world = glm::scale(world, graph.getScale(node));
+            }
+            worlds[i] = world;
+        }
+        benchmark::DoNotOptimize(worlds.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * graph.size());
+}
+BENCHMARK(BM_ChainedTransforms)->Arg(1024)->Arg(16384);
+
+static void BM_SceneGraphFullUpdate(benchmark::State &state)
+{
+    SceneGraph graph = makeGraph(state.range(0));
+    for (auto _ : state)
+    {
+        for (size_t i = 0; i < graph.size(); i += 64)
+        {
+            graph.setScale((SceneGraph::NodeId) i, glm::vec3(1.0f));
+        }
+        benchmark::DoNotOptimize(graph.update());
+    }
+    state.SetItemsProcessed(state.iterations() * graph.size());
+}
+BENCHMARK(BM_SceneGraphFullUpdate)->Arg(1024)->Arg(16384);
+
+// one subtree in 16 moves per frame
+static void BM_SceneGraphPartialUpdate(benchmark::State &state)
+{
+    SceneGraph graph = makeGraph(state.range(0));
+    for (auto _ : state)
+    {
+        for (size_t i = 0; i < graph.size(); i += 64 * 16)
+        {
+            graph.setScale((SceneGraph::NodeId) i, glm::vec3(1.0f));
+        }
+        benchmark::DoNotOptimize(graph.update());
+    }
+    state.SetItemsProcessed(state.iterations() * graph.size());
+}
+BENCHMARK(BM_SceneGraphPartialUpdate)->Arg(1024)->Arg(16384);
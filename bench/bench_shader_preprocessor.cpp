@@ -0,0 +1,21 @@
+#include <benchmark/benchmark.h>
+
+#include "ShaderPreprocessor.h"
+
+namespace
+{
+    const std::string SHADER_DIR = MY_GAMES_SHADER_DIR;
+}
+
+// cost of preprocessing a shader with includes, paid on every (re)load
+static void BM_PreprocessFragmentShader(benchmark::State &state)
+{
+    ShaderPreprocessor::Defines defines = {{"NR_MAX_POINT_LIGHTS", "4 * 4"}, {"NR_MAX_SPOT_LIGHTS", "4"}};
+    for (auto _ : state)
+    {
+        ShaderPreprocessor preprocessor;
+        PreprocessedShader shader = preprocessor.process(SHADER_DIR + "simpleFragment.fs", defines);
+        benchmark::DoNotOptimize(shader.source.data());
+    }
+}
+BENCHMARK(BM_PreprocessFragmentShader);
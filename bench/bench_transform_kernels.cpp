@@ -0,0 +1,163 @@
+#include <benchmark/benchmark.h>
+
+#include <random>
+#include <vector>
+
+#include "TransformKernels.h"
+#include "glm/gtc/matrix_transform.hpp"
+
+namespace
+{
+    std::vector<glm::mat4> makeTransforms(size_t count)
+    {
+        std::mt19937 rng(42);
+        std::uniform_real_distribution<float> value(0.5f, 2.0f);
+        std::vector<glm::mat4> transforms(count);
+        for (glm::mat4 &transform : transforms)
+        {
+            transform = glm::translate(glm::mat4(1.0f), glm::vec3(value(rng), value(rng), value(rng)));
+            transform = glm::rotate(transform, value(rng), glm::normalize(glm::vec3(value(rng), value(rng), value(rng))));
+            transform = glm::scale(transform, glm::vec3(value(rng)));
+        }
+        return transforms;
+    }
+}
+
+// what the vertex shader used to do per vertex, done once per instance on the CPU
+static void BM_NormalMatricesGlm(benchmark::State &state)
+{
+    std::vector<glm::mat4> models = makeTransforms(state.range(0));
+    std::vector<glm::mat3> normals(models.size());
+    for (auto _ : state)
+    {
+        for (size_t i = 0; i < models.size(); i++)
+        {
+            normals[i] = glm::transpose(glm::inverse(glm::mat3(models[i])));
+        }
+        benchmark::DoNotOptimize(normals.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * models.size());
+}
+BENCHMARK(BM_NormalMatricesGlm)->Arg(64)->Arg(1024)->Arg(16384);
+
+static void BM_NormalMatrices(benchmark::State &state)
+{
+    std::vector<glm::mat4> models = makeTransforms(state.range(0));
+    std::vector<glm::mat3> normals(models.size());
+    for (auto _ : state)
+    {
+        TransformKernels::normalMatrices(models.data(), normals.data(), models.size());
+        benchmark::DoNotOptimize(normals.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * models.size());
+}
+BENCHMARK(BM_NormalMatrices)->Arg(64)->Arg(1024)->Arg(16384);
+
+namespace
+{
+    // runs the kernel benchmarks once per supported instruction set, range(1) is the Isa
+    void applyIsas(benchmark::internal::Benchmark *benchmark)
+    {
+        for (TransformKernels::Isa isa : {TransformKernels::Isa::SCALAR, TransformKernels::Isa::SSE, TransformKernels::Isa::AVX2})
+        {
+            if (!TransformKernels::isSupported(isa))
+            {
+                continue;
+            }
+            for (int count : {64, 1024, 16384})
+            {
+                benchmark->Args({count, (int) isa});
+            }
+        }
+        benchmark->ArgNames({"count", "isa"});
+    }
+
+    struct TRSArrays
+    {
+        std::vector<glm::vec3> translations;
+        std::vector<glm::quat> rotations;
+        std::vector<glm::vec3> scales;
+
+        explicit TRSArrays(size_t count)
+        {
+            std::mt19937 rng(42);
+            std::uniform_real_distribution<float> value(0.5f, 2.0f);
+            for (size_t i = 0; i < count; i++)
+            {
+                translations.push_back(glm::vec3(value(rng), value(rng), value(rng)));
+                rotations.push_back(glm::angleAxis(value(rng), glm::normalize(glm::vec3(value(rng), value(rng), value(rng)))));
+                scales.push_back(glm::vec3(value(rng), value(rng), value(rng)));
+            }
+        }
+    };
+}
+
+static void BM_MultiplyGlm(benchmark::State &state)
+{
+    std::vector<glm::mat4> a = makeTransforms(state.range(0));
+    std::vector<glm::mat4> b = makeTransforms(state.range(0));
+    std::vector<glm::mat4> out(a.size());
+    for (auto _ : state)
+    {
+        for (size_t i = 0; i < a.size(); i++)
+        {
+            out[i] = a[i] * b[i];
+        }
+        benchmark::DoNotOptimize(out.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * a.size());
+}
+BENCHMARK(BM_MultiplyGlm)->Arg(64)->Arg(1024)->Arg(16384);
+
+static void BM_Multiply(benchmark::State &state)
+{
+    TransformKernels::setIsa((TransformKernels::Isa) state.range(1));
+    std::vector<glm::mat4> a = makeTransforms(state.range(0));
+    std::vector<glm::mat4> b = makeTransforms(state.range(0));
+    std::vector<glm::mat4> out(a.size());
+    for (auto _ : state)
+    {
+        TransformKernels::multiply(a.data(), b.data(), out.data(), a.size());
+        benchmark::DoNotOptimize(out.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * a.size());
+    state.SetLabel(TransformKernels::getIsaName(TransformKernels::getIsa()));
+}
+BENCHMARK(BM_Multiply)->Apply(applyIsas);
+
+static void BM_ComposeGlm(benchmark::State &state)
+{
+    TRSArrays trs(state.range(0));
+    std::vector<glm::mat4> out(trs.translations.size());
+    for (auto _ : state)
+    {
+        for (size_t i = 0; i < out.size(); i++)
+        {
+            out[i] = glm::scale(glm::translate(glm::mat4(1.0f), trs.translations[i]) * glm::mat4_cast(trs.rotations[i]), trs.scales[i]);
+        }
+        benchmark::DoNotOptimize(out.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * out.size());
+}
+BENCHMARK(BM_ComposeGlm)->Arg(64)->Arg(1024)->Arg(16384);
+
+static void BM_ComposeTRS(benchmark::State &state)
+{
+    TransformKernels::setIsa((TransformKernels::Isa) state.range(1));
+    TRSArrays trs(state.range(0));
+    std::vector<glm::mat4> out(trs.translations.size());
+    for (auto _ : state)
+    {
+        TransformKernels::composeTRS(trs.translations.data(), trs.rotations.data(), trs.scales.data(), out.data(), out.size());
+        benchmark::DoNotOptimize(out.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * out.size());
+    state.SetLabel(TransformKernels::getIsaName(TransformKernels::getIsa()));
+}
+BENCHMARK(BM_ComposeTRS)->Apply(applyIsas);
@@ -4,6 +4,7 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
+#include <chrono>
 #include <iostream>
 #include <memory>
 
@@ -12,13 +13,19 @@
 #include "Program.h"
 #include "GLSL.h"
 
-#include "MatrixStack.h" 
+#include "SceneGraph.h"
 #include "Camera.h"
+#include "ShaderWatcher.h"
+#include "Benchmark.h"
+#include "Simulation.h"
+#include "RenderThread.h"
+#include "StreamBuffer.h"
+#include "ModelRegistry.h"
 
 // value_ptr for glm
 const std::string PROJECT_NAME = "my_game";
-#include "D:/my_games/lib/glm/gtc/type_ptr.hpp"
-#include "D:/my_games/lib/glm/gtc/matrix_transform.hpp"
+#include "glm/gtc/type_ptr.hpp"
+#include "glm/gtc/matrix_transform.hpp"
 
 // settings
 const unsigned int SCR_WIDTH = 800;
@@ -28,6 +35,20 @@ const unsigned int SCR_HEIGHT = 600;
 
 
 
+// How models are loaded and drawn, independent of the window they are drawn to
+struct RenderSettings
+{
+    // with packVertices the default shader is built with PACKED_VERTICES and its OBJ
+    // models are packed, the other options apply to every model
+    ModelImportOptions modelImport;
+    // OBJ models get levels of detail, drawn at the coarsest one whose error stays
+    // below this many pixels on screen. 0 always draws the full meshes.
+    float lodPixelError = 0.0f;
+    // OBJ models are split into meshlets, instanced draws skip the ones outside the
+    // frustum or facing away from the camera (needs GL 4.3 for indirect draws)
+    bool meshletCulling = false;
+};
+
 struct DirLight
 {
     glm::vec3 direction;
@@ -58,31 +79,96 @@ struct SpotLight
     bool isOn;
 };
 
+// Everything render() needs from the game state, captured once per frame so the
+// frame can be drawn on the render thread while the next one is simulated
+struct FrameData
+{
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::vec3 viewPos;
+    int width;
+    int height;
+    // when the input this frame is based on was polled
+    std::chrono::steady_clock::time_point inputTime;
+    // copies of the game state the frame draws, with a render thread the game
+    // already changes the originals for the next frame
+    DirLight directionalLight;
+    std::vector<PointLight> pointLights;
+    std::vector<SpotLight> spotLights;
+    // the models of each program that has any
+    std::vector<std::pair<Program *, std::vector<ModelSnapshot>>> models;
+};
+
 class Application : public EventCallbacks
 {
     private:
         WindowManager * windowManager = nullptr;
 
         std::map<std::string, Program> shaders;
+        // recompiles programs whose sources change on disk
+        ShaderWatcher shaderWatcher;
 
         const std::string &resourceDir;
         const std::string &shaderDir;
 
         Camera camera;
 
+        // fixed step simulation, camera is moved to the interpolated simulation state every frame
+        SimulationSettings simulationSettings;
+        FixedTimestep timestep;
+        SimulationState previousState;
+        SimulationState currentState;
+        SimulationThread simulationThread;
+        std::function<void(float)> simulationCallback;
+        // copy of camera the simulation steps read their input from
+        std::mutex inputMutex;
+        Camera simulationCamera;
+
+        // GL work runs on renderThread while run() is active, see setRenderThreaded
+        bool renderThreaded = false;
+        RenderThread renderThread;
+
+        // size of the window or, when headless, of the offscreen framebuffer
+        int width;
+        int height;
+
+        // when the events were polled last
+        std::chrono::steady_clock::time_point inputTime;
+
         // frame time values
         float deltaTime = 0.0f;
         float lastFrame = 0.0f;
 
         // cursor position values (initialize to center of screen)
-        float lastX = SCR_WIDTH / 2.0f;
-        float lastY = SCR_HEIGHT / 2.0f;
+        float lastX;
+        float lastY;
         bool firstMouse = true;
 
+        // camera recording for benchmark scenes, empty file name when not recording
+        std::string recordFile;
+        CameraPath recordedPath;
+        float recordStart = 0.0f;
+        float nextRecordTime = 0.0f;
+
         unsigned int planeVAO, planeVBO;
         unsigned int quadVAO, quadVBO;
         unsigned int skyBoxVAO, skyBoxVBO;
         unsigned int fbo, rbo;  // frame buffer and render buffer objects
+        // size fbo's attachments were allocated with
+        int framebufferWidth = 0;
+        int framebufferHeight = 0;
+        // see WindowSettings::reversedZ, clipZeroToOne is false if glClipControl is missing
+        bool reversedZ;
+        bool clipZeroToOne = false;
+        // see RenderSettings::lodPixelError
+        float lodPixelError;
+        // see RenderSettings::meshletCulling
+        bool meshletCulling;
+        // see RenderSettings::modelImport, addModel sets packVertices per shader
+        ModelImportOptions modelImport;
+
+        // per frame data (instance matrices) is suballocated from here
+        StreamBuffer frameStream;
 
         // textures
         std::vector<glm::vec3> textures;
@@ -114,26 +200,57 @@ class Application : public EventCallbacks
         void resizeCallback(GLFWwindow *window, int width, int height);
         void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 
-        void initializeShader(const std::string &shaderName, bool verbose, const std::string &vertexShader, const std::string &fragmentShader, const std::vector<std::string> &attributes);
+        void initializeShader(const std::string &shaderName, bool verbose, const std::string &vertexShader, const std::string &fragmentShader, const std::vector<std::string> &attributes, const std::vector<std::string> &defines = {});
         void initGeom();
+        void resizeFramebuffer(int width, int height);
         void init();
         
         void initSky();
         void initGround();
         void updateVars();
-        void render();
+        void startSimulation();
+        void simulate(float frameTime);
+        void stepSimulation(SimulationState &state, double step);
+        // per frame GL state that is not a draw: shader reloads and light uniforms
+        void updateScene(const FrameData &frame);
+        void recordCamera();
+        void reloadShaders();
+        void pollInput();
+        void runThreaded(std::function<void()> loop);
+        FrameData captureFrame();
+        void render(const FrameData &frame);
         void drawSky(glm::mat4 view, glm::mat4 projection);
         void drawGround(std::shared_ptr<Program> &curS);
-        void drawScene(glm::mat4 view, glm::mat4 projection);
-        void setLightUniforms(Program &prog);
+        void drawScene(const FrameData &frame, glm::mat4 view, glm::mat4 projection);
+        void setLightUniforms(Program &prog, const FrameData &frame);
 
     public:
-        Application(const std::string &shaderDirectory, const std::string &resourceDirectory);
+        Application(const std::string &shaderDirectory, const std::string &resourceDirectory,
+                    const WindowSettings &settings = WindowSettings(), const RenderSettings &render = RenderSettings());
         void run(std::function<void()> init, std::function<void()> loop);
+        void requestClose();
+        // configures the fixed step simulation, takes effect with the next run()
+        void setSimulationSettings(const SimulationSettings &settings);
+        // called once per simulation step with the step length. With a threaded
+        // simulation this runs on the simulation thread.
+        void setSimulationCallback(std::function<void(float)> callback);
+        // moves all GL work of run() to a render thread, takes effect with the next run().
+        // The loop function then runs on the game thread and must not call GL directly,
+        // it can use enqueueRenderCommand instead.
+        void setRenderThreaded(bool threaded);
+        // runs command on the thread that owns the GL context, right away when not threaded
+        void enqueueRenderCommand(std::function<void()> command);
+        FramePacingStats getFramePacing();
+        // renders the benchmark's frames at its fixed time step, returns false if closed early
+        bool runBenchmark(Benchmark &benchmark);
+        // samples the camera a few times per second and writes it as benchmark keys on shutdown
+        void recordCameraPath(const std::string &fileName);
         void shutdown();
         void setKeyBind(int key, std::function<void(int)> func);
         void setKeyBindSet(Camera_Type type);
         void setCameraType(Camera_Type type);
+        // loads the model's GL resources, so with a render thread only before run() or
+        // from the init function, returns nullptr while the render thread runs
         Model *addModel(const std::string &modelPath, const std::string &shaderName = "default");
 };
 
@@ -0,0 +1,120 @@
+#pragma once
+#ifndef BENCHMARK_H_INCLUDED
+#define BENCHMARK_H_INCLUDED
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "Camera.h"
+#include "RenderStats.h"
+
+// One key of a camera path, angles in degrees like Camera::Yaw/Pitch
+struct CameraKey
+{
+    float time;
+    glm::vec3 position;
+    float yaw;
+    float pitch;
+};
+
+// Camera path through a list of keys, interpolated with a uniform Catmull-Rom
+// spline so the camera moves smoothly through every key
+class CameraPath
+{
+public:
+    void addKey(const CameraKey &key);
+    bool empty() const { return keys.empty(); }
+    float duration() const { return keys.empty() ? 0.0f : keys.back().time; }
+
+    CameraKey sample(float time) const;
+    void apply(Camera &camera, float time) const;
+
+    // writes the keys in the "key" format of benchmark scene files
+    bool save(const std::string &fileName) const;
+
+private:
+    std::vector<CameraKey> keys;
+};
+
+// A model to load for a benchmark with its instances
+struct BenchmarkModel
+{
+    std::string path;
+    std::string shader = "default";
+    std::vector<glm::mat4> instances;
+};
+
+// Renders a scene along a scripted camera path at a fixed time step and
+// collects per-frame timings and render counters.
+//
+// Scene files are plain text, one command per line, '#' starts a comment:
+//   frames <n>                    measured frames (default 300)
+//   warmup <n>                    frames rendered before measuring (default 30)
+//   dt <seconds>                  simulated time step (default 1/60)
+//   model <path> [shader]         model relative to the resource directory
+//   instance <x> <y> <z> [scale] [yaw]   placement of the last model
+//   key <t> <x> <y> <z> <yaw> <pitch>    camera key at time t
+class Benchmark
+{
+public:
+    Benchmark() = default;
+    ~Benchmark();
+
+    Benchmark(const Benchmark&) = delete;
+    Benchmark& operator= (const Benchmark&) = delete;
+
+    bool load(const std::string &fileName);
+
+    int getWarmupFrames() const { return warmupFrames; }
+    int getFrames() const { return frames; }
+    float getDeltaTime() const { return deltaTime; }
+    const std::vector<BenchmarkModel> &getModels() const { return models; }
+
+    // time spent loading the scene's models, reported as load_ms
+    void setLoadTime(double milliseconds) { loadTime = milliseconds; }
+
+    // moves the camera to where it is in the given frame (warmup frames stay at the start)
+    void applyCamera(Camera &camera, int frame) const;
+
+    // bracket everything a frame does before it is presented
+    void beginFrame(int frame);
+    void endFrame();
+
+    // waits for the outstanding GPU timings
+    void finish();
+
+    // writes min/mean/p95/p99 of every metric as JSON, to stdout if fileName is empty
+    bool writeReport(const std::string &fileName) const;
+
+private:
+    std::string sceneName;
+    int frames = 300;
+    int warmupFrames = 30;
+    float deltaTime = 1.0f / 60.0f;
+    double loadTime = 0.0;
+    std::vector<BenchmarkModel> models;
+    CameraPath path;
+
+    // GL_TIME_ELAPSED queries are read back a few frames later so the CPU never waits on them
+    static const int QUERY_COUNT = 4;
+    GLuint queries[QUERY_COUNT] = {0};
+    int queryFrame[QUERY_COUNT] = {0};
+    bool queryActive[QUERY_COUNT] = {false};
+    int currentQuery = 0;
+
+    bool measuring = false;
+    int currentFrame = 0;
+    std::chrono::steady_clock::time_point frameStart;
+
+    // indexed by measured frame
+    std::vector<double> cpuTimes;
+    std::vector<double> gpuTimes;
+    std::vector<RenderStats::Counters> counters;
+
+    void collectQuery(int index, bool wait);
+};
+
+#endif // BENCHMARK_H_INCLUDED
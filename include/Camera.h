@@ -2,8 +2,8 @@
 #define CAMERA_H
 
 #include <glad/glad.h>
-#include "../lib/glm/glm.hpp"
-#include "../lib/glm/gtc/matrix_transform.hpp"
+#include "glm/glm.hpp"
+#include "glm/gtc/quaternion.hpp"
 
 #define ZOOM_MIN     1.0f
 #define ZOOM_MAX     45.0f
@@ -12,8 +12,11 @@
 
 enum class Camera_Type
 {
+    // walks on the ground plane, eye at Position
     FIRST_PERSON,
+    // orbits Position at FollowDistance, Position is the followed character
     THIRD_PERSON,
+    // flies freely, eye at Position
     FREE_CAMERA
 };
 
@@ -30,158 +33,116 @@ const float PITCH           = 0.0f;
 const float SPEED           = 2.5f;
 const float SENSITIVITY     = 0.1f;
 const float ZOOM            = 45.0f;
+const float FOLLOW_DISTANCE = 4.0f;
+const float NEAR_PLANE      = 0.1f;
+const float FAR_PLANE       = 100.0f;
 
+// Planes of a view frustum as (normal, distance), normals point inwards
+struct Frustum
+{
+    enum Plane { PLANE_LEFT, PLANE_RIGHT, PLANE_BOTTOM, PLANE_TOP, PLANE_NEAR, PLANE_FAR, PLANE_COUNT };
+    glm::vec4 planes[PLANE_COUNT];
+
+    // extracts the planes from a view-projection matrix, reversedZ for Camera's
+    // reversed-Z projection (near at depth 1, no far plane)
+    static Frustum fromMatrix(const glm::mat4 &viewProjection, bool reversedZ = false);
+    // false only if the sphere is completely outside
+    bool intersectsSphere(const glm::vec3 &center, float radius) const;
+};
+
+// Camera with its orientation stored as a quaternion built from yaw and pitch.
+//
+// View, projection and view-projection matrices and the frustum are cached and
+// only recomputed when something they depend on changed, so asking for them
+// several times a frame (rendering, culling, recording) costs nothing. State
+// that feeds the caches is only reachable through setters for that reason.
 class Camera
 {
 public:
-
-    // camera options
-    Camera_Type Type;
-
-    // camera Attributes
-    glm::vec3 Position;
-    glm::vec3 Front;
-    glm::vec3 Up;
-    glm::vec3 Right;
-    glm::vec3 WorldUp;
+    // input for move() and integrate(), in camera space: x right, y up, -z forward
     glm::vec3 Motion;
-    // Euler angles
-    float Yaw;
-    float Pitch;
-    // camera options
     float MovementSpeed;
     float MouseSensitivity;
-    float Zoom;
 
-    // constructor with vectors
-    Camera(Camera_Type type, glm::vec3 position = glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3 up = glm::vec3(0.0f, 1.0f, 0.0f), float yaw = YAW, float pitch = PITCH) 
-        : Front(glm::vec3(0.0f, 0.0f, -1.0f)),
-          Motion(glm::vec3(0.0f)),
-          MovementSpeed(SPEED), 
-          MouseSensitivity(SENSITIVITY), 
-          Zoom(ZOOM)
-    {
-        Type = type;
-        Position = position;
-        WorldUp = up;
-        Yaw = yaw;
-        Pitch = pitch;
-        updateCameraVectors();
-    }
-    // constructor with scalar values
-    Camera(float posX, float posY, float posZ, float upX, float upY, float upZ, float yaw, float pitch) 
-    : Front(glm::vec3(0.0f, 0.0f, -1.0f)),
-      Motion(glm::vec3(0.0f)),
-      MovementSpeed(SPEED), 
-      MouseSensitivity(SENSITIVITY), 
-      Zoom(ZOOM)
-    {
-        Position = glm::vec3(posX, posY, posZ);
-        WorldUp = glm::vec3(upX, upY, upZ);
-        Yaw = yaw;
-        Pitch = pitch;
-        updateCameraVectors();
-    }
-
-    // returns the view matrix calculated using Euler Angles and the LookAt Matrix
-    glm::mat4 GetViewMatrix()
-    {
-        return myLookAt(Position, Position + Front, Up);
-    }
+    Camera(Camera_Type type, glm::vec3 position = glm::vec3(0.0f, 0.0f, 0.0f), float yaw = YAW, float pitch = PITCH);
 
-    // translate the camera position in the specified direction and speed
-    void translateCamera(glm::vec3 direction, float speed, float deltaTime)
-    {
-        direction = normalize(direction);
-        Position += direction * speed * deltaTime;
-    }
-
-    // translate the camera in the specified direction RELATIVE to Camera->Front
-    void moveCamera(glm::vec3 direction, float speed, float deltaTime)
-    {
-        direction = normalize(direction);
-        Position -= direction.z * Front * speed * deltaTime;
-        Position += direction.x * Right * speed * deltaTime;
-    }
-
-    void Reverse()
-    {
-        Front *= -1.0f;
-        Right *= -1.0f;
-    }
-
-    // set Position to specified value
-    void setCameraPos(glm::vec3 position)
-    {
-        Position = position;
-    }
-
-    void rotateCamera(float delta_yaw, float delta_pitch, GLboolean constrainPitch = true)
-    {
-        Yaw     += delta_yaw;
-        Pitch   += delta_pitch;
-
-        // if pitch is out of bounds, clamp it
-        if (constrainPitch)
-        {
-            if (Pitch > PITCH_MAX)
-                Pitch = PITCH_MAX;
-            if (Pitch < PITCH_MIN)
-                Pitch = PITCH_MIN;
-        }
-
-        // update Front, Right, and Up Vectors
-        updateCameraVectors();
-    }
-
-    void adjustZoom(float zoom_offset)
-    {
-        Zoom -= zoom_offset;
-        if (Zoom < ZOOM_MIN)
-            Zoom = ZOOM_MIN;
-        if (Zoom > ZOOM_MAX)
-            Zoom = ZOOM_MAX;
-    }
-
-    void addMotion(glm::vec3(direction))
-    {
-        Motion += direction * MovementSpeed;
-    }
+    Camera_Type getType() const { return Type; }
+    const glm::vec3 &getPosition() const { return Position; }
+    // where the view is rendered from, differs from Position for THIRD_PERSON
+    glm::vec3 getEyePosition() const;
+    float getYaw() const { return Yaw; }
+    float getPitch() const { return Pitch; }
+    float getZoom() const { return Zoom; }
+    float getFollowDistance() const { return FollowDistance; }
+    const glm::quat &getOrientation() const { return Orientation; }
 
+    glm::vec3 getFront() const { return Orientation * glm::vec3(0.0f, 0.0f, -1.0f); }
+    glm::vec3 getRight() const { return Orientation * glm::vec3(1.0f, 0.0f, 0.0f); }
+    glm::vec3 getUp() const { return Orientation * glm::vec3(0.0f, 1.0f, 0.0f); }
+
+    const glm::mat4 &GetViewMatrix();
+    const glm::mat4 &GetProjectionMatrix();
+    const glm::mat4 &GetViewProjectionMatrix();
+    const Frustum &GetFrustum();
+
+    void setType(Camera_Type type);
+
+    // translate the camera position in the specified direction and speed
+    void translateCamera(glm::vec3 direction, float speed, float deltaTime);
+    // translate the camera in the specified direction RELATIVE to the camera's front
+    void moveCamera(glm::vec3 direction, float speed, float deltaTime);
+    // turns the camera around, calling it again turns it back
+    void Reverse();
+
+    void setCameraPos(glm::vec3 position);
+    // set Yaw and Pitch to absolute values, in degrees
+    void setOrientation(float yaw, float pitch);
+    void rotateCamera(float delta_yaw, float delta_pitch, GLboolean constrainPitch = true);
+    void adjustZoom(float zoom_offset);
+    void adjustFollowDistance(float offset);
+    // only changes anything if the aspect ratio differs, width or height may be 0 while minimized
+    void setViewport(int width, int height);
+    void setClipPlanes(float nearPlane, float farPlane);
+    // reversed-Z projection with the far plane at infinity: depth is 1 at the near
+    // plane and goes to 0 far away, which a float depth buffer stores precisely.
+    // Meant for glClipControl(GL_LOWER_LEFT, GL_ZERO_TO_ONE) and a GL_GEQUAL depth test.
+    void setReversedZ(bool reversed);
+    bool isReversedZ() const { return ReversedZ; }
+
+    void addMotion(glm::vec3 direction);
     // moves the camera based on the values in Motion
-    void move(float deltaTime)
-    {
-        if (Motion != glm::vec3(0))
-        {
-            Position -= Motion.z * glm::normalize(glm::cross(WorldUp, Right)) * deltaTime;
-            Position += Motion.x * Right * deltaTime;
-            Position += Motion.y * WorldUp * deltaTime;
-        }
-    }
+    void move(float deltaTime);
+    // where Motion takes a camera at position after deltaTime, used by the fixed step simulation
+    glm::vec3 integrate(glm::vec3 position, float deltaTime) const;
+
 private:
-    // updates Camera's Euler Angles from Yaw and Pitch
-    void updateCameraVectors()
-    {
-        // recalculate front vector from Yaw and Pitch
-        glm::vec3 front;
-        front.x = cos(glm::radians(Yaw)) * cos(glm::radians(Pitch));
-        front.y = sin(glm::radians(Pitch));
-        front.z = sin(glm::radians(Yaw)) * cos(glm::radians(Pitch));
-        Front = glm::normalize(front);
-        // recalculate Right and Up vectors
-        Right   = glm::normalize(glm::cross(Front, WorldUp));
-        Up      = glm::normalize(glm::cross(Right, Front));
-    }
-
-    glm::mat4 myLookAt(glm::vec3 position, glm::vec3 target, glm::vec3 up)
-    {
-        glm::mat4 a = glm::mat4(glm::transpose(glm::mat3(Right, up, position - target)));
-        glm::mat4 b = glm::mat4(glm::mat3(1.0f));
-        b[3] = glm::vec4(-1.0f * position, 1.0f);
-        return a * b;
-    }
+    static const glm::vec3 WorldUp;
 
+    Camera_Type Type;
+    glm::vec3 Position;
+    // Euler angles in degrees, Orientation is derived from them
+    float Yaw;
+    float Pitch;
+    glm::quat Orientation;
+    float Zoom;
+    float FollowDistance;
+    float AspectRatio;
+    float NearPlane;
+    float FarPlane;
+    bool ReversedZ = false;
+
+    bool viewDirty = true;
+    bool projectionDirty = true;
+    bool frustumDirty = true;
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::mat4 viewProjection;
+    Frustum frustum;
+
+    void updateOrientation();
+    void markViewDirty() { viewDirty = true; frustumDirty = true; }
+    void markProjectionDirty() { projectionDirty = true; frustumDirty = true; }
 };
 
 
-#endif //CAMERA_H
\ No newline at end of file
+#endif //CAMERA_H
@@ -4,6 +4,15 @@
 
 #include <glad/glad.h>
 #include <string.h>
+#include <string>
+
+// KHR_parallel_shader_compile (same values as the ARB variant)
+#ifndef GL_MAX_SHADER_COMPILER_THREADS_KHR
+#define GL_MAX_SHADER_COMPILER_THREADS_KHR 0x91B0
+#endif
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
 
 namespace GLSL
 {
@@ -11,7 +20,18 @@ namespace GLSL
     void checkError(const char *str = 0);
     void printProgramInfoLog(GLuint program);
     void printShaderInfoLog(GLuint shader);
+    std::string getShaderInfoLog(GLuint shader);
     void checkVersion();
+    // queries the extension list and loads the entry points glad was not generated with
+    void loadExtensions(GLADloadproc load);
+    bool hasExtension(const char *name);
+    bool hasParallelShaderCompile();
+    // installs a KHR_debug message callback if the context supports it. Messages below
+    // minSeverity are filtered out, repeats of a message are only counted.
+    bool enableDebugOutput(GLADloadproc load, GLenum minSeverity = GL_DEBUG_SEVERITY_MEDIUM);
+    bool isDebugOutputEnabled();
+    void checkCall(char const * const Function, char const * const File, int const Line);
+    void setCallSite(char const * const Function, char const * const File, int const Line);
     GLint getAttribLocation(const GLuint program, const char varname[], bool verbose = true);
     GLint getUniformLocation(const GLuint program, const char varname[], bool verbose = true);
     void enableVertexAttribArray(const GLint handle);
@@ -19,9 +39,15 @@ namespace GLSL
     void vertexAttribPointer(const GLint handle, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const GLvoid *pointer);
 }
 
-#ifndef DISABLE_OPENGL_ERROR_CHECKS
-#define CHECKED_GL_CALL(x) do { GLSL::printOpenGLErrors("{{BEFORE}} "#x, __FILE__, __LINE__); (x); GLSL::printOpenGLErrors(#x, __FILE__, __LINE__); } while (0)
+// Error checks are compiled into debug builds only, FORCE_OPENGL_ERROR_CHECKS keeps
+// them in release builds and DISABLE_OPENGL_ERROR_CHECKS drops them from debug builds.
+// With debug output enabled errors arrive through the debug callback, which then
+// reports the call site instead of polling glGetError around every call.
+#if defined(FORCE_OPENGL_ERROR_CHECKS) || !(defined(NDEBUG) || defined(DISABLE_OPENGL_ERROR_CHECKS))
+#define OPENGL_ERROR_CHECKS 1
+#define CHECKED_GL_CALL(x) do { GLSL::setCallSite(#x, __FILE__, __LINE__); (x); GLSL::checkCall(#x, __FILE__, __LINE__); } while (0)
 #else
+#define OPENGL_ERROR_CHECKS 0
 #define CHECKED_GL_CALL(x) (x)
 #endif
 
@@ -0,0 +1,78 @@
+#pragma once
+#ifndef GLTF_LOADER_H_INCLUDED
+#define GLTF_LOADER_H_INCLUDED
+
+#include <cstddef>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "MappedFile.h"
+#include "Mesh.h"
+#include "tiny_obj_loader.h"
+
+// One triangle primitive of a glTF mesh, placed by the node that uses it
+struct GltfPrimitive
+{
+    // offsets relative to GltfModel::vertexData
+    MeshBufferLayout layout;
+    // index into GltfModel::materials, -1 for none
+    int material = -1;
+    // world matrix of the node
+    glm::mat4 transform = glm::mat4(1.0f);
+};
+
+// An image of a material, either a file next to the model or a PNG/JPEG inside the binary chunk
+struct GltfImage
+{
+    // what the image is known as in Model's texture cache, the uri for files
+    std::string name;
+    std::string uri;
+    const unsigned char *data = nullptr;
+    size_t size = 0;
+};
+
+struct GltfModel
+{
+    GltfModel() = default;
+    GltfModel(const GltfModel&) = delete;
+    GltfModel& operator= (const GltfModel&) = delete;
+
+    std::vector<GltfPrimitive> primitives;
+    // glTF metallic-roughness materials mapped onto what the Material shader struct has
+    std::vector<tinyobj::material_t> materials;
+    std::vector<GltfImage> images;
+
+    // the part of the binary buffer the primitives read from, to upload as one GL buffer
+    const char *vertexData = nullptr;
+    size_t vertexDataSize = 0;
+
+    // bounds of the transformed primitives
+    glm::vec3 min = glm::vec3(std::numeric_limits<float>::max());
+    glm::vec3 max = glm::vec3(-std::numeric_limits<float>::max());
+
+    // backing storage of vertexData and embedded images when loaded from files
+    MappedFile file;
+    MappedFile bufferFile;
+};
+
+// glTF 2.0 loader for .glb files and .gltf files with one external .bin buffer.
+//
+// glTF accessors already describe GPU vertex and index buffers, so loading only
+// validates them (bounds, types, strides, index ranges) and turns them into
+// MeshBufferLayouts; nothing is converted or copied. The buffer is then uploaded
+// as it is with a single glBufferData.
+//
+// Supports POSITION, NORMAL and TEXCOORD_0 (interleaved or not, float or
+// normalized integer texture coordinates), 8/16/32-bit indices, the node
+// hierarchy of the default scene and base color textures. Other attributes
+// (tangents, skins, morph targets), non-triangle primitives, sparse accessors
+// and data: URIs are skipped with a warning.
+namespace GltfLoader
+{
+    bool load(const std::string &path, GltfModel &model);
+    // a GLB container in memory, which has to outlive model
+    bool parseGlb(const char *data, size_t size, GltfModel &model);
+}
+
+#endif // GLTF_LOADER_H_INCLUDED
@@ -0,0 +1,57 @@
+#pragma once
+#ifndef JSON_H_INCLUDED
+#define JSON_H_INCLUDED
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Minimal read-only JSON document, enough for asset manifests like glTF.
+//
+// Lookups never fail: a missing member or element is a null value, so nested
+// optional fields read as value["a"]["b"].getNumber(fallback).
+namespace Json
+{
+    class Value
+    {
+    public:
+        enum Type { NUL, BOOLEAN, NUMBER, STRING, ARRAY, OBJECT };
+
+        Type getType() const { return type; }
+        bool isNull() const { return type == NUL; }
+        bool isNumber() const { return type == NUMBER; }
+        bool isString() const { return type == STRING; }
+        bool isArray() const { return type == ARRAY; }
+        bool isObject() const { return type == OBJECT; }
+
+        bool getBool(bool fallback = false) const { return type == BOOLEAN ? boolean : fallback; }
+        double getNumber(double fallback = 0.0) const { return type == NUMBER ? number : fallback; }
+        // empty unless a string
+        const std::string &getString() const { return text; }
+
+        // elements of an array or members of an object
+        size_t size() const { return items.size(); }
+        const Value &operator[](size_t index) const;
+        // literal indices would be ambiguous between size_t and const char * otherwise
+        const Value &operator[](int index) const { return index < 0 ? (*this)[size()] : (*this)[(size_t) index]; }
+        const Value &operator[](const char *key) const;
+        bool has(const char *key) const;
+        // member names of an object, in file order, parallel to the elements
+        const std::vector<std::string> &getKeys() const { return keys; }
+
+    private:
+        friend class Parser;
+
+        Type type = NUL;
+        bool boolean = false;
+        double number = 0.0;
+        std::string text;
+        std::vector<Value> items;
+        std::vector<std::string> keys;
+    };
+
+    // on failure error says what was wrong and where
+    bool parse(const char *data, size_t size, Value &value, std::string &error);
+}
+
+#endif // JSON_H_INCLUDED
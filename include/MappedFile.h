@@ -0,0 +1,30 @@
+#pragma once
+#ifndef MAPPED_FILE_H_INCLUDED
+#define MAPPED_FILE_H_INCLUDED
+
+#include <cstddef>
+#include <string>
+
+// Read-only memory mapping of a whole file, for loaders that parse large assets
+// in place instead of copying them through a stream first
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator= (const MappedFile&) = delete;
+
+    // an empty file opens fine, with data() == nullptr
+    bool open(const std::string &path);
+    void close();
+
+    const char *data() const { return mapped; }
+    size_t size() const { return length; }
+
+private:
+    const char *mapped = nullptr;
+    size_t length = 0;
+};
+
+#endif // MAPPED_FILE_H_INCLUDED
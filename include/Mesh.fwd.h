@@ -1,2 +1,13 @@
 #pragma once
-class Mesh;
\ No newline at end of file
+class Mesh;
+class StreamBuffer;
+struct MeshMaterials;
+namespace VertexPacking
+{
+    struct Options;
+}
+
+namespace MeshSimplifier
+{
+    struct Options;
+}
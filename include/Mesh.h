@@ -3,11 +3,13 @@
 #define SHAPES_INCLUDE_H
 
 #include "Mesh.fwd.h"
+#include <algorithm>
 #include <string>
 #include <memory>
 
+#include "Meshlets.h"
 #include "Program.h"
-#include "D:/my_games/lib/glm/gtc/matrix_transform.hpp"
+#include "glm/gtc/matrix_transform.hpp"
 #include "tiny_obj_loader.h"
 #include <GLSL.h>
 
@@ -19,6 +21,50 @@ struct Vertex
     glm::vec2 TexCoord;
 };
 
+// where one vertex attribute of a mesh lives in its vertex buffer, as glVertexAttribPointer takes it
+struct VertexAttribute
+{
+    // components, 0 if the mesh does not have the attribute
+    GLint size = 0;
+    GLenum type = GL_FLOAT;
+    GLboolean normalized = GL_FALSE;
+    // 0 for tightly packed
+    GLsizei stride = 0;
+    GLintptr offset = 0;
+};
+
+// Vertices and indices of a mesh that are already in a GL buffer, in whatever
+// layout the file had (interleaved or one array per attribute). Lets loaders
+// for GPU ready formats like glTF upload their data as it is.
+struct MeshBufferLayout
+{
+    // position, normal and texture coordinates, at the locations of Vertex's members
+    VertexAttribute attributes[3];
+    GLsizei vertexCount = 0;
+    // GL_UNSIGNED_BYTE, GL_UNSIGNED_SHORT or GL_UNSIGNED_INT, 0 to draw the vertices in order
+    GLenum indexType = 0;
+    GLsizei indexCount = 0;
+    GLintptr indexOffset = 0;
+};
+
+// a level of detail of a mesh, a range of its index buffer
+struct MeshLod
+{
+    GLsizei indexCount = 0;
+    GLintptr indexOffset = 0;
+    // how far the simplified surface may be from the full one, in the mesh's units
+    float error = 0.0f;
+};
+
+// what a mesh is drawn with, the materials and textures of the Model drawing it
+struct MeshMaterials
+{
+    const std::vector<tinyobj::material_t> &materials;
+    std::map<std::string, unsigned int> &textures;
+    // diffuse textures bound after the materials' ones
+    const std::vector<unsigned int> &extraTextures;
+};
+
 float min(float x, float y);
 float max(float x, float y);
 
@@ -27,20 +73,85 @@ class Mesh
 public:
     
 
-    Mesh(std::vector<Vertex> vertices, std::vector<int> material_ids);
+    // indexed triangles, an empty index list draws the vertices in order
+    Mesh(std::vector<Vertex> vertices, std::vector<uint32_t> indices, std::vector<int> material_ids);
+    // a mesh drawn from buffer, which the caller owns and has to keep alive.
+    // Vertices and indices may share the buffer.
+    Mesh(GLuint buffer, const MeshBufferLayout &layout, int material_id);
+    // only for meshes with their own vertices
     void center(glm::vec3 min, glm::vec3 max);
-    void Draw(Program *shader, std::vector<tinyobj::material_t> materials, std::map<std::string, unsigned int> textures);
-    void addTexture(int texture_index);
-    void setupMesh();
+    // attribute locations of the per instance matrices used by DrawInstanced
+    static const GLuint INSTANCE_MODEL_LOCATION = 3;
+    static const GLuint INSTANCE_NORMAL_LOCATION = 7;
+
+    void Draw(Program *shader, const MeshMaterials &materials, size_t lod = 0);
+    // draws count instances whose model and normal matrices are tightly packed at the given offsets of instanceBuffer
+    void DrawInstanced(Program *shader, const MeshMaterials &materials,
+                       GLuint instanceBuffer, GLintptr modelOffset, GLintptr normalOffset, GLsizei count, size_t lod = 0);
+    // draws a single instance of a shader built with INSTANCED whose matrices are not
+    // streamed, they are given as constant values of the instance attributes
+    void DrawInstance(Program *shader, const MeshMaterials &materials,
+                      const glm::mat4 &model, const glm::mat3 &normal, size_t lod = 0);
+    // DrawInstanced at the full level, leaving out each instance's meshlets that are
+    // outside the frustum or face away from viewPos. models are the count matrices at
+    // modelOffset. The draws are indirect commands written to stream; false, with
+    // nothing drawn, without room for them or without GL 4.3.
+    bool DrawMeshletsInstanced(Program *shader, const MeshMaterials &materials, StreamBuffer *stream,
+                               GLintptr modelOffset, GLintptr normalOffset, const glm::mat4 *models, GLsizei count,
+                               const glm::mat4 &viewProjection, const glm::vec3 &viewPos, bool reversedZ);
+    size_t getTriangleCount(size_t lod = 0) const;
+
+    // Simplifies the mesh's own indexed triangles into up to MAX_LODS - 1 coarser
+    // levels, each with about half the triangles of the one before. The levels are
+    // appended to the index buffer, so this has to happen before setupMesh.
+    void generateLods(const MeshSimplifier::Options &options);
+    static const size_t MAX_LODS = 5;
+    // 1 for meshes without generated levels, lods past the last one draw the last
+    size_t getLodCount() const { return lods.empty() ? 1 : lods.size(); }
+    float getLodError(size_t lod) const { return lods.empty() ? 0.0f : lods[std::min(lod, lods.size() - 1)].error; }
+    // Splits the full level into meshlets (see Meshlets), reordering its triangles.
+    // Only for meshes with their own indices, and before setupMesh.
+    void buildMeshlets();
+    bool hasMeshlets() const { return !meshlets.empty(); }
+    size_t getMeshletCount() const { return meshlets.size(); }
+    // placement of the mesh inside its model, applied on top of the model matrices
+    void setTransform(const glm::mat4 &transform);
+    bool hasTransform() const { return transformed; }
+    const glm::mat4 &getTransform() const { return transform; }
+    // uploads the mesh, with packing its own vertices go up in the smallest format within
+    // the tolerances (see VertexPacking), drawn by shaders built with PACKED_VERTICES
+    void setupMesh(const VertexPacking::Options *packing = nullptr);
     void clearBuffers();
 private:
+    void bindTextures(Program *shader, const MeshMaterials &materials);
+    void drawElements(GLsizei instances, size_t lod);
+    // points the per instance attributes at the matrices in instanceBuffer
+    void bindInstances(GLuint instanceBuffer, GLintptr modelOffset, GLintptr normalOffset);
+    // dequantization uniforms of shaders built with PACKED_VERTICES
+    void setVertexFormat(Program *shader);
+
     // render data
     unsigned int VAO       = 0, 
-                 VBO       = 0; 
+                 VBO       = 0,
+                 EBO       = 0;
+    // the caller's buffer for meshes that do not own their data
+    GLuint external_buffer = 0;
+    MeshBufferLayout layout;
+    // level 0 is the full mesh, empty without generated levels
+    std::vector<MeshLod> lods;
+    // of the full level, in index buffer order
+    std::vector<Meshlets::Meshlet> meshlets;
+    std::vector<DrawElementsIndirectCommand> meshlet_commands;
+    glm::mat4 transform = glm::mat4(1.0f);
+    bool transformed = false;
+    // see VertexPacking::PackedVertices, the defaults decode float vertices as they are
+    glm::vec3 position_scale = glm::vec3(1.0f);
+    glm::vec3 position_offset = glm::vec3(0.0f);
+    bool octahedral_normals = false;
     // mesh data
     std::vector<Vertex>   vertices;
+    std::vector<uint32_t> indices;
     std::vector<int>  material_ids;
-    std::vector<int>  texture_ids;
 
 };
 
@@ -0,0 +1,38 @@
+#pragma once
+#ifndef MESH_SIMPLIFIER_H_INCLUDED
+#define MESH_SIMPLIFIER_H_INCLUDED
+
+#include <cstdint>
+#include <vector>
+
+#include "Mesh.h"
+
+// Quadric error edge collapse (Garland and Heckbert) for generating levels of detail.
+//
+// Edges collapse onto one of their vertices rather than a new optimal point, so
+// a simplified mesh indexes the same vertices as the original and every level
+// of detail can share one vertex buffer. Vertices on attribute seams (the same
+// position with different normals or texture coordinates) never move, so
+// seams cannot tear; neither do border vertices unless lockBorders is off.
+namespace MeshSimplifier
+{
+    struct Options
+    {
+        // vertices on open edges keep their place, holes and cut outlines do not shrink
+        bool lockBorders = true;
+        // position error a full change of normal or texture coordinates is worth,
+        // as a fraction of the mesh's extent
+        float attributeWeight = 0.02f;
+        // collapses over this error are not done even if the target is not reached,
+        // as a fraction of the mesh's extent
+        float maxError = 0.05f;
+    };
+
+    // Simplifies indexed triangles until at most targetIndexCount indices are left
+    // or no collapse stays within maxError. error is set to the largest error of
+    // the collapses, in the units of the positions.
+    std::vector<uint32_t> simplify(const std::vector<Vertex> &vertices, const std::vector<uint32_t> &indices,
+                                   size_t targetIndexCount, const Options &options, float &error);
+}
+
+#endif // MESH_SIMPLIFIER_H_INCLUDED
@@ -0,0 +1,63 @@
+#pragma once
+#ifndef MESHLETS_H_INCLUDED
+#define MESHLETS_H_INCLUDED
+
+#include <cstdint>
+#include <vector>
+
+#include "Camera.h"
+
+struct Vertex;
+
+// the layout glMultiDrawElementsIndirect reads
+struct DrawElementsIndirectCommand
+{
+    GLuint count;
+    GLuint instanceCount;
+    GLuint firstIndex;
+    GLint baseVertex;
+    GLuint baseInstance;
+};
+
+// Small clusters of a mesh's triangles that can be culled on their own.
+//
+// build() reorders a mesh's triangles so that every meshlet is a contiguous
+// range of its index buffer, then culling leaves a list of ranges to draw with
+// one multi draw. Each meshlet has a bounding sphere for frustum culling and a
+// cone around its face normals: when the camera sees every face in the cone
+// from behind, the whole meshlet is back facing.
+namespace Meshlets
+{
+    const size_t MAX_VERTICES = 64;
+    const size_t MAX_TRIANGLES = 124;
+
+    struct Meshlet
+    {
+        // range of the index buffer, in triangles
+        uint32_t firstTriangle = 0;
+        uint32_t triangleCount = 0;
+        uint32_t vertexCount = 0;
+        glm::vec3 center = glm::vec3(0.0f);
+        float radius = 0.0f;
+        glm::vec3 coneAxis = glm::vec3(0.0f, 0.0f, 1.0f);
+        // sine of the angle between the axis and the furthest face normal, over 1
+        // if the faces spread too far for the meshlet to ever be back facing
+        float coneCutoff = 2.0f;
+    };
+
+    // Groups the first indexCount indices (counter-clockwise triangles) into
+    // meshlets of at most MAX_VERTICES distinct vertices and MAX_TRIANGLES
+    // triangles, reordering them in place so each meshlet is contiguous.
+    std::vector<Meshlet> build(const std::vector<Vertex> &vertices, uint32_t *indices, size_t indexCount);
+
+    // frustum and camera in the meshlet's space, e.g. Frustum::fromMatrix(viewProjection * model)
+    bool isBackFacing(const Meshlet &meshlet, const glm::vec3 &camera);
+    bool isVisible(const Meshlet &meshlet, const Frustum &frustum, const glm::vec3 &camera);
+
+    // appends one command per run of consecutive visible meshlets, drawing
+    // instance baseInstance. Returns the number of triangles in them.
+    size_t cull(const std::vector<Meshlet> &meshlets, const Frustum &frustum, const glm::vec3 &camera,
+                GLuint baseInstance, std::vector<DrawElementsIndirectCommand> &commands);
+}
+
+#endif // MESHLETS_H_INCLUDED
@@ -1,2 +1,6 @@
 #pragma once
-class Model;
\ No newline at end of file
+class Model;
+class ModelAsset;
+struct ModelImportOptions;
+struct DrawView;
+struct ModelSnapshot;
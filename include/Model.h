@@ -2,6 +2,7 @@
 
 #include "Model.fwd.h"
 
+#include <functional>
 #include <iostream>
 #include <vector>
 #include <memory>
@@ -10,45 +11,153 @@
 #include "Mesh.h"
 #include "Program.fwd.h"
 #include "Program.h"
+#include "StreamBuffer.h"
 #include "stb_image.h"
 #include "tiny_obj_loader.h"
-#include "D:/my_games/lib/glm/gtc/type_ptr.hpp"
+#include "glm/gtc/type_ptr.hpp"
 
 
+// what Model::Draw needs to know about the view to pick a level of detail for each
+// instance and to cull meshlets
+struct DrawView
+{
+    glm::vec3 viewPos = glm::vec3(0.0f);
+    // pixels a unit of error at distance 1 covers, projection[1][1] * viewport height / 2,
+    // 0 to draw every instance at the full level
+    float pixelScale = 0.0f;
+    // largest error an instance may show, in pixels
+    float pixelError = 1.0f;
+    // a coarser level is only picked once its error is this fraction below pixelError,
+    // so instances near a threshold do not switch back and forth every frame
+    float hysteresis = 0.25f;
+    // per instance frustum and back face culling of models loaded with meshlets
+    bool cullMeshlets = false;
+    glm::mat4 viewProjection = glm::mat4(1.0f);
+    bool reversedZ = false;
+};
+
+// Writes count model and normal matrices to the stream, split over as many
+// allocations as it takes, and calls draw(first, count, modelOffset, normalOffset)
+// for each part. Returns how many instances were written, fewer than count once
+// the stream is full this frame.
+size_t streamInstances(StreamBuffer &stream, const glm::mat4 *models, const glm::mat3 *normals, size_t count,
+                       const std::function<void(size_t, GLsizei, GLintptr, GLintptr)> &draw);
+
 unsigned int TextureFromFile(const std::string &path, const std::string &directory, bool gamma = false);
+// decodes a PNG/JPEG/... file that is already in memory
+unsigned int TextureFromMemory(const unsigned char *data, size_t size);
 unsigned int loadCubemap(const std::string &path, const std::vector<std::string> &faces);
 
 
-class Model
+// The meshes, GPU buffers and materials loaded from one file. Shared by every
+// Model made from it through ModelRegistry, and freed with the last of them.
+class ModelAsset
 {
 public:
-    // vector containing positions and orientations of models
-    // for example, a model of a tree can be placed in multiple locations
-    std::vector<glm::mat4> model_matrices;
+    // expects a filepath to a 3D model, .obj or glTF (.glb/.gltf). OBJ meshes are
+    // packed, get levels of detail and are split into meshlets as the options say,
+    // glTF buffers go up as they are.
+    ModelAsset(const std::string &path, const ModelImportOptions &options);
+    ~ModelAsset();
+    ModelAsset(const ModelAsset &) = delete;
+    ModelAsset &operator=(const ModelAsset &) = delete;
 
-    // constructor, expects a filepath to a 3D model;
-    Model(const std::string &path);
-    
-    // draw the model and all of its meshes
-    void Draw(Program *shader);
-
-    void addTexture(const std::string &texture_name);
-
-    void clearBuffers();
+    const std::vector<tinyobj::material_t> &getMaterials() const { return materials; }
+    size_t getLodCount() const { return lod_errors.size(); }
+    const std::string &getResourceDirectory() const { return resource_directory; }
 
 private:
-    // model data
+    friend class Model;
 
+    // textures by name, shared by all models
     static std::map<std::string, unsigned int> textures_loaded;
     std::vector<tinyobj::material_t> materials;
     std::vector<Mesh> meshes;
+    // some meshes have their own transform (glTF nodes), which Draw has to apply per mesh
+    bool mesh_transforms = false;
+    // vertex and index data shared by all meshes of a glTF model
+    GLuint gltf_buffer = 0;
     std::string resource_directory;
+    // per level of detail the largest error of the meshes, one entry without generated levels
+    std::vector<float> lod_errors = {0.0f};
+    // of the centered model, around the origin
+    float bounding_radius = 0.0f;
 
     glm::vec3 model_min = glm::vec3(std::numeric_limits<float>::max());
     glm::vec3 model_max = glm::vec3(std::numeric_limits<float>::min());
 
-    void loadModel(const std::string &path);
-    Mesh processMesh(tinyobj::shape_t shape, tinyobj::attrib_t attribs, std::vector<tinyobj::material_t> materials);
+    void loadModel(const std::string &path, const ModelImportOptions &options);
+    void loadGltf(const std::string &path);
     void loadMaterialTextures(tinyobj::material_t material);
+};
+
+// A placement of a ModelAsset: its own instances, materials and extra textures
+// drawn with the asset's shared geometry.
+class Model
+{
+public:
+    // vector containing positions and orientations of models
+    // for example, a model of a tree can be placed in multiple locations.
+    // Game state: frames draw a copy of it, see ModelSnapshot.
+    std::vector<glm::mat4> model_matrices;
 
-};
\ No newline at end of file
+    // see ModelRegistry::acquire for a shared asset
+    explicit Model(std::shared_ptr<ModelAsset> asset);
+    
+    // draw the model and all of its meshes at instances, a copy of model_matrices.
+    // Draw keeps the normal matrices and levels of detail of the last call, so all
+    // calls have to come from the thread that renders. With a stream buffer and a shader built
+    // with INSTANCED, all instances are drawn at once from matrices written to the stream,
+    // the ones that do not fit it any more are drawn one by one.
+    // With a DrawView each instance is drawn at the coarsest level whose error stays
+    // within its pixelError, instances at the same level share a draw. Instanced
+    // draws at the full level leave out the meshlets the view culls.
+    void Draw(Program *shader, const std::vector<glm::mat4> &instances, StreamBuffer *stream = nullptr,
+              const DrawView *view = nullptr);
+
+    size_t getLodCount() const { return asset->getLodCount(); }
+    const std::shared_ptr<ModelAsset> &getAsset() const { return asset; }
+
+    // this model's copy of the asset's materials, changes do not affect other models of the asset
+    std::vector<tinyobj::material_t> &getMaterials() { return materials; }
+    // an extra diffuse texture for every mesh of this model, from the asset's directory
+    void addTexture(const std::string &texture_name);
+
+private:
+    std::shared_ptr<ModelAsset> asset;
+    std::vector<tinyobj::material_t> materials;
+    std::vector<unsigned int> extra_textures;
+    // transpose(inverse(mat3(model))) per instance drawn last
+    std::vector<glm::mat3> normal_matrices;
+    // the instances of the last updateNormalMatrices(), used to find the changed entries
+    std::vector<glm::mat4> normal_source_matrices;
+    // instances with a mesh transform applied, for meshes that have one
+    std::vector<glm::mat4> mesh_model_matrices;
+    std::vector<glm::mat3> mesh_normal_matrices;
+    // level each instance was drawn at last, empty when drawn without levels
+    std::vector<unsigned char> instance_lods;
+
+    MeshMaterials getMeshMaterials();
+    // recomputes the normal matrices of every instance that changed since the last call
+    void updateNormalMatrices(const std::vector<glm::mat4> &instances);
+    void selectLods(const std::vector<glm::mat4> &instances, const DrawView &view);
+    // instanced draws of the instances at each level
+    void drawLodsInstanced(Program *shader, const std::vector<glm::mat4> &instances, StreamBuffer *stream,
+                           const DrawView *view);
+    // every mesh with the count instances streamed, returns how many fit the stream
+    size_t drawMeshesInstanced(Program *shader, StreamBuffer *stream, const glm::mat4 *models, const glm::mat3 *normals,
+                               size_t count, size_t lod, const DrawView *view);
+    // meshes [firstMesh, endMesh) of count instances with a draw each, at level lod or
+    // at lods[m] per instance. For shaders without INSTANCED and instances the stream
+    // has no room for.
+    void drawOneByOne(Program *shader, const glm::mat4 *models, const glm::mat3 *normals, size_t count,
+                      size_t firstMesh, size_t endMesh, size_t lod, const unsigned char *lods = nullptr);
+};
+
+// A Model's instances as of one frame. The game thread copies them, so the render
+// thread draws a consistent frame while the next one already moves the models.
+struct ModelSnapshot
+{
+    Model *model;
+    std::vector<glm::mat4> instances;
+};
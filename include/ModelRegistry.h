@@ -0,0 +1,39 @@
+#pragma once
+#ifndef MODEL_REGISTRY_H_INCLUDED
+#define MODEL_REGISTRY_H_INCLUDED
+
+#include <memory>
+#include <string>
+
+#include "Model.h"
+#include "MeshSimplifier.h"
+#include "VertexPacking.h"
+
+// how a file is turned into a ModelAsset, only OBJ meshes use the options
+struct ModelImportOptions
+{
+    // vertices in the formats of VertexPacking, for shaders built with PACKED_VERTICES
+    bool packVertices = false;
+    VertexPacking::Options packing;
+    bool generateLods = false;
+    MeshSimplifier::Options lods;
+    bool meshlets = false;
+};
+
+// Loads every file once. Assets are keyed by the file's canonical path and the
+// import options, so the same file reached through different relative paths
+// is shared, while a different packing or simplification gets its own asset.
+// The registry only keeps weak references: an asset is freed with the last
+// Model using it and loaded again by the next acquire.
+namespace ModelRegistry
+{
+    // the asset for path and options, loaded unless a Model still holds it
+    std::shared_ptr<ModelAsset> acquire(const std::string &path, const ModelImportOptions &options);
+
+    std::string makeKey(const std::string &path, const ModelImportOptions &options);
+
+    // assets that are still held by a Model
+    size_t getLoadedCount();
+}
+
+#endif // MODEL_REGISTRY_H_INCLUDED
@@ -0,0 +1,63 @@
+#pragma once
+#ifndef OBJ_PARSER_H_INCLUDED
+#define OBJ_PARSER_H_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "Mesh.h"
+#include "tiny_obj_loader.h"
+
+// One object or group of an OBJ file as indexed, deduplicated triangles
+struct ObjShape
+{
+    std::string name;
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+    // index into ObjModel::materials for every triangle, -1 without a known usemtl
+    std::vector<int> material_ids;
+};
+
+struct ObjModel
+{
+    std::vector<ObjShape> shapes;
+    std::vector<tinyobj::material_t> materials;
+    // bounds of every position a face refers to
+    glm::vec3 min = glm::vec3(std::numeric_limits<float>::max());
+    glm::vec3 max = glm::vec3(-std::numeric_limits<float>::max());
+};
+
+// OBJ loader for the asset pipeline, replacing tinyobj::ObjReader for models.
+//
+// The file is memory mapped and cut into chunks at line boundaries, each chunk
+// is parsed on its own thread (memchr to find the lines, std::from_chars for the
+// numbers) into flat attribute and face arrays. The chunks are then merged in
+// file order, so the result does not depend on the thread count, and every
+// shape is turned into an indexed vertex buffer with each distinct
+// position/texcoord/normal combination stored once.
+//
+// Supports v, vt, vn, f (polygons are triangulated as fans, negative indices
+// are relative), o/g (a new shape), usemtl and mtllib. Materials are read with
+// tinyobj's MTL loader. Everything else (lines, points, smoothing groups,
+// vertex colors) is skipped.
+namespace ObjParser
+{
+    struct Options
+    {
+        // parser threads, 0 for one per hardware thread
+        unsigned threads = 0;
+        // files are only split into chunks of at least this many bytes
+        size_t minChunkSize = 1 << 20;
+    };
+
+    bool load(const std::string &path, ObjModel &model, const Options &options = Options());
+    // parses OBJ text that is already in memory. mtllib files are looked up in
+    // materialDirectory, or ignored if it is empty.
+    bool parse(const char *data, size_t size, ObjModel &model, const Options &options = Options(),
+               const std::string &materialDirectory = "");
+}
+
+#endif // OBJ_PARSER_H_INCLUDED
@@ -0,0 +1,155 @@
+#pragma once
+#ifndef PROFILER_H_INCLUDED
+#define PROFILER_H_INCLUDED
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <glad/glad.h>
+
+// Hierarchical CPU/GPU frame profiler.
+//
+// Scopes are opened with PROFILE_SCOPE("name") and nest by lexical scope. Every
+// scope records steady_clock times and a pair of GL_TIMESTAMP queries. Queries
+// are kept per frame in a ring of FRAME_LATENCY slots and only read back once
+// the driver reports them available, so profiling never stalls the pipeline;
+// a frame whose results are still missing when its slot comes around again is
+// dropped instead.
+//
+// Resolved frames are merged into a tree (scopes with the same name under the
+// same parent are summed) that can be printed, and optionally recorded as a
+// Chrome trace (chrome://tracing, Perfetto) with the CPU and GPU as two threads.
+//
+// Frames that mark when their input was sampled also get an input-to-photon
+// estimate: input sampling to the GPU finishing the frame, measured with the
+// frame's last timestamp query, plus the display's presentation latency.
+//
+// The profiler is not thread safe. It belongs to the thread that calls
+// beginFrame() (the one with the GL context), scopes opened on any other
+// thread are ignored.
+class Profiler
+{
+public:
+    static const int FRAME_LATENCY = 3;
+
+    struct Node
+    {
+        const char *name;
+        int depth;
+        int calls;
+        double cpuMs;
+        double gpuMs;
+    };
+
+    static Profiler &get();
+
+    void setEnabled(bool enabled);
+    bool isEnabled() const { return enabled; }
+
+    void beginFrame();
+    void endFrame();
+
+    void beginScope(const char *name);
+    void endScope();
+
+    // when the input the current frame is based on was sampled
+    void markInput(std::chrono::steady_clock::time_point time);
+    // added to every input latency for the way from the finished frame to the screen
+    void setPresentLatency(double milliseconds) { presentLatencyMs = milliseconds; }
+    // input-to-photon estimate of the most recent frame, negative if it has none
+    double getInputLatency() const { return inputLatencyMs; }
+
+    // tree of the most recent frame whose GPU times are available, in depth-first order
+    const std::vector<Node> &getLastFrame() const { return lastFrame; }
+    void print(std::ostream &out) const;
+
+    // records every resolved frame until writeTrace()
+    void startTrace();
+    bool writeTrace(const std::string &fileName);
+
+private:
+    struct Scope
+    {
+        const char *name;
+        int parent;
+        int64_t cpuBegin;
+        int64_t cpuEnd;
+        // indices into Frame::queries
+        int gpuBegin;
+        int gpuEnd;
+    };
+
+    struct Frame
+    {
+        uint64_t number = 0;
+        bool pending = false;
+        std::vector<Scope> scopes;
+        std::vector<GLuint> queries;
+        int usedQueries = 0;
+        // steady_clock nanoseconds since start, negative without input
+        int64_t inputTime = -1;
+    };
+
+    struct TraceEvent
+    {
+        const char *name;
+        int thread;
+        int64_t begin;
+        int64_t duration;
+    };
+
+    Profiler();
+
+    bool enabled = true;
+    bool inFrame = false;
+    std::atomic<std::thread::id> owner;
+    uint64_t frameNumber = 0;
+    uint64_t droppedFrames = 0;
+    Frame frames[FRAME_LATENCY];
+    std::vector<int> openScopes;
+
+    std::chrono::steady_clock::time_point start;
+    // GL_TIMESTAMP - steady_clock, both in nanoseconds
+    int64_t gpuClockOffset = 0;
+    bool calibrated = false;
+
+    std::vector<Node> lastFrame;
+    uint64_t lastFrameNumber = 0;
+
+    double presentLatencyMs = 0.0;
+    double inputLatencyMs = -1.0;
+
+    bool tracing = false;
+    std::vector<TraceEvent> traceEvents;
+
+    int64_t now() const;
+    int timestamp(Frame &frame);
+    bool resolve(Frame &frame);
+};
+
+// Profiles the enclosing block
+class ProfileScope
+{
+public:
+    explicit ProfileScope(const char *name) { Profiler::get().beginScope(name); }
+    ~ProfileScope() { Profiler::get().endScope(); }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator= (const ProfileScope&) = delete;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+#ifndef DISABLE_PROFILER
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#else
+#define PROFILE_SCOPE(name) do {} while (0)
+#endif
+
+#endif // PROFILER_H_INCLUDED
@@ -6,11 +6,15 @@
 
 #include <map>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include <glad/glad.h>
 #include "Model.fwd.h"
 #include "Model.h"
-#include "D:/my_games/lib/glm/gtc/type_ptr.hpp"
+#include "ShaderPreprocessor.h"
+#include "StreamBuffer.h"
+#include "glm/gtc/type_ptr.hpp"
 
 std::string readFileAsString(const std::string &fileName);
 
@@ -19,20 +23,83 @@ class Program
     protected:
         std::string vShaderName;
         std::string fShaderName;
+        std::vector<std::pair<std::string, std::string>> defines;
+        // preprocessed stages of the last submit(), including the files they were built from
+        PreprocessedShader vShader;
+        PreprocessedShader fShader;
+
+        void deleteShaders();
+        void discardBuild();
+        // makes a freshly linked program the live one, replacing the previous program
+        void activate(GLuint program);
 
     private:
-        GLuint pid = 0;
+        enum class Status
+        {
+            UNINITIALIZED,
+            PENDING,    // submitted to the driver, result not queried yet
+            LINKED,
+            FAILED
+        };
+
+        enum class UniformType
+        {
+            NONE,
+            INT,
+            FLOAT,
+            VEC3,
+            MAT3,
+            MAT4
+        };
+
+        struct Uniform
+        {
+            GLint location = -1;
+            // last value set through one of the setters, re-applied after a reload
+            UniformType type = UniformType::NONE;
+            int intValue = 0;
+            glm::mat4 value = glm::mat4(0.0f);
+        };
+
+        GLuint pid = 0;         // live program, used by bind()
+        GLuint buildPid = 0;    // program being compiled/linked by submit()
+        GLuint VS = 0;
+        GLuint FS = 0;
+        Status status = Status::UNINITIALIZED;
+        bool useCache = false;
+        std::string cacheKey;
+        std::vector<std::string> pendingAttributes;
         std::map<std::string, GLint> attributes;
-        std::map<std::string, GLint> uniforms;
+        std::map<std::string, Uniform> uniforms;
         bool verbose = true;
 
+        Uniform &findUniform(const std::string &name);
+        void applyUniform(const Uniform &uniform);
+
     public:
+        // the models drawn with this program, game state like their model_matrices
         std::vector<Model *> models;
         void setVerbose(const bool v) {verbose = v;}
         bool isVerbose() const { return verbose;}
         
         void setShaderNames(const std::string &v, const std:: string &f);
+        // adds a #define to both shader stages, must be called before init()
+        void addDefine(const std::string &name, const std::string &value = "");
+        bool hasDefine(const std::string &name) const;
+        // compiles and links synchronously, same as submit() followed by finish()
         virtual bool init();
+        // starts compiling and linking without waiting for the driver
+        bool submit();
+        // true once finish() can be called without stalling
+        bool isReady() const;
+        // waits for the compile/link started by submit() and reports errors
+        bool finish();
+        // recompiles from the files on disk, the current program stays live until
+        // the new one links successfully and is kept if it does not
+        bool reload();
+        bool isReloading() const { return status == Status::LINKED && buildPid != 0; }
+        // true if path is one of the source files of this program
+        bool usesFile(const std::string &path) const;
         virtual void bind();
         virtual void unbind();
 
@@ -42,10 +109,15 @@ class Program
         void setInt(const std::string &name, int i);
         void setFloat(const std::string &name, float f);
         void setVector3f(const std::string &name, glm::vec3 v);
+        void setMat3(const std::string &name, glm::mat3 m);
         void setMat4(const std::string &name, glm::mat4 m);
         GLint getAttribute(const std::string &name) const;
         GLint getUniform(const std::string &name) const;
-        void drawModels(glm::mat4 view, glm::mat4 projection, glm::vec3 viewPos);
+        // draws snapshots of this program's models. stream is used by models to upload
+        // per instance data, it may be null. Models pick their levels of detail and cull
+        // meshlets with drawView, null draws them in full.
+        void drawModels(glm::mat4 view, glm::mat4 projection, glm::vec3 viewPos, const std::vector<ModelSnapshot> &snapshots,
+                        StreamBuffer *stream = nullptr, const DrawView *drawView = nullptr);
 };
 
 #endif //SHADER_PROGRAM_H_INCLUDED
\ No newline at end of file
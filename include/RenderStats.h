@@ -0,0 +1,28 @@
+#pragma once
+#ifndef RENDER_STATS_H_INCLUDED
+#define RENDER_STATS_H_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+
+// Per-frame counters of the work submitted to the driver. The renderer bumps
+// them at the few places that issue draws or change state, whoever consumes
+// them (benchmark, profiler) resets them at the start of a frame.
+namespace RenderStats
+{
+    struct Counters
+    {
+        uint64_t drawCalls = 0;
+        uint64_t triangles = 0;
+        // program, vertex array and texture binds
+        uint64_t stateChanges = 0;
+    };
+
+    const Counters &frame();
+    void reset();
+
+    void addDraw(size_t triangles);
+    void addStateChange(size_t count = 1);
+}
+
+#endif // RENDER_STATS_H_INCLUDED
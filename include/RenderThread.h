@@ -0,0 +1,110 @@
+#pragma once
+#ifndef RENDER_THREAD_H_INCLUDED
+#define RENDER_THREAD_H_INCLUDED
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <ostream>
+#include <thread>
+#include <vector>
+
+// Commands recorded by the game thread and executed in order on the render thread.
+// Commands capture the data they need by value, they must not read game state
+// that keeps changing while the next frame is simulated.
+class RenderCommandList
+{
+public:
+    typedef std::function<void()> Command;
+
+    void push(Command command) { commands.push_back(std::move(command)); }
+    void execute();
+    void clear() { commands.clear(); }
+    bool empty() const { return commands.empty(); }
+
+private:
+    std::vector<Command> commands;
+};
+
+// averages over the last RenderThread::WINDOW frames, all times in milliseconds
+struct FramePacingStats
+{
+    uint64_t frames = 0;
+    // time between two submitted frames on the game thread
+    double frameMs = 0.0;
+    double maxFrameMs = 0.0;
+    // time the game thread spent producing a frame (excluding waiting)
+    double gameMs = 0.0;
+    // time the game thread waited for the render thread to take the frame
+    double gameWaitMs = 0.0;
+    // time the render thread spent executing a frame's commands, including the swap
+    double renderMs = 0.0;
+    // time the render thread waited for the next frame
+    double renderIdleMs = 0.0;
+
+    void print(std::ostream &out) const;
+};
+
+// Thread that owns the GL context and executes the game thread's command lists.
+// There are two lists: the game thread records into one while the render thread
+// executes the other, so simulating frame N+1 overlaps with submitting frame N.
+// The hand-off is a single atomic flag; the game thread only waits if it is a
+// whole frame ahead.
+class RenderThread
+{
+public:
+    RenderThread() = default;
+    ~RenderThread();
+
+    RenderThread(const RenderThread&) = delete;
+    RenderThread& operator= (const RenderThread&) = delete;
+
+    // acquire/release make the GL context current on / detach it from the calling thread
+    void start(std::function<void()> acquireContext, std::function<void()> releaseContext);
+    // executes what was already submitted, then releases the context and joins
+    void stop();
+    bool isRunning() const { return running; }
+
+    // list to record the next frame into (game thread only)
+    RenderCommandList &commands() { return lists[recording]; }
+    // hands the recorded list to the render thread
+    void submit();
+    // blocks until the render thread has executed everything submitted, game
+    // thread only. Waiting here before sampling input trades the overlap for latency.
+    void waitIdle();
+
+    FramePacingStats getStats();
+
+private:
+    static const int WINDOW = 120;
+
+    RenderCommandList lists[2];
+    int recording = 0;
+    int submitted = 0;
+    // true while lists[submitted] waits for or is being executed
+    std::atomic<bool> pending{false};
+    std::atomic<bool> running{false};
+    std::thread thread;
+
+    std::function<void()> acquireContext;
+    std::function<void()> releaseContext;
+
+    // frame pacing, accumulated per window and published when a window is complete
+    typedef std::chrono::steady_clock clock;
+    std::mutex statsMutex;
+    FramePacingStats stats;
+    FramePacingStats gameWindow;
+    FramePacingStats renderWindow;
+    clock::time_point lastSubmit;
+    clock::time_point lastRenderEnd;
+
+    void renderLoop();
+    // copy the finished windows into stats, statsMutex has to be held
+    void publishGame();
+    void publishRender();
+    static void waitBackoff(int &spins);
+};
+
+#endif // RENDER_THREAD_H_INCLUDED
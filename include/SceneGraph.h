@@ -0,0 +1,74 @@
+#pragma once
+#ifndef SCENE_GRAPH_H_INCLUDED
+#define SCENE_GRAPH_H_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "glm/glm.hpp"
+#include "glm/gtc/quaternion.hpp"
+
+// Transform hierarchy with cached world matrices.
+//
+// Every node has a local translation, rotation and scale (world = parent world *
+// T * R * S). Nodes are stored as flat arrays (structure of arrays) in creation
+// order, and since a parent has to exist before its children, parents always come
+// first. update() is therefore a single forward pass over the arrays: a node is
+// recomputed if it was changed or its parent was recomputed earlier in the same
+// pass, everything else keeps its cached matrix.
+class SceneGraph
+{
+public:
+    typedef int32_t NodeId;
+    static const NodeId NONE = -1;
+
+    // adds a node under parent (NONE for a root), parent has to exist already
+    NodeId addNode(NodeId parent = NONE,
+                   const glm::vec3 &translation = glm::vec3(0.0f),
+                   const glm::quat &rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f),
+                   const glm::vec3 &scale = glm::vec3(1.0f));
+    void clear();
+    size_t size() const { return parents.size(); }
+
+    void setTranslation(NodeId node, const glm::vec3 &translation);
+    void setRotation(NodeId node, const glm::quat &rotation);
+    void setScale(NodeId node, const glm::vec3 &scale);
+    void setLocal(NodeId node, const glm::vec3 &translation, const glm::quat &rotation, const glm::vec3 &scale);
+
+    NodeId getParent(NodeId node) const { return parents[node]; }
+    const glm::vec3 &getTranslation(NodeId node) const { return translations[node]; }
+    const glm::quat &getRotation(NodeId node) const { return rotations[node]; }
+    const glm::vec3 &getScale(NodeId node) const { return scales[node]; }
+
+    // recomputes the world matrices of changed nodes and their descendants,
+    // returns how many were recomputed
+    size_t update();
+
+    // valid as of the last update()
+    const glm::mat4 &getWorld(NodeId node) const { return worlds[node]; }
+    const glm::mat4 *getWorldMatrices() const { return worlds.data(); }
+    // true if update() recomputed the node, for consumers that cache derived data
+    bool wasUpdated(NodeId node) const { return updated[node] != 0; }
+
+    // gathers the world matrices of nodes into out, e.g. a Model's model_matrices
+    void copyWorld(const NodeId *nodes, size_t count, glm::mat4 *out) const;
+
+    // T * R * S as one matrix
+    static glm::mat4 compose(const glm::vec3 &translation, const glm::quat &rotation, const glm::vec3 &scale);
+
+private:
+    std::vector<NodeId> parents;
+    std::vector<glm::vec3> translations;
+    std::vector<glm::quat> rotations;
+    std::vector<glm::vec3> scales;
+    std::vector<glm::mat4> worlds;
+    // set by the setters, cleared by update()
+    std::vector<uint8_t> dirty;
+    std::vector<uint8_t> updated;
+    bool anyDirty = false;
+
+    void markDirty(NodeId node);
+};
+
+#endif // SCENE_GRAPH_H_INCLUDED
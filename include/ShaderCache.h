@@ -0,0 +1,34 @@
+#pragma once
+#ifndef SHADER_CACHE_H_INCLUDED
+#define SHADER_CACHE_H_INCLUDED
+
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+
+// On-disk cache of linked program binaries (glGetProgramBinary / glProgramBinary).
+// Entries are keyed on the final shader sources (which already contain any
+// injected #defines) together with the driver vendor, renderer and version, so
+// a driver update or a changed permutation simply misses the cache.
+namespace ShaderCache
+{
+    // directory the binaries are stored in, an empty string disables the cache
+    void setDirectory(const std::string &directory);
+    const std::string &getDirectory();
+
+    // true if the cache is enabled and the driver exposes at least one binary format
+    bool isSupported();
+
+    // builds the cache key for a program made from the given (preprocessed) sources
+    std::string makeKey(const std::vector<std::string> &sources);
+
+    // tries to load the binary stored under key into program, returns false
+    // (and drops the stale entry) if there is none or the driver rejects it
+    bool load(const std::string &key, GLuint program);
+
+    // retrieves the binary of a successfully linked program and writes it to disk
+    bool store(const std::string &key, GLuint program);
+}
+
+#endif // SHADER_CACHE_H_INCLUDED
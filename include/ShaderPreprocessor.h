@@ -0,0 +1,59 @@
+#pragma once
+#ifndef SHADER_PREPROCESSOR_H_INCLUDED
+#define SHADER_PREPROCESSOR_H_INCLUDED
+
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Result of preprocessing one shader stage
+struct PreprocessedShader
+{
+    std::string source;
+    // every file that went into source, files[0] is the shader itself
+    std::vector<std::string> files;
+    // (file index, line in that file) for every line of source
+    std::vector<std::pair<int, int>> lines;
+    bool ok = true;
+};
+
+// Small GLSL preprocessor run before the source is handed to the driver:
+//  - resolves #include "file" relative to the including file (each file is included once)
+//  - injects the #defines of a program permutation right after #version
+//  - folds #define values that are constant integer expressions into a single literal,
+//    using only names defined once outside of #if blocks
+//  - records where every output line came from so the driver's error log can be
+//    mapped back to files. No #line directives are emitted because drivers
+//    disagree on whether they report the source string number (Mesa does not)
+class ShaderPreprocessor
+{
+public:
+    typedef std::vector<std::pair<std::string, std::string>> Defines;
+
+    PreprocessedShader process(const std::string &fileName, const Defines &defines = Defines());
+
+    // rewrites "<source>:<line>" / "<source>(<line>)" references in a driver info
+    // log into "<file>:<line>" using the line table of a preprocessed shader
+    static std::string mapLog(const std::string &log, const PreprocessedShader &shader);
+
+    // evaluates an integer constant expression, returns false if it is not one
+    static bool evaluate(const std::string &expression, const std::map<std::string, long long> &constants, long long &result);
+
+private:
+    PreprocessedShader result;
+    // names with a known value, and names defined more than once or in a conditional
+    std::map<std::string, long long> constants;
+    std::set<std::string> unfoldable;
+    // the open #if blocks, the name of an #ifndef before its #else, empty otherwise
+    std::vector<std::string> conditionals;
+    std::vector<std::string> defineLines;
+
+    void emit(const std::string &line, int file, int lineNumber);
+    void emitDefines();
+    bool processFile(const std::string &fileName, int depth);
+    std::string foldDefine(const std::string &line);
+};
+
+#endif // SHADER_PREPROCESSOR_H_INCLUDED
@@ -0,0 +1,53 @@
+#pragma once
+#ifndef SHADER_WATCHER_H_INCLUDED
+#define SHADER_WATCHER_H_INCLUDED
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+#include <filesystem>
+
+// Watches a directory for modified files on a background thread.
+// On Linux this uses inotify, elsewhere the modification times are polled.
+// The watcher only collects file names, the owner picks them up with
+// pollChanges() on the GL thread and recompiles whatever is affected.
+class ShaderWatcher
+{
+public:
+    ShaderWatcher() = default;
+    ~ShaderWatcher();
+
+    ShaderWatcher(const ShaderWatcher&) = delete;
+    ShaderWatcher& operator= (const ShaderWatcher&) = delete;
+
+    bool start(const std::string &directory);
+    void stop();
+
+    // returns the paths of all files changed since the last call
+    std::vector<std::string> pollChanges();
+
+private:
+    std::string directory;
+    std::thread thread;
+    std::atomic<bool> running{false};
+
+    std::mutex mutex;
+    std::set<std::string> changed;
+
+#ifdef __linux__
+    int inotifyFd = -1;
+    int watchFd = -1;
+#else
+    std::map<std::string, std::filesystem::file_time_type> timestamps;
+    void scanDirectory(bool notify);
+#endif
+
+    void watchLoop();
+    void addChange(const std::string &path);
+};
+
+#endif // SHADER_WATCHER_H_INCLUDED
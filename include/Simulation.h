@@ -0,0 +1,95 @@
+#pragma once
+#ifndef SIMULATION_H_INCLUDED
+#define SIMULATION_H_INCLUDED
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include "glm/glm.hpp"
+
+// Everything the simulation produces that the renderer needs. Kept small and
+// copyable so it can be handed between threads by value.
+struct SimulationState
+{
+    glm::vec3 cameraPosition = glm::vec3(0.0f);
+    // simulated time of this state in seconds
+    double time = 0.0;
+    uint64_t step = 0;
+};
+
+struct SimulationSettings
+{
+    // length of one simulation step in seconds
+    double step = 1.0 / 120.0;
+    // steps run at most per frame, time beyond that is dropped instead of
+    // letting a slow frame cause even more work in the next one
+    int maxSteps = 8;
+    // run the simulation on its own thread instead of before each frame
+    bool threaded = false;
+};
+
+// Accumulator for running a simulation in fixed steps from variable frame times
+class FixedTimestep
+{
+public:
+    explicit FixedTimestep(double step = 1.0 / 120.0, int maxSteps = 8);
+
+    // adds elapsed seconds and returns how many steps to run now
+    int advance(double elapsed);
+
+    // how far the accumulated time is into the next step, in [0, 1)
+    double getAlpha() const { return accumulator / step; }
+    double getStep() const { return step; }
+    // total time thrown away by the catch-up cap
+    double getDroppedTime() const { return droppedTime; }
+
+private:
+    double step;
+    int maxSteps;
+    double accumulator = 0.0;
+    double droppedTime = 0.0;
+};
+
+// interpolates the render state between two simulation states
+SimulationState interpolate(const SimulationState &previous, const SimulationState &current, double alpha);
+
+// Runs a step function at a fixed rate on a background thread. Each finished
+// step is published into a double buffer (previous and latest state), the
+// renderer copies both and interpolates between them, so neither side ever
+// waits for the other for longer than that copy.
+class SimulationThread
+{
+public:
+    typedef std::function<void(SimulationState &state, double step)> StepFunction;
+
+    SimulationThread() = default;
+    ~SimulationThread();
+
+    SimulationThread(const SimulationThread&) = delete;
+    SimulationThread& operator= (const SimulationThread&) = delete;
+
+    void start(const SimulationState &initial, const SimulationSettings &settings, StepFunction stepFunction);
+    void stop();
+    bool isRunning() const { return running; }
+
+    // state to render now: between the two latest states, one step behind the simulation
+    SimulationState read();
+
+private:
+    std::thread thread;
+    std::atomic<bool> running{false};
+    SimulationSettings settings;
+    StepFunction stepFunction;
+
+    std::mutex mutex;
+    SimulationState published[2];
+    std::chrono::steady_clock::time_point publishTime;
+
+    void simulationLoop(SimulationState state);
+};
+
+#endif // SIMULATION_H_INCLUDED
@@ -0,0 +1,76 @@
+#pragma once
+#ifndef STREAM_BUFFER_H_INCLUDED
+#define STREAM_BUFFER_H_INCLUDED
+
+#include <cstdint>
+#include <vector>
+
+#include <glad/glad.h>
+
+// Ring buffer for data that is written by the CPU every frame (instance
+// transforms, lights, debug lines, ...).
+//
+// The buffer is split into one region per frame in flight. Everything written
+// during a frame is suballocated from that frame's region, and a fence placed
+// at the end of the frame tells when the GPU is done reading it, so a region
+// is only reused once it is free instead of reallocating with glBufferData.
+// The fence goes in when the next frame begins: by then the swap has flushed
+// the frame, so the fence does not force an early flush (llvmpipe, for one,
+// flushes synchronously when a fence is created behind pending draws).
+//
+// With GL 4.4 / ARB_buffer_storage the whole buffer is mapped once, persistent
+// and coherent, and allocations are plain pointers into it. On GL 3.3 every
+// allocation is mapped with glMapBufferRange(UNSYNCHRONIZED | INVALIDATE_RANGE),
+// the fences make the missing synchronization safe.
+class StreamBuffer
+{
+public:
+    static const int DEFAULT_REGIONS = 3;
+
+    struct Allocation
+    {
+        // where to write, nullptr if the region is full
+        void *data = nullptr;
+        // byte offset into getBuffer() to point the GPU at
+        GLintptr offset = 0;
+    };
+
+    StreamBuffer() = default;
+    StreamBuffer(const StreamBuffer&) = delete;
+    StreamBuffer& operator= (const StreamBuffer&) = delete;
+
+    // regionSize bytes per frame, persistent mapping is used when available and allowed
+    bool init(GLsizeiptr regionSize, int regions = DEFAULT_REGIONS, bool allowPersistent = true);
+    // needs the context, so it is not done by a destructor
+    void destroy();
+
+    // fences the previous frame's region and moves to the next one, waiting for
+    // the GPU if it still reads it
+    void beginFrame();
+
+    Allocation allocate(GLsizeiptr size, GLsizeiptr alignment = 16);
+    // has to be called after writing an allocation and before the GPU reads it.
+    // Unmaps on the GL 3.3 path, nothing to do with a coherent persistent mapping.
+    void flush();
+
+    GLuint getBuffer() const { return buffer; }
+    bool isPersistent() const { return persistentData != nullptr; }
+    GLsizeiptr getRegionSize() const { return regionSize; }
+    // how often beginFrame() had to wait for the GPU
+    uint64_t getStallCount() const { return stalls; }
+
+private:
+    GLuint buffer = 0;
+    GLsizeiptr regionSize = 0;
+    int region = 0;
+    GLsizeiptr used = 0;
+    std::vector<GLsync> fences;
+
+    char *persistentData = nullptr;
+    bool mapped = false;
+    bool inFrame = false;
+    bool warnedFull = false;
+    uint64_t stalls = 0;
+};
+
+#endif // STREAM_BUFFER_H_INCLUDED
@@ -0,0 +1,46 @@
+#pragma once
+#ifndef TRANSFORM_KERNELS_H_INCLUDED
+#define TRANSFORM_KERNELS_H_INCLUDED
+
+#include <cstddef>
+
+#include "glm/glm.hpp"
+#include "glm/gtc/quaternion.hpp"
+
+// Batched matrix kernels that work on whole arrays of transforms at once.
+//
+// The mat4 kernels have a scalar, an SSE and an AVX2/FMA path. The best one the
+// CPU supports is picked on first use; binaries stay runnable on CPUs without
+// AVX2 because only those functions are compiled for it.
+namespace TransformKernels
+{
+    enum class Isa
+    {
+        SCALAR,
+        SSE,
+        AVX2
+    };
+
+    Isa getIsa();
+    bool isSupported(Isa isa);
+    // forces a path, for tests and benchmarks. Returns false (and changes nothing) if unsupported.
+    bool setIsa(Isa isa);
+    const char *getIsaName(Isa isa);
+
+    // out[i] = a[i] * b[i], out may be a or b
+    void multiply(const glm::mat4 *a, const glm::mat4 *b, glm::mat4 *out, size_t count);
+    // out[i] = a * b[i], e.g. a parent or view-projection applied to many transforms, out may be b
+    void multiply(const glm::mat4 &a, const glm::mat4 *b, glm::mat4 *out, size_t count);
+    // out[i] = a[i] * b, e.g. a local transform applied under many instances, out may be a
+    void multiply(const glm::mat4 *a, const glm::mat4 &b, glm::mat4 *out, size_t count);
+    // out[i] = translate(translations[i]) * mat4_cast(rotations[i]) * scale(scales[i]),
+    // from separate arrays as a scene graph stores them. Rotations have to be unit quaternions.
+    void composeTRS(const glm::vec3 *translations, const glm::quat *rotations, const glm::vec3 *scales, glm::mat4 *out, size_t count);
+
+    // normals[i] = transpose(inverse(mat3(models[i])))
+    // Uses the cofactor matrix of the upper 3x3 (three cross products and a
+    // determinant), four matrices at a time with SSE.
+    void normalMatrices(const glm::mat4 *models, glm::mat3 *normals, size_t count);
+}
+
+#endif // TRANSFORM_KERNELS_H_INCLUDED
@@ -0,0 +1,67 @@
+#pragma once
+#ifndef VERTEX_PACKING_H_INCLUDED
+#define VERTEX_PACKING_H_INCLUDED
+
+#include <cstdint>
+#include <vector>
+
+#include "Mesh.h"
+
+// Compact vertex formats, encoded once when a mesh is loaded.
+//
+// Positions become unorm16 inside the mesh's bounding box, normals 2x snorm16
+// octahedral or GL_INT_2_10_10_10_REV, texture coordinates half floats: 16
+// bytes per vertex instead of Vertex's 32. Each attribute is checked against a
+// tolerance and kept as floats if its encoding is worse, so a mesh can end up
+// with any mix of the two. Shaders built with PACKED_VERTICES decode it.
+namespace VertexPacking
+{
+    enum class NormalEncoding
+    {
+        OCTAHEDRAL,     // 2x GL_SHORT, decoded in the vertex shader
+        INT_2_10_10_10  // GL_INT_2_10_10_10_REV, read as is
+    };
+
+    struct Options
+    {
+        NormalEncoding normals = NormalEncoding::OCTAHEDRAL;
+        // largest position error, as a fraction of the mesh's largest extent
+        float positionTolerance = 1e-4f;
+        // largest angle between a normal and its decoded value, in degrees
+        float normalTolerance = 0.5f;
+        // largest texture coordinate error, half a texel of a 1024 texture by
+        // default, which keeps half floats for coordinates in [-2, 2]
+        float texCoordTolerance = 1.0f / 2048.0f;
+    };
+
+    struct PackedVertices
+    {
+        // interleaved vertices, stride bytes each
+        std::vector<unsigned char> data;
+        GLsizei stride = 0;
+        // position, normal and texture coordinates as Mesh::setupMesh binds them
+        VertexAttribute attributes[3];
+        // the shader's position is positionOffset + positionScale * aPos
+        glm::vec3 positionScale = glm::vec3(1.0f);
+        glm::vec3 positionOffset = glm::vec3(0.0f);
+        // the normal attribute holds octahedral xy instead of xyz
+        bool octahedralNormals = false;
+        // largest error of each attribute, in the units of Options. Measured even
+        // for attributes that stayed floats.
+        float positionError = 0.0f;
+        float normalError = 0.0f;
+        float texCoordError = 0.0f;
+    };
+
+    void pack(const std::vector<Vertex> &vertices, const Options &options, PackedVertices &packed);
+
+    // n does not have to be unit length, the encoding picks whichever of the four
+    // nearest snorm16 pairs decodes closest to it. x in the low 16 bits.
+    uint32_t encodeOctahedral(glm::vec3 n);
+    glm::vec3 decodeOctahedral(uint32_t encoded);
+    // x in the low 10 bits, w is 0
+    uint32_t encodeInt2101010(glm::vec3 n);
+    glm::vec3 decodeInt2101010(uint32_t encoded);
+}
+
+#endif // VERTEX_PACKING_H_INCLUDED
@@ -22,6 +22,9 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
+#include <chrono>
+#include <deque>
+
 
 // This interface let's us write our own class that can be notified by input
 // events, such as key presses and mouse movement.
@@ -42,6 +45,47 @@ public:
 
 };
 
+// Where the OpenGL context comes from
+enum class WindowBackend
+{
+	GLFW,			// visible window, needs a display
+	EGL_HEADLESS	// no window at all (EGL surfaceless or pbuffer), for benchmarks and CI
+};
+
+// How swapBuffers presents a frame
+enum class PresentMode
+{
+	IMMEDIATE,	// no vsync, lowest latency but tears
+	VSYNC,		// waits for the vertical blank
+	ADAPTIVE	// vsync, but late frames are shown right away (EXT_swap_control_tear), VSYNC without it
+};
+
+struct WindowSettings
+{
+	int width = 800;
+	int height = 600;
+	WindowBackend backend = WindowBackend::GLFW;
+	PresentMode presentMode = PresentMode::VSYNC;
+	// frames per second swapBuffers paces to, 0 for no limit
+	double maxFrameRate = 0.0;
+	// frames the CPU may queue ahead of the GPU, 0 leaves it to the driver
+	int maxFramesInFlight = 2;
+	// latency over throughput: a single frame in flight, and a threaded renderer
+	// only samples input once the previous frame has been submitted
+	bool lowLatency = false;
+	// reversed-Z depth: a 32-bit float depth buffer, an infinite far plane and
+	// glClipControl(GL_ZERO_TO_ONE) when the context has it (GL 4.5)
+	bool reversedZ = false;
+	// headless only: ask Mesa for its software rasterizer (llvmpipe) instead of a GPU driver
+	bool softwareRendering = false;
+	// request a debug context and report driver messages through KHR_debug
+#ifdef NDEBUG
+	bool debugContext = false;
+#else
+	bool debugContext = true;
+#endif
+};
+
 // This class is responsible for all window management code, i.e. GLFW3 code
 // You shouldn't have to touch this code for any of the early lab assignments
 class WindowManager
@@ -57,12 +101,36 @@ public:
 	WindowManager& operator= (const WindowManager&) = delete;
 
 	bool init(int const width, int const height, const char *windowName);
+	bool init(const WindowSettings &settings, const char *windowName);
 	void shutdown();
 
 	void setEventCallbacks(EventCallbacks *callbacks);
 
 	GLFWwindow *getHandle();
 
+	// in headless mode there is no default framebuffer, everything renders into an FBO
+	bool isHeadless() const { return settings.backend == WindowBackend::EGL_HEADLESS; }
+	const WindowSettings &getSettings() const { return settings; }
+
+	// backend independent versions of the GLFW main loop calls
+	bool shouldClose();
+	void setShouldClose(bool close);
+	// presents the frame and then paces: blocks until no more than maxFramesInFlight
+	// frames are queued and the frame limit allows the next one, so input polled
+	// right after it is as fresh as possible
+	void swapBuffers();
+	void pollEvents();
+	double getTime();
+
+	// refresh rate of the display in Hz, 0 when headless or unknown
+	double getRefreshRate();
+	// estimated time from the end of a frame on the GPU until it is on screen, in milliseconds
+	double getPresentLatency();
+
+	// moves the GL context between threads, it can only be current on one at a time
+	bool makeContextCurrent();
+	void releaseContext();
+
 protected:
 
 	// This class implements the singleton design pattern
@@ -71,6 +139,25 @@ protected:
 	GLFWwindow *windowHandle = nullptr;
 	EventCallbacks *callbacks = nullptr;
 
+	WindowSettings settings;
+	bool closeRequested = false;
+	std::chrono::steady_clock::time_point startTime;
+
+	// fences of the frames queued on the GPU, oldest first
+	std::deque<GLsync> frameFences;
+	std::chrono::steady_clock::time_point nextFrameTime;
+
+	// EGL handles, kept as void pointers so this header does not need EGL
+	void *eglDisplay = nullptr;
+	void *eglContext = nullptr;
+	void *eglSurface = nullptr;
+
+	bool initGLFW(const char *windowName);
+	bool initEGL();
+	bool initGL(GLADloadproc load);
+	void setSwapInterval();
+	void paceFrame();
+
 private:
 
 	// What are these?!
@@ -0,0 +1,34 @@
+#!/usr/bin/env bash
+# Runs a benchmark scene once per --lod setting and prints the triangles drawn and
+# the frame times of each, "off" being the full meshes.
+#
+# usage: scripts/lod_sweep.sh [scene] [pixel errors...]
+# the binary is taken from MY_GAMES (default build/my_games), extra arguments
+# for it (e.g. --software) can be passed in MY_GAMES_ARGS
+
+set -euo pipefail
+
+root="$(cd "$(dirname "$0")/.." && pwd)"
+scene="${1:-$root/benchmarks/lod_distance.txt}"
+shift || true
+settings=("${@:-0 0.5 1 2 4}")
+binary="${MY_GAMES:-$root/build/my_games}"
+args=(--headless ${MY_GAMES_ARGS:-})
+out="$(mktemp -d)"
+trap 'rm -rf "$out"' EXIT
+
+for pixels in ${settings[@]}; do
+    "$binary" "${args[@]}" --lod "$pixels" --benchmark "$scene" --out "$out/lod_$pixels.json" > /dev/null 2>&1
+done
+
+python3 - "$out" ${settings[@]} <<'PY'
+import json, sys
+out, settings = sys.argv[1], sys.argv[2:]
+print(f"{'lod px':<8}{'triangles':>12}{'cpu mean':>10}{'cpu p95':>10}{'gpu mean':>10}{'gpu p95':>10}{'load ms':>10}")
+for pixels in settings:
+    report = json.load(open(f"{out}/lod_{pixels}.json"))
+    m = report["metrics"]
+    name = "off" if float(pixels) == 0 else pixels
+    print(f"{name:<8}{m['triangles']['mean']:>12.0f}{m['cpu_ms']['mean']:>10.3f}{m['cpu_ms']['p95']:>10.3f}"
+          f"{m['gpu_ms']['mean']:>10.3f}{m['gpu_ms']['p95']:>10.3f}{report['load_ms']:>10.1f}")
+PY
@@ -0,0 +1,81 @@
+#!/usr/bin/env bash
+# Profile guided build of my_games.
+#
+#   1. builds a plain release + LTO binary as the baseline
+#   2. builds an instrumented binary and runs the headless training scene with it
+#   3. rebuilds with the collected profile + LTO
+#   4. benchmarks baseline and optimized binary on the same scene and prints both
+#
+# usage: scripts/pgo_build.sh [build directory] [training scene] [measured scene]
+# extra arguments for my_games (e.g. --software) can be passed in MY_GAMES_ARGS
+
+set -euo pipefail
+
+root="$(cd "$(dirname "$0")/.." && pwd)"
+build="$(mkdir -p "${1:-$root/build-pgo}" && cd "${1:-$root/build-pgo}" && pwd)"
+training="${2:-$root/benchmarks/pgo_training.txt}"
+measured="${3:-$training}"
+runs="${PGO_RUNS:-3}"
+args=(--headless ${MY_GAMES_ARGS:-})
+
+jobs="$(nproc 2>/dev/null || echo 2)"
+profiles="$build/profiles"
+common=(-DCMAKE_BUILD_TYPE=Release -DMY_GAMES_ENABLE_LTO=ON -DMY_GAMES_BUILD_TESTS=OFF -DMY_GAMES_BUILD_BENCHMARKS=OFF)
+
+configure_and_build()
+{
+    cmake -S "$root" -B "$1" "${common[@]}" "${@:2}" > /dev/null
+    cmake --build "$1" --target my_games -j"$jobs" > /dev/null
+}
+
+# runs the measured scene $runs times and keeps the report with the lowest mean CPU time
+measure()
+{
+    local binary="$1" out="$2" best="" best_mean=""
+    for i in $(seq "$runs"); do
+        "$binary" "${args[@]}" --benchmark "$measured" --out "$out.$i" > /dev/null 2>&1
+        local mean
+        mean="$(python3 -c "import json,sys; print(json.load(open(sys.argv[1]))['metrics']['cpu_ms']['mean'])" "$out.$i")"
+        if [ -z "$best" ] || python3 -c "import sys; sys.exit(0 if float(sys.argv[1]) < float(sys.argv[2]) else 1)" "$mean" "$best_mean"; then
+            best="$out.$i"
+            best_mean="$mean"
+        fi
+    done
+    cp "$best" "$out"
+}
+
+echo "== baseline (release + LTO)"
+configure_and_build "$build/baseline" -DMY_GAMES_PGO=OFF
+
+echo "== instrumented build"
+rm -rf "$profiles"
+mkdir -p "$profiles"
+# GCC names the profiles after the object files, so generate and use share one build tree
+configure_and_build "$build/pgo" -DMY_GAMES_PGO=GENERATE -DMY_GAMES_PGO_DIR="$profiles"
+
+echo "== training run: $training"
+"$build/pgo/my_games" "${args[@]}" --benchmark "$training" --out "$build/training.json" > /dev/null 2>&1
+
+if ls "$profiles"/*.profraw > /dev/null 2>&1; then
+    llvm-profdata merge -output="$profiles/my_games.profdata" "$profiles"/*.profraw
+fi
+
+echo "== optimized build (profile + LTO)"
+configure_and_build "$build/pgo" -DMY_GAMES_PGO=USE -DMY_GAMES_PGO_DIR="$profiles"
+
+echo "== measuring: $measured ($runs runs each, best mean kept)"
+measure "$build/baseline/my_games" "$build/baseline.json"
+measure "$build/pgo/my_games" "$build/pgo.json"
+
+python3 - "$build/baseline.json" "$build/pgo.json" <<'PY'
+import json, sys
+base, pgo = (json.load(open(path)) for path in sys.argv[1:3])
+def row(name, a, b):
+    gain = (a - b) / a * 100.0 if a else 0.0
+    print(f"{name:<16}{a:>12.3f}{b:>12.3f}{gain:>+10.1f}%")
+print(f"{'':<16}{'baseline':>12}{'pgo':>12}{'gain':>11}")
+row("load_ms", base["load_ms"], pgo["load_ms"])
+for metric in ("cpu_ms", "gpu_ms"):
+    for stat in ("mean", "p95", "p99"):
+        row(f"{metric} {stat}", base["metrics"][metric][stat], pgo["metrics"][metric][stat])
+PY
@@ -0,0 +1,141 @@
+// Shared lighting library for the lit fragment shaders, pulled in with
+// #include "lighting.glsl" by the shader preprocessor.
+#pragma once
+
+struct Material {
+    sampler2D texture_diffuse1;
+    sampler2D texture_specular1;
+    sampler2D texture_emission1;
+
+    float shine;
+    vec3 emission;
+    vec3 specular;
+};
+struct DirLight {
+    vec3 direction;
+
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+};
+struct PointLight
+{
+    vec3 position;
+
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+
+    vec3 attenuation;
+};
+struct SpotLight
+{
+    int isOn;
+    vec3 position;
+    vec3 direction;
+
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+
+    vec3 attenuation;
+    float innerCone;
+    float outerCone;
+};
+
+// can be overridden per program permutation
+#ifndef NR_MAX_POINT_LIGHTS
+#define NR_MAX_POINT_LIGHTS 100
+#endif
+#ifndef NR_MAX_SPOT_LIGHTS
+#define NR_MAX_SPOT_LIGHTS 100
+#endif
+
+// material textures sampled once per fragment instead of once per light
+struct Surface
+{
+    vec3 diffuse;
+    vec3 specular;
+    float shine;
+};
+
+Surface SampleSurface(Material material, vec2 texCoords)
+{
+    Surface surface;
+    surface.diffuse = vec3(texture(material.texture_diffuse1, texCoords));
+    surface.specular = vec3(texture(material.texture_specular1, texCoords));
+    surface.shine = material.shine;
+    return surface;
+}
+
+vec3 CalculateDirLight(DirLight light, Surface surface, vec3 normal, vec3 viewDir)
+{
+    vec3 lightDir = normalize(-light.direction);
+    // diffuse shading
+    float diff = max(dot(normal, lightDir), 0.0);
+    // specular shading
+    vec3 reflectDir = reflect(-lightDir, normal);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), surface.shine);
+    // combine results
+    return (light.ambient + light.diffuse * diff) * surface.diffuse + light.specular * spec * surface.specular;
+}
+
+vec3 CalculatePointLight(PointLight light, Surface surface, vec3 normal, vec3 fragPos, vec3 viewDir)
+{
+    vec3 lightDir = normalize(light.position - fragPos);
+    // diffuse shading
+    float diff = max(dot(normal, lightDir), 0.0);
+    // specular shading
+    vec3 reflectDir = reflect(-lightDir, normal);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), surface.shine);
+    // combine results
+    return (light.ambient + light.diffuse * diff) * surface.diffuse + light.specular * spec * surface.specular;
+}
+
+vec3 CalculateSpotLight(SpotLight light, Surface surface, vec3 normal, vec3 fragPos, vec3 viewDir)
+{
+    vec3 toLight = light.position - fragPos;
+    float distance = length(toLight);
+    vec3 lightDir = toLight / distance;
+    float theta = dot(lightDir, normalize(-light.direction));
+
+    // calculate attenuation
+    float attenuation = 1.0 / (light.attenuation.x + light.attenuation.y * distance +
+                                light.attenuation.z * (distance * distance));
+
+    if (theta > light.outerCone)
+    {
+        // in flashlight, do calculations
+        float epsilon = light.innerCone - light.outerCone;
+        float intensity = clamp((theta - light.outerCone) / epsilon, 0.0, 1.0);
+        // diffuse shading
+        float diff = max(dot(normal, lightDir), 0.0);
+        // specular shading
+        vec3 reflectDir = reflect(-lightDir, normal);
+        float spec = pow(max(dot(viewDir, reflectDir), 0.0), surface.shine);
+
+        // combine results
+        vec3 ambient = light.ambient * surface.diffuse;
+        vec3 diffuse = light.diffuse * diff * surface.diffuse;
+        vec3 specular = light.specular * spec * surface.specular;
+        return attenuation * (ambient + intensity * (diffuse + specular));
+    }
+    else
+        // outside flashlight: only calculate ambient light
+        return attenuation * light.ambient * surface.diffuse;
+}
+
+vec3 CalculateReflection(vec3 norm, vec3 fragPos, vec3 cameraPos, samplerCube skybox)
+{
+    vec3 I = normalize(fragPos - cameraPos);
+    vec3 R = reflect(I, norm);
+    return texture(skybox, R).rgb;
+}
+
+vec3 CalculateRefraction(vec3 norm, vec3 fragPos, vec3 cameraPos, samplerCube skybox, float refractiveIndex)
+{
+    float ratio = 1.00 / refractiveIndex;
+    vec3 I = normalize(fragPos - cameraPos);
+    vec3 R = refract(I , norm, ratio);
+    return texture(skybox, R).rgb;
+}
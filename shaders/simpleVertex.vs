@@ -1,10 +1,40 @@
 #version 330 core
 
 layout (location = 0) in vec3 aPos;
-layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoords;
 
+#ifdef PACKED_VERTICES
+// see VertexPacking: positions are unorm16 inside the mesh's bounds (or floats with a
+// scale of 1), normals octahedral xy, 2_10_10_10 or float xyz, set per mesh
+layout (location = 1) in vec4 aNormal;
+uniform vec3 positionScale;
+uniform vec3 positionOffset;
+uniform bool octahedralNormals;
+
+vec3 decodeOctahedral(vec2 e)
+{
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    if (n.z < 0.0)
+    {
+        n.xy = (1.0 - abs(e.yx)) * vec2(e.x >= 0.0 ? 1.0 : -1.0, e.y >= 0.0 ? 1.0 : -1.0);
+    }
+    return normalize(n);
+}
+#else
+layout (location = 1) in vec3 aNormal;
+#endif
+
+#ifdef INSTANCED
+// per instance attributes streamed every frame, see Mesh::DrawInstanced
+layout (location = 3) in mat4 instanceModel;
+layout (location = 7) in mat3 instanceNormalMatrix;
+#define model instanceModel
+#define normalMatrix instanceNormalMatrix
+#else
 uniform mat4 model;
+// transpose(inverse(mat3(model))), computed once per instance on the CPU
+uniform mat3 normalMatrix;
+#endif
 uniform mat4 view;
 uniform mat4 projection;
 
@@ -14,8 +44,16 @@ out vec2 TexCoords;
 
 void main()
 {
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
-    FragPos = vec3(model * vec4(aPos, 1.0));
-    Normal = mat3(transpose(inverse(model))) * aNormal;
+#ifdef PACKED_VERTICES
+    vec3 position = positionOffset + positionScale * aPos;
+    vec3 normal = octahedralNormals ? decodeOctahedral(aNormal.xy) : aNormal.xyz;
+#else
+    vec3 position = aPos;
+    vec3 normal = aNormal;
+#endif
+    vec4 worldPos = model * vec4(position, 1.0);
+    gl_Position = projection * view * worldPos;
+    FragPos = vec3(worldPos);
+    Normal = normalMatrix * normal;
     TexCoords = aTexCoords;
 }
\ No newline at end of file
@@ -10,5 +10,12 @@ void main()
 {
     TexCoords = aPos;
     vec4 pos = projection * view * vec4(aPos, 1.0);
+    // put the sky at the far depth, behind everything else
+#if defined(REVERSED_Z) && defined(CLIP_ZERO_TO_ONE)
+    gl_Position = vec4(pos.xy, 0.0, pos.w);
+#elif defined(REVERSED_Z)
+    gl_Position = vec4(pos.xy, -pos.w, pos.w);
+#else
     gl_Position = pos.xyww;
-}
\ No newline at end of file
+#endif
+}
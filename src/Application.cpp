@@ -1,4 +1,7 @@
 #include "Application.h"
+#include "Profiler.h"
+#include "RenderStats.h"
+#include "ShaderCache.h"
 
 #define TINYOBJLOADER_IMPLEMENTATION
 #include "tiny_obj_loader.h"
@@ -9,26 +12,286 @@
 // configuration options
 // #define CULL_FACES 
 
-Application::Application(const std::string &shaderDirectory, const std::string &resourceDirectory)
-    : resourceDir(resourceDirectory), shaderDir(shaderDirectory), camera(Camera_Type::FREE_CAMERA, glm::vec3(0.0f, 0.0f, 3.0f))
+Application::Application(const std::string &shaderDirectory, const std::string &resourceDirectory,
+                         const WindowSettings &settings, const RenderSettings &render)
+    : resourceDir(resourceDirectory), shaderDir(shaderDirectory), camera(Camera_Type::FREE_CAMERA, glm::vec3(0.0f, 0.0f, 3.0f)),
+      simulationCamera(camera),
+      width(settings.width), height(settings.height), lastX(settings.width / 2.0f), lastY(settings.height / 2.0f),
+      reversedZ(settings.reversedZ),
+      lodPixelError(render.lodPixelError), meshletCulling(render.meshletCulling), modelImport(render.modelImport)
 {
+    modelImport.generateLods = lodPixelError > 0.0f;
+    modelImport.meshlets = meshletCulling;
     windowManager = new WindowManager();
-    windowManager->init(SCR_WIDTH, SCR_HEIGHT, PROJECT_NAME.c_str());
+    if (!windowManager->init(settings, PROJECT_NAME.c_str()))
+    {
+        std::cerr << "Failed to create an OpenGL context" << std::endl;
+        std::exit(EXIT_FAILURE);
+    }
     windowManager->setEventCallbacks(this);
+    Profiler::get().setPresentLatency(windowManager->getPresentLatency());
     this->init();
 }
 
 void Application::run(std::function<void()> initFunc, std::function<void()> loopFunc)
 {
     initFunc();
-    while (!glfwWindowShouldClose(windowManager->getHandle()))
+    startSimulation();
+    if (renderThreaded)
+    {
+        runThreaded(loopFunc);
+    }
+    else
     {
+        while (!windowManager->shouldClose())
+        {
+            Profiler::get().beginFrame();
+            RenderStats::reset();
+            // the previous swap already waited for the GPU and the frame limit,
+            // so input is sampled as late as possible
+            pollInput();
+            FrameData frame;
+            {
+                PROFILE_SCOPE("Update");
+                updateVars();
+                loopFunc();
+                frame = captureFrame();
+                updateScene(frame);
+            }
+            Profiler::get().markInput(frame.inputTime);
+            render(frame);
+            
+            {
+                PROFILE_SCOPE("Swap");
+                windowManager->swapBuffers();
+            }
+            Profiler::get().endFrame();
+        }
+    }
+    simulationThread.stop();
+}
+
+void Application::runThreaded(std::function<void()> loopFunc)
+{
+    // the render thread owns the context until the loop ends
+    windowManager->releaseContext();
+    renderThread.start([this]() { windowManager->makeContextCurrent(); },
+                       [this]() { windowManager->releaseContext(); });
+
+    while (!windowManager->shouldClose())
+    {
+        if (windowManager->getSettings().lowLatency)
+        {
+            renderThread.waitIdle();
+        }
+        // GLFW wants events handled on the main thread
+        pollInput();
         updateVars();
         loopFunc();
-        render();
-        
-        glfwSwapBuffers(windowManager->getHandle());
-        glfwPollEvents();
+
+        // the command only reads its copy of the frame, the game state belongs to the next one
+        renderThread.commands().push([this, frame = captureFrame()]()
+        {
+            Profiler::get().beginFrame();
+            Profiler::get().markInput(frame.inputTime);
+            RenderStats::reset();
+            {
+                PROFILE_SCOPE("Update");
+                updateScene(frame);
+            }
+            render(frame);
+            {
+                PROFILE_SCOPE("Swap");
+                windowManager->swapBuffers();
+            }
+            Profiler::get().endFrame();
+        });
+        // only waits if the render thread is still busy with the previous frame
+        renderThread.submit();
+    }
+
+    renderThread.stop();
+    windowManager->makeContextCurrent();
+
+    std::cout << "Frame pacing: ";
+    renderThread.getStats().print(std::cout);
+}
+
+void Application::pollInput()
+{
+    PROFILE_SCOPE("Input");
+    windowManager->pollEvents();
+    inputTime = std::chrono::steady_clock::now();
+}
+
+void Application::requestClose()
+{
+    windowManager->setShouldClose(true);
+}
+
+void Application::setSimulationSettings(const SimulationSettings &settings)
+{
+    simulationSettings = settings;
+}
+
+void Application::setSimulationCallback(std::function<void(float)> callback)
+{
+    simulationCallback = callback;
+}
+
+void Application::setRenderThreaded(bool threaded)
+{
+    renderThreaded = threaded;
+}
+
+void Application::enqueueRenderCommand(std::function<void()> command)
+{
+    if (renderThread.isRunning())
+    {
+        renderThread.commands().push(command);
+    }
+    else
+    {
+        command();
+    }
+}
+
+FramePacingStats Application::getFramePacing()
+{
+    return renderThread.getStats();
+}
+
+void Application::startSimulation()
+{
+    timestep = FixedTimestep(simulationSettings.step, simulationSettings.maxSteps);
+    currentState = SimulationState();
+    currentState.cameraPosition = camera.getPosition();
+    previousState = currentState;
+    simulationCamera = camera;
+
+    if (simulationSettings.threaded)
+    {
+        simulationThread.start(currentState, simulationSettings,
+            [this](SimulationState &state, double step) { stepSimulation(state, step); });
+    }
+}
+
+void Application::stepSimulation(SimulationState &state, double step)
+{
+    {
+        std::lock_guard<std::mutex> lock(inputMutex);
+        state.cameraPosition = simulationCamera.integrate(state.cameraPosition, (float) step);
+    }
+    if (simulationCallback)
+    {
+        simulationCallback((float) step);
+    }
+}
+
+void Application::simulate(float frameTime)
+{
+    PROFILE_SCOPE("Simulation");
+
+    // hand this frame's input to the simulation
+    {
+        std::lock_guard<std::mutex> lock(inputMutex);
+        simulationCamera = camera;
+    }
+
+    SimulationState state;
+    if (simulationThread.isRunning())
+    {
+        state = simulationThread.read();
+    }
+    else
+    {
+        int steps = timestep.advance(frameTime);
+        for (int i = 0; i < steps; i++)
+        {
+            previousState = currentState;
+            stepSimulation(currentState, timestep.getStep());
+            currentState.time += timestep.getStep();
+            currentState.step++;
+        }
+        state = interpolate(previousState, currentState, timestep.getAlpha());
+    }
+
+    camera.setCameraPos(state.cameraPosition);
+}
+
+bool Application::runBenchmark(Benchmark &benchmark)
+{
+    auto loadStart = std::chrono::steady_clock::now();
+    for (const BenchmarkModel &benchmarkModel : benchmark.getModels())
+    {
+        Model *model = addModel(benchmarkModel.path, benchmarkModel.shader);
+        if (model && !benchmarkModel.instances.empty())
+        {
+            model->model_matrices = benchmarkModel.instances;
+        }
+    }
+    benchmark.setLoadTime(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - loadStart).count());
+
+    // input would make the run non-deterministic
+    keybinds.clear();
+
+    const int totalFrames = benchmark.getWarmupFrames() + benchmark.getFrames();
+    int frame = 0;
+    for (; frame < totalFrames && !windowManager->shouldClose(); frame++)
+    {
+        Profiler::get().beginFrame();
+        benchmark.beginFrame(frame);
+
+        deltaTime = benchmark.getDeltaTime();
+        lastFrame += deltaTime;
+        FrameData frameData;
+        {
+            PROFILE_SCOPE("Update");
+            benchmark.applyCamera(camera, frame);
+            frameData = captureFrame();
+            updateScene(frameData);
+        }
+        render(frameData);
+
+        benchmark.endFrame();
+        {
+            PROFILE_SCOPE("Swap");
+            windowManager->swapBuffers();
+        }
+        windowManager->pollEvents();
+        Profiler::get().endFrame();
+    }
+    benchmark.finish();
+
+    return frame == totalFrames;
+}
+
+void Application::recordCameraPath(const std::string &fileName)
+{
+    recordFile = fileName;
+    recordedPath = CameraPath();
+}
+
+void Application::recordCamera()
+{
+    // a key every quarter second is plenty for the spline to follow the path
+    const float recordInterval = 0.25f;
+    if (recordFile.empty())
+    {
+        return;
+    }
+    // the path starts with the first recorded frame
+    if (recordedPath.empty())
+    {
+        recordStart = lastFrame;
+        nextRecordTime = 0.0f;
+    }
+
+    float time = lastFrame - recordStart;
+    if (time >= nextRecordTime)
+    {
+        recordedPath.addKey(CameraKey{time, camera.getPosition(), camera.getYaw(), camera.getPitch()});
+        nextRecordTime = time + recordInterval;
     }
 }
 
@@ -65,7 +328,7 @@ void Application::setKeyBind(int key, std::function<void(int)> func)
 
 void Application::setCameraType(Camera_Type type)
 {
-    camera.Type = type;
+    camera.setType(type);
 }
 
 void Application::setKeyBindSet(Camera_Type type)
@@ -73,10 +336,18 @@ void Application::setKeyBindSet(Camera_Type type)
     switch (type)
     {
         case Camera_Type::FIRST_PERSON:
-            // TODO: implement first person camera controls
-            break;
         case Camera_Type::THIRD_PERSON:
-            // TODO: implement third person camera controls
+            // walking: the camera (or the character it follows) stays on the ground plane
+            setKeyBind(GLFW_KEY_W, [&](int action) { if (action == GLFW_PRESS) camera.addMotion(glm::vec3(0.0f, 0.0f, -1.0f));
+                                                     if (action == GLFW_RELEASE) camera.addMotion(glm::vec3(0.0f, 0.0f, 1.0f)); });
+            setKeyBind(GLFW_KEY_S, [&](int action) { if (action == GLFW_PRESS) camera.addMotion(glm::vec3(0.0f, 0.0f, 1.0f));
+                                                     if (action == GLFW_RELEASE) camera.addMotion(glm::vec3(0.0f, 0.0f, -1.0f)); });
+            setKeyBind(GLFW_KEY_A, [&](int action) { if (action == GLFW_PRESS) camera.addMotion(glm::vec3(-1.0f, 0.0f, 0.0f));
+                                                     if (action == GLFW_RELEASE) camera.addMotion(glm::vec3(1.0f, 0.0f, 0.0f)); });
+            setKeyBind(GLFW_KEY_D, [&](int action) { if (action == GLFW_PRESS) camera.addMotion(glm::vec3(1.0f, 0.0f, 0.0f));
+                                                     if (action == GLFW_RELEASE) camera.addMotion(glm::vec3(-1.0f, 0.0f, 0.0f)); });
+            keybinds.erase(GLFW_KEY_SPACE);
+            keybinds.erase(GLFW_KEY_V);
             break;
         case Camera_Type::FREE_CAMERA:
             setKeyBind(GLFW_KEY_W, [&](int action) { if (action == GLFW_PRESS) camera.addMotion(glm::vec3(0.0f, 0.0f, -1.0f));
@@ -99,7 +370,21 @@ void Application::keyCallback(GLFWwindow *window, int key, int scancode, int act
 {
     if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS)
     {
-        glfwSetWindowShouldClose(window, GL_TRUE);
+        windowManager->setShouldClose(true);
+        return;
+    }
+    if (key == GLFW_KEY_P && action == GLFW_PRESS)
+    {
+        // the profiler belongs to the thread rendering the frames
+        enqueueRenderCommand([this]()
+        {
+            Profiler::get().print(std::cout);
+            if (renderThread.isRunning())
+            {
+                std::cout << "Frame pacing: ";
+                renderThread.getStats().print(std::cout);
+            }
+        });
         return;
     }
     
@@ -196,15 +481,24 @@ void Application::mouseCallback(GLFWwindow *window, int button, int action, int
 
 void Application::scrollCallback(GLFWwindow *window, double in_deltaX, double in_deltaY)
 {
-    camera.adjustZoom(in_deltaY);
+    if (camera.getType() == Camera_Type::THIRD_PERSON)
+    {
+        camera.adjustFollowDistance((float) in_deltaY);
+    }
+    else
+    {
+        camera.adjustZoom((float) in_deltaY);
+    }
 }
 
-void Application::resizeCallback(GLFWwindow *window, int width, int height)
+void Application::resizeCallback(GLFWwindow *window, int in_width, int in_height)
 {
-    CHECKED_GL_CALL(glViewport(0, 0, width, height));
+    // render() sets the viewport, this may not be the thread that owns the context
+    width = in_width;
+    height = in_height;
 }
 
-void Application::initializeShader(const std::string &shaderName, bool verbose, const std::string &vertexShader, const std::string &fragmentShader, const std::vector<std::string> &attributes)
+void Application::initializeShader(const std::string &shaderName, bool verbose, const std::string &vertexShader, const std::string &fragmentShader, const std::vector<std::string> &attributes, const std::vector<std::string> &defines)
 {
     if (shaders.find(shaderName) != shaders.end())
     {
@@ -216,7 +510,12 @@ void Application::initializeShader(const std::string &shaderName, bool verbose,
 
     prog.setVerbose(verbose);
     prog.setShaderNames(shaderDir + vertexShader, shaderDir + fragmentShader);
-    prog.init();
+    for (const std::string &define : defines)
+    {
+        prog.addDefine(define);
+    }
+    // only submitted here, compile/link status is checked when the program is first bound
+    prog.submit();
     for (const auto &attribute : attributes)
     {
         prog.addAttribute(attribute);
@@ -234,9 +533,32 @@ void Application::init()
 
     GLSL::checkVersion();
 
-    // enable z-buffer
+    // linked program binaries are cached next to the shader sources
+    ShaderCache::setDirectory(shaderDir + "/.cache");
+
+    // enable z-buffer, the sky is drawn at exactly the far depth so the tests include equality
     CHECKED_GL_CALL(glEnable(GL_DEPTH_TEST));
-    glDepthFunc(GL_LEQUAL); 
+    if (reversedZ)
+    {
+        // the near plane is at depth 1 and the far plane, at infinity, at 0. With
+        // glClipControl all of [0, 1] holds that range, without it only [0.5, 1] does.
+        if (GLAD_GL_VERSION_4_5 && glClipControl)
+        {
+            CHECKED_GL_CALL(glClipControl(GL_LOWER_LEFT, GL_ZERO_TO_ONE));
+            clipZeroToOne = true;
+        }
+        else
+        {
+            std::cerr << "glClipControl is not available, reversed-Z loses half of the depth range" << std::endl;
+        }
+        glDepthFunc(GL_GEQUAL);
+        glClearDepth(0.0);
+        camera.setReversedZ(true);
+    }
+    else
+    {
+        glDepthFunc(GL_LEQUAL);
+    }
     
     // enable stencil buffer
     glEnable(GL_STENCIL_TEST);
@@ -256,11 +578,17 @@ void Application::init()
 
     std::vector<std::string>attributes;
 
-    // initialize default shader programs
+    // initialize default shader programs, all of them are submitted before any
+    // assets are loaded so the driver can compile while textures are decoded
 
     // // Initialize the GLSL program that we will use for local shading
     attributes = {"aPos", "aNormal", "aTexCoords"};
-    initializeShader("default", true, "/simpleVertex.vs", "/simpleFragment.fs", attributes);
+    std::vector<std::string> defaultDefines = {"INSTANCED"};
+    if (modelImport.packVertices)
+    {
+        defaultDefines.push_back("PACKED_VERTICES");
+    }
+    initializeShader("default", true, "/simpleVertex.vs", "/simpleFragment.fs", attributes, defaultDefines);
     
     // // Initialize shader for light sources
     // attributes = {"aPos"};
@@ -280,7 +608,16 @@ void Application::init()
     
     // // Initialize shader for skybox rendering
     attributes = {"aPos"};
-    initializeShader("skyboxShader", true, "/skyboxShader.vs", "/skyboxShader.fs", attributes);
+    std::vector<std::string> skyDefines;
+    if (reversedZ)
+    {
+        skyDefines.push_back("REVERSED_Z");
+    }
+    if (clipZeroToOne)
+    {
+        skyDefines.push_back("CLIP_ZERO_TO_ONE");
+    }
+    initializeShader("skyboxShader", true, "/skyboxShader.vs", "/skyboxShader.fs", attributes, skyDefines);
 
     // // Initialize shader for reflective objects
     // attributes = {"aPos", "aNormal"};
@@ -290,12 +627,56 @@ void Application::init()
     // attributes = {"aPos", "aNormal", "aTexCoords"};
     // initializeShader(chameleonShader, true, "/simpleVertex.vs", "/chameleonShader.fs", attributes);
 
+    // shader hot-reload
+    shaderWatcher.start(shaderDir);
+
+    // 1 MB per frame is a matrix pair for about 10000 instances
+    if (!frameStream.init(1 << 20))
+    {
+        std::cerr << "Stream buffer unavailable, drawing instances one by one" << std::endl;
+    }
+
     initSky();
     initGeom();
 }
 
+void Application::reloadShaders()
+{
+    PROFILE_SCOPE("ShaderReload");
+    // start rebuilding every program that uses a changed file
+    for (const std::string &path : shaderWatcher.pollChanges())
+    {
+        for (auto &shader : shaders)
+        {
+            if (shader.second.usesFile(path))
+            {
+                std::cout << "Reloading shader " << shader.first << std::endl;
+                shader.second.reload();
+            }
+        }
+    }
+
+    // swap in the programs the driver has finished with, this never stalls the frame
+    for (auto &shader : shaders)
+    {
+        if (shader.second.isReloading() && shader.second.isReady())
+        {
+            if (!shader.second.finish())
+            {
+                std::cerr << "Reloading shader " << shader.first << " failed, keeping the previous program" << std::endl;
+            }
+        }
+    }
+}
+
 Model *Application::addModel(const std::string &modelPath, const std::string &shaderName) 
 {
+    // the render thread owns the context, and the frames it draws list the models
+    if (renderThread.isRunning())
+    {
+        std::cerr << "Cannot add model " << modelPath << " while the render thread runs" << std::endl;
+        return nullptr;
+    }
     if (shaders.find(shaderName) == shaders.end())
     {
         std::cerr << "Shader not found: " << shaderName << std::endl;
@@ -304,7 +685,11 @@ Model *Application::addModel(const std::string &modelPath, const std::string &sh
 
     Program &shader = shaders[shaderName];
 
-    Model *model = new Model(resourceDir + modelPath);
+    // only shaders that decode packed vertices get them. Models of the same file
+    // and options share their meshes, each has its own instances and materials.
+    ModelImportOptions options = modelImport;
+    options.packVertices = shader.hasDefine("PACKED_VERTICES");
+    Model *model = new Model(ModelRegistry::acquire(resourceDir + modelPath, options));
 
     shader.models.push_back(model);
 
@@ -316,20 +701,29 @@ void Application::initGeom()
     Model *model;
     stbi_set_flip_vertically_on_load(false);
 
-    // setup FBO
+    // setup FBO, in headless mode or with reversed-Z this is the render target
     glGenFramebuffers(1, &fbo);
-    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
-    // setup FBO texture
     glGenTextures(1, &frame_texture);
     glBindTexture(GL_TEXTURE_2D, frame_texture);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, SCR_WIDTH, SCR_HEIGHT, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, frame_texture, 0);
-    // setup RBO
     glGenRenderbuffers(1, &rbo);
+    resizeFramebuffer(width, height);
+}
+
+void Application::resizeFramebuffer(int newWidth, int newHeight)
+{
+    framebufferWidth = newWidth;
+    framebufferHeight = newHeight;
+
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    // setup FBO texture
+    glBindTexture(GL_TEXTURE_2D, frame_texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, newWidth, newHeight, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, frame_texture, 0);
+    // setup RBO, reversed-Z only gains precision with a float depth buffer
     glBindRenderbuffer(GL_RENDERBUFFER, rbo);
-    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, SCR_WIDTH, SCR_HEIGHT);
+    glRenderbufferStorage(GL_RENDERBUFFER, reversedZ ? GL_DEPTH32F_STENCIL8 : GL_DEPTH24_STENCIL8, newWidth, newHeight);
     glBindRenderbuffer(GL_RENDERBUFFER, 0); // unbind rbo
 
     glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, rbo);
@@ -449,8 +843,11 @@ void Application::drawGround(std::shared_ptr<Program> &curS)
     glBindVertexArray(0);
 }
 
-void Application::setLightUniforms(Program &prog)
+void Application::setLightUniforms(Program &prog, const FrameData &frame)
 {
+    const DirLight &directionalLight = frame.directionalLight;
+    const std::vector<PointLight> &pointLights = frame.pointLights;
+    const std::vector<SpotLight> &spotLights = frame.spotLights;
     prog.bind();
     // set directional light uniforms
     prog.setVector3f("dirLight.direction", directionalLight.direction);
@@ -492,14 +889,20 @@ void Application::setLightUniforms(Program &prog)
 
 void Application::updateVars()
 {
-    float currentFrame = glfwGetTime();
+    float currentFrame = windowManager->getTime();
     deltaTime = currentFrame - lastFrame;
     lastFrame = currentFrame;
 
-    camera.move(deltaTime);
+    simulate(deltaTime);
+    recordCamera();
+}
+
+void Application::updateScene(const FrameData &frame)
+{
+    reloadShaders();
 
     // move legs
-    setLightUniforms(shaders["default"]);
+    setLightUniforms(shaders["default"], frame);
     // setLightUniforms(chameleonShader);
     // chameleonShader->bind();
     // chameleonShader->setVector3f("coloring", glm::vec3(0.0f, 1.0f * mixRatio, 1.0f * (1.0f - mixRatio)));
@@ -519,6 +922,7 @@ void enableStencil()
 
 void Application::drawSky(glm::mat4 view, glm::mat4 projection)
 {
+    PROFILE_SCOPE("Sky");
     Program &skyboxShader = shaders["skyboxShader"];
     CHECKED_GL_CALL(glDepthMask(GL_FALSE));
     CHECKED_GL_CALL(glActiveTexture(GL_TEXTURE0 + skyboxTexture));
@@ -530,15 +934,26 @@ void Application::drawSky(glm::mat4 view, glm::mat4 projection)
     CHECKED_GL_CALL(glBindVertexArray(skyBoxVAO));
     CHECKED_GL_CALL(glBindTexture(GL_TEXTURE_CUBE_MAP, skyBoxTex));
     CHECKED_GL_CALL(glDrawArrays(GL_TRIANGLES, 0, 36));
+    RenderStats::addStateChange(2);
+    RenderStats::addDraw(12);
     skyboxShader.unbind();
     CHECKED_GL_CALL(glDepthMask(GL_TRUE));
     CHECKED_GL_CALL(glActiveTexture(GL_TEXTURE0));
 }
-void Application::drawScene(glm::mat4 view, glm::mat4 projection)
+void Application::drawScene(const FrameData &frame, glm::mat4 view, glm::mat4 projection)
 {
-    for (auto &shader : shaders)
+    PROFILE_SCOPE("Scene");
+    DrawView drawView;
+    drawView.viewPos = frame.viewPos;
+    drawView.pixelScale = lodPixelError > 0.0f ? projection[1][1] * frame.height * 0.5f : 0.0f;
+    drawView.pixelError = lodPixelError;
+    drawView.cullMeshlets = meshletCulling;
+    drawView.viewProjection = projection * view;
+    drawView.reversedZ = reversedZ;
+    for (const auto &models : frame.models)
     {
-        shader.second.drawModels(view, projection, camera.Position);
+        PROFILE_SCOPE("Models");
+        models.first->drawModels(view, projection, frame.viewPos, models.second, &frameStream, &drawView);
     }
     // prog->bind();
     // CHECKED_GL_CALL(glActiveTexture(GL_TEXTURE0 + skyboxTexture));
@@ -596,13 +1011,48 @@ void Application::drawScene(glm::mat4 view, glm::mat4 projection)
     drawSky(view, projection);
 }
 
-void Application::render()
+FrameData Application::captureFrame()
+{
+    FrameData frame;
+    frame.width = width;
+    frame.height = height;
+    camera.setViewport(width, height);
+    frame.projection = camera.GetProjectionMatrix();
+    frame.view = camera.GetViewMatrix();
+    frame.viewPos = camera.getEyePosition();
+    frame.inputTime = inputTime;
+
+    frame.directionalLight = directionalLight;
+    frame.pointLights = pointLights;
+    frame.spotLights = spotLights;
+    for (auto &shader : shaders)
+    {
+        if (shader.second.models.empty())
+        {
+            continue;
+        }
+        frame.models.emplace_back(&shader.second, std::vector<ModelSnapshot>());
+        std::vector<ModelSnapshot> &snapshots = frame.models.back().second;
+        snapshots.reserve(shader.second.models.size());
+        for (Model *model : shader.second.models)
+        {
+            snapshots.push_back(ModelSnapshot{model, model->model_matrices});
+        }
+    }
+    return frame;
+}
+
+void Application::render(const FrameData &frame)
 {
-    glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
+    PROFILE_SCOPE("Render");
+    frameStream.beginFrame();
+    // only frame may be read here, the game state already belongs to the next frame
+    glm::mat4 projection = frame.projection;
     glm::mat4 view;
     // first pass
     // if (show_rear_view)
     // {
+    //     PROFILE_SCOPE("RearView");
     //     glBindFramebuffer(GL_FRAMEBUFFER, fbo);
     //     glEnable(GL_DEPTH_TEST);
     //     glEnable(GL_STENCIL_TEST);
@@ -613,7 +1063,7 @@ void Application::render()
     //     camera.Reverse();
     //     view = camera.GetViewMatrix();
     //     camera.Reverse();
-    //     drawScene(view, projection);
+    //     drawScene(frame, view, projection);
     // }
 
     // texProg->bind();
@@ -635,14 +1085,23 @@ void Application::render()
     // }
     
     // second pass
-    glBindFramebuffer(GL_FRAMEBUFFER, 0); // default frame buffer
+    // there is no default frame buffer without a window, and the window's depth
+    // buffer is fixed point, so reversed-Z renders offscreen and blits the result
+    bool offscreen = windowManager->isHeadless() || reversedZ;
+    if (offscreen && frame.width > 0 && frame.height > 0 &&
+        (frame.width != framebufferWidth || frame.height != framebufferHeight))
+    {
+        resizeFramebuffer(frame.width, frame.height);
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, offscreen ? fbo : 0);
+    glViewport(0, 0, frame.width, frame.height);
     glEnable(GL_DEPTH_TEST);
     glEnable(GL_STENCIL_TEST);
     glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
 
-    view = camera.GetViewMatrix();
-    drawScene(view, projection);    // draw rearview mirror
+    view = frame.view;
+    drawScene(frame, view, projection);    // draw rearview mirror
 
     // if (show_rear_view)
     // {
@@ -656,16 +1115,34 @@ void Application::render()
     //     glBindTexture(GL_TEXTURE_2D, frame_texture);
     //     glDrawArrays(GL_TRIANGLES, 0, 6);
     // }   
+
+    if (offscreen && !windowManager->isHeadless())
+    {
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+        glBlitFramebuffer(0, 0, frame.width, frame.height, 0, 0, frame.width, frame.height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
 }
 
 void Application::shutdown()
 {
+    shaderWatcher.stop();
+    if (!recordFile.empty())
+    {
+        recordedPath.save(recordFile);
+    }
     glDeleteVertexArrays(1, &skyBoxVAO);
     glDeleteVertexArrays(1, &quadVAO);
     glDeleteVertexArrays(1, &planeVAO);
     glDeleteBuffers(1, &quadVBO);
     glDeleteBuffers(1, &planeVBO);
     glDeleteFramebuffers(1, &fbo);
+    glDeleteTextures(1, &frame_texture);
+    glDeleteRenderbuffers(1, &rbo);
+    frameStream.destroy();
+
+    windowManager->shutdown();
 }
 
 void Application::framebuffer_size_callback(GLFWwindow* window, int width, int height)
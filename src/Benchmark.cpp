@@ -0,0 +1,363 @@
+#include "Benchmark.h"
+#include "GLSL.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+namespace
+{
+    // uniform Catmull-Rom between p1 and p2
+    template <typename T>
+    T catmullRom(const T &p0, const T &p1, const T &p2, const T &p3, float t)
+    {
+        float t2 = t * t;
+        float t3 = t2 * t;
+        return 0.5f * ((2.0f * p1) +
+                       (p2 - p0) * t +
+                       (2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3) * t2 +
+                       (3.0f * p1 - p0 - 3.0f * p2 + p3) * t3);
+    }
+
+    struct Summary
+    {
+        double min = 0.0;
+        double mean = 0.0;
+        double p95 = 0.0;
+        double p99 = 0.0;
+    };
+
+    Summary summarize(std::vector<double> values)
+    {
+        Summary summary;
+        if (values.empty())
+        {
+            return summary;
+        }
+        std::sort(values.begin(), values.end());
+
+        double sum = 0.0;
+        for (double value : values)
+        {
+            sum += value;
+        }
+        // nearest-rank percentiles
+        auto percentile = [&](double p)
+        {
+            size_t rank = (size_t) std::ceil(p * values.size());
+            return values[std::min(std::max(rank, (size_t) 1), values.size()) - 1];
+        };
+
+        summary.min = values.front();
+        summary.mean = sum / values.size();
+        summary.p95 = percentile(0.95);
+        summary.p99 = percentile(0.99);
+        return summary;
+    }
+
+    void writeSummary(std::ostream &out, const char *name, const std::vector<double> &values, bool last = false)
+    {
+        Summary summary = summarize(values);
+        out << "    \"" << name << "\": {\"min\": " << summary.min << ", \"mean\": " << summary.mean
+            << ", \"p95\": " << summary.p95 << ", \"p99\": " << summary.p99 << "}" << (last ? "\n" : ",\n");
+    }
+}
+
+void CameraPath::addKey(const CameraKey &key)
+{
+    // keep the keys sorted by time
+    auto position = std::upper_bound(keys.begin(), keys.end(), key,
+        [](const CameraKey &a, const CameraKey &b) { return a.time < b.time; });
+    keys.insert(position, key);
+}
+
+CameraKey CameraPath::sample(float time) const
+{
+    if (keys.empty())
+    {
+        return CameraKey{time, glm::vec3(0.0f), YAW, PITCH};
+    }
+    if (time <= keys.front().time)
+    {
+        return keys.front();
+    }
+    if (time >= keys.back().time)
+    {
+        return keys.back();
+    }
+
+    size_t i = 1;
+    while (keys[i].time < time)
+    {
+        i++;
+    }
+    // the end points are repeated so the path starts and ends on a key
+    const CameraKey &k0 = keys[i >= 2 ? i - 2 : 0];
+    const CameraKey &k1 = keys[i - 1];
+    const CameraKey &k2 = keys[i];
+    const CameraKey &k3 = keys[std::min(i + 1, keys.size() - 1)];
+    float t = (time - k1.time) / (k2.time - k1.time);
+
+    CameraKey result;
+    result.time = time;
+    result.position = catmullRom(k0.position, k1.position, k2.position, k3.position, t);
+    result.yaw = catmullRom(k0.yaw, k1.yaw, k2.yaw, k3.yaw, t);
+    result.pitch = glm::clamp(catmullRom(k0.pitch, k1.pitch, k2.pitch, k3.pitch, t), PITCH_MIN, PITCH_MAX);
+    return result;
+}
+
+void CameraPath::apply(Camera &camera, float time) const
+{
+    CameraKey key = sample(time);
+    camera.setCameraPos(key.position);
+    camera.setOrientation(key.yaw, key.pitch);
+}
+
+bool CameraPath::save(const std::string &fileName) const
+{
+    std::ofstream out(fileName);
+    if (!out.is_open())
+    {
+        std::cerr << "Could not write camera path: '" << fileName << "'" << std::endl;
+        return false;
+    }
+    out << "# recorded camera path: key <t> <x> <y> <z> <yaw> <pitch>\n";
+    for (const CameraKey &key : keys)
+    {
+        out << "key " << key.time << " " << key.position.x << " " << key.position.y << " " << key.position.z
+            << " " << key.yaw << " " << key.pitch << "\n";
+    }
+    return true;
+}
+
+Benchmark::~Benchmark()
+{
+    if (queries[0] != 0)
+    {
+        glDeleteQueries(QUERY_COUNT, queries);
+    }
+}
+
+bool Benchmark::load(const std::string &fileName)
+{
+    std::ifstream in(fileName);
+    if (!in.is_open())
+    {
+        std::cerr << "Could not open benchmark scene: '" << fileName << "'" << std::endl;
+        return false;
+    }
+    sceneName = fileName;
+
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(in, line))
+    {
+        lineNumber++;
+        size_t comment = line.find('#');
+        if (comment != std::string::npos)
+        {
+            line.erase(comment);
+        }
+
+        std::istringstream words(line);
+        std::string command;
+        if (!(words >> command))
+        {
+            continue;
+        }
+
+        bool ok = true;
+        if (command == "frames")
+        {
+            ok = (bool) (words >> frames) && frames > 0;
+        }
+        else if (command == "warmup")
+        {
+            ok = (bool) (words >> warmupFrames) && warmupFrames >= 0;
+        }
+        else if (command == "dt")
+        {
+            ok = (bool) (words >> deltaTime) && deltaTime > 0.0f;
+        }
+        else if (command == "model")
+        {
+            BenchmarkModel model;
+            ok = (bool) (words >> model.path);
+            words >> model.shader;
+            models.push_back(model);
+        }
+        else if (command == "instance")
+        {
+            glm::vec3 position;
+            float scale = 1.0f;
+            float yaw = 0.0f;
+            ok = !models.empty() && (words >> position.x >> position.y >> position.z);
+            words >> scale >> yaw;
+            if (ok)
+            {
+                glm::mat4 instance = glm::translate(glm::mat4(1.0f), position);
+                instance = glm::rotate(instance, glm::radians(yaw), glm::vec3(0.0f, 1.0f, 0.0f));
+                instance = glm::scale(instance, glm::vec3(scale));
+                models.back().instances.push_back(instance);
+            }
+        }
+        else if (command == "key")
+        {
+            CameraKey key;
+            ok = (bool) (words >> key.time >> key.position.x >> key.position.y >> key.position.z >> key.yaw >> key.pitch);
+            if (ok)
+            {
+                path.addKey(key);
+            }
+        }
+        else
+        {
+            ok = false;
+        }
+
+        if (!ok)
+        {
+            std::cerr << fileName << ":" << lineNumber << ": invalid benchmark command '" << line << "'" << std::endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void Benchmark::applyCamera(Camera &camera, int frame) const
+{
+    if (!path.empty())
+    {
+        path.apply(camera, std::max(frame - warmupFrames, 0) * deltaTime);
+    }
+}
+
+void Benchmark::beginFrame(int frame)
+{
+    if (queries[0] == 0)
+    {
+        glGenQueries(QUERY_COUNT, queries);
+    }
+
+    currentFrame = frame - warmupFrames;
+    measuring = currentFrame >= 0;
+    RenderStats::reset();
+
+    if (measuring)
+    {
+        // the oldest query in the ring is reused, its result is almost always there by now
+        collectQuery(currentQuery, true);
+        queryFrame[currentQuery] = currentFrame;
+        queryActive[currentQuery] = true;
+        glBeginQuery(GL_TIME_ELAPSED, queries[currentQuery]);
+
+        cpuTimes.resize(currentFrame + 1, 0.0);
+        gpuTimes.resize(currentFrame + 1, 0.0);
+        counters.resize(currentFrame + 1);
+    }
+    frameStart = std::chrono::steady_clock::now();
+}
+
+void Benchmark::endFrame()
+{
+    if (!measuring)
+    {
+        return;
+    }
+
+    cpuTimes[currentFrame] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frameStart).count();
+    counters[currentFrame] = RenderStats::frame();
+
+    glEndQuery(GL_TIME_ELAPSED);
+    currentQuery = (currentQuery + 1) % QUERY_COUNT;
+    measuring = false;
+}
+
+void Benchmark::collectQuery(int index, bool wait)
+{
+    if (!queryActive[index])
+    {
+        return;
+    }
+    if (!wait)
+    {
+        GLint available = 0;
+        glGetQueryObjectiv(queries[index], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available)
+        {
+            return;
+        }
+    }
+
+    GLuint64 elapsed = 0;
+    glGetQueryObjectui64v(queries[index], GL_QUERY_RESULT, &elapsed);
+    gpuTimes[queryFrame[index]] = elapsed / 1.0e6;
+    queryActive[index] = false;
+}
+
+void Benchmark::finish()
+{
+    for (int i = 0; i < QUERY_COUNT; i++)
+    {
+        collectQuery(i, true);
+    }
+}
+
+bool Benchmark::writeReport(const std::string &fileName) const
+{
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(4);
+
+    std::vector<double> drawCalls, triangles, stateChanges;
+    for (const RenderStats::Counters &frame : counters)
+    {
+        drawCalls.push_back((double) frame.drawCalls);
+        triangles.push_back((double) frame.triangles);
+        stateChanges.push_back((double) frame.stateChanges);
+    }
+
+    const char *renderer = (const char *) glGetString(GL_RENDERER);
+    std::string escapedScene;
+    for (char c : sceneName)
+    {
+        if (c == '"' || c == '\\')
+        {
+            escapedScene += '\\';
+        }
+        escapedScene += c;
+    }
+
+    out << "{\n";
+    out << "  \"scene\": \"" << escapedScene << "\",\n";
+    out << "  \"renderer\": \"" << (renderer ? renderer : "") << "\",\n";
+    out << "  \"frames\": " << cpuTimes.size() << ",\n";
+    out << "  \"dt\": " << std::setprecision(6) << deltaTime << std::setprecision(4) << ",\n";
+    out << "  \"load_ms\": " << loadTime << ",\n";
+    out << "  \"metrics\": {\n";
+    writeSummary(out, "cpu_ms", cpuTimes);
+    writeSummary(out, "gpu_ms", gpuTimes);
+    writeSummary(out, "draw_calls", drawCalls);
+    writeSummary(out, "triangles", triangles);
+    writeSummary(out, "state_changes", stateChanges, true);
+    out << "  }\n";
+    out << "}\n";
+
+    if (fileName.empty())
+    {
+        std::cout << out.str();
+        return true;
+    }
+
+    std::ofstream file(fileName);
+    if (!file.is_open())
+    {
+        std::cerr << "Could not write benchmark report: '" << fileName << "'" << std::endl;
+        return false;
+    }
+    file << out.str();
+    return true;
+}
@@ -0,0 +1,275 @@
+#include "Camera.h"
+
+#include <cmath>
+
+#include "glm/gtc/matrix_transform.hpp"
+
+const glm::vec3 Camera::WorldUp = glm::vec3(0.0f, 1.0f, 0.0f);
+
+Frustum Frustum::fromMatrix(const glm::mat4 &m, bool reversedZ)
+{
+    // rows of the matrix, glm stores columns
+    glm::vec4 row[4];
+    for (int i = 0; i < 4; i++)
+    {
+        row[i] = glm::vec4(m[0][i], m[1][i], m[2][i], m[3][i]);
+    }
+
+    Frustum frustum;
+    frustum.planes[PLANE_LEFT] = row[3] + row[0];
+    frustum.planes[PLANE_RIGHT] = row[3] - row[0];
+    frustum.planes[PLANE_BOTTOM] = row[3] + row[1];
+    frustum.planes[PLANE_TOP] = row[3] - row[1];
+    if (reversedZ)
+    {
+        // z <= w at the near plane; z >= 0 would be the far plane, which is at infinity
+        frustum.planes[PLANE_NEAR] = row[3] - row[2];
+        frustum.planes[PLANE_FAR] = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+    }
+    else
+    {
+        frustum.planes[PLANE_NEAR] = row[3] + row[2];
+        frustum.planes[PLANE_FAR] = row[3] - row[2];
+    }
+    for (glm::vec4 &plane : frustum.planes)
+    {
+        float length = glm::length(glm::vec3(plane));
+        if (length > 0.0f)
+        {
+            plane /= length;
+        }
+    }
+    return frustum;
+}
+
+bool Frustum::intersectsSphere(const glm::vec3 &center, float radius) const
+{
+    for (const glm::vec4 &plane : planes)
+    {
+        if (glm::dot(glm::vec3(plane), center) + plane.w < -radius)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+Camera::Camera(Camera_Type type, glm::vec3 position, float yaw, float pitch)
+    : Motion(glm::vec3(0.0f)),
+      MovementSpeed(SPEED),
+      MouseSensitivity(SENSITIVITY),
+      Type(type),
+      Position(position),
+      Yaw(yaw),
+      Pitch(pitch),
+      Zoom(ZOOM),
+      FollowDistance(FOLLOW_DISTANCE),
+      AspectRatio(1.0f),
+      NearPlane(NEAR_PLANE),
+      FarPlane(FAR_PLANE)
+{
+    updateOrientation();
+}
+
+glm::vec3 Camera::getEyePosition() const
+{
+    if (Type == Camera_Type::THIRD_PERSON)
+    {
+        return Position - getFront() * FollowDistance;
+    }
+    return Position;
+}
+
+const glm::mat4 &Camera::GetViewMatrix()
+{
+    if (viewDirty)
+    {
+        // inverse of the camera's rigid transform: the rotation transposed, then the eye moved to the origin
+        glm::mat3 rotation = glm::mat3_cast(glm::conjugate(Orientation));
+        view = glm::mat4(rotation);
+        view[3] = glm::vec4(-(rotation * getEyePosition()), 1.0f);
+        viewDirty = false;
+    }
+    return view;
+}
+
+const glm::mat4 &Camera::GetProjectionMatrix()
+{
+    if (projectionDirty)
+    {
+        if (ReversedZ)
+        {
+            // clip z is the near distance, clip w the view distance, so depth = near / distance
+            float f = 1.0f / std::tan(glm::radians(Zoom) * 0.5f);
+            projection = glm::mat4(0.0f);
+            projection[0][0] = f / AspectRatio;
+            projection[1][1] = f;
+            projection[2][3] = -1.0f;
+            projection[3][2] = NearPlane;
+        }
+        else
+        {
+            projection = glm::perspective(glm::radians(Zoom), AspectRatio, NearPlane, FarPlane);
+        }
+        projectionDirty = false;
+    }
+    return projection;
+}
+
+const glm::mat4 &Camera::GetViewProjectionMatrix()
+{
+    if (frustumDirty)
+    {
+        viewProjection = GetProjectionMatrix() * GetViewMatrix();
+        frustum = Frustum::fromMatrix(viewProjection, ReversedZ);
+        frustumDirty = false;
+    }
+    return viewProjection;
+}
+
+const Frustum &Camera::GetFrustum()
+{
+    GetViewProjectionMatrix();
+    return frustum;
+}
+
+void Camera::setType(Camera_Type type)
+{
+    Type = type;
+    // keys held while switching would otherwise keep pushing the new mode
+    Motion = glm::vec3(0.0f);
+    markViewDirty();
+}
+
+void Camera::translateCamera(glm::vec3 direction, float speed, float deltaTime)
+{
+    direction = glm::normalize(direction);
+    setCameraPos(Position + direction * speed * deltaTime);
+}
+
+void Camera::moveCamera(glm::vec3 direction, float speed, float deltaTime)
+{
+    direction = glm::normalize(direction);
+    glm::vec3 position = Position;
+    position -= direction.z * getFront() * speed * deltaTime;
+    position += direction.x * getRight() * speed * deltaTime;
+    setCameraPos(position);
+}
+
+void Camera::Reverse()
+{
+    Yaw += Yaw < 0.0f ? 180.0f : -180.0f;
+    updateOrientation();
+}
+
+void Camera::setCameraPos(glm::vec3 position)
+{
+    if (position != Position)
+    {
+        Position = position;
+        markViewDirty();
+    }
+}
+
+void Camera::setOrientation(float yaw, float pitch)
+{
+    Yaw = yaw;
+    Pitch = pitch;
+    updateOrientation();
+}
+
+void Camera::rotateCamera(float delta_yaw, float delta_pitch, GLboolean constrainPitch)
+{
+    if (delta_yaw == 0.0f && delta_pitch == 0.0f)
+    {
+        return;
+    }
+    Yaw += delta_yaw;
+    Pitch += delta_pitch;
+
+    // if pitch is out of bounds, clamp it
+    if (constrainPitch)
+    {
+        Pitch = glm::clamp(Pitch, PITCH_MIN, PITCH_MAX);
+    }
+    updateOrientation();
+}
+
+void Camera::adjustZoom(float zoom_offset)
+{
+    float zoom = glm::clamp(Zoom - zoom_offset, ZOOM_MIN, ZOOM_MAX);
+    if (zoom != Zoom)
+    {
+        Zoom = zoom;
+        markProjectionDirty();
+    }
+}
+
+void Camera::adjustFollowDistance(float offset)
+{
+    FollowDistance = glm::max(FollowDistance - offset, 1.0f);
+    markViewDirty();
+}
+
+void Camera::setViewport(int width, int height)
+{
+    if (width <= 0 || height <= 0)
+    {
+        return;
+    }
+    float aspectRatio = (float) width / (float) height;
+    if (aspectRatio != AspectRatio)
+    {
+        AspectRatio = aspectRatio;
+        markProjectionDirty();
+    }
+}
+
+void Camera::setClipPlanes(float nearPlane, float farPlane)
+{
+    NearPlane = nearPlane;
+    FarPlane = farPlane;
+    markProjectionDirty();
+}
+
+void Camera::setReversedZ(bool reversed)
+{
+    ReversedZ = reversed;
+    markProjectionDirty();
+}
+
+void Camera::addMotion(glm::vec3 direction)
+{
+    Motion += direction * MovementSpeed;
+}
+
+void Camera::move(float deltaTime)
+{
+    setCameraPos(integrate(Position, deltaTime));
+}
+
+glm::vec3 Camera::integrate(glm::vec3 position, float deltaTime) const
+{
+    if (Motion != glm::vec3(0))
+    {
+        // forward and right stay on the ground plane whatever the pitch
+        glm::vec3 right = getRight();
+        position -= Motion.z * glm::normalize(glm::cross(WorldUp, right)) * deltaTime;
+        position += Motion.x * right * deltaTime;
+        if (Type == Camera_Type::FREE_CAMERA)
+        {
+            position += Motion.y * WorldUp * deltaTime;
+        }
+    }
+    return position;
+}
+
+void Camera::updateOrientation()
+{
+    // yaw turns around the world up axis, pitch around the turned right axis.
+    // A yaw of -90 degrees looks down -z, which is the quaternion's identity.
+    glm::quat yaw = glm::angleAxis(glm::radians(-Yaw - 90.0f), WorldUp);
+    glm::quat pitch = glm::angleAxis(glm::radians(Pitch), glm::vec3(1.0f, 0.0f, 0.0f));
+    Orientation = yaw * pitch;
+    markViewDirty();
+}
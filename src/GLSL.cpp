@@ -6,6 +6,10 @@
 #include <iostream>
 #include <cstring>
 #include <cassert>
+#include <map>
+#include <set>
+#include <string>
+#include <tuple>
 
 namespace GLSL
 {
@@ -77,6 +81,22 @@ namespace GLSL
         }
     }
 
+    std::string getShaderInfoLog(GLuint shader)
+    {
+        GLint infologLength = 0;
+        CHECKED_GL_CALL(glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &infologLength));
+        if (infologLength <= 0)
+        {
+            return std::string();
+        }
+
+        std::string infoLog(infologLength, '\0');
+        GLint charsWritten = 0;
+        CHECKED_GL_CALL(glGetShaderInfoLog(shader, infologLength, &charsWritten, &infoLog[0]));
+        infoLog.resize(charsWritten);
+        return infoLog;
+    }
+
     void printProgramInfoLog(GLuint program)
     {
         GLchar *infoLog;
@@ -117,6 +137,205 @@ namespace GLSL
         }
     }
 
+    typedef void (APIENTRYP PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)(GLuint count);
+
+    static std::set<std::string> extensions;
+    static bool parallelShaderCompile = false;
+
+    void loadExtensions(GLADloadproc load)
+    {
+        extensions.clear();
+        GLint count = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+        for (GLint i = 0; i < count; i++)
+        {
+            const char *name = (const char *) glGetStringi(GL_EXTENSIONS, i);
+            if (name)
+            {
+                extensions.insert(name);
+            }
+        }
+
+        parallelShaderCompile = hasExtension("GL_KHR_parallel_shader_compile") || hasExtension("GL_ARB_parallel_shader_compile");
+        if (parallelShaderCompile)
+        {
+            // let the driver pick as many compiler threads as it likes
+            PFNGLMAXSHADERCOMPILERTHREADSKHRPROC maxShaderCompilerThreads =
+                (PFNGLMAXSHADERCOMPILERTHREADSKHRPROC) load("glMaxShaderCompilerThreadsKHR");
+            if (!maxShaderCompilerThreads)
+            {
+                maxShaderCompilerThreads = (PFNGLMAXSHADERCOMPILERTHREADSKHRPROC) load("glMaxShaderCompilerThreadsARB");
+            }
+            if (maxShaderCompilerThreads)
+            {
+                maxShaderCompilerThreads(0xFFFFFFFF);
+            }
+        }
+    }
+
+    static bool debugOutput = false;
+    static GLenum debugMinSeverity = GL_DEBUG_SEVERITY_MEDIUM;
+    static std::map<std::tuple<GLenum, GLenum, GLuint>, unsigned long> debugMessageCounts;
+
+    // the CHECKED_GL_CALL currently executing, reported by the synchronous debug callback
+    static const char *callFunction = nullptr;
+    static const char *callFile = nullptr;
+    static int callLine = 0;
+
+    static int severityRank(GLenum severity)
+    {
+        switch (severity)
+        {
+            case GL_DEBUG_SEVERITY_HIGH:         return 3;
+            case GL_DEBUG_SEVERITY_MEDIUM:       return 2;
+            case GL_DEBUG_SEVERITY_LOW:          return 1;
+            default:                             return 0;
+        }
+    }
+
+    static const char *severityString(GLenum severity)
+    {
+        switch (severity)
+        {
+            case GL_DEBUG_SEVERITY_HIGH:         return "high";
+            case GL_DEBUG_SEVERITY_MEDIUM:       return "medium";
+            case GL_DEBUG_SEVERITY_LOW:          return "low";
+            default:                             return "notification";
+        }
+    }
+
+    static const char *debugTypeString(GLenum type)
+    {
+        switch (type)
+        {
+            case GL_DEBUG_TYPE_ERROR:               return "error";
+            case GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR: return "deprecated";
+            case GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR:  return "undefined behavior";
+            case GL_DEBUG_TYPE_PORTABILITY:         return "portability";
+            case GL_DEBUG_TYPE_PERFORMANCE:         return "performance";
+            default:                                return "other";
+        }
+    }
+
+    static void APIENTRY debugCallback(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar *message, const void *userParam)
+    {
+        if (severityRank(severity) < severityRank(debugMinSeverity))
+        {
+            return;
+        }
+
+        // print a message the first time and then only every power of ten repeats
+        unsigned long count = ++debugMessageCounts[std::make_tuple(source, type, id)];
+        bool print = count == 1;
+        for (unsigned long n = 10; n <= count && !print; n *= 10)
+        {
+            print = count == n;
+        }
+        if (!print)
+        {
+            return;
+        }
+
+        std::cerr << "GL " << debugTypeString(type) << " (" << severityString(severity) << ", id " << id << "): " << message;
+        if (count > 1)
+        {
+            std::cerr << " [repeated " << count << " times]";
+        }
+        if (callFunction)
+        {
+            std::cerr << "\n    in '" << callFunction << "' at " << callFile << ":" << callLine;
+        }
+        std::cerr << std::endl;
+    }
+
+    bool enableDebugOutput(GLADloadproc load, GLenum minSeverity)
+    {
+        debugMinSeverity = minSeverity;
+
+        GLint flags = 0;
+        glGetIntegerv(GL_CONTEXT_FLAGS, &flags);
+        if (!(flags & GL_CONTEXT_FLAG_DEBUG_BIT))
+        {
+            std::cerr << "Not a debug context, OpenGL debug output disabled" << std::endl;
+            return false;
+        }
+
+        // core since 4.3, KHR_debug uses the same unsuffixed names on desktop GL
+        if (!GLAD_GL_VERSION_4_3)
+        {
+            if (!hasExtension("GL_KHR_debug"))
+            {
+                std::cerr << "KHR_debug not supported, OpenGL debug output disabled" << std::endl;
+                return false;
+            }
+            glad_glDebugMessageCallback = (PFNGLDEBUGMESSAGECALLBACKPROC) load("glDebugMessageCallback");
+            glad_glDebugMessageControl = (PFNGLDEBUGMESSAGECONTROLPROC) load("glDebugMessageControl");
+        }
+        if (!glad_glDebugMessageCallback || !glad_glDebugMessageControl)
+        {
+            return false;
+        }
+
+        glEnable(GL_DEBUG_OUTPUT);
+        // report errors from inside the offending call so the call site is known
+        glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+        glDebugMessageCallback(debugCallback, nullptr);
+        // let the driver drop notifications instead of calling back for each of them
+        glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DEBUG_SEVERITY_NOTIFICATION, 0, nullptr,
+                              minSeverity == GL_DEBUG_SEVERITY_NOTIFICATION ? GL_TRUE : GL_FALSE);
+
+        // errors from before the callback was installed would be blamed on the next checked call
+        while (glGetError() != GL_NO_ERROR)
+        {
+        }
+        debugOutput = true;
+        return true;
+    }
+
+    bool isDebugOutputEnabled()
+    {
+        return debugOutput;
+    }
+
+    void setCallSite(const char *const Function, const char *const File, int const Line)
+    {
+        if (debugOutput)
+        {
+            callFunction = Function;
+            callFile = File;
+            callLine = Line;
+        }
+        else
+        {
+            // errors left behind by an unchecked call
+            GLenum Error = glGetError();
+            if (Error != GL_NO_ERROR)
+            {
+                printf("OpenGL error in file '%s' at line %d before calling function '%s': '%s' ' %d 0x%X'\n", File, Line, Function, errorString(Error), Error, Error);
+            }
+        }
+    }
+
+    void checkCall(const char *const Function, const char *const File, int const Line)
+    {
+        if (debugOutput)
+        {
+            callFunction = nullptr;
+            return;
+        }
+        printOpenGLErrors(Function, File, Line);
+    }
+
+    bool hasExtension(const char *name)
+    {
+        return extensions.find(name) != extensions.end();
+    }
+
+    bool hasParallelShaderCompile()
+    {
+        return parallelShaderCompile;
+    }
+
     GLint getAttribLocation(const GLuint program, const char varname[], bool verbose)
     {
         GLint r = glGetAttribLocation(program, varname);
@@ -0,0 +1,720 @@
+#include "GltfLoader.h"
+#include "Json.h"
+#include "SceneGraph.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <iostream>
+
+namespace GltfLoader
+{
+    namespace
+    {
+        const uint32_t GLB_MAGIC = 0x46546C67;   // "glTF"
+        const uint32_t GLB_JSON = 0x4E4F534A;    // "JSON"
+        const uint32_t GLB_BIN = 0x004E4942;     // "BIN\0"
+
+        // glTF component types are the GL enums
+        size_t componentSize(int componentType)
+        {
+            switch (componentType)
+            {
+            case GL_BYTE:
+            case GL_UNSIGNED_BYTE:
+                return 1;
+            case GL_SHORT:
+            case GL_UNSIGNED_SHORT:
+                return 2;
+            case GL_UNSIGNED_INT:
+            case GL_FLOAT:
+                return 4;
+            default:
+                return 0;
+            }
+        }
+
+        int componentCount(const std::string &type)
+        {
+            static const char *names[] = {"SCALAR", "VEC2", "VEC3", "VEC4", "MAT2", "MAT3", "MAT4"};
+            static const int counts[] = {1, 2, 3, 4, 4, 9, 16};
+            for (size_t i = 0; i < sizeof(counts) / sizeof(counts[0]); i++)
+            {
+                if (type == names[i])
+                {
+                    return counts[i];
+                }
+            }
+            return 0;
+        }
+
+        // a non-negative integer below limit
+        bool getIndex(const Json::Value &value, size_t limit, size_t &index)
+        {
+            double number = value.getNumber(-1.0);
+            if (number < 0.0 || number >= (double) limit || number != (double) (size_t) number)
+            {
+                return false;
+            }
+            index = (size_t) number;
+            return true;
+        }
+
+        template<int N>
+        glm::vec<N, float> getVector(const Json::Value &value, glm::vec<N, float> fallback)
+        {
+            if (value.size() != N)
+            {
+                return fallback;
+            }
+            glm::vec<N, float> result;
+            for (int i = 0; i < N; i++)
+            {
+                result[i] = (float) value[i].getNumber(fallback[i]);
+            }
+            return result;
+        }
+
+        // an accessor that was checked to lie inside the buffer
+        struct Accessor
+        {
+            // from the start of the buffer
+            size_t offset = 0;
+            size_t stride = 0;
+            size_t count = 0;
+            int componentType = 0;
+            int components = 0;
+            bool normalized = false;
+            // the bufferView had an explicit byteStride
+            bool strided = false;
+        };
+
+        struct Document
+        {
+            const Json::Value *json = nullptr;
+            const char *buffer = nullptr;
+            size_t bufferSize = 0;
+            // byte range of the buffer that vertex and index accessors use
+            size_t usedBegin = SIZE_MAX;
+            size_t usedEnd = 0;
+        };
+
+        bool fail(const std::string &message)
+        {
+            std::cerr << "glTF: " << message << std::endl;
+            return false;
+        }
+
+        bool readAccessor(Document &document, const Json::Value &reference, Accessor &accessor)
+        {
+            const Json::Value &accessors = (*document.json)["accessors"];
+            size_t index;
+            if (!getIndex(reference, accessors.size(), index))
+            {
+                return fail("Invalid accessor index");
+            }
+            const Json::Value &json = accessors[index];
+            std::string name = "Accessor " + std::to_string(index);
+            if (json.has("sparse"))
+            {
+                return fail(name + " is sparse, which is not supported");
+            }
+
+            const Json::Value &views = (*document.json)["bufferViews"];
+            size_t viewIndex;
+            if (!getIndex(json["bufferView"], views.size(), viewIndex))
+            {
+                return fail(name + " has no valid bufferView");
+            }
+            const Json::Value &view = views[viewIndex];
+            if (view["buffer"].getNumber(-1.0) != 0.0)
+            {
+                return fail(name + " does not use the first buffer");
+            }
+
+            accessor.componentType = (int) json["componentType"].getNumber();
+            accessor.components = componentCount(json["type"].getString());
+            accessor.normalized = json["normalized"].getBool();
+            size_t size = componentSize(accessor.componentType);
+            if (size == 0 || accessor.components == 0)
+            {
+                return fail(name + " has an invalid type");
+            }
+            double count = json["count"].getNumber(0.0);
+            double viewOffset = view["byteOffset"].getNumber(0.0);
+            double viewLength = view["byteLength"].getNumber(0.0);
+            double offset = json["byteOffset"].getNumber(0.0);
+            double stride = view["byteStride"].getNumber(0.0);
+            if (count < 1.0 || viewOffset < 0.0 || viewLength < 1.0 || offset < 0.0 || stride < 0.0 ||
+                viewOffset + viewLength > (double) document.bufferSize)
+            {
+                return fail(name + " has an invalid range");
+            }
+
+            accessor.count = (size_t) count;
+            size_t elementSize = size * accessor.components;
+            accessor.strided = stride > 0.0;
+            accessor.stride = accessor.strided ? (size_t) stride : elementSize;
+            accessor.offset = (size_t) viewOffset + (size_t) offset;
+            size_t end = (size_t) offset + accessor.stride * (accessor.count - 1) + elementSize;
+            if (accessor.stride < elementSize || end > (size_t) viewLength ||
+                accessor.offset % size != 0 || accessor.stride % size != 0)
+            {
+                return fail(name + " is out of bounds or misaligned");
+            }
+            document.usedBegin = std::min(document.usedBegin, accessor.offset);
+            document.usedEnd = std::max(document.usedEnd, (size_t) viewOffset + end);
+            return true;
+        }
+
+        VertexAttribute toAttribute(const Accessor &accessor)
+        {
+            VertexAttribute attribute;
+            attribute.size = accessor.components;
+            attribute.type = accessor.componentType;
+            attribute.normalized = accessor.normalized ? GL_TRUE : GL_FALSE;
+            attribute.stride = (GLsizei) accessor.stride;
+            attribute.offset = (GLintptr) accessor.offset;
+            return attribute;
+        }
+
+        template<typename Index>
+        bool indicesInRange(const char *data, size_t count, size_t vertexCount)
+        {
+            Index largest = 0;
+            for (size_t i = 0; i < count; i++)
+            {
+                Index index;
+                memcpy(&index, data + i * sizeof(Index), sizeof(Index));
+                largest = std::max(largest, index);
+            }
+            return (size_t) largest < vertexCount;
+        }
+
+        // bounds of a position accessor, from its min and max (which glTF requires) or the data itself
+        void positionBounds(const Document &document, const Json::Value &json, const Accessor &accessor, glm::vec3 &min, glm::vec3 &max)
+        {
+            if (json["min"].size() == 3 && json["max"].size() == 3)
+            {
+                min = getVector<3>(json["min"], glm::vec3(0.0f));
+                max = getVector<3>(json["max"], glm::vec3(0.0f));
+                return;
+            }
+            for (size_t i = 0; i < accessor.count; i++)
+            {
+                glm::vec3 position;
+                memcpy(&position, document.buffer + accessor.offset + i * accessor.stride, sizeof(position));
+                min = glm::min(min, position);
+                max = glm::max(max, position);
+            }
+        }
+
+        // validates a primitive and turns it into a layout, false on invalid data.
+        // Primitives that are valid but cannot be drawn are skipped.
+        bool loadPrimitive(Document &document, const Json::Value &json, const std::string &name,
+                           std::vector<GltfPrimitive> &primitives, std::vector<std::pair<glm::vec3, glm::vec3>> &bounds)
+        {
+            if (json["mode"].getNumber(GL_TRIANGLES) != GL_TRIANGLES)
+            {
+                std::cerr << "glTF: skipping " << name << ", only triangles are supported" << std::endl;
+                return true;
+            }
+            const Json::Value &attributes = json["attributes"];
+            if (!attributes.has("POSITION"))
+            {
+                std::cerr << "glTF: skipping " << name << ", it has no positions" << std::endl;
+                return true;
+            }
+
+            GltfPrimitive primitive;
+            MeshBufferLayout &layout = primitive.layout;
+            const char *semantics[3] = {"POSITION", "NORMAL", "TEXCOORD_0"};
+            for (int i = 0; i < 3; i++)
+            {
+                if (!attributes.has(semantics[i]))
+                {
+                    continue;
+                }
+                Accessor accessor;
+                if (!readAccessor(document, attributes[semantics[i]], accessor))
+                {
+                    return false;
+                }
+                // float vec3 positions and normals, float or normalized unsigned vec2 texture coordinates
+                bool valid = i < 2 ? accessor.components == 3 && accessor.componentType == GL_FLOAT
+                                   : accessor.components == 2 && (accessor.componentType == GL_FLOAT ||
+                                     (accessor.normalized && (accessor.componentType == GL_UNSIGNED_BYTE || accessor.componentType == GL_UNSIGNED_SHORT)));
+                if (!valid || (i > 0 && (GLsizei) accessor.count != layout.vertexCount))
+                {
+                    return fail(name + " has an invalid " + semantics[i]);
+                }
+                layout.attributes[i] = toAttribute(accessor);
+                if (i == 0)
+                {
+                    layout.vertexCount = (GLsizei) accessor.count;
+                    glm::vec3 min(std::numeric_limits<float>::max()), max(-std::numeric_limits<float>::max());
+                    positionBounds(document, (*document.json)["accessors"][(size_t) attributes["POSITION"].getNumber()], accessor, min, max);
+                    bounds.push_back(std::make_pair(min, max));
+                }
+            }
+
+            if (json.has("indices"))
+            {
+                Accessor accessor;
+                if (!readAccessor(document, json["indices"], accessor))
+                {
+                    return false;
+                }
+                // GL reads indices tightly packed
+                size_t size = componentSize(accessor.componentType);
+                if (accessor.components != 1 || accessor.strided || accessor.componentType == GL_BYTE ||
+                    accessor.componentType == GL_SHORT || accessor.componentType == GL_FLOAT)
+                {
+                    return fail(name + " has invalid indices");
+                }
+                const char *data = document.buffer + accessor.offset;
+                bool inRange = size == 1 ? indicesInRange<uint8_t>(data, accessor.count, layout.vertexCount)
+                             : size == 2 ? indicesInRange<uint16_t>(data, accessor.count, layout.vertexCount)
+                                         : indicesInRange<uint32_t>(data, accessor.count, layout.vertexCount);
+                if (!inRange)
+                {
+                    return fail(name + " has indices past its vertices");
+                }
+                layout.indexType = accessor.componentType;
+                layout.indexCount = (GLsizei) accessor.count;
+                layout.indexOffset = (GLintptr) accessor.offset;
+            }
+
+            size_t material;
+            if (getIndex(json["material"], (*document.json)["materials"].size(), material))
+            {
+                primitive.material = (int) material;
+            }
+            primitives.push_back(primitive);
+            return true;
+        }
+
+        // the primitives of a mesh with their untransformed bounds, loaded once no matter how many nodes use it
+        struct LoadedMesh
+        {
+            bool loaded = false;
+            std::vector<GltfPrimitive> primitives;
+            std::vector<std::pair<glm::vec3, glm::vec3>> bounds;
+        };
+
+        bool loadMesh(Document &document, size_t index, LoadedMesh &mesh)
+        {
+            if (mesh.loaded)
+            {
+                return true;
+            }
+            mesh.loaded = true;
+            const Json::Value &primitives = (*document.json)["meshes"][index]["primitives"];
+            for (size_t i = 0; i < primitives.size(); i++)
+            {
+                std::string name = "mesh " + std::to_string(index) + " primitive " + std::to_string(i);
+                if (!loadPrimitive(document, primitives[i], name, mesh.primitives, mesh.bounds))
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        // a node's local transform as translation, rotation and scale
+        void nodeTransform(const Json::Value &node, glm::vec3 &translation, glm::quat &rotation, glm::vec3 &scale)
+        {
+            const Json::Value &matrix = node["matrix"];
+            if (matrix.size() == 16)
+            {
+                // glTF requires matrices to decompose into T * R * S without shear
+                glm::mat4 m;
+                for (int i = 0; i < 16; i++)
+                {
+                    m[i / 4][i % 4] = (float) matrix[i].getNumber();
+                }
+                translation = glm::vec3(m[3]);
+                scale = glm::vec3(glm::length(glm::vec3(m[0])), glm::length(glm::vec3(m[1])), glm::length(glm::vec3(m[2])));
+                if (glm::determinant(glm::mat3(m)) < 0.0f)
+                {
+                    scale.x = -scale.x;
+                }
+                glm::mat3 r(glm::vec3(m[0]) / scale.x, glm::vec3(m[1]) / scale.y, glm::vec3(m[2]) / scale.z);
+                rotation = glm::normalize(glm::quat_cast(r));
+                return;
+            }
+            translation = getVector<3>(node["translation"], glm::vec3(0.0f));
+            // stored as x, y, z, w
+            glm::vec4 q = getVector<4>(node["rotation"], glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+            rotation = glm::normalize(glm::quat(q.w, q.x, q.y, q.z));
+            scale = getVector<3>(node["scale"], glm::vec3(1.0f));
+        }
+
+        // walks the node hierarchy of the default scene and places the meshes of every node
+        bool loadNodes(Document &document, GltfModel &model)
+        {
+            const Json::Value &json = *document.json;
+            const Json::Value &nodes = json["nodes"];
+
+            std::vector<size_t> roots;
+            const Json::Value &scenes = json["scenes"];
+            if (scenes.size() > 0)
+            {
+                size_t scene = 0;
+                if (json.has("scene") && !getIndex(json["scene"], scenes.size(), scene))
+                {
+                    return fail("Invalid default scene");
+                }
+                const Json::Value &sceneNodes = scenes[scene]["nodes"];
+                for (size_t i = 0; i < sceneNodes.size(); i++)
+                {
+                    size_t node;
+                    if (!getIndex(sceneNodes[i], nodes.size(), node))
+                    {
+                        return fail("Invalid scene node");
+                    }
+                    roots.push_back(node);
+                }
+            }
+            else
+            {
+                // without scenes every node that is nobody's child is a root
+                std::vector<uint8_t> isChild(nodes.size(), 0);
+                for (size_t i = 0; i < nodes.size(); i++)
+                {
+                    const Json::Value &children = nodes[i]["children"];
+                    for (size_t c = 0; c < children.size(); c++)
+                    {
+                        size_t child;
+                        if (getIndex(children[c], nodes.size(), child))
+                        {
+                            isChild[child] = 1;
+                        }
+                    }
+                }
+                for (size_t i = 0; i < nodes.size(); i++)
+                {
+                    if (!isChild[i])
+                    {
+                        roots.push_back(i);
+                    }
+                }
+            }
+
+            // depth first, so parents are added to the graph before their children
+            SceneGraph graph;
+            std::vector<std::pair<size_t, SceneGraph::NodeId>> placed;
+            std::vector<uint8_t> visited(nodes.size(), 0);
+            std::vector<std::pair<size_t, SceneGraph::NodeId>> stack;
+            for (auto root = roots.rbegin(); root != roots.rend(); ++root)
+            {
+                stack.push_back(std::make_pair(*root, SceneGraph::NONE));
+            }
+            while (!stack.empty())
+            {
+                size_t node = stack.back().first;
+                SceneGraph::NodeId parent = stack.back().second;
+                stack.pop_back();
+                if (visited[node])
+                {
+                    return fail("Node " + std::to_string(node) + " is used more than once");
+                }
+                visited[node] = 1;
+
+                glm::vec3 translation, scale;
+                glm::quat rotation;
+                nodeTransform(nodes[node], translation, rotation, scale);
+                SceneGraph::NodeId id = graph.addNode(parent, translation, rotation, scale);
+                placed.push_back(std::make_pair(node, id));
+
+                const Json::Value &children = nodes[node]["children"];
+                for (size_t c = children.size(); c-- > 0;)
+                {
+                    size_t child;
+                    if (!getIndex(children[c], nodes.size(), child))
+                    {
+                        return fail("Invalid child of node " + std::to_string(node));
+                    }
+                    stack.push_back(std::make_pair(child, id));
+                }
+            }
+            graph.update();
+
+            std::vector<LoadedMesh> meshes(json["meshes"].size());
+            for (const std::pair<size_t, SceneGraph::NodeId> &entry : placed)
+            {
+                const Json::Value &node = nodes[entry.first];
+                if (!node.has("mesh"))
+                {
+                    continue;
+                }
+                size_t index;
+                if (!getIndex(node["mesh"], meshes.size(), index))
+                {
+                    return fail("Invalid mesh of node " + std::to_string(entry.first));
+                }
+                if (!loadMesh(document, index, meshes[index]))
+                {
+                    return false;
+                }
+
+                const glm::mat4 &world = graph.getWorld(entry.second);
+                for (size_t p = 0; p < meshes[index].primitives.size(); p++)
+                {
+                    GltfPrimitive primitive = meshes[index].primitives[p];
+                    primitive.transform = world;
+                    model.primitives.push_back(primitive);
+
+                    // transformed corners of the local bounds
+                    const glm::vec3 &min = meshes[index].bounds[p].first;
+                    const glm::vec3 &max = meshes[index].bounds[p].second;
+                    for (int corner = 0; corner < 8; corner++)
+                    {
+                        glm::vec3 local((corner & 1) ? max.x : min.x, (corner & 2) ? max.y : min.y, (corner & 4) ? max.z : min.z);
+                        glm::vec3 position = glm::vec3(world * glm::vec4(local, 1.0f));
+                        model.min = glm::min(model.min, position);
+                        model.max = glm::max(model.max, position);
+                    }
+                }
+            }
+            return true;
+        }
+
+        void loadImages(const Document &document, GltfModel &model, const std::string &namePrefix)
+        {
+            const Json::Value &images = (*document.json)["images"];
+            const Json::Value &views = (*document.json)["bufferViews"];
+            model.images.resize(images.size());
+            for (size_t i = 0; i < images.size(); i++)
+            {
+                GltfImage &image = model.images[i];
+                const Json::Value &json = images[i];
+                if (json.has("uri"))
+                {
+                    image.uri = json["uri"].getString();
+                    if (image.uri.compare(0, 5, "data:") == 0)
+                    {
+                        std::cerr << "glTF: skipping image " << i << ", data: URIs are not supported" << std::endl;
+                        image.uri.clear();
+                        continue;
+                    }
+                    image.name = image.uri;
+                    continue;
+                }
+
+                size_t view;
+                if (!getIndex(json["bufferView"], views.size(), view))
+                {
+                    std::cerr << "glTF: skipping image " << i << ", it has no data" << std::endl;
+                    continue;
+                }
+                double offset = views[view]["byteOffset"].getNumber(0.0);
+                double length = views[view]["byteLength"].getNumber(0.0);
+                if (offset < 0.0 || length < 1.0 || offset + length > (double) document.bufferSize)
+                {
+                    std::cerr << "glTF: skipping image " << i << ", it is out of bounds" << std::endl;
+                    continue;
+                }
+                image.name = namePrefix + "#image" + std::to_string(i);
+                image.data = (const unsigned char *) document.buffer + (size_t) offset;
+                image.size = (size_t) length;
+            }
+        }
+
+        // texture reference (a textureInfo) to the name of its image, empty if there is none
+        std::string textureName(const Document &document, const GltfModel &model, const Json::Value &info)
+        {
+            const Json::Value &textures = (*document.json)["textures"];
+            size_t texture, image;
+            if (!getIndex(info["index"], textures.size(), texture) ||
+                !getIndex(textures[texture]["source"], model.images.size(), image))
+            {
+                return "";
+            }
+            return model.images[image].name;
+        }
+
+        // maps metallic-roughness materials onto the Phong terms of the Material shader struct
+        void loadMaterials(const Document &document, GltfModel &model)
+        {
+            const Json::Value &materials = (*document.json)["materials"];
+            model.materials.resize(materials.size());
+            for (size_t i = 0; i < materials.size(); i++)
+            {
+                const Json::Value &json = materials[i];
+                const Json::Value &pbr = json["pbrMetallicRoughness"];
+                tinyobj::material_t &material = model.materials[i];
+                material.name = json["name"].getString();
+
+                glm::vec4 baseColor = getVector<4>(pbr["baseColorFactor"], glm::vec4(1.0f));
+                float metallic = (float) pbr["metallicFactor"].getNumber(1.0);
+                float roughness = (float) pbr["roughnessFactor"].getNumber(1.0);
+                glm::vec3 emission = getVector<3>(json["emissiveFactor"], glm::vec3(0.0f));
+                // dielectrics reflect about 4%, metals their base color
+                glm::vec3 specular = glm::mix(glm::vec3(0.04f), glm::vec3(baseColor), metallic);
+                for (int c = 0; c < 3; c++)
+                {
+                    material.diffuse[c] = baseColor[c];
+                    material.specular[c] = specular[c];
+                    material.emission[c] = emission[c];
+                }
+                material.dissolve = baseColor.a;
+                // Blinn-Phong exponent with about the same highlight as GGX at this roughness
+                float alpha = std::max(roughness * roughness, 1e-3f);
+                material.shininess = glm::clamp(2.0f / (alpha * alpha) - 2.0f, 1.0f, 256.0f);
+
+                material.diffuse_texname = textureName(document, model, pbr["baseColorTexture"]);
+                material.emissive_texname = textureName(document, model, json["emissiveTexture"]);
+            }
+        }
+
+        bool parseDocument(const Json::Value &json, const char *buffer, size_t bufferSize,
+                           GltfModel &model, const std::string &namePrefix)
+        {
+            if (json["asset"]["version"].getString().compare(0, 2, "2.") != 0)
+            {
+                return fail("Only glTF 2.0 is supported");
+            }
+            const Json::Value &buffers = json["buffers"];
+            if (buffers.size() > 1)
+            {
+                return fail("Only files with a single buffer are supported");
+            }
+            if (buffers.size() == 1)
+            {
+                double length = buffers[0]["byteLength"].getNumber(-1.0);
+                if (length < 0.0 || length > (double) bufferSize)
+                {
+                    return fail("The buffer is shorter than its byteLength");
+                }
+                bufferSize = (size_t) length;
+            }
+
+            Document document;
+            document.json = &json;
+            document.buffer = buffer;
+            document.bufferSize = buffers.size() == 1 ? bufferSize : 0;
+
+            loadImages(document, model, namePrefix);
+            loadMaterials(document, model);
+            if (!loadNodes(document, model))
+            {
+                return false;
+            }
+
+            // only the range the primitives use is uploaded, embedded images stay behind.
+            // The start is kept 4 byte aligned as vertex attributes need it.
+            if (document.usedEnd > 0)
+            {
+                size_t begin = document.usedBegin & ~(size_t) 3;
+                model.vertexData = buffer + begin;
+                model.vertexDataSize = document.usedEnd - begin;
+                for (GltfPrimitive &primitive : model.primitives)
+                {
+                    for (VertexAttribute &attribute : primitive.layout.attributes)
+                    {
+                        attribute.offset -= attribute.size ? (GLintptr) begin : 0;
+                    }
+                    primitive.layout.indexOffset -= primitive.layout.indexType ? (GLintptr) begin : 0;
+                }
+            }
+            return true;
+        }
+
+        uint32_t readUint32(const char *data)
+        {
+            uint32_t value;
+            memcpy(&value, data, sizeof(value));
+            return value;
+        }
+
+        bool parseGlb(const char *data, size_t size, GltfModel &model, const std::string &namePrefix)
+        {
+            // 12 byte header, then chunks of (length, type, data): JSON first, an optional BIN second
+            if (size < 20 || readUint32(data) != GLB_MAGIC || readUint32(data + 4) != 2)
+            {
+                return fail("Not a glTF 2.0 binary");
+            }
+            size_t length = std::min<size_t>(readUint32(data + 8), size);
+            size_t jsonLength = readUint32(data + 12);
+            if (readUint32(data + 16) != GLB_JSON || jsonLength > length - 20)
+            {
+                return fail("Invalid JSON chunk");
+            }
+            const char *buffer = nullptr;
+            size_t bufferSize = 0;
+            size_t next = 20 + jsonLength;
+            if (length >= next + 8 && readUint32(data + next + 4) == GLB_BIN)
+            {
+                bufferSize = readUint32(data + next);
+                buffer = data + next + 8;
+                if (bufferSize > length - next - 8)
+                {
+                    return fail("Invalid BIN chunk");
+                }
+            }
+            Json::Value json;
+            std::string error;
+            if (!Json::parse(data + 20, jsonLength, json, error))
+            {
+                return fail(error);
+            }
+            return parseDocument(json, buffer, bufferSize, model, namePrefix);
+        }
+    }
+
+    bool load(const std::string &path, GltfModel &model)
+    {
+        if (!model.file.open(path))
+        {
+            return false;
+        }
+
+        bool loaded;
+        size_t dot = path.find_last_of('.');
+        std::string extension = dot == std::string::npos ? "" : path.substr(dot);
+        std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+        if (extension == ".gltf")
+        {
+            // the buffer is a file next to the JSON, it has to be known before parsing
+            Json::Value json;
+            std::string error;
+            if (!Json::parse(model.file.data(), model.file.size(), json, error))
+            {
+                fail(error);
+                std::cerr << "in '" << path << "'" << std::endl;
+                return false;
+            }
+            const std::string &uri = json["buffers"][0]["uri"].getString();
+            if (!uri.empty())
+            {
+                if (uri.compare(0, 5, "data:") == 0)
+                {
+                    return fail("data: buffers are not supported, in '" + path + "'");
+                }
+                size_t slash = path.find_last_of("/\\");
+                std::string directory = slash == std::string::npos ? "." : path.substr(0, slash);
+                if (!model.bufferFile.open(directory + "/" + uri))
+                {
+                    return false;
+                }
+            }
+            loaded = parseDocument(json, model.bufferFile.data(), model.bufferFile.size(), model, path);
+        }
+        else
+        {
+            loaded = parseGlb(model.file.data(), model.file.size(), model, path);
+        }
+
+        if (!loaded)
+        {
+            std::cerr << "in '" << path << "'" << std::endl;
+        }
+        return loaded;
+    }
+
+    bool parseGlb(const char *data, size_t size, GltfModel &model)
+    {
+        return parseGlb(data, size, model, "");
+    }
+}
@@ -0,0 +1,365 @@
+#include "Json.h"
+
+#include <cctype>
+#include <charconv>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+namespace Json
+{
+    namespace
+    {
+        const Value NULL_VALUE;
+        // nesting limit, deeper documents are rejected instead of overflowing the stack
+        const int MAX_DEPTH = 128;
+
+        void appendUtf8(std::string &out, uint32_t codepoint)
+        {
+            if (codepoint < 0x80)
+            {
+                out += (char) codepoint;
+            }
+            else if (codepoint < 0x800)
+            {
+                out += (char) (0xC0 | (codepoint >> 6));
+                out += (char) (0x80 | (codepoint & 0x3F));
+            }
+            else if (codepoint < 0x10000)
+            {
+                out += (char) (0xE0 | (codepoint >> 12));
+                out += (char) (0x80 | ((codepoint >> 6) & 0x3F));
+                out += (char) (0x80 | (codepoint & 0x3F));
+            }
+            else
+            {
+                out += (char) (0xF0 | (codepoint >> 18));
+                out += (char) (0x80 | ((codepoint >> 12) & 0x3F));
+                out += (char) (0x80 | ((codepoint >> 6) & 0x3F));
+                out += (char) (0x80 | (codepoint & 0x3F));
+            }
+        }
+    }
+
+    const Value &Value::operator[](size_t index) const
+    {
+        return type == ARRAY && index < items.size() ? items[index] : NULL_VALUE;
+    }
+
+    const Value &Value::operator[](const char *key) const
+    {
+        if (type == OBJECT)
+        {
+            for (size_t i = 0; i < keys.size(); i++)
+            {
+                if (keys[i] == key)
+                {
+                    return items[i];
+                }
+            }
+        }
+        return NULL_VALUE;
+    }
+
+    bool Value::has(const char *key) const
+    {
+        return &(*this)[key] != &NULL_VALUE;
+    }
+
+    // recursive descent over the text, the first error stops it
+    class Parser
+    {
+    public:
+        Parser(const char *data, size_t size) : begin(data), p(data), end(data + size) {}
+
+        bool parseDocument(Value &value, std::string &error)
+        {
+            if (!parseValue(value, 0))
+            {
+                error = message + " at offset " + std::to_string(p - begin);
+                return false;
+            }
+            skipWhitespace();
+            if (p != end)
+            {
+                error = "Trailing characters at offset " + std::to_string(p - begin);
+                return false;
+            }
+            return true;
+        }
+
+    private:
+        const char *begin;
+        const char *p;
+        const char *end;
+        std::string message;
+
+        bool fail(const char *what)
+        {
+            message = what;
+            return false;
+        }
+
+        void skipWhitespace()
+        {
+            while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r'))
+            {
+                p++;
+            }
+        }
+
+        bool consume(const char *literal)
+        {
+            size_t length = strlen(literal);
+            if ((size_t) (end - p) < length || memcmp(p, literal, length) != 0)
+            {
+                return false;
+            }
+            p += length;
+            return true;
+        }
+
+        bool parseValue(Value &value, int depth)
+        {
+            if (depth > MAX_DEPTH)
+            {
+                return fail("Nested too deeply");
+            }
+            skipWhitespace();
+            if (p == end)
+            {
+                return fail("Unexpected end");
+            }
+            switch (*p)
+            {
+            case '{':
+                return parseObject(value, depth);
+            case '[':
+                return parseArray(value, depth);
+            case '"':
+                value.type = Value::STRING;
+                return parseString(value.text);
+            case 't':
+                value.type = Value::BOOLEAN;
+                value.boolean = true;
+                return consume("true") || fail("Invalid literal");
+            case 'f':
+                value.type = Value::BOOLEAN;
+                value.boolean = false;
+                return consume("false") || fail("Invalid literal");
+            case 'n':
+                value.type = Value::NUL;
+                return consume("null") || fail("Invalid literal");
+            default:
+                return parseNumber(value);
+            }
+        }
+
+        bool parseObject(Value &value, int depth)
+        {
+            value.type = Value::OBJECT;
+            p++;
+            skipWhitespace();
+            if (p < end && *p == '}')
+            {
+                p++;
+                return true;
+            }
+            while (true)
+            {
+                skipWhitespace();
+                if (p == end || *p != '"')
+                {
+                    return fail("Expected a member name");
+                }
+                value.keys.emplace_back();
+                if (!parseString(value.keys.back()))
+                {
+                    return false;
+                }
+                skipWhitespace();
+                if (p == end || *p != ':')
+                {
+                    return fail("Expected ':'");
+                }
+                p++;
+                value.items.emplace_back();
+                if (!parseValue(value.items.back(), depth + 1))
+                {
+                    return false;
+                }
+                skipWhitespace();
+                if (p < end && *p == ',')
+                {
+                    p++;
+                    continue;
+                }
+                if (p < end && *p == '}')
+                {
+                    p++;
+                    return true;
+                }
+                return fail("Expected ',' or '}'");
+            }
+        }
+
+        bool parseArray(Value &value, int depth)
+        {
+            value.type = Value::ARRAY;
+            p++;
+            skipWhitespace();
+            if (p < end && *p == ']')
+            {
+                p++;
+                return true;
+            }
+            while (true)
+            {
+                value.items.emplace_back();
+                if (!parseValue(value.items.back(), depth + 1))
+                {
+                    return false;
+                }
+                skipWhitespace();
+                if (p < end && *p == ',')
+                {
+                    p++;
+                    continue;
+                }
+                if (p < end && *p == ']')
+                {
+                    p++;
+                    return true;
+                }
+                return fail("Expected ',' or ']'");
+            }
+        }
+
+        bool parseHex4(uint32_t &value)
+        {
+            if (end - p < 4)
+            {
+                return fail("Invalid \\u escape");
+            }
+            std::from_chars_result result = std::from_chars(p, p + 4, value, 16);
+            if (result.ptr != p + 4)
+            {
+                return fail("Invalid \\u escape");
+            }
+            p += 4;
+            return true;
+        }
+
+        bool parseString(std::string &out)
+        {
+            // opening quote
+            p++;
+            while (true)
+            {
+                // copy runs without escapes at once
+                const char *run = p;
+                while (p < end && *p != '"' && *p != '\\' && (unsigned char) *p >= 0x20)
+                {
+                    p++;
+                }
+                out.append(run, p);
+                if (p == end)
+                {
+                    return fail("Unterminated string");
+                }
+                if (*p == '"')
+                {
+                    p++;
+                    return true;
+                }
+                if (*p != '\\')
+                {
+                    return fail("Control character in string");
+                }
+
+                p++;
+                if (p == end)
+                {
+                    return fail("Unterminated string");
+                }
+                char escape = *p++;
+                switch (escape)
+                {
+                case '"': out += '"'; break;
+                case '\\': out += '\\'; break;
+                case '/': out += '/'; break;
+                case 'b': out += '\b'; break;
+                case 'f': out += '\f'; break;
+                case 'n': out += '\n'; break;
+                case 'r': out += '\r'; break;
+                case 't': out += '\t'; break;
+                case 'u':
+                {
+                    uint32_t codepoint;
+                    if (!parseHex4(codepoint))
+                    {
+                        return false;
+                    }
+                    // a surrogate pair for characters outside the basic plane
+                    if (codepoint >= 0xD800 && codepoint < 0xDC00)
+                    {
+                        uint32_t low;
+                        if (!consume("\\u") || !parseHex4(low) || low < 0xDC00 || low >= 0xE000)
+                        {
+                            return fail("Invalid surrogate pair");
+                        }
+                        codepoint = 0x10000 + ((codepoint - 0xD800) << 10) + (low - 0xDC00);
+                    }
+                    appendUtf8(out, codepoint);
+                    break;
+                }
+                default:
+                    return fail("Invalid escape");
+                }
+            }
+        }
+
+        bool parseNumber(Value &value)
+        {
+            value.type = Value::NUMBER;
+            const char *start = p;
+            if (p < end && *p == '-')
+            {
+                p++;
+            }
+            if (p == end || *p < '0' || *p > '9')
+            {
+                return fail("Unexpected character");
+            }
+#ifdef __cpp_lib_to_chars
+            std::from_chars_result result = std::from_chars(start, end, value.number);
+            if (result.ec != std::errc())
+            {
+                return fail("Invalid number");
+            }
+            p = result.ptr;
+#else
+            // strtod needs a null terminated copy
+            while (p < end && (isdigit((unsigned char) *p) || *p == '.' || *p == 'e' || *p == 'E' || *p == '+' || *p == '-'))
+            {
+                p++;
+            }
+            std::string token(start, p);
+            char *parsedEnd = nullptr;
+            value.number = strtod(token.c_str(), &parsedEnd);
+            if (parsedEnd != token.c_str() + token.size())
+            {
+                return fail("Invalid number");
+            }
+#endif
+            return true;
+        }
+    };
+
+    bool parse(const char *data, size_t size, Value &value, std::string &error)
+    {
+        value = Value();
+        Parser parser(data, size);
+        return parser.parseDocument(value, error);
+    }
+}
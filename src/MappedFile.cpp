@@ -0,0 +1,111 @@
+#include "MappedFile.h"
+
+#include <iostream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(const std::string &path)
+{
+    close();
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        std::cerr << "Could not open '" << path << "'" << std::endl;
+        return false;
+    }
+
+    LARGE_INTEGER fileSize;
+    bool ok = GetFileSizeEx(file, &fileSize) != 0;
+    if (ok && fileSize.QuadPart > 0)
+    {
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping)
+        {
+            mapped = (const char *) MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            CloseHandle(mapping);
+        }
+        ok = mapped != nullptr;
+        length = ok ? (size_t) fileSize.QuadPart : 0;
+    }
+    CloseHandle(file);
+
+    if (!ok)
+    {
+        std::cerr << "Could not map '" << path << "'" << std::endl;
+    }
+    return ok;
+}
+
+void MappedFile::close()
+{
+    if (mapped)
+    {
+        UnmapViewOfFile(mapped);
+    }
+    mapped = nullptr;
+    length = 0;
+}
+
+#else
+
+bool MappedFile::open(const std::string &path)
+{
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        std::cerr << "Could not open '" << path << "'" << std::endl;
+        return false;
+    }
+
+    struct stat info;
+    bool ok = fstat(fd, &info) == 0;
+    if (ok && info.st_size > 0)
+    {
+        void *address = mmap(nullptr, (size_t) info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ok = address != MAP_FAILED;
+        if (ok)
+        {
+            // loaders read front to back, let the kernel read ahead aggressively
+            madvise(address, (size_t) info.st_size, MADV_SEQUENTIAL);
+            mapped = (const char *) address;
+            length = (size_t) info.st_size;
+        }
+    }
+    // the mapping stays valid without the descriptor
+    ::close(fd);
+
+    if (!ok)
+    {
+        std::cerr << "Could not map '" << path << "'" << std::endl;
+    }
+    return ok;
+}
+
+void MappedFile::close()
+{
+    if (mapped)
+    {
+        munmap((void *) mapped, length);
+    }
+    mapped = nullptr;
+    length = 0;
+}
+
+#endif
@@ -1,9 +1,16 @@
 #include "Mesh.h"
+#include "MeshSimplifier.h"
+#include "RenderStats.h"
+#include "StreamBuffer.h"
+#include "VertexPacking.h"
 
-Mesh::Mesh(std::vector<Vertex> vertices, std::vector<int> material_ids)
+#include <cstring>
+
+Mesh::Mesh(std::vector<Vertex> vertices, std::vector<uint32_t> indices, std::vector<int> material_ids)
 {
-    this->vertices = (vertices);
-    this->material_ids.push_back(material_ids[0]);
+    this->vertices = std::move(vertices);
+    this->indices = std::move(indices);
+    this->material_ids.push_back(material_ids.empty() ? -1 : material_ids[0]);
     
     // sort and place material_ids so no repeats exist
     for (int i = 1; i < material_ids.size(); i++)
@@ -14,41 +21,93 @@ Mesh::Mesh(std::vector<Vertex> vertices, std::vector<int> material_ids)
             this->material_ids.insert(index, material_ids[i]);
         }
     }
-    
+
+    // the layout of Vertex in VBO and the indices in EBO
+    layout.attributes[0] = {3, GL_FLOAT, GL_FALSE, sizeof(Vertex), offsetof(Vertex, Position)};
+    layout.attributes[1] = {3, GL_FLOAT, GL_FALSE, sizeof(Vertex), offsetof(Vertex, Normal)};
+    layout.attributes[2] = {2, GL_FLOAT, GL_FALSE, sizeof(Vertex), offsetof(Vertex, TexCoord)};
+    layout.vertexCount = (GLsizei) this->vertices.size();
+    layout.indexType = this->indices.empty() ? 0 : GL_UNSIGNED_INT;
+    layout.indexCount = (GLsizei) this->indices.size();
+}
+
+Mesh::Mesh(GLuint buffer, const MeshBufferLayout &layout, int material_id)
+{
+    external_buffer = buffer;
+    this->layout = layout;
+    material_ids.push_back(material_id);
 }
 
 void Mesh::clearBuffers()
 {
     CHECKED_GL_CALL(glDeleteVertexArrays(1, &VAO));
     CHECKED_GL_CALL(glDeleteBuffers(1, &VBO));
+    CHECKED_GL_CALL(glDeleteBuffers(1, &EBO));
 }
 
-void Mesh::setupMesh()
+void Mesh::setupMesh(const VertexPacking::Options *packing)
 {
     CHECKED_GL_CALL(glGenVertexArrays(1, &VAO));
-    CHECKED_GL_CALL(glGenBuffers(1, &VBO));
-
     CHECKED_GL_CALL(glBindVertexArray(VAO));
-    // buffer vertex position data
-    CHECKED_GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, VBO));
-    CHECKED_GL_CALL(glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW));
-    
-    // vertex positions
-    CHECKED_GL_CALL(glEnableVertexAttribArray(0));
-    CHECKED_GL_CALL(glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0));
-    // vertex normals
-    CHECKED_GL_CALL(glEnableVertexAttribArray(1));
-    CHECKED_GL_CALL(glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal)));
-    // texture coords
-    CHECKED_GL_CALL(glEnableVertexAttribArray(2));
-    CHECKED_GL_CALL(glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoord)));
-    
+
+    GLuint vertexBuffer = external_buffer;
+    GLuint indexBuffer = external_buffer;
+    if (!external_buffer)
+    {
+        // buffer vertex data
+        CHECKED_GL_CALL(glGenBuffers(1, &VBO));
+        CHECKED_GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, VBO));
+        if (packing)
+        {
+            VertexPacking::PackedVertices packed;
+            VertexPacking::pack(vertices, *packing, packed);
+            CHECKED_GL_CALL(glBufferData(GL_ARRAY_BUFFER, packed.data.size(), packed.data.data(), GL_STATIC_DRAW));
+            std::copy(packed.attributes, packed.attributes + 3, layout.attributes);
+            position_scale = packed.positionScale;
+            position_offset = packed.positionOffset;
+            octahedral_normals = packed.octahedralNormals;
+        }
+        else
+        {
+            CHECKED_GL_CALL(glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), vertices.data(), GL_STATIC_DRAW));
+        }
+        vertexBuffer = VBO;
+        if (!indices.empty())
+        {
+            CHECKED_GL_CALL(glGenBuffers(1, &EBO));
+            CHECKED_GL_CALL(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO));
+            CHECKED_GL_CALL(glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint32_t), indices.data(), GL_STATIC_DRAW));
+            indexBuffer = EBO;
+        }
+    }
+
+    // the element buffer binding is part of the VAO
+    if (layout.indexType)
+    {
+        CHECKED_GL_CALL(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer));
+    }
+    // positions, normals and texture coords. Missing attributes stay disabled and
+    // read as (0, 0, 0, 1).
+    CHECKED_GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer));
+    for (GLuint location = 0; location < 3; location++)
+    {
+        const VertexAttribute &attribute = layout.attributes[location];
+        if (attribute.size)
+        {
+            CHECKED_GL_CALL(glEnableVertexAttribArray(location));
+            CHECKED_GL_CALL(glVertexAttribPointer(location, attribute.size, attribute.type, attribute.normalized,
+                                                  attribute.stride, (void *) attribute.offset));
+        }
+    }
+
     CHECKED_GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, 0));
     CHECKED_GL_CALL(glBindVertexArray(0));
 }
 
-void Mesh::Draw(Program *shader, std::vector<tinyobj::material_t> materials, std::map<std::string, unsigned int> textures)
+void Mesh::bindTextures(Program *shader, const MeshMaterials &meshMaterials)
 {
+    const std::vector<tinyobj::material_t> &materials = meshMaterials.materials;
+    std::map<std::string, unsigned int> &textures = meshMaterials.textures;
     unsigned int diffuseNr = 1;
     unsigned int specularNr = 1;
     unsigned int textureNr = 0;
@@ -67,46 +126,251 @@ void Mesh::Draw(Program *shader, std::vector<tinyobj::material_t> materials, std
             std::string name;
 
             // bind diffuse texture
-            name = materials[i].diffuse_texname;
+            name = materials[material_ids[i]].diffuse_texname;
             if (name.size() > 0)
             {
                 CHECKED_GL_CALL(glActiveTexture(GL_TEXTURE0 + textureNr));
                 number = std::to_string(diffuseNr);
                 shader->setInt(("material.texture_diffuse" + number).c_str(), textureNr);
                 CHECKED_GL_CALL(glBindTexture(GL_TEXTURE_2D, textures[name]));
+                RenderStats::addStateChange();
                 textureNr++;
                 diffuseNr++;
             }
 
             
             // bind specular texture
-            name = materials[i].specular_texname;
+            name = materials[material_ids[i]].specular_texname;
             if (name.size() > 0)
             {
                 CHECKED_GL_CALL(glActiveTexture(GL_TEXTURE0 + textureNr));
                 number = std::to_string(specularNr);
                 shader->setInt(("material.texture_specular" + number).c_str(), textureNr);
                 CHECKED_GL_CALL(glBindTexture(GL_TEXTURE_2D, textures[name]));
+                RenderStats::addStateChange();
                 textureNr++;
                 specularNr++;
             }        
         }
     }
 
+    const std::vector<unsigned int> &texture_ids = meshMaterials.extraTextures;
     for (unsigned int i = 0; i < texture_ids.size(); i++)
     {
         CHECKED_GL_CALL(glActiveTexture(GL_TEXTURE0 + textureNr));
         shader->setInt(("material.texture_diffuse" + std::to_string(i+1)).c_str(), textureNr);
         CHECKED_GL_CALL(glBindTexture(GL_TEXTURE_2D, texture_ids[i]));
+        RenderStats::addStateChange();
         textureNr++;
     }
     CHECKED_GL_CALL(glActiveTexture(GL_TEXTURE0));
+}
+
+void Mesh::setVertexFormat(Program *shader)
+{
+    if (shader->hasDefine("PACKED_VERTICES"))
+    {
+        shader->setVector3f("positionScale", position_scale);
+        shader->setVector3f("positionOffset", position_offset);
+        shader->setBool("octahedralNormals", octahedral_normals);
+    }
+}
+
+void Mesh::Draw(Program *shader, const MeshMaterials &materials, size_t lod)
+{
+    bindTextures(shader, materials);
+    setVertexFormat(shader);
 
     // draw mesh
     CHECKED_GL_CALL(glBindVertexArray(VAO));
-    CHECKED_GL_CALL(glDrawArrays(GL_TRIANGLES, 0, vertices.size()));
-    // glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
+    drawElements(1, lod);
+    RenderStats::addStateChange();
+    RenderStats::addDraw(getTriangleCount(lod));
+    CHECKED_GL_CALL(glBindVertexArray(0));
+}
+
+void Mesh::DrawInstanced(Program *shader, const MeshMaterials &materials,
+                         GLuint instanceBuffer, GLintptr modelOffset, GLintptr normalOffset, GLsizei count, size_t lod)
+{
+    bindTextures(shader, materials);
+    setVertexFormat(shader);
+
+    CHECKED_GL_CALL(glBindVertexArray(VAO));
+    bindInstances(instanceBuffer, modelOffset, normalOffset);
+    drawElements(count, lod);
+    RenderStats::addStateChange();
+    RenderStats::addDraw(getTriangleCount(lod) * count);
+    CHECKED_GL_CALL(glBindVertexArray(0));
+}
+
+void Mesh::DrawInstance(Program *shader, const MeshMaterials &materials,
+                        const glm::mat4 &model, const glm::mat3 &normal, size_t lod)
+{
+    bindTextures(shader, materials);
+    setVertexFormat(shader);
+
+    CHECKED_GL_CALL(glBindVertexArray(VAO));
+    // with their arrays disabled the instance attributes read the current values,
+    // bindInstances enables them again
+    for (GLuint column = 0; column < 4; column++)
+    {
+        CHECKED_GL_CALL(glDisableVertexAttribArray(INSTANCE_MODEL_LOCATION + column));
+        CHECKED_GL_CALL(glVertexAttrib4fv(INSTANCE_MODEL_LOCATION + column, glm::value_ptr(model[column])));
+    }
+    for (GLuint column = 0; column < 3; column++)
+    {
+        CHECKED_GL_CALL(glDisableVertexAttribArray(INSTANCE_NORMAL_LOCATION + column));
+        CHECKED_GL_CALL(glVertexAttrib3fv(INSTANCE_NORMAL_LOCATION + column, glm::value_ptr(normal[column])));
+    }
+    drawElements(1, lod);
+    RenderStats::addStateChange();
+    RenderStats::addDraw(getTriangleCount(lod));
+    CHECKED_GL_CALL(glBindVertexArray(0));
+}
+
+bool Mesh::DrawMeshletsInstanced(Program *shader, const MeshMaterials &materials, StreamBuffer *stream,
+                                 GLintptr modelOffset, GLintptr normalOffset, const glm::mat4 *models, GLsizei count,
+                                 const glm::mat4 &viewProjection, const glm::vec3 &viewPos, bool reversedZ)
+{
+    if (meshlets.empty() || !GLAD_GL_VERSION_4_3)
+    {
+        return false;
+    }
+
+    // cull in each instance's model space, the meshlets' bounds stay as they are
+    meshlet_commands.clear();
+    size_t triangles = 0;
+    for (GLsizei m = 0; m < count; m++)
+    {
+        Frustum frustum = Frustum::fromMatrix(viewProjection * models[m], reversedZ);
+        glm::vec3 camera = glm::vec3(glm::inverse(models[m]) * glm::vec4(viewPos, 1.0f));
+        triangles += Meshlets::cull(meshlets, frustum, camera, (GLuint) m, meshlet_commands);
+    }
+    if (meshlet_commands.empty())
+    {
+        return true;
+    }
+    const GLsizeiptr bytes = meshlet_commands.size() * sizeof(DrawElementsIndirectCommand);
+    StreamBuffer::Allocation allocation = stream->allocate(bytes, sizeof(GLuint));
+    if (!allocation.data)
+    {
+        return false;
+    }
+    memcpy(allocation.data, meshlet_commands.data(), bytes);
+    stream->flush();
+
+    bindTextures(shader, materials);
+    setVertexFormat(shader);
+    CHECKED_GL_CALL(glBindVertexArray(VAO));
+    bindInstances(stream->getBuffer(), modelOffset, normalOffset);
+    // the base instance of each command picks its instance's matrices
+    CHECKED_GL_CALL(glBindBuffer(GL_DRAW_INDIRECT_BUFFER, stream->getBuffer()));
+    CHECKED_GL_CALL(glMultiDrawElementsIndirect(GL_TRIANGLES, layout.indexType, (void *) allocation.offset,
+                                                (GLsizei) meshlet_commands.size(), 0));
+    CHECKED_GL_CALL(glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0));
+    RenderStats::addStateChange();
+    RenderStats::addDraw(triangles);
     CHECKED_GL_CALL(glBindVertexArray(0));
+    return true;
+}
+
+void Mesh::bindInstances(GLuint instanceBuffer, GLintptr modelOffset, GLintptr normalOffset)
+{
+    // per instance model matrix (locations 3-6) and normal matrix (7-9), one column per location.
+    // The offsets move every frame, so the pointers are set on every draw.
+    CHECKED_GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer));
+    for (GLuint column = 0; column < 4; column++)
+    {
+        CHECKED_GL_CALL(glEnableVertexAttribArray(INSTANCE_MODEL_LOCATION + column));
+        CHECKED_GL_CALL(glVertexAttribPointer(INSTANCE_MODEL_LOCATION + column, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4),
+                                              (void *)(modelOffset + column * sizeof(glm::vec4))));
+        CHECKED_GL_CALL(glVertexAttribDivisor(INSTANCE_MODEL_LOCATION + column, 1));
+    }
+    for (GLuint column = 0; column < 3; column++)
+    {
+        CHECKED_GL_CALL(glEnableVertexAttribArray(INSTANCE_NORMAL_LOCATION + column));
+        CHECKED_GL_CALL(glVertexAttribPointer(INSTANCE_NORMAL_LOCATION + column, 3, GL_FLOAT, GL_FALSE, sizeof(glm::mat3),
+                                              (void *)(normalOffset + column * sizeof(glm::vec3))));
+        CHECKED_GL_CALL(glVertexAttribDivisor(INSTANCE_NORMAL_LOCATION + column, 1));
+    }
+    CHECKED_GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, 0));
+}
+
+void Mesh::drawElements(GLsizei instances, size_t lod)
+{
+    if (!layout.indexType)
+    {
+        CHECKED_GL_CALL(glDrawArraysInstanced(GL_TRIANGLES, 0, layout.vertexCount, instances));
+    }
+    else if (!lods.empty())
+    {
+        const MeshLod &level = lods[std::min(lod, lods.size() - 1)];
+        CHECKED_GL_CALL(glDrawElementsInstanced(GL_TRIANGLES, level.indexCount, layout.indexType, (void *) level.indexOffset, instances));
+    }
+    else
+    {
+        CHECKED_GL_CALL(glDrawElementsInstanced(GL_TRIANGLES, layout.indexCount, layout.indexType, (void *) layout.indexOffset, instances));
+    }
+}
+
+size_t Mesh::getTriangleCount(size_t lod) const
+{
+    if (!lods.empty())
+    {
+        return lods[std::min(lod, lods.size() - 1)].indexCount / 3;
+    }
+    return (layout.indexType ? layout.indexCount : layout.vertexCount) / 3;
+}
+
+void Mesh::generateLods(const MeshSimplifier::Options &options)
+{
+    if (external_buffer || indices.empty() || !lods.empty())
+    {
+        return;
+    }
+
+    MeshLod full;
+    full.indexCount = layout.indexCount;
+    full.indexOffset = layout.indexOffset;
+    lods.push_back(full);
+
+    // each level is simplified from the one before, which is faster than starting
+    // over and keeps the levels nested. The errors add up as an upper bound.
+    std::vector<uint32_t> previous(indices);
+    while (lods.size() < MAX_LODS)
+    {
+        size_t target = previous.size() / 6 * 3;
+        float error;
+        std::vector<uint32_t> simplified = MeshSimplifier::simplify(vertices, previous, target, options, error);
+        // stop once the simplifier is stuck on locked vertices or the error limit
+        if (simplified.empty() || simplified.size() > previous.size() * 3 / 4)
+        {
+            break;
+        }
+
+        MeshLod level;
+        level.indexCount = (GLsizei) simplified.size();
+        level.indexOffset = (GLintptr)(indices.size() * sizeof(uint32_t));
+        level.error = lods.back().error + error;
+        lods.push_back(level);
+        indices.insert(indices.end(), simplified.begin(), simplified.end());
+        previous = std::move(simplified);
+    }
+    if (lods.size() == 1)
+    {
+        lods.clear();
+    }
+}
+
+void Mesh::buildMeshlets()
+{
+    if (external_buffer || indices.empty() || !meshlets.empty())
+    {
+        return;
+    }
+    // the full level is the start of the index buffer, generated levels follow it
+    size_t count = lods.empty() ? indices.size() : (size_t) lods[0].indexCount;
+    meshlets = Meshlets::build(vertices, indices.data(), count);
 }
 
 void Mesh::center(glm::vec3 model_min, glm::vec3 model_max)
@@ -124,9 +388,10 @@ void Mesh::center(glm::vec3 model_min, glm::vec3 model_max)
     }
 }
 
-void Mesh::addTexture(int texture_id)
+void Mesh::setTransform(const glm::mat4 &transform)
 {
-    texture_ids.push_back(texture_id);
+    this->transform = transform;
+    transformed = transform != glm::mat4(1.0f);
 }
 
 float min(float x, float y)
@@ -0,0 +1,355 @@
+#include "MeshSimplifier.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    // symmetric 4x4 error quadric of area weighted planes
+    struct Quadric
+    {
+        double a00 = 0, a01 = 0, a02 = 0, a11 = 0, a12 = 0, a22 = 0;
+        double b0 = 0, b1 = 0, b2 = 0, c = 0;
+        double weight = 0;
+
+        void addPlane(const glm::dvec3 &n, double d, double w)
+        {
+            a00 += w * n.x * n.x; a01 += w * n.x * n.y; a02 += w * n.x * n.z;
+            a11 += w * n.y * n.y; a12 += w * n.y * n.z; a22 += w * n.z * n.z;
+            b0 += w * n.x * d; b1 += w * n.y * d; b2 += w * n.z * d;
+            c += w * d * d;
+            weight += w;
+        }
+
+        Quadric &operator+=(const Quadric &q)
+        {
+            a00 += q.a00; a01 += q.a01; a02 += q.a02; a11 += q.a11; a12 += q.a12; a22 += q.a22;
+            b0 += q.b0; b1 += q.b1; b2 += q.b2; c += q.c;
+            weight += q.weight;
+            return *this;
+        }
+
+        // mean squared distance of p to the planes
+        double evaluate(const glm::dvec3 &p) const
+        {
+            if (weight <= 0.0)
+            {
+                return 0.0;
+            }
+            double q = a00 * p.x * p.x + a11 * p.y * p.y + a22 * p.z * p.z
+                     + 2.0 * (a01 * p.x * p.y + a02 * p.x * p.z + a12 * p.y * p.z)
+                     + 2.0 * (b0 * p.x + b1 * p.y + b2 * p.z) + c;
+            return std::max(q / weight, 0.0);
+        }
+    };
+
+    struct Collapse
+    {
+        uint32_t from;
+        uint32_t to;
+        double cost;
+    };
+
+    // triangles around each vertex, as offsets into an index list
+    struct Adjacency
+    {
+        std::vector<uint32_t> offsets;
+        std::vector<uint32_t> triangles;
+
+        Adjacency(const std::vector<uint32_t> &indices, size_t vertexCount)
+            : offsets(vertexCount + 1, 0), triangles(indices.size())
+        {
+            for (uint32_t index : indices)
+            {
+                offsets[index + 1]++;
+            }
+            for (size_t v = 0; v < vertexCount; v++)
+            {
+                offsets[v + 1] += offsets[v];
+            }
+            std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+            for (size_t i = 0; i < indices.size(); i++)
+            {
+                triangles[fill[indices[i]]++] = (uint32_t)(i - i % 3);
+            }
+        }
+
+        // an edge with a triangle on one side only
+        bool isOpen(const std::vector<uint32_t> &indices, uint32_t a, uint32_t b) const
+        {
+            int count = 0;
+            for (uint32_t i = offsets[a]; i < offsets[a + 1]; i++)
+            {
+                const uint32_t *triangle = &indices[triangles[i]];
+                count += triangle[0] == b || triangle[1] == b || triangle[2] == b;
+            }
+            return count == 1;
+        }
+    };
+}
+
+namespace MeshSimplifier
+{
+    std::vector<uint32_t> simplify(const std::vector<Vertex> &vertices, const std::vector<uint32_t> &indices,
+                                   size_t targetIndexCount, const Options &options, float &error)
+    {
+        error = 0.0f;
+        std::vector<uint32_t> result(indices);
+        const size_t vertexCount = vertices.size();
+        if (result.size() <= targetIndexCount || result.size() % 3 != 0)
+        {
+            return result;
+        }
+
+        // work in a unit box so the error options do not depend on the mesh's size
+        glm::vec3 minimum(std::numeric_limits<float>::max());
+        glm::vec3 maximum(-std::numeric_limits<float>::max());
+        for (uint32_t index : result)
+        {
+            minimum = glm::min(minimum, vertices[index].Position);
+            maximum = glm::max(maximum, vertices[index].Position);
+        }
+        glm::vec3 size = maximum - minimum;
+        double extent = std::max(std::max(size.x, size.y), size.z);
+        if (extent <= 0.0)
+        {
+            return result;
+        }
+        std::vector<glm::dvec3> positions(vertexCount);
+        for (size_t v = 0; v < vertexCount; v++)
+        {
+            positions[v] = glm::dvec3(vertices[v].Position - minimum) / extent;
+        }
+
+        // vertices sharing a position with another one sit on an attribute seam
+        std::vector<char> locked(vertexCount, 0);
+        std::vector<char> border(vertexCount, 0);
+        {
+            std::vector<uint32_t> used(result);
+            std::sort(used.begin(), used.end());
+            used.erase(std::unique(used.begin(), used.end()), used.end());
+            std::sort(used.begin(), used.end(), [&](uint32_t a, uint32_t b)
+            {
+                const glm::vec3 &p = vertices[a].Position, &q = vertices[b].Position;
+                return p.x != q.x ? p.x < q.x : p.y != q.y ? p.y < q.y : p.z < q.z;
+            });
+            for (size_t i = 1; i < used.size(); i++)
+            {
+                if (vertices[used[i]].Position == vertices[used[i - 1]].Position)
+                {
+                    locked[used[i]] = locked[used[i - 1]] = 1;
+                }
+            }
+        }
+
+        std::vector<Quadric> quadrics(vertexCount);
+        Adjacency initialAdjacency(result, vertexCount);
+        for (size_t t = 0; t < result.size(); t += 3)
+        {
+            const glm::dvec3 &p0 = positions[result[t]], &p1 = positions[result[t + 1]], &p2 = positions[result[t + 2]];
+            glm::dvec3 normal = glm::cross(p1 - p0, p2 - p0);
+            double length = glm::length(normal);
+            if (length > 0.0)
+            {
+                normal /= length;
+                double d = -glm::dot(normal, p0);
+                for (int e = 0; e < 3; e++)
+                {
+                    quadrics[result[t + e]].addPlane(normal, d, 0.5 * length);
+                }
+            }
+
+            for (int e = 0; e < 3; e++)
+            {
+                uint32_t a = result[t + e], b = result[t + (e + 1) % 3];
+                if (!initialAdjacency.isOpen(result, a, b))
+                {
+                    continue;
+                }
+                border[a] = border[b] = 1;
+                if (options.lockBorders)
+                {
+                    locked[a] = locked[b] = 1;
+                }
+                else if (length > 0.0)
+                {
+                    // a plane through the edge, perpendicular to the triangle, keeps the outline in place
+                    glm::dvec3 edge = positions[b] - positions[a];
+                    glm::dvec3 side = glm::cross(edge, normal);
+                    double sideLength = glm::length(side);
+                    if (sideLength > 0.0)
+                    {
+                        side /= sideLength;
+                        double w = glm::dot(edge, edge);
+                        quadrics[a].addPlane(side, -glm::dot(side, positions[a]), w);
+                        quadrics[b].addPlane(side, -glm::dot(side, positions[b]), w);
+                    }
+                }
+            }
+        }
+
+        const double maxErrorSquared = (double) options.maxError * options.maxError;
+        const double attributeWeightSquared = (double) options.attributeWeight * options.attributeWeight;
+        auto cost = [&](uint32_t from, uint32_t to)
+        {
+            Quadric q = quadrics[from];
+            q += quadrics[to];
+            // normals differ by at most 2, texture coordinates are usually within [0, 1]
+            glm::vec3 normal = vertices[from].Normal - vertices[to].Normal;
+            glm::vec2 texCoord = vertices[from].TexCoord - vertices[to].TexCoord;
+            double attributes = 0.25 * glm::dot(normal, normal) + glm::dot(texCoord, texCoord);
+            return q.evaluate(positions[to]) + attributeWeightSquared * attributes;
+        };
+
+        double worst = 0.0;
+        std::vector<uint32_t> remap(vertexCount);
+        std::vector<char> touched(vertexCount);
+        std::vector<uint32_t> fromNeighbours, toNeighbours, wings;
+        std::vector<Collapse> collapses;
+        // each pass collapses independent edges in order of cost, then rebuilds the triangles
+        while (result.size() > targetIndexCount)
+        {
+            Adjacency adjacency(result, vertexCount);
+
+            collapses.clear();
+            for (size_t t = 0; t < result.size(); t += 3)
+            {
+                for (int e = 0; e < 3; e++)
+                {
+                    uint32_t a = result[t + e], b = result[t + (e + 1) % 3];
+                    bool open = (border[a] || border[b]) && adjacency.isOpen(result, a, b);
+                    // the triangle on the other side of an edge adds the same two collapses
+                    if (a > b && !open)
+                    {
+                        continue;
+                    }
+                    for (int direction = 0; direction < 2; direction++)
+                    {
+                        uint32_t from = direction ? b : a, to = direction ? a : b;
+                        // border vertices only slide along the border
+                        if (locked[from] || (border[from] && !open))
+                        {
+                            continue;
+                        }
+                        collapses.push_back({from, to, cost(from, to)});
+                    }
+                }
+            }
+            std::sort(collapses.begin(), collapses.end(), [](const Collapse &a, const Collapse &b) { return a.cost < b.cost; });
+
+            for (size_t v = 0; v < vertexCount; v++)
+            {
+                remap[v] = (uint32_t) v;
+            }
+            std::fill(touched.begin(), touched.end(), 0);
+            const size_t trianglesToRemove = (result.size() - targetIndexCount + 2) / 3;
+            size_t removed = 0;
+            for (const Collapse &collapse : collapses)
+            {
+                if (collapse.cost > maxErrorSquared || removed >= trianglesToRemove)
+                {
+                    break;
+                }
+                if (touched[collapse.from] || touched[collapse.to])
+                {
+                    continue;
+                }
+
+                // no triangle may flip, and the edge's ends may only have the third vertices of
+                // the triangles on the edge in common, or the collapse would fold the surface
+                bool valid = true;
+                size_t sharedTriangles = 0;
+                fromNeighbours.clear();
+                toNeighbours.clear();
+                wings.clear();
+                for (uint32_t i = adjacency.offsets[collapse.from]; valid && i < adjacency.offsets[collapse.from + 1]; i++)
+                {
+                    const uint32_t *triangle = &result[adjacency.triangles[i]];
+                    bool shared = triangle[0] == collapse.to || triangle[1] == collapse.to || triangle[2] == collapse.to;
+                    for (int c = 0; c < 3; c++)
+                    {
+                        if (triangle[c] != collapse.from && triangle[c] != collapse.to)
+                        {
+                            (shared ? wings : fromNeighbours).push_back(triangle[c]);
+                        }
+                    }
+                    if (shared)
+                    {
+                        sharedTriangles++;
+                        continue;
+                    }
+                    glm::dvec3 before[3], after[3];
+                    for (int c = 0; c < 3; c++)
+                    {
+                        before[c] = positions[triangle[c]];
+                        after[c] = triangle[c] == collapse.from ? positions[collapse.to] : before[c];
+                    }
+                    glm::dvec3 normalBefore = glm::cross(before[1] - before[0], before[2] - before[0]);
+                    glm::dvec3 normalAfter = glm::cross(after[1] - after[0], after[2] - after[0]);
+                    valid = glm::dot(normalBefore, normalAfter) > 0.0;
+                }
+                if (!valid || sharedTriangles == 0)
+                {
+                    continue;
+                }
+                for (uint32_t i = adjacency.offsets[collapse.to]; i < adjacency.offsets[collapse.to + 1]; i++)
+                {
+                    const uint32_t *triangle = &result[adjacency.triangles[i]];
+                    for (int c = 0; c < 3; c++)
+                    {
+                        if (triangle[c] != collapse.from && triangle[c] != collapse.to)
+                        {
+                            toNeighbours.push_back(triangle[c]);
+                        }
+                    }
+                }
+                std::sort(toNeighbours.begin(), toNeighbours.end());
+                bool folds = false;
+                for (uint32_t neighbour : fromNeighbours)
+                {
+                    folds |= std::binary_search(toNeighbours.begin(), toNeighbours.end(), neighbour) &&
+                             std::find(wings.begin(), wings.end(), neighbour) == wings.end();
+                }
+                if (folds)
+                {
+                    continue;
+                }
+
+                remap[collapse.from] = collapse.to;
+                quadrics[collapse.to] += quadrics[collapse.from];
+                worst = std::max(worst, collapse.cost);
+                removed += sharedTriangles;
+                touched[collapse.from] = touched[collapse.to] = 1;
+                for (uint32_t neighbour : fromNeighbours)
+                {
+                    touched[neighbour] = 1;
+                }
+                for (uint32_t neighbour : wings)
+                {
+                    touched[neighbour] = 1;
+                }
+            }
+            if (removed == 0)
+            {
+                break;
+            }
+
+            // drop the triangles that collapsed
+            size_t write = 0;
+            for (size_t t = 0; t < result.size(); t += 3)
+            {
+                uint32_t a = remap[result[t]], b = remap[result[t + 1]], c = remap[result[t + 2]];
+                if (a != b && b != c && a != c)
+                {
+                    result[write++] = a;
+                    result[write++] = b;
+                    result[write++] = c;
+                }
+            }
+            result.resize(write);
+        }
+
+        error = (float)(std::sqrt(worst) * extent);
+        return result;
+    }
+}
@@ -0,0 +1,230 @@
+#include "Meshlets.h"
+#include "Mesh.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+namespace
+{
+    // the bounding sphere of the meshlet's vertices and the cone around its face normals
+    void computeBounds(const std::vector<Vertex> &vertices, const uint32_t *triangles, Meshlets::Meshlet &meshlet,
+                       const std::vector<uint32_t> &meshletVertices)
+    {
+        glm::vec3 minimum(std::numeric_limits<float>::max());
+        glm::vec3 maximum(-std::numeric_limits<float>::max());
+        for (uint32_t v : meshletVertices)
+        {
+            minimum = glm::min(minimum, vertices[v].Position);
+            maximum = glm::max(maximum, vertices[v].Position);
+        }
+        meshlet.center = 0.5f * (minimum + maximum);
+        meshlet.radius = 0.0f;
+        for (uint32_t v : meshletVertices)
+        {
+            meshlet.radius = std::max(meshlet.radius, glm::length(vertices[v].Position - meshlet.center));
+        }
+
+        std::vector<glm::vec3> normals;
+        glm::vec3 axis(0.0f);
+        for (uint32_t t = 0; t < meshlet.triangleCount; t++)
+        {
+            const uint32_t *triangle = triangles + 3 * t;
+            glm::vec3 p0 = vertices[triangle[0]].Position;
+            glm::vec3 normal = glm::cross(vertices[triangle[1]].Position - p0, vertices[triangle[2]].Position - p0);
+            float length = glm::length(normal);
+            if (length > 0.0f)
+            {
+                normals.push_back(normal / length);
+                axis += normals.back();
+            }
+        }
+        meshlet.coneCutoff = 2.0f;
+        float axisLength = glm::length(axis);
+        if (normals.empty() || axisLength <= 0.0f)
+        {
+            return;
+        }
+        meshlet.coneAxis = axis / axisLength;
+        float minimumDot = 1.0f;
+        for (const glm::vec3 &normal : normals)
+        {
+            minimumDot = std::min(minimumDot, glm::dot(normal, meshlet.coneAxis));
+        }
+        // faces 90 degrees or more apart always have one facing the camera
+        if (minimumDot > 0.0f)
+        {
+            meshlet.coneCutoff = std::sqrt(1.0f - minimumDot * minimumDot);
+        }
+    }
+}
+
+namespace Meshlets
+{
+    std::vector<Meshlet> build(const std::vector<Vertex> &vertices, uint32_t *indices, size_t indexCount)
+    {
+        std::vector<Meshlet> meshlets;
+        const size_t triangleCount = indexCount / 3;
+        if (triangleCount == 0)
+        {
+            return meshlets;
+        }
+
+        // triangles around each vertex
+        std::vector<uint32_t> offsets(vertices.size() + 1, 0);
+        for (size_t i = 0; i < triangleCount * 3; i++)
+        {
+            offsets[indices[i] + 1]++;
+        }
+        for (size_t v = 0; v < vertices.size(); v++)
+        {
+            offsets[v + 1] += offsets[v];
+        }
+        std::vector<uint32_t> adjacent(triangleCount * 3);
+        {
+            std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+            for (size_t i = 0; i < triangleCount * 3; i++)
+            {
+                adjacent[fill[indices[i]]++] = (uint32_t)(i / 3);
+            }
+        }
+
+        std::vector<uint32_t> ordered;
+        ordered.reserve(triangleCount * 3);
+        std::vector<char> emitted(triangleCount, 0);
+        std::vector<char> inMeshlet(vertices.size(), 0);
+        std::vector<uint32_t> meshletVertices;
+        std::vector<uint32_t> candidates;
+        size_t seed = 0;
+        while (true)
+        {
+            while (seed < triangleCount && emitted[seed])
+            {
+                seed++;
+            }
+            if (seed == triangleCount)
+            {
+                break;
+            }
+
+            // grow from the seed through shared vertices, always taking the triangle that
+            // adds the fewest new vertices and, among those, the one nearest the meshlet's
+            // centroid. Round meshlets have tighter bounds and leave fewer scraps behind.
+            Meshlet meshlet;
+            meshlet.firstTriangle = (uint32_t)(ordered.size() / 3);
+            glm::vec3 centroidSum(0.0f);
+            candidates.assign(1, (uint32_t) seed);
+            while (meshlet.triangleCount < MAX_TRIANGLES)
+            {
+                glm::vec3 centroid = meshletVertices.empty() ? glm::vec3(0.0f) : centroidSum / (float) meshletVertices.size();
+                size_t best = SIZE_MAX;
+                int bestNewVertices = 4;
+                float bestDistance = std::numeric_limits<float>::max();
+                for (size_t i = 0; i < candidates.size(); i++)
+                {
+                    if (emitted[candidates[i]])
+                    {
+                        candidates[i--] = candidates.back();
+                        candidates.pop_back();
+                        continue;
+                    }
+                    const uint32_t *triangle = indices + 3 * candidates[i];
+                    int newVertices = !inMeshlet[triangle[0]] + !inMeshlet[triangle[1]] + !inMeshlet[triangle[2]];
+                    if (newVertices > bestNewVertices || meshletVertices.size() + newVertices > MAX_VERTICES)
+                    {
+                        continue;
+                    }
+                    glm::vec3 center = (vertices[triangle[0]].Position + vertices[triangle[1]].Position + vertices[triangle[2]].Position) / 3.0f;
+                    float distance = glm::dot(center - centroid, center - centroid);
+                    if (newVertices < bestNewVertices || distance < bestDistance)
+                    {
+                        best = i;
+                        bestNewVertices = newVertices;
+                        bestDistance = distance;
+                    }
+                }
+                if (best == SIZE_MAX)
+                {
+                    break;
+                }
+
+                uint32_t t = candidates[best];
+                candidates[best] = candidates.back();
+                candidates.pop_back();
+                emitted[t] = 1;
+                meshlet.triangleCount++;
+                for (int c = 0; c < 3; c++)
+                {
+                    uint32_t v = indices[3 * t + c];
+                    ordered.push_back(v);
+                    if (inMeshlet[v])
+                    {
+                        continue;
+                    }
+                    inMeshlet[v] = 1;
+                    meshletVertices.push_back(v);
+                    centroidSum += vertices[v].Position;
+                    for (uint32_t i = offsets[v]; i < offsets[v + 1]; i++)
+                    {
+                        if (!emitted[adjacent[i]])
+                        {
+                            candidates.push_back(adjacent[i]);
+                        }
+                    }
+                }
+            }
+
+            meshlet.vertexCount = (uint32_t) meshletVertices.size();
+            computeBounds(vertices, ordered.data() + 3 * meshlet.firstTriangle, meshlet, meshletVertices);
+            meshlets.push_back(meshlet);
+            for (uint32_t v : meshletVertices)
+            {
+                inMeshlet[v] = 0;
+            }
+            meshletVertices.clear();
+        }
+
+        std::copy(ordered.begin(), ordered.end(), indices);
+        return meshlets;
+    }
+
+    bool isBackFacing(const Meshlet &meshlet, const glm::vec3 &camera)
+    {
+        // the angle to the axis plus the cone's spread has to stay under 90 degrees
+        // for every point of the bounding sphere
+        glm::vec3 toCenter = meshlet.center - camera;
+        return glm::dot(toCenter, meshlet.coneAxis) >= meshlet.coneCutoff * glm::length(toCenter) + meshlet.radius;
+    }
+
+    bool isVisible(const Meshlet &meshlet, const Frustum &frustum, const glm::vec3 &camera)
+    {
+        return frustum.intersectsSphere(meshlet.center, meshlet.radius) && !isBackFacing(meshlet, camera);
+    }
+
+    size_t cull(const std::vector<Meshlet> &meshlets, const Frustum &frustum, const glm::vec3 &camera,
+                GLuint baseInstance, std::vector<DrawElementsIndirectCommand> &commands)
+    {
+        size_t triangles = 0;
+        bool extend = false;
+        for (const Meshlet &meshlet : meshlets)
+        {
+            if (!isVisible(meshlet, frustum, camera))
+            {
+                extend = false;
+                continue;
+            }
+            if (extend)
+            {
+                commands.back().count += 3 * meshlet.triangleCount;
+            }
+            else
+            {
+                commands.push_back({3 * meshlet.triangleCount, 1, 3 * meshlet.firstTriangle, 0, baseInstance});
+            }
+            extend = true;
+            triangles += meshlet.triangleCount;
+        }
+        return triangles;
+    }
+}
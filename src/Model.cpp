@@ -1,70 +1,299 @@
 #include "Model.h"
+#include "GltfLoader.h"
+#include "MeshSimplifier.h"
+#include "ModelRegistry.h"
+#include "ObjParser.h"
+#include "TransformKernels.h"
 
-std::map<std::string, unsigned int> Model::textures_loaded;
+#include <algorithm>
+#include <cctype>
+#include <cstring>
 
-Model::Model(const std::string &path)
+std::map<std::string, unsigned int> ModelAsset::textures_loaded;
+
+ModelAsset::ModelAsset(const std::string &path, const ModelImportOptions &options)
+{
+    loadModel(path, options);
+}
+
+ModelAsset::~ModelAsset()
+{
+    for (unsigned int i = 0; i < meshes.size(); i++)
+    {
+        meshes[i].clearBuffers();
+    }
+    CHECKED_GL_CALL(glDeleteBuffers(1, &gltf_buffer));
+}
+
+Model::Model(std::shared_ptr<ModelAsset> asset)
+    : asset(std::move(asset))
 {
+    materials = this->asset->materials;
     // default model position
     model_matrices.push_back(glm::mat4(1.0f));
+}
 
-    loadModel(path);
+MeshMaterials Model::getMeshMaterials()
+{
+    return MeshMaterials{materials, ModelAsset::textures_loaded, extra_textures};
 }
 
-void Model::clearBuffers()
+void Model::updateNormalMatrices(const std::vector<glm::mat4> &instances)
 {
-    for (unsigned int i = 0; i < meshes.size(); i++)
+    size_t count = instances.size();
+    if (normal_source_matrices.size() != count)
     {
-        meshes[i].clearBuffers();
+        normal_source_matrices.resize(count, glm::mat4(0.0f));
+        normal_matrices.resize(count);
+    }
+
+    // recompute runs of changed matrices in batches
+    size_t i = 0;
+    while (i < count)
+    {
+        if (normal_source_matrices[i] == instances[i])
+        {
+            i++;
+            continue;
+        }
+        size_t start = i;
+        while (i < count && normal_source_matrices[i] != instances[i])
+        {
+            normal_source_matrices[i] = instances[i];
+            i++;
+        }
+        TransformKernels::normalMatrices(&instances[start], &normal_matrices[start], i - start);
     }
 }
 
-void Model::Draw(Program *shader)
+size_t streamInstances(StreamBuffer &stream, const glm::mat4 *models, const glm::mat3 *normals, size_t count,
+                       const std::function<void(size_t, GLsizei, GLintptr, GLintptr)> &draw)
 {
-    for (glm::mat4 &m : model_matrices)
+    // as many instances as a region holds, with room for aligning the normals
+    const GLsizeiptr instanceBytes = sizeof(glm::mat4) + sizeof(glm::mat3);
+    size_t chunk = std::min(count, (size_t) std::max<GLsizeiptr>(stream.getRegionSize() - 16, 0) / instanceBytes);
+    size_t first = 0;
+    while (first < count && chunk > 0)
     {
-        shader->setMat4("model", m);
+        const size_t chunkCount = std::min(chunk, count - first);
+        const GLsizeiptr modelBytes = chunkCount * sizeof(glm::mat4);
+        const GLsizeiptr normalBytes = chunkCount * sizeof(glm::mat3);
+        StreamBuffer::Allocation modelAllocation = stream.allocate(modelBytes);
+        StreamBuffer::Allocation normalAllocation;
+        if (modelAllocation.data)
+        {
+            memcpy(modelAllocation.data, models + first, modelBytes);
+            normalAllocation = stream.allocate(normalBytes);
+            if (normalAllocation.data)
+            {
+                memcpy(normalAllocation.data, normals + first, normalBytes);
+            }
+            stream.flush();
+        }
+        if (!normalAllocation.data)
+        {
+            // the rest of the region may still hold fewer
+            chunk = chunkCount / 2;
+            continue;
+        }
+        draw(first, (GLsizei) chunkCount, modelAllocation.offset, normalAllocation.offset);
+        first += chunkCount;
+    }
+    return first;
+}
 
-        for (unsigned int i = 0; i < meshes.size(); i++)
+void Model::selectLods(const std::vector<glm::mat4> &instances, const DrawView &view)
+{
+    instance_lods.resize(instances.size(), 0);
+    const std::vector<float> &lod_errors = asset->lod_errors;
+    const size_t coarsest = lod_errors.size() - 1;
+    for (size_t m = 0; m < instances.size(); m++)
+    {
+        const glm::mat4 &matrix = instances[m];
+        float scale = std::sqrt(std::max(std::max(glm::dot(matrix[0], matrix[0]), glm::dot(matrix[1], matrix[1])), glm::dot(matrix[2], matrix[2])));
+        // from the nearest point of the bounding sphere, inside it nothing is coarse enough
+        float distance = glm::length(glm::vec3(matrix[3]) - view.viewPos) - asset->bounding_radius * scale;
+        size_t current = instance_lods[m];
+        size_t level = 0;
+        if (distance > 0.0f)
         {
-            meshes[i].Draw(shader, materials, textures_loaded);
+            float pixelsPerError = view.pixelScale * scale / distance;
+            for (level = coarsest; level > 0; level--)
+            {
+                float limit = level > current ? view.pixelError * (1.0f - view.hysteresis) : view.pixelError;
+                if (lod_errors[level] * pixelsPerError <= limit)
+                {
+                    break;
+                }
+            }
         }
+        instance_lods[m] = (unsigned char) level;
     }
 }
 
-void Model::loadModel(const std::string &path)
+size_t Model::drawMeshesInstanced(Program *shader, StreamBuffer *stream, const glm::mat4 *models, const glm::mat3 *normals,
+                                  size_t count, size_t lod, const DrawView *view)
 {
-    tinyobj::ObjReader reader;
-    tinyobj::ObjReaderConfig reader_config;
+    MeshMaterials meshMaterials = getMeshMaterials();
+    return streamInstances(*stream, models, normals, count,
+                           [&](size_t first, GLsizei chunkCount, GLintptr modelOffset, GLintptr normalOffset)
+    {
+        for (Mesh &mesh : asset->meshes)
+        {
+            // meshlets only cover the full level
+            if (lod == 0 && view && view->cullMeshlets &&
+                mesh.DrawMeshletsInstanced(shader, meshMaterials, stream, modelOffset, normalOffset, models + first,
+                                           chunkCount, view->viewProjection, view->viewPos, view->reversedZ))
+            {
+                continue;
+            }
+            mesh.DrawInstanced(shader, meshMaterials, stream->getBuffer(), modelOffset, normalOffset, chunkCount, lod);
+        }
+    });
+}
 
-    if (!reader.ParseFromFile(path, reader_config))
+void Model::drawLodsInstanced(Program *shader, const std::vector<glm::mat4> &instances, StreamBuffer *stream,
+                              const DrawView *view)
+{
+    for (size_t lod = 0; lod < asset->lod_errors.size(); lod++)
     {
-        if (!reader.Error().empty())
+        mesh_model_matrices.clear();
+        mesh_normal_matrices.clear();
+        for (size_t m = 0; m < instances.size(); m++)
         {
-            std::cerr << "TinyObjReader: " << reader.Error();
+            if (instance_lods[m] == lod)
+            {
+                mesh_model_matrices.push_back(instances[m]);
+                mesh_normal_matrices.push_back(normal_matrices[m]);
+            }
+        }
+        const size_t count = mesh_model_matrices.size();
+        size_t drawn = drawMeshesInstanced(shader, stream, mesh_model_matrices.data(), mesh_normal_matrices.data(),
+                                           count, lod, view);
+        drawOneByOne(shader, mesh_model_matrices.data() + drawn, mesh_normal_matrices.data() + drawn, count - drawn,
+                     0, asset->meshes.size(), lod);
+    }
+}
+
+void Model::drawOneByOne(Program *shader, const glm::mat4 *models, const glm::mat3 *normals, size_t count,
+                         size_t firstMesh, size_t endMesh, size_t lod, const unsigned char *lods)
+{
+    std::vector<Mesh> &meshes = asset->meshes;
+    MeshMaterials meshMaterials = getMeshMaterials();
+    // INSTANCED turns model and normalMatrix into instance attributes
+    const bool instanced = shader->hasDefine("INSTANCED");
+    for (size_t m = 0; m < count; m++)
+    {
+        size_t level = lods ? lods[m] : lod;
+        for (size_t i = firstMesh; i < endMesh; i++)
+        {
+            glm::mat4 model = models[m];
+            glm::mat3 normal = normals[m];
+            if (meshes[i].hasTransform())
+            {
+                model = models[m] * meshes[i].getTransform();
+                TransformKernels::normalMatrices(&model, &normal, 1);
+            }
+            if (instanced)
+            {
+                meshes[i].DrawInstance(shader, meshMaterials, model, normal, level);
+                continue;
+            }
+            shader->setMat4("model", model);
+            shader->setMat3("normalMatrix", normal);
+            meshes[i].Draw(shader, meshMaterials, level);
+        }
+    }
+}
+
+void Model::Draw(Program *shader, const std::vector<glm::mat4> &instances, StreamBuffer *stream, const DrawView *view)
+{
+    updateNormalMatrices(instances);
+    if (view && view->pixelScale > 0.0f && asset->lod_errors.size() > 1)
+    {
+        selectLods(instances, *view);
+    }
+    else
+    {
+        instance_lods.clear();
+    }
+
+    std::vector<Mesh> &meshes = asset->meshes;
+    const size_t count = instances.size();
+    if (!stream || !shader->hasDefine("INSTANCED"))
+    {
+        drawOneByOne(shader, instances.data(), normal_matrices.data(), count, 0, meshes.size(), 0,
+                     instance_lods.empty() ? nullptr : instance_lods.data());
+    }
+    else if (!instance_lods.empty())
+    {
+        drawLodsInstanced(shader, instances, stream, view);
+    }
+    else if (!asset->mesh_transforms)
+    {
+        size_t drawn = drawMeshesInstanced(shader, stream, instances.data(), normal_matrices.data(), count, 0, view);
+        drawOneByOne(shader, instances.data() + drawn, normal_matrices.data() + drawn, count - drawn,
+                     0, meshes.size(), 0);
+    }
+    else
+    {
+        mesh_model_matrices.resize(count);
+        mesh_normal_matrices.resize(count);
+        MeshMaterials meshMaterials = getMeshMaterials();
+        for (size_t i = 0; i < meshes.size(); i++)
+        {
+            const Mesh &mesh = meshes[i];
+            const glm::mat4 *models = instances.data();
+            const glm::mat3 *normals = normal_matrices.data();
+            if (mesh.hasTransform())
+            {
+                TransformKernels::multiply(instances.data(), mesh.getTransform(), mesh_model_matrices.data(), count);
+                TransformKernels::normalMatrices(mesh_model_matrices.data(), mesh_normal_matrices.data(), count);
+                models = mesh_model_matrices.data();
+                normals = mesh_normal_matrices.data();
+            }
+            size_t drawn = streamInstances(*stream, models, normals, count,
+                                           [&](size_t, GLsizei chunkCount, GLintptr modelOffset, GLintptr normalOffset)
+            {
+                meshes[i].DrawInstanced(shader, meshMaterials, stream->getBuffer(), modelOffset, normalOffset, chunkCount);
+            });
+            // drawOneByOne applies the mesh transform itself
+            drawOneByOne(shader, instances.data() + drawn, normal_matrices.data() + drawn, count - drawn,
+                         i, i + 1, 0);
         }
-        exit(1);
     }
+}
 
-    if (!reader.Warning().empty())
+void ModelAsset::loadModel(const std::string &path, const ModelImportOptions &options)
+{
+    size_t dot = path.find_last_of('.');
+    std::string extension = dot == std::string::npos ? "" : path.substr(dot);
+    std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+    if (extension == ".glb" || extension == ".gltf")
     {
-        std::cout << "TinyObjReader: " << reader.Warning();
+        loadGltf(path);
+        return;
+    }
+
+    ObjModel obj;
+    if (!ObjParser::load(path, obj))
+    {
+        std::cerr << "Could not load model '" << path << "'" << std::endl;
+        exit(1);
     }
     resource_directory = path.substr(0, path.find_last_of('/'));
 
-    auto& attribs = reader.GetAttrib();
-    auto& shapes = reader.GetShapes();
-    auto& mats = reader.GetMaterials();
-    
-    materials.assign(mats.begin(), mats.end());
+    materials = std::move(obj.materials);
+    model_min = obj.min;
+    model_max = obj.max;
 
     // append default material
     // materials.push_back(tinyobj::material_t());
 
-    // loop over shapes
-    for (size_t s = 0; s < shapes.size(); s++)
+    // one mesh per shape
+    for (ObjShape &shape : obj.shapes)
     {
-        Mesh mesh = processMesh(shapes[s], attribs, materials);
-        meshes.push_back(mesh);
+        meshes.push_back(Mesh(std::move(shape.vertices), std::move(shape.indices), std::move(shape.material_ids)));
     }
 
     // load textures
@@ -72,15 +301,91 @@ void Model::loadModel(const std::string &path)
     {
         loadMaterialTextures(m);
     }
-    // center meshes and bind buffers
+    // center meshes, simplify them, cluster them and bind buffers
     for (Mesh &mesh : meshes)
     {
         mesh.center(model_min, model_max);
-        mesh.setupMesh();
+        if (options.generateLods)
+        {
+            mesh.generateLods(options.lods);
+            // a mesh with fewer levels draws its last one at the levels past it
+            lod_errors.resize(std::max(lod_errors.size(), mesh.getLodCount()), 0.0f);
+        }
+        if (options.meshlets)
+        {
+            mesh.buildMeshlets();
+        }
+        mesh.setupMesh(options.packVertices ? &options.packing : nullptr);
+    }
+    for (size_t level = 0; level < lod_errors.size(); level++)
+    {
+        for (const Mesh &mesh : meshes)
+        {
+            lod_errors[level] = std::max(lod_errors[level], mesh.getLodError(level));
+        }
+    }
+    glm::vec3 size = model_max - model_min;
+    float scale = max(max(size.x, size.y), size.z);
+    bounding_radius = scale > 0.0f ? glm::length(size / scale) : 0.0f;
+}
+
+void ModelAsset::loadGltf(const std::string &path)
+{
+    GltfModel gltf;
+    if (!GltfLoader::load(path, gltf))
+    {
+        std::cerr << "Could not load model '" << path << "'" << std::endl;
+        exit(1);
+    }
+    resource_directory = path.substr(0, path.find_last_of('/'));
+
+    materials = std::move(gltf.materials);
+    model_min = gltf.min;
+    model_max = gltf.max;
+
+    // the accessors are already in GL's formats, the buffer goes up as it is
+    if (gltf.vertexDataSize)
+    {
+        CHECKED_GL_CALL(glGenBuffers(1, &gltf_buffer));
+        CHECKED_GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, gltf_buffer));
+        CHECKED_GL_CALL(glBufferData(GL_ARRAY_BUFFER, gltf.vertexDataSize, gltf.vertexData, GL_STATIC_DRAW));
+        CHECKED_GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, 0));
+    }
+
+    // only decode the images the materials use
+    for (const GltfImage &image : gltf.images)
+    {
+        if (image.name.empty() || textures_loaded.find(image.name) != textures_loaded.end())
+        {
+            continue;
+        }
+        bool used = false;
+        for (const tinyobj::material_t &material : materials)
+        {
+            used |= material.diffuse_texname == image.name || material.specular_texname == image.name;
+        }
+        if (used)
+        {
+            textures_loaded[image.name] = image.data ? TextureFromMemory(image.data, image.size)
+                                                     : TextureFromFile(image.uri, resource_directory);
+        }
+    }
+
+    // center and scale like Mesh::center does for OBJ vertices, but as part of the transform
+    glm::vec3 size = model_max - model_min;
+    float scale = max(max(size.x, size.y), size.z);
+    glm::mat4 centering = glm::scale(glm::mat4(1.0f), glm::vec3(scale > 0.0f ? 2.0f / scale : 1.0f));
+    centering = glm::translate(centering, -0.5f * (model_min + model_max));
+    for (const GltfPrimitive &primitive : gltf.primitives)
+    {
+        meshes.push_back(Mesh(gltf_buffer, primitive.layout, primitive.material));
+        meshes.back().setTransform(centering * primitive.transform);
+        meshes.back().setupMesh();
+        mesh_transforms |= meshes.back().hasTransform();
     }
 }
 
-void Model::loadMaterialTextures(tinyobj::material_t material)
+void ModelAsset::loadMaterialTextures(tinyobj::material_t material)
 {
     unsigned int texture_id;
     std::string path;
@@ -110,65 +415,13 @@ void Model::loadMaterialTextures(tinyobj::material_t material)
 
 void Model::addTexture(const std::string &texture_name)
 {
+    std::map<std::string, unsigned int> &textures_loaded = ModelAsset::textures_loaded;
     if (textures_loaded.find(texture_name) == textures_loaded.end())
     {
-        unsigned int texture_id = TextureFromFile(texture_name, resource_directory);
+        unsigned int texture_id = TextureFromFile(texture_name, asset->resource_directory);
         textures_loaded[texture_name] = texture_id;
     }
-    for (Mesh &mesh : meshes)
-    {
-        mesh.addTexture(textures_loaded[texture_name]);
-    }
-}
-
-Mesh Model::processMesh(tinyobj::shape_t shape, tinyobj::attrib_t attribs, std::vector<tinyobj::material_t> materials)
-{
-    std::vector<Vertex> vertices;
-    // loop over faces
-    size_t index_offset = 0;
-    for (size_t f = 0; f < shape.mesh.num_face_vertices.size(); f++)
-    {
-        size_t fv = size_t(shape.mesh.num_face_vertices[f]);
-
-        // loop over vertices in each face
-        for (size_t v = 0; v < fv; v++)
-        {
-            Vertex vertex;
-            tinyobj::index_t idx = shape.mesh.indices[index_offset + v];
-            vertex.Position.x = attribs.vertices[3 * size_t(idx.vertex_index)+0];
-            vertex.Position.y = attribs.vertices[3 * size_t(idx.vertex_index)+1];
-            vertex.Position.z = attribs.vertices[3 * size_t(idx.vertex_index)+2];
-
-            // check if normals exist
-            if (idx.normal_index >= 0)
-            {
-                vertex.Normal.x = attribs.normals[3 * size_t(idx.normal_index) + 0];
-                vertex.Normal.y = attribs.normals[3 * size_t(idx.normal_index) + 1];
-                vertex.Normal.z = attribs.normals[3 * size_t(idx.normal_index) + 2];
-            }
-
-            // check if texcoords exist
-            if (idx.texcoord_index >= 0)
-            {
-                vertex.TexCoord.x = attribs.texcoords[2 * size_t(idx.texcoord_index) + 0];
-                vertex.TexCoord.y = attribs.texcoords[2 * size_t(idx.texcoord_index) + 1];
-            }
-
-            // compute model limits
-            model_min.x = min(model_min.x, vertex.Position.x);
-            model_min.y = min(model_min.y, vertex.Position.y);
-            model_min.z = min(model_min.z, vertex.Position.z);
-
-            model_max.x = max(model_max.x, vertex.Position.x);
-            model_max.y = max(model_max.y, vertex.Position.y);
-            model_max.z = max(model_max.z, vertex.Position.z);
-
-            vertices.push_back(vertex);            
-        }            
-        index_offset += fv;
-    }
-    
-    return Mesh(vertices, shape.mesh.material_ids);
+    extra_textures.push_back(textures_loaded[texture_name]);
 }
 
 unsigned int loadCubemap(const std::string &path, const std::vector<std::string> &faces)
@@ -203,6 +456,38 @@ unsigned int loadCubemap(const std::string &path, const std::vector<std::string>
     return textureID;
 }
 
+// fills textureID with decoded stb_image pixels and frees them
+static void uploadTexture(unsigned int textureID, unsigned char *data, int width, int height, int nrComponents)
+{
+    GLenum format = GL_RGB;
+    switch(nrComponents)
+    {
+        case 1:
+            format = GL_RED;
+            break;
+        case 2:
+            format = GL_RG;
+            break;
+        case 3:
+            format = GL_RGB;
+            break;
+        case 4:
+            format = GL_RGBA;
+            break;
+    }
+
+    CHECKED_GL_CALL(glBindTexture(GL_TEXTURE_2D, textureID));
+    CHECKED_GL_CALL(glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data));
+    CHECKED_GL_CALL(glGenerateMipmap(GL_TEXTURE_2D));
+
+    CHECKED_GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, format == GL_RGBA ? GL_CLAMP_TO_EDGE : GL_REPEAT));
+    CHECKED_GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, format == GL_RGBA ? GL_CLAMP_TO_EDGE : GL_REPEAT));
+    CHECKED_GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR));
+    CHECKED_GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+
+    stbi_image_free(data);
+}
+
 unsigned int TextureFromFile(const std::string &path, const std::string &directory, bool gamma)
 {
     std::string filename = std::string(path);
@@ -215,35 +500,31 @@ unsigned int TextureFromFile(const std::string &path, const std::string &directo
     unsigned char *data = stbi_load(filename.c_str(), &width, &height, &nrComponents, 0);
     if (data)
     {
-        GLenum format;
-        switch(nrComponents)
-        {
-            case 1:
-                format = GL_RED;
-                break;
-            case 3:
-                format = GL_RGB;
-                break;
-            case 4:
-                format = GL_RGBA;
-                break;
-        }
+        uploadTexture(textureID, data, width, height, nrComponents);
+    }
+    else
+    {
+        std::cout << "Texture failed to load at path: " << path << std::endl;
+        stbi_image_free(data);
+    }
 
-        CHECKED_GL_CALL(glBindTexture(GL_TEXTURE_2D, textureID));
-        CHECKED_GL_CALL(glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data));
-        CHECKED_GL_CALL(glGenerateMipmap(GL_TEXTURE_2D));
+    return textureID;
+}
 
-        CHECKED_GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, format == GL_RGBA ? GL_CLAMP_TO_EDGE : GL_REPEAT));
-        CHECKED_GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, format == GL_RGBA ? GL_CLAMP_TO_EDGE : GL_REPEAT));
-        CHECKED_GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR));
-        CHECKED_GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+unsigned int TextureFromMemory(const unsigned char *file, size_t size)
+{
+    unsigned int textureID;
+    CHECKED_GL_CALL(glGenTextures(1, &textureID));
 
-        stbi_image_free(data);
+    int width, height, nrComponents;
+    unsigned char *data = stbi_load_from_memory(file, (int) size, &width, &height, &nrComponents, 0);
+    if (data)
+    {
+        uploadTexture(textureID, data, width, height, nrComponents);
     }
     else
     {
-        std::cout << "Texture failed to load at path: " << path << std::endl;
-        stbi_image_free(data);
+        std::cout << "Texture failed to decode: " << stbi_failure_reason() << std::endl;
     }
 
     return textureID;
@@ -0,0 +1,71 @@
+#include "ModelRegistry.h"
+
+#include <filesystem>
+#include <iomanip>
+#include <map>
+#include <sstream>
+
+namespace ModelRegistry
+{
+    namespace
+    {
+        std::map<std::string, std::weak_ptr<ModelAsset>> assets;
+
+        void dropExpired()
+        {
+            for (auto it = assets.begin(); it != assets.end();)
+            {
+                it = it->second.expired() ? assets.erase(it) : std::next(it);
+            }
+        }
+    }
+
+    std::shared_ptr<ModelAsset> acquire(const std::string &path, const ModelImportOptions &options)
+    {
+        std::string key = makeKey(path, options);
+        std::shared_ptr<ModelAsset> asset = assets[key].lock();
+        if (!asset)
+        {
+            dropExpired();
+            asset = std::make_shared<ModelAsset>(path, options);
+            assets[key] = asset;
+        }
+        return asset;
+    }
+
+    std::string makeKey(const std::string &path, const ModelImportOptions &options)
+    {
+        // follows symlinks and ".." for the parts of the path that exist
+        std::error_code ec;
+        std::filesystem::path canonical = std::filesystem::weakly_canonical(path, ec);
+        if (ec)
+        {
+            canonical = std::filesystem::absolute(path, ec).lexically_normal();
+        }
+
+        std::ostringstream key;
+        key << canonical.generic_string() << std::setprecision(9);
+        if (options.packVertices)
+        {
+            const VertexPacking::Options &packing = options.packing;
+            key << "|packed " << (int) packing.normals << " " << packing.positionTolerance << " "
+                << packing.normalTolerance << " " << packing.texCoordTolerance;
+        }
+        if (options.generateLods)
+        {
+            const MeshSimplifier::Options &lods = options.lods;
+            key << "|lods " << lods.lockBorders << " " << lods.attributeWeight << " " << lods.maxError;
+        }
+        if (options.meshlets)
+        {
+            key << "|meshlets";
+        }
+        return key.str();
+    }
+
+    size_t getLoadedCount()
+    {
+        dropExpired();
+        return assets.size();
+    }
+}
@@ -0,0 +1,717 @@
+#include "ObjParser.h"
+#include "MappedFile.h"
+
+#include <atomic>
+#include <charconv>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <set>
+#include <thread>
+
+namespace ObjParser
+{
+    namespace
+    {
+        const int32_t NO_INDEX = std::numeric_limits<int32_t>::min();
+
+        // v/vt/vn of one face corner, 0-based. Relative (negative) OBJ indices are
+        // stored relative to the start of their chunk until the merge knows where
+        // the chunk starts, relative has a bit per component for those.
+        struct Corner
+        {
+            int32_t v, vt, vn;
+        };
+
+        enum RelativeBits : uint8_t
+        {
+            RELATIVE_V = 1,
+            RELATIVE_VT = 2,
+            RELATIVE_VN = 4
+        };
+
+        struct Event
+        {
+            enum Type { OBJECT, MATERIAL, LIBRARY } type;
+            // first triangle of the chunk the event applies to
+            size_t triangle;
+            std::string name;
+        };
+
+        struct Chunk
+        {
+            std::vector<glm::vec3> positions;
+            std::vector<glm::vec2> texcoords;
+            std::vector<glm::vec3> normals;
+            // three per triangle
+            std::vector<Corner> corners;
+            std::vector<uint8_t> relative;
+            // first triangles of quads, split along their shorter diagonal once the positions are known
+            std::vector<size_t> quads;
+            std::vector<Event> events;
+            std::string error;
+        };
+
+        // triangles [begin, end) of a chunk that share a material
+        struct Segment
+        {
+            size_t chunk;
+            size_t begin;
+            size_t end;
+            int material;
+        };
+
+        struct ShapeSource
+        {
+            std::string name;
+            std::vector<Segment> segments;
+        };
+
+        inline bool isSpace(char c)
+        {
+            return c == ' ' || c == '\t';
+        }
+
+        inline const char *skipSpaces(const char *p, const char *end)
+        {
+            while (p < end && isSpace(*p))
+            {
+                p++;
+            }
+            return p;
+        }
+
+        // "keyword" followed by whitespace at p
+        inline bool startsWith(const char *p, const char *end, const char *keyword)
+        {
+            size_t length = strlen(keyword);
+            return (size_t) (end - p) > length && memcmp(p, keyword, length) == 0 && isSpace(p[length]);
+        }
+
+        inline std::string trimmed(const char *p, const char *end)
+        {
+            p = skipSpaces(p, end);
+            while (end > p && isSpace(end[-1]))
+            {
+                end--;
+            }
+            return std::string(p, end);
+        }
+
+        inline bool parseFloat(const char *&p, const char *end, float &value)
+        {
+            p = skipSpaces(p, end);
+            // from_chars does not accept a plus sign
+            if (p < end && *p == '+')
+            {
+                p++;
+            }
+#ifdef __cpp_lib_to_chars
+            std::from_chars_result result = std::from_chars(p, end, value);
+            if (result.ptr == p)
+            {
+                return false;
+            }
+            // denormals and overflows are reported as out of range, keep going with 0
+            if (result.ec == std::errc::result_out_of_range)
+            {
+                value = 0.0f;
+            }
+            p = result.ptr;
+            return true;
+#else
+            // the mapping is not null terminated, strtof needs a copy of the token
+            char token[64];
+            size_t length = 0;
+            while (p + length < end && !isSpace(p[length]) && length < sizeof(token) - 1)
+            {
+                token[length] = p[length];
+                length++;
+            }
+            token[length] = '\0';
+            char *parsedEnd = nullptr;
+            value = strtof(token, &parsedEnd);
+            if (parsedEnd == token)
+            {
+                return false;
+            }
+            p += parsedEnd - token;
+            return true;
+#endif
+        }
+
+        inline bool parseInt(const char *&p, const char *end, int32_t &value)
+        {
+            std::from_chars_result result = std::from_chars(p, end, value);
+            if (result.ec != std::errc())
+            {
+                return false;
+            }
+            p = result.ptr;
+            return true;
+        }
+
+        // 1-based OBJ index to 0-based, relative ones against count (the chunk's own attributes)
+        inline int32_t resolve(int32_t index, size_t count, uint8_t bit, uint8_t &relative)
+        {
+            if (index > 0)
+            {
+                return index - 1;
+            }
+            if (index < 0)
+            {
+                relative |= bit;
+                return (int32_t) count + index;
+            }
+            return NO_INDEX;
+        }
+
+        // one of v, v/vt, v//vn or v/vt/vn
+        bool parseCorner(const char *&p, const char *end, const Chunk &chunk, Corner &corner, uint8_t &relative)
+        {
+            int32_t values[3] = {0, 0, 0};
+            if (!parseInt(p, end, values[0]))
+            {
+                return false;
+            }
+            for (int i = 1; i < 3 && p < end && *p == '/'; i++)
+            {
+                p++;
+                // empty field, as the texture coordinate of v//vn
+                if (p < end && *p == '/')
+                {
+                    continue;
+                }
+                if (!parseInt(p, end, values[i]))
+                {
+                    return false;
+                }
+            }
+
+            relative = 0;
+            corner.v = resolve(values[0], chunk.positions.size(), RELATIVE_V, relative);
+            corner.vt = resolve(values[1], chunk.texcoords.size(), RELATIVE_VT, relative);
+            corner.vn = resolve(values[2], chunk.normals.size(), RELATIVE_VN, relative);
+            return corner.v != NO_INDEX;
+        }
+
+        bool parseFace(const char *p, const char *end, Chunk &chunk, std::vector<Corner> &face, std::vector<uint8_t> &faceRelative)
+        {
+            face.clear();
+            faceRelative.clear();
+            for (p = skipSpaces(p, end); p < end; p = skipSpaces(p, end))
+            {
+                Corner corner;
+                uint8_t relative;
+                if (!parseCorner(p, end, chunk, corner, relative) || (p < end && !isSpace(*p)))
+                {
+                    return false;
+                }
+                face.push_back(corner);
+                faceRelative.push_back(relative);
+            }
+
+            // fan triangulation like tinyobj's default, which splits quads differently, see splitQuads
+            if (face.size() == 4)
+            {
+                chunk.quads.push_back(chunk.corners.size() / 3);
+            }
+            for (size_t i = 2; i < face.size(); i++)
+            {
+                const size_t corners[3] = {0, i - 1, i};
+                for (size_t c : corners)
+                {
+                    chunk.corners.push_back(face[c]);
+                    chunk.relative.push_back(faceRelative[c]);
+                }
+            }
+            return true;
+        }
+
+        template<int N>
+        bool parseVector(const char *p, const char *end, glm::vec<N, float> &value)
+        {
+            for (int i = 0; i < N; i++)
+            {
+                if (!parseFloat(p, end, value[i]))
+                {
+                    return false;
+                }
+            }
+            // anything after (vt's w, vertex colors) is ignored
+            return true;
+        }
+
+        void parseLine(const char *p, const char *end, Chunk &chunk, std::vector<Corner> &face, std::vector<uint8_t> &faceRelative)
+        {
+            p = skipSpaces(p, end);
+            if (end - p < 2)
+            {
+                return;
+            }
+
+            bool ok = true;
+            size_t triangle = chunk.corners.size() / 3;
+            if (p[0] == 'v' && isSpace(p[1]))
+            {
+                chunk.positions.emplace_back();
+                ok = parseVector<3>(p + 2, end, chunk.positions.back());
+            }
+            else if (p[0] == 'v' && p[1] == 't' && startsWith(p, end, "vt"))
+            {
+                chunk.texcoords.emplace_back();
+                ok = parseVector<2>(p + 3, end, chunk.texcoords.back());
+            }
+            else if (p[0] == 'v' && p[1] == 'n' && startsWith(p, end, "vn"))
+            {
+                chunk.normals.emplace_back();
+                ok = parseVector<3>(p + 3, end, chunk.normals.back());
+            }
+            else if (p[0] == 'f' && isSpace(p[1]))
+            {
+                ok = parseFace(p + 2, end, chunk, face, faceRelative);
+            }
+            else if ((p[0] == 'o' || p[0] == 'g') && isSpace(p[1]))
+            {
+                chunk.events.push_back(Event{Event::OBJECT, triangle, trimmed(p + 2, end)});
+            }
+            else if (startsWith(p, end, "usemtl"))
+            {
+                chunk.events.push_back(Event{Event::MATERIAL, triangle, trimmed(p + 6, end)});
+            }
+            else if (startsWith(p, end, "mtllib"))
+            {
+                chunk.events.push_back(Event{Event::LIBRARY, triangle, trimmed(p + 6, end)});
+            }
+
+            if (!ok)
+            {
+                chunk.error = "Could not parse '" + std::string(p, end) + "'";
+            }
+        }
+
+        void parseChunk(const char *begin, const char *end, Chunk &chunk)
+        {
+            // rough guesses that save most of the reallocations of big files
+            size_t lines = (end - begin) / 32;
+            chunk.positions.reserve(lines / 4);
+            chunk.corners.reserve(lines);
+            chunk.relative.reserve(lines);
+
+            std::vector<Corner> face;
+            std::vector<uint8_t> faceRelative;
+            const char *line = begin;
+            while (line < end && chunk.error.empty())
+            {
+                // memchr is vectorized by the C library, this is where most of the scanning happens
+                const char *eol = (const char *) memchr(line, '\n', end - line);
+                if (!eol)
+                {
+                    eol = end;
+                }
+                const char *lineEnd = eol;
+                if (lineEnd > line && lineEnd[-1] == '\r')
+                {
+                    lineEnd--;
+                }
+                parseLine(line, lineEnd, chunk, face, faceRelative);
+                line = eol + 1;
+            }
+        }
+
+        // runs work(i) for i in [0, count) on up to threads threads, in order on the calling thread if only one
+        template<typename Work>
+        void parallelFor(size_t count, unsigned threads, Work work)
+        {
+            threads = (unsigned) std::min<size_t>(threads, count);
+            if (threads <= 1)
+            {
+                for (size_t i = 0; i < count; i++)
+                {
+                    work(i);
+                }
+                return;
+            }
+
+            std::atomic<size_t> next{0};
+            std::vector<std::thread> workers;
+            for (unsigned t = 0; t < threads; t++)
+            {
+                workers.emplace_back([&]()
+                {
+                    for (size_t i = next++; i < count; i = next++)
+                    {
+                        work(i);
+                    }
+                });
+            }
+            for (std::thread &worker : workers)
+            {
+                worker.join();
+            }
+        }
+
+        // chunk boundaries, each chunk ends after a newline
+        std::vector<const char *> split(const char *data, size_t size, size_t chunks)
+        {
+            std::vector<const char *> bounds = {data};
+            const char *end = data + size;
+            for (size_t i = 1; i < chunks; i++)
+            {
+                const char *p = std::max(data + size * i / chunks, bounds.back());
+                const char *eol = (const char *) memchr(p, '\n', end - p);
+                if (!eol)
+                {
+                    break;
+                }
+                if (eol + 1 > bounds.back() && eol + 1 < end)
+                {
+                    bounds.push_back(eol + 1);
+                }
+            }
+            bounds.push_back(end);
+            return bounds;
+        }
+
+        void loadMaterials(const std::vector<Chunk> &chunks, const std::string &directory, ObjModel &model,
+                           std::map<std::string, int> &materialIds)
+        {
+            std::set<std::string> loaded;
+            for (const Chunk &chunk : chunks)
+            {
+                for (const Event &event : chunk.events)
+                {
+                    if (event.type != Event::LIBRARY)
+                    {
+                        continue;
+                    }
+                    // several libraries may follow one mtllib
+                    const char *p = event.name.c_str();
+                    const char *end = p + event.name.size();
+                    while ((p = skipSpaces(p, end)) < end)
+                    {
+                        const char *nameEnd = p;
+                        while (nameEnd < end && !isSpace(*nameEnd))
+                        {
+                            nameEnd++;
+                        }
+                        std::string name(p, nameEnd);
+                        p = nameEnd;
+                        if (!loaded.insert(name).second)
+                        {
+                            continue;
+                        }
+
+                        std::ifstream file(directory + "/" + name);
+                        if (!file)
+                        {
+                            std::cerr << "Could not open material library '" << name << "'" << std::endl;
+                            continue;
+                        }
+                        std::string warning, error;
+                        tinyobj::LoadMtl(&materialIds, &model.materials, &file, &warning, &error);
+                        if (!warning.empty() || !error.empty())
+                        {
+                            std::cerr << name << ": " << warning << error;
+                        }
+                    }
+                }
+            }
+        }
+
+        // makes every relative index absolute and checks that all of them exist
+        bool fixIndices(Chunk &chunk, const size_t offsets[3], const size_t counts[3])
+        {
+            for (size_t i = 0; i < chunk.corners.size(); i++)
+            {
+                Corner &corner = chunk.corners[i];
+                uint8_t relative = chunk.relative[i];
+                if (relative)
+                {
+                    if (relative & RELATIVE_V) corner.v += (int32_t) offsets[0];
+                    if (relative & RELATIVE_VT) corner.vt += (int32_t) offsets[1];
+                    if (relative & RELATIVE_VN) corner.vn += (int32_t) offsets[2];
+                }
+                if (corner.v < 0 || (size_t) corner.v >= counts[0] ||
+                    (corner.vt != NO_INDEX && (corner.vt < 0 || (size_t) corner.vt >= counts[1])) ||
+                    (corner.vn != NO_INDEX && (corner.vn < 0 || (size_t) corner.vn >= counts[2])))
+                {
+                    chunk.error = "Face refers to a vertex that does not exist";
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        // quads were stored as (0, 1, 2) (0, 2, 3), like tinyobj they are split along
+        // the shorter diagonal instead, which matters for quads that are not planar
+        void splitQuads(Chunk &chunk, const std::vector<glm::vec3> &positions)
+        {
+            for (size_t triangle : chunk.quads)
+            {
+                Corner *c = &chunk.corners[triangle * 3];
+                const Corner quad[4] = {c[0], c[1], c[2], c[5]};
+                glm::vec3 diagonal02 = positions[quad[2].v] - positions[quad[0].v];
+                glm::vec3 diagonal13 = positions[quad[3].v] - positions[quad[1].v];
+                if (!(glm::dot(diagonal02, diagonal02) < glm::dot(diagonal13, diagonal13)))
+                {
+                    const Corner split[6] = {quad[0], quad[1], quad[3], quad[1], quad[2], quad[3]};
+                    std::copy(split, split + 6, c);
+                }
+            }
+        }
+
+        // groups the triangles of all chunks into shapes, in file order
+        std::vector<ShapeSource> collectShapes(const std::vector<Chunk> &chunks, const std::map<std::string, int> &materialIds)
+        {
+            std::vector<ShapeSource> shapes(1);
+            std::set<std::string> missing;
+            int material = -1;
+            for (size_t c = 0; c < chunks.size(); c++)
+            {
+                const Chunk &chunk = chunks[c];
+                size_t triangles = chunk.corners.size() / 3;
+                size_t begin = 0;
+                auto addSegment = [&](size_t end)
+                {
+                    if (end > begin)
+                    {
+                        shapes.back().segments.push_back(Segment{c, begin, end, material});
+                    }
+                    begin = end;
+                };
+
+                for (const Event &event : chunk.events)
+                {
+                    if (event.type == Event::OBJECT)
+                    {
+                        addSegment(event.triangle);
+                        if (!shapes.back().segments.empty())
+                        {
+                            shapes.emplace_back();
+                        }
+                        shapes.back().name = event.name;
+                    }
+                    else if (event.type == Event::MATERIAL)
+                    {
+                        addSegment(event.triangle);
+                        auto found = materialIds.find(event.name);
+                        material = found != materialIds.end() ? found->second : -1;
+                        if (found == materialIds.end() && missing.insert(event.name).second)
+                        {
+                            std::cerr << "Material '" << event.name << "' not found" << std::endl;
+                        }
+                    }
+                }
+                addSegment(triangles);
+            }
+
+            if (shapes.back().segments.empty())
+            {
+                shapes.pop_back();
+            }
+            return shapes;
+        }
+
+        inline uint32_t hashCorner(const Corner &corner)
+        {
+            uint32_t h = (uint32_t) corner.v * 0x9E3779B1u;
+            h ^= (uint32_t) corner.vt * 0x85EBCA77u;
+            h ^= (uint32_t) corner.vn * 0xC2B2AE3Du;
+            h ^= h >> 16;
+            h *= 0x7FEB352Du;
+            h ^= h >> 15;
+            return h;
+        }
+
+        // one vertex per distinct corner, with an open addressing table from corner to vertex index
+        void buildShape(const ShapeSource &source, const std::vector<Chunk> &chunks, const std::vector<glm::vec3> &positions,
+                        const std::vector<glm::vec2> &texcoords, const std::vector<glm::vec3> &normals, ObjShape &shape,
+                        glm::vec3 &min, glm::vec3 &max)
+        {
+            size_t triangles = 0;
+            for (const Segment &segment : source.segments)
+            {
+                triangles += segment.end - segment.begin;
+            }
+
+            shape.name = source.name;
+            shape.indices.reserve(triangles * 3);
+            shape.material_ids.reserve(triangles);
+
+            const uint32_t EMPTY = 0xFFFFFFFFu;
+            std::vector<Corner> keys;
+            size_t capacity = 64;
+            while (capacity < triangles)
+            {
+                capacity *= 2;
+            }
+            std::vector<uint32_t> table(capacity, EMPTY);
+
+            for (const Segment &segment : source.segments)
+            {
+                const std::vector<Corner> &corners = chunks[segment.chunk].corners;
+                shape.material_ids.insert(shape.material_ids.end(), segment.end - segment.begin, segment.material);
+                for (size_t i = segment.begin * 3; i < segment.end * 3; i++)
+                {
+                    const Corner &corner = corners[i];
+                    size_t mask = table.size() - 1;
+                    size_t slot = hashCorner(corner) & mask;
+                    while (table[slot] != EMPTY)
+                    {
+                        const Corner &key = keys[table[slot]];
+                        if (key.v == corner.v && key.vt == corner.vt && key.vn == corner.vn)
+                        {
+                            break;
+                        }
+                        slot = (slot + 1) & mask;
+                    }
+
+                    if (table[slot] == EMPTY)
+                    {
+                        uint32_t index = (uint32_t) keys.size();
+                        table[slot] = index;
+                        keys.push_back(corner);
+
+                        Vertex vertex;
+                        vertex.Position = positions[corner.v];
+                        vertex.Normal = corner.vn != NO_INDEX ? normals[corner.vn] : glm::vec3(0.0f);
+                        vertex.TexCoord = corner.vt != NO_INDEX ? texcoords[corner.vt] : glm::vec2(0.0f);
+                        shape.vertices.push_back(vertex);
+                        min = glm::min(min, vertex.Position);
+                        max = glm::max(max, vertex.Position);
+
+                        // keep the table at most half full
+                        if (keys.size() * 2 > table.size())
+                        {
+                            std::vector<uint32_t> grown(table.size() * 2, EMPTY);
+                            size_t grownMask = grown.size() - 1;
+                            for (uint32_t k = 0; k < (uint32_t) keys.size(); k++)
+                            {
+                                size_t s = hashCorner(keys[k]) & grownMask;
+                                while (grown[s] != EMPTY)
+                                {
+                                    s = (s + 1) & grownMask;
+                                }
+                                grown[s] = k;
+                            }
+                            table.swap(grown);
+                        }
+                        shape.indices.push_back(index);
+                    }
+                    else
+                    {
+                        shape.indices.push_back(table[slot]);
+                    }
+                }
+            }
+        }
+    }
+
+    bool load(const std::string &path, ObjModel &model, const Options &options)
+    {
+        MappedFile file;
+        if (!file.open(path))
+        {
+            return false;
+        }
+        size_t slash = path.find_last_of("/\\");
+        std::string directory = slash == std::string::npos ? "." : path.substr(0, slash);
+        if (!parse(file.data(), file.size(), model, options, directory))
+        {
+            std::cerr << "in '" << path << "'" << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    bool parse(const char *data, size_t size, ObjModel &model, const Options &options, const std::string &materialDirectory)
+    {
+        model = ObjModel();
+        unsigned threads = options.threads ? options.threads : std::max(std::thread::hardware_concurrency(), 1u);
+
+        // parse the chunks independently
+        size_t chunkCount = std::max<size_t>(1, std::min<size_t>(threads, size / std::max<size_t>(options.minChunkSize, 1)));
+        std::vector<const char *> bounds = split(data, size, chunkCount);
+        std::vector<Chunk> chunks(bounds.size() - 1);
+        parallelFor(chunks.size(), threads, [&](size_t i)
+        {
+            parseChunk(bounds[i], bounds[i + 1], chunks[i]);
+        });
+        for (const Chunk &chunk : chunks)
+        {
+            if (!chunk.error.empty())
+            {
+                std::cerr << chunk.error << std::endl;
+                return false;
+            }
+        }
+
+        std::map<std::string, int> materialIds;
+        if (!materialDirectory.empty())
+        {
+            loadMaterials(chunks, materialDirectory, model, materialIds);
+        }
+
+        // concatenate the attributes in file order and make the indices absolute
+        std::vector<size_t> offsets(chunks.size() * 3);
+        size_t counts[3] = {0, 0, 0};
+        for (size_t i = 0; i < chunks.size(); i++)
+        {
+            offsets[i * 3 + 0] = counts[0];
+            offsets[i * 3 + 1] = counts[1];
+            offsets[i * 3 + 2] = counts[2];
+            counts[0] += chunks[i].positions.size();
+            counts[1] += chunks[i].texcoords.size();
+            counts[2] += chunks[i].normals.size();
+        }
+        if (counts[0] > (size_t) std::numeric_limits<int32_t>::max())
+        {
+            std::cerr << "Too many vertices" << std::endl;
+            return false;
+        }
+
+        std::vector<glm::vec3> positions(counts[0]);
+        std::vector<glm::vec2> texcoords(counts[1]);
+        std::vector<glm::vec3> normals(counts[2]);
+        std::vector<uint8_t> valid(chunks.size());
+        parallelFor(chunks.size(), threads, [&](size_t i)
+        {
+            Chunk &chunk = chunks[i];
+            std::copy(chunk.positions.begin(), chunk.positions.end(), positions.begin() + offsets[i * 3 + 0]);
+            std::copy(chunk.texcoords.begin(), chunk.texcoords.end(), texcoords.begin() + offsets[i * 3 + 1]);
+            std::copy(chunk.normals.begin(), chunk.normals.end(), normals.begin() + offsets[i * 3 + 2]);
+            valid[i] = fixIndices(chunk, &offsets[i * 3], counts);
+        });
+        for (size_t i = 0; i < chunks.size(); i++)
+        {
+            if (!valid[i])
+            {
+                std::cerr << chunks[i].error << std::endl;
+                return false;
+            }
+        }
+        parallelFor(chunks.size(), threads, [&](size_t i)
+        {
+            splitQuads(chunks[i], positions);
+        });
+
+        // deduplicate the shapes in parallel
+        std::vector<ShapeSource> sources = collectShapes(chunks, materialIds);
+        model.shapes.resize(sources.size());
+        std::vector<glm::vec3> mins(sources.size(), model.min);
+        std::vector<glm::vec3> maxs(sources.size(), model.max);
+        parallelFor(sources.size(), threads, [&](size_t i)
+        {
+            buildShape(sources[i], chunks, positions, texcoords, normals, model.shapes[i], mins[i], maxs[i]);
+        });
+        for (size_t i = 0; i < sources.size(); i++)
+        {
+            model.min = glm::min(model.min, mins[i]);
+            model.max = glm::max(model.max, maxs[i]);
+        }
+        return true;
+    }
+}
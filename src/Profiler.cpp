@@ -0,0 +1,300 @@
+#include "Profiler.h"
+#include "GLSL.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+namespace
+{
+    // enough for a few minutes of a typical frame, tracing stops recording after that
+    const size_t MAX_TRACE_EVENTS = 1 << 20;
+}
+
+Profiler &Profiler::get()
+{
+    static Profiler profiler;
+    return profiler;
+}
+
+Profiler::Profiler()
+    : start(std::chrono::steady_clock::now())
+{
+}
+
+int64_t Profiler::now() const
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+void Profiler::setEnabled(bool enable)
+{
+    // takes effect with the next frame so scopes always stay balanced
+    enabled = enable;
+}
+
+void Profiler::beginFrame()
+{
+    if (!enabled)
+    {
+        return;
+    }
+
+    owner = std::this_thread::get_id();
+
+    if (!calibrated)
+    {
+        // maps GPU timestamps onto the CPU timeline for the trace
+        GLint64 gpuTime = 0;
+        glGetInteger64v(GL_TIMESTAMP, &gpuTime);
+        gpuClockOffset = gpuTime - now();
+        calibrated = true;
+    }
+
+    // collect whatever the GPU has finished, oldest frame first
+    for (int i = 0; i < FRAME_LATENCY; i++)
+    {
+        Frame &frame = frames[(frameNumber + i) % FRAME_LATENCY];
+        if (frame.pending)
+        {
+            resolve(frame);
+        }
+    }
+
+    Frame &frame = frames[frameNumber % FRAME_LATENCY];
+    if (frame.pending)
+    {
+        // the GPU is more than FRAME_LATENCY frames behind, waiting would stall the frame
+        droppedFrames++;
+        frame.pending = false;
+    }
+    frame.number = frameNumber;
+    frame.scopes.clear();
+    frame.usedQueries = 0;
+    frame.inputTime = -1;
+
+    openScopes.clear();
+    inFrame = true;
+    beginScope("Frame");
+}
+
+void Profiler::endFrame()
+{
+    if (!inFrame)
+    {
+        return;
+    }
+    while (!openScopes.empty())
+    {
+        endScope();
+    }
+    frames[frameNumber % FRAME_LATENCY].pending = true;
+    frameNumber++;
+    inFrame = false;
+}
+
+void Profiler::markInput(std::chrono::steady_clock::time_point time)
+{
+    if (owner != std::this_thread::get_id() || !inFrame)
+    {
+        return;
+    }
+    frames[frameNumber % FRAME_LATENCY].inputTime = std::chrono::duration_cast<std::chrono::nanoseconds>(time - start).count();
+}
+
+int Profiler::timestamp(Frame &frame)
+{
+    if (frame.usedQueries == (int) frame.queries.size())
+    {
+        GLuint query;
+        glGenQueries(1, &query);
+        frame.queries.push_back(query);
+    }
+    glQueryCounter(frame.queries[frame.usedQueries], GL_TIMESTAMP);
+    return frame.usedQueries++;
+}
+
+void Profiler::beginScope(const char *name)
+{
+    if (owner != std::this_thread::get_id() || !inFrame)
+    {
+        return;
+    }
+    Frame &frame = frames[frameNumber % FRAME_LATENCY];
+
+    Scope scope;
+    scope.name = name;
+    scope.parent = openScopes.empty() ? -1 : openScopes.back();
+    scope.gpuBegin = timestamp(frame);
+    scope.gpuEnd = -1;
+    scope.cpuBegin = now();
+    scope.cpuEnd = scope.cpuBegin;
+
+    openScopes.push_back((int) frame.scopes.size());
+    frame.scopes.push_back(scope);
+}
+
+void Profiler::endScope()
+{
+    if (owner != std::this_thread::get_id() || !inFrame || openScopes.empty())
+    {
+        return;
+    }
+    Frame &frame = frames[frameNumber % FRAME_LATENCY];
+
+    Scope &scope = frame.scopes[openScopes.back()];
+    scope.cpuEnd = now();
+    scope.gpuEnd = timestamp(frame);
+    openScopes.pop_back();
+}
+
+bool Profiler::resolve(Frame &frame)
+{
+    if (frame.usedQueries == 0)
+    {
+        frame.pending = false;
+        return true;
+    }
+
+    // timestamps complete in order, if the last one is there all of them are
+    GLint available = 0;
+    glGetQueryObjectiv(frame.queries[frame.usedQueries - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available)
+    {
+        return false;
+    }
+
+    std::vector<GLuint64> times(frame.usedQueries);
+    for (int i = 0; i < frame.usedQueries; i++)
+    {
+        glGetQueryObjectui64v(frame.queries[i], GL_QUERY_RESULT, &times[i]);
+    }
+    frame.pending = false;
+
+    // merge scopes with the same name under the same parent
+    struct TreeNode
+    {
+        Node node;
+        std::vector<int> children;
+    };
+    std::vector<TreeNode> tree;
+    std::vector<int> scopeNode(frame.scopes.size());
+    std::vector<int> roots;
+
+    for (size_t i = 0; i < frame.scopes.size(); i++)
+    {
+        const Scope &scope = frame.scopes[i];
+        int parentNode = scope.parent < 0 ? -1 : scopeNode[scope.parent];
+        std::vector<int> &siblings = parentNode < 0 ? roots : tree[parentNode].children;
+
+        int nodeIndex = -1;
+        for (int sibling : siblings)
+        {
+            if (strcmp(tree[sibling].node.name, scope.name) == 0)
+            {
+                nodeIndex = sibling;
+                break;
+            }
+        }
+        if (nodeIndex < 0)
+        {
+            nodeIndex = (int) tree.size();
+            int depth = parentNode < 0 ? 0 : tree[parentNode].node.depth + 1;
+            tree.push_back(TreeNode{Node{scope.name, depth, 0, 0.0, 0.0}, {}});
+            // siblings may have been invalidated by the push_back
+            (parentNode < 0 ? roots : tree[parentNode].children).push_back(nodeIndex);
+        }
+        scopeNode[i] = nodeIndex;
+
+        int64_t gpuBegin = (int64_t) times[scope.gpuBegin];
+        int64_t gpuEnd = scope.gpuEnd < 0 ? gpuBegin : (int64_t) times[scope.gpuEnd];
+        Node &node = tree[nodeIndex].node;
+        node.calls++;
+        node.cpuMs += (scope.cpuEnd - scope.cpuBegin) / 1.0e6;
+        node.gpuMs += (gpuEnd - gpuBegin) / 1.0e6;
+
+        if (tracing && traceEvents.size() + 2 <= MAX_TRACE_EVENTS)
+        {
+            traceEvents.push_back(TraceEvent{scope.name, 1, scope.cpuBegin, scope.cpuEnd - scope.cpuBegin});
+            traceEvents.push_back(TraceEvent{scope.name, 2, gpuBegin - gpuClockOffset, gpuEnd - gpuBegin});
+        }
+    }
+
+    // flatten depth first
+    lastFrame.clear();
+    std::vector<int> stack(roots.rbegin(), roots.rend());
+    while (!stack.empty())
+    {
+        int index = stack.back();
+        stack.pop_back();
+        lastFrame.push_back(tree[index].node);
+        stack.insert(stack.end(), tree[index].children.rbegin(), tree[index].children.rend());
+    }
+    lastFrameNumber = frame.number;
+
+    // the first scope is the whole frame, its end is the GPU finishing the frame
+    inputLatencyMs = -1.0;
+    if (frame.inputTime >= 0 && !frame.scopes.empty() && frame.scopes[0].gpuEnd >= 0)
+    {
+        int64_t gpuDone = (int64_t) times[frame.scopes[0].gpuEnd] - gpuClockOffset;
+        inputLatencyMs = (gpuDone - frame.inputTime) / 1.0e6 + presentLatencyMs;
+    }
+
+    return true;
+}
+
+void Profiler::print(std::ostream &out) const
+{
+    out << "Profile of frame " << lastFrameNumber << " (" << droppedFrames << " frames dropped)" << std::endl;
+    out << std::left << std::setw(32) << "scope" << std::right << std::setw(10) << "cpu ms" << std::setw(10) << "gpu ms" << std::setw(8) << "calls" << std::endl;
+
+    std::ios_base::fmtflags flags = out.flags();
+    out << std::fixed << std::setprecision(3);
+    for (const Node &node : lastFrame)
+    {
+        std::string name = std::string(node.depth * 2, ' ') + node.name;
+        out << std::left << std::setw(32) << name << std::right << std::setw(10) << node.cpuMs
+            << std::setw(10) << node.gpuMs << std::setw(8) << node.calls << std::endl;
+    }
+    if (inputLatencyMs >= 0.0)
+    {
+        out << "input to photon (estimated) " << inputLatencyMs << " ms" << std::endl;
+    }
+    out.flags(flags);
+}
+
+void Profiler::startTrace()
+{
+    traceEvents.clear();
+    tracing = true;
+}
+
+bool Profiler::writeTrace(const std::string &fileName)
+{
+    tracing = false;
+
+    std::ofstream out(fileName);
+    if (!out.is_open())
+    {
+        std::cerr << "Could not write profiler trace: '" << fileName << "'" << std::endl;
+        return false;
+    }
+
+    // Chrome trace event format, timestamps in microseconds
+    out << "{\"traceEvents\":[\n";
+    out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"CPU\"}},\n";
+    out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"GPU\"}}";
+    out << std::fixed << std::setprecision(3);
+    for (const TraceEvent &event : traceEvents)
+    {
+        out << ",\n{\"name\":\"" << event.name << "\",\"cat\":\"" << (event.thread == 1 ? "cpu" : "gpu")
+            << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.thread
+            << ",\"ts\":" << event.begin / 1000.0 << ",\"dur\":" << event.duration / 1000.0 << "}";
+    }
+    out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+
+    traceEvents.clear();
+    return true;
+}
@@ -1,9 +1,13 @@
 #include <iostream>
 #include <cassert>
+#include <filesystem>
 #include <fstream>
 
 #include "Program.h"
 #include "GLSL.h"
+#include "ShaderCache.h"
+#include "RenderStats.h"
+#include "ShaderPreprocessor.h"
 
 std::string readFileAsString(const std::string &fileName)
 {
@@ -32,70 +36,271 @@ void Program::setShaderNames(const std::string &v, const std::string &f)
     fShaderName = f;
 }
 
+void Program::addDefine(const std::string &name, const std::string &value)
+{
+    defines.push_back(std::make_pair(name, value));
+}
+
+bool Program::hasDefine(const std::string &name) const
+{
+    for (const auto &define : defines)
+    {
+        if (define.first == name)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
 bool Program::init()
 {
-    GLint rc;
+    return submit() && finish();
+}
+
+bool Program::submit()
+{
+    // Read shader sources, resolving #includes and adding this permutation's #defines
+    ShaderPreprocessor preprocessor;
+    vShader = preprocessor.process(vShaderName, defines);
+    fShader = preprocessor.process(fShaderName, defines);
+    if (!vShader.ok || !fShader.ok)
+    {
+        if (status != Status::LINKED)
+        {
+            status = Status::FAILED;
+        }
+        return false;
+    }
+    const std::string &vShaderString = vShader.source;
+    const std::string &fShaderString = fShader.source;
+
+    // Try the program binary cache before compiling anything. The expanded
+    // sources contain every included file, so editing a dependency changes the key
+    useCache = ShaderCache::isSupported();
+    buildPid = glCreateProgram();
+    if (useCache)
+    {
+        cacheKey = ShaderCache::makeKey({vShaderString, fShaderString});
+        if (ShaderCache::load(cacheKey, buildPid))
+        {
+            activate(buildPid);
+            return true;
+        }
+    }
 
     // Create shader handles
-    GLuint VS = glCreateShader(GL_VERTEX_SHADER);
-    GLuint FS = glCreateShader(GL_FRAGMENT_SHADER);
+    VS = glCreateShader(GL_VERTEX_SHADER);
+    FS = glCreateShader(GL_FRAGMENT_SHADER);
 
-    // Read shader sources
-    std::string vShaderString = readFileAsString(vShaderName);
-    std::string fShaderString = readFileAsString(fShaderName);
     const char *vshader = vShaderString.c_str();
     const char *fshader = fShaderString.c_str();
     CHECKED_GL_CALL(glShaderSource(VS, 1, &vshader, NULL));
     CHECKED_GL_CALL(glShaderSource(FS, 1, &fshader, NULL));
 
-    // Compile vertex shader
+    // Compile and link without querying any status in between, the driver is
+    // free to do the work in the background until finish() asks for the result
     CHECKED_GL_CALL(glCompileShader(VS));
+    CHECKED_GL_CALL(glCompileShader(FS));
+    if (useCache)
+    {
+        CHECKED_GL_CALL(glProgramParameteri(buildPid, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE));
+    }
+    CHECKED_GL_CALL(glAttachShader(buildPid, VS));
+    CHECKED_GL_CALL(glAttachShader(buildPid, FS));
+    CHECKED_GL_CALL(glLinkProgram(buildPid));
+
+    // a reload keeps the current program live while the new one builds
+    if (status != Status::LINKED)
+    {
+        status = Status::PENDING;
+    }
+    return true;
+}
+
+bool Program::isReady() const
+{
+    if (buildPid == 0)
+    {
+        return true;
+    }
+
+    // without KHR_parallel_shader_compile there is no way to ask without
+    // blocking, so report ready and let finish() wait for the driver
+    if (!GLSL::hasParallelShaderCompile())
+    {
+        return true;
+    }
+
+    GLint done = GL_FALSE;
+    CHECKED_GL_CALL(glGetProgramiv(buildPid, GL_COMPLETION_STATUS_KHR, &done));
+    return done == GL_TRUE;
+}
+
+bool Program::finish()
+{
+    if (buildPid == 0)
+    {
+        return status == Status::LINKED;
+    }
+
+    GLint rc;
+
+    // Check vertex shader
     CHECKED_GL_CALL(glGetShaderiv(VS, GL_COMPILE_STATUS, &rc));
     if (!rc)
     {
         if (isVerbose())
         {
-            GLSL::printShaderInfoLog(VS);
+            std::cout << ShaderPreprocessor::mapLog(GLSL::getShaderInfoLog(VS), vShader);
             std::cout << "Error compiling vertex shader " << vShaderName << std::endl;
         }
+        discardBuild();
         return false;
     }
 
-    // Compile fragment shader
-    CHECKED_GL_CALL(glCompileShader(FS));
+    // Check fragment shader
     CHECKED_GL_CALL(glGetShaderiv(FS, GL_COMPILE_STATUS, &rc));
     if (!rc)
     {
         if (isVerbose())
         {
-            GLSL::printShaderInfoLog(FS);
+            std::cout << ShaderPreprocessor::mapLog(GLSL::getShaderInfoLog(FS), fShader);
             std::cout << "Error compiling fragment shader " << fShaderName << std::endl;
         }
+        discardBuild();
         return false;
     }
 
-    // Create the program and link
-    pid = glCreateProgram();
-    CHECKED_GL_CALL(glAttachShader(pid, VS));
-    CHECKED_GL_CALL(glAttachShader(pid, FS));
-    CHECKED_GL_CALL(glLinkProgram(pid));
-    CHECKED_GL_CALL(glGetProgramiv(pid, GL_LINK_STATUS, &rc));
+    // Check the link
+    CHECKED_GL_CALL(glGetProgramiv(buildPid, GL_LINK_STATUS, &rc));
     if (!rc)
     {
         if (isVerbose())
         {
-            GLSL::printProgramInfoLog(pid);
+            GLSL::printProgramInfoLog(buildPid);
             std::cout << "Error linking shaders " << vShaderName << " and " << fShaderName << std::endl;
         }
+        discardBuild();
         return false;
     }
 
+    // the shader objects are not needed once the program is linked
+    deleteShaders();
+
+    if (useCache)
+    {
+        ShaderCache::store(cacheKey, buildPid);
+    }
+
+    activate(buildPid);
     return true;
 }
 
+bool Program::reload()
+{
+    // a newer edit supersedes a build that is still in flight
+    discardBuild();
+    return submit();
+}
+
+bool Program::usesFile(const std::string &path) const
+{
+    std::filesystem::path changed = std::filesystem::path(path).lexically_normal();
+    if (changed == std::filesystem::path(vShaderName).lexically_normal() ||
+        changed == std::filesystem::path(fShaderName).lexically_normal())
+    {
+        return true;
+    }
+
+    // included files count as well
+    for (const PreprocessedShader *shader : {&vShader, &fShader})
+    {
+        for (const std::string &file : shader->files)
+        {
+            if (changed == std::filesystem::path(file).lexically_normal())
+            {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void Program::activate(GLuint program)
+{
+    GLuint previous = pid;
+    pid = program;
+    buildPid = 0;
+    status = Status::LINKED;
+
+    // resolve the attributes that were requested while the link was in flight
+    for (const std::string &name : pendingAttributes)
+    {
+        attributes[name] = -1;
+    }
+    pendingAttributes.clear();
+    for (auto &attribute : attributes)
+    {
+        attribute.second = GLSL::getAttribLocation(pid, attribute.first.c_str(), isVerbose());
+    }
+
+    if (previous == 0)
+    {
+        return;
+    }
+
+    // swapped in by a reload: uniform locations may have moved and the new
+    // program starts out with default values, so restore the cached state
+    GLint current = 0;
+    CHECKED_GL_CALL(glGetIntegerv(GL_CURRENT_PROGRAM, &current));
+    CHECKED_GL_CALL(glUseProgram(pid));
+    for (auto &uniform : uniforms)
+    {
+        uniform.second.location = GLSL::getUniformLocation(pid, uniform.first.c_str(), false);
+        applyUniform(uniform.second);
+    }
+    CHECKED_GL_CALL(glUseProgram((GLuint) current == previous ? pid : (GLuint) current));
+    CHECKED_GL_CALL(glDeleteProgram(previous));
+}
+
+void Program::discardBuild()
+{
+    deleteShaders();
+    if (buildPid != 0)
+    {
+        CHECKED_GL_CALL(glDeleteProgram(buildPid));
+        buildPid = 0;
+    }
+    if (status == Status::PENDING)
+    {
+        status = Status::FAILED;
+    }
+}
+
+void Program::deleteShaders()
+{
+    GLuint shaders[2] = {VS, FS};
+    for (GLuint shader : shaders)
+    {
+        if (shader != 0)
+        {
+            CHECKED_GL_CALL(glDetachShader(buildPid, shader));
+            CHECKED_GL_CALL(glDeleteShader(shader));
+        }
+    }
+    VS = FS = 0;
+}
+
 void Program::bind()
 {
+    // status checks are deferred to the first time the program is used
+    if (status == Status::PENDING)
+    {
+        finish();
+    }
     CHECKED_GL_CALL(glUseProgram(pid));
+    RenderStats::addStateChange();
 }
 
 void Program::unbind()
@@ -105,72 +310,104 @@ void Program::unbind()
 
 void Program::addAttribute(const std::string &name)
 {
+    if (status == Status::PENDING)
+    {
+        pendingAttributes.push_back(name);
+        return;
+    }
     attributes[name] = GLSL::getAttribLocation(pid, name.c_str(), isVerbose());
 }
 
 void Program::addUniform(const std::string &name)
 {
-    uniforms[name] = GLSL::getUniformLocation(pid, name.c_str(), isVerbose());
+    if (status == Status::PENDING)
+    {
+        finish();
+    }
+    uniforms[name].location = GLSL::getUniformLocation(pid, name.c_str(), isVerbose());
 }
 
-void Program::setBool(const std::string &name, bool b)
+Program::Uniform &Program::findUniform(const std::string &name)
 {
-    std::map<std::string, GLint>::const_iterator uniform = uniforms.find(name.c_str());
+    std::map<std::string, Uniform>::iterator uniform = uniforms.find(name);
     if (uniform == uniforms.end())
     {
-        uniforms[name] = GLSL::getUniformLocation(pid, name.c_str(), isVerbose());
-        CHECKED_GL_CALL(glUniform1i(uniforms[name], b ? 1 : 0));
-        return;
+        uniform = uniforms.emplace(name, Uniform()).first;
+        uniform->second.location = GLSL::getUniformLocation(pid, name.c_str(), isVerbose());
     }
-    CHECKED_GL_CALL(glUniform1i(uniform->second, b ? 1 : 0));
+    return uniform->second;
 }
 
-void Program::setInt(const std::string &name, int i)
+void Program::applyUniform(const Uniform &uniform)
 {
-    std::map<std::string, GLint>::const_iterator uniform = uniforms.find(name.c_str());
-    if (uniform == uniforms.end())
+    switch (uniform.type)
     {
-        uniforms[name] = GLSL::getUniformLocation(pid, name.c_str(), isVerbose());
-        CHECKED_GL_CALL(glUniform1i(uniforms[name], i));
-        return;
+        case UniformType::INT:
+            CHECKED_GL_CALL(glUniform1i(uniform.location, uniform.intValue));
+            break;
+        case UniformType::FLOAT:
+            CHECKED_GL_CALL(glUniform1f(uniform.location, uniform.value[0][0]));
+            break;
+        case UniformType::VEC3:
+            CHECKED_GL_CALL(glUniform3fv(uniform.location, 1, glm::value_ptr(uniform.value[0])));
+            break;
+        case UniformType::MAT3:
+        {
+            glm::mat3 m = glm::mat3(uniform.value);
+            CHECKED_GL_CALL(glUniformMatrix3fv(uniform.location, 1, GL_FALSE, glm::value_ptr(m)));
+            break;
+        }
+        case UniformType::MAT4:
+            CHECKED_GL_CALL(glUniformMatrix4fv(uniform.location, 1, GL_FALSE, glm::value_ptr(uniform.value)));
+            break;
+        default:
+            break;
     }
-    CHECKED_GL_CALL(glUniform1i(uniform->second, i));
+}
+
+void Program::setBool(const std::string &name, bool b)
+{
+    setInt(name, b ? 1 : 0);
+}
+
+void Program::setInt(const std::string &name, int i)
+{
+    Uniform &uniform = findUniform(name);
+    uniform.type = UniformType::INT;
+    uniform.intValue = i;
+    CHECKED_GL_CALL(glUniform1i(uniform.location, i));
 }
 
 void Program::setFloat(const std::string &name, float f)
 {
-    std::map<std::string, GLint>::const_iterator uniform = uniforms.find(name.c_str());
-    if (uniform == uniforms.end())
-    {
-        uniforms[name] = GLSL::getUniformLocation(pid, name.c_str(), isVerbose());
-        CHECKED_GL_CALL(glUniform1f(uniforms[name], f));
-        return;
-    }
-    CHECKED_GL_CALL(glUniform1f(uniform->second, f));
+    Uniform &uniform = findUniform(name);
+    uniform.type = UniformType::FLOAT;
+    uniform.value[0][0] = f;
+    CHECKED_GL_CALL(glUniform1f(uniform.location, f));
 }
 
 void Program::setVector3f(const std::string &name, glm::vec3 v)
 {
-    std::map<std::string, GLint>::const_iterator uniform = uniforms.find(name.c_str());
-    if (uniform == uniforms.end())
-    {
-        uniforms[name] = GLSL::getUniformLocation(pid, name.c_str(), isVerbose());
-        CHECKED_GL_CALL(glUniform3fv(uniforms[name], 1, glm::value_ptr(v)));
-        return;
-    }
-    CHECKED_GL_CALL(glUniform3fv(uniform->second, 1, glm::value_ptr(v)));
+    Uniform &uniform = findUniform(name);
+    uniform.type = UniformType::VEC3;
+    uniform.value[0] = glm::vec4(v, 0.0f);
+    CHECKED_GL_CALL(glUniform3fv(uniform.location, 1, glm::value_ptr(v)));
+}
+
+void Program::setMat3(const std::string &name, glm::mat3 m)
+{
+    Uniform &uniform = findUniform(name);
+    uniform.type = UniformType::MAT3;
+    uniform.value = glm::mat4(m);
+    CHECKED_GL_CALL(glUniformMatrix3fv(uniform.location, 1, GL_FALSE, glm::value_ptr(m)));
 }
 
 void Program::setMat4(const std::string &name, glm::mat4 m)
 {
-    std::map<std::string, GLint>::const_iterator uniform = uniforms.find(name.c_str());
-    if (uniform == uniforms.end())
-    {
-        uniforms[name] = GLSL::getUniformLocation(pid, name.c_str(), isVerbose());
-        CHECKED_GL_CALL(glUniformMatrix4fv(uniforms[name], 1, GL_FALSE, glm::value_ptr(m)));
-        return;
-    }
-    CHECKED_GL_CALL(glUniformMatrix4fv(uniform->second, 1, GL_FALSE, glm::value_ptr(m)));
+    Uniform &uniform = findUniform(name);
+    uniform.type = UniformType::MAT4;
+    uniform.value = m;
+    CHECKED_GL_CALL(glUniformMatrix4fv(uniform.location, 1, GL_FALSE, glm::value_ptr(m)));
 }
 
 GLint Program::getAttribute(const std::string &name) const
@@ -189,7 +426,7 @@ GLint Program::getAttribute(const std::string &name) const
 
 GLint Program::getUniform(const std::string &name) const
 {
-    std::map<std::string, GLint>::const_iterator uniform = uniforms.find(name.c_str());
+    std::map<std::string, Uniform>::const_iterator uniform = uniforms.find(name.c_str());
     if (uniform == uniforms.end())
     {
         if (isVerbose())
@@ -198,17 +435,18 @@ GLint Program::getUniform(const std::string &name) const
         }
         return -1;
     }
-    return uniform->second;
+    return uniform->second.location;
 }
 
-void Program::drawModels(glm::mat4 view, glm::mat4 projection, glm::vec3 viewPos)
+void Program::drawModels(glm::mat4 view, glm::mat4 projection, glm::vec3 viewPos, const std::vector<ModelSnapshot> &snapshots,
+                         StreamBuffer *stream, const DrawView *drawView)
 {
     bind();
     setMat4("view", view);
     setMat4("projection", projection);
     setVector3f("viewPos", viewPos);
-    for (Model *model : models)
+    for (const ModelSnapshot &snapshot : snapshots)
     {
-        model->Draw(this);
+        snapshot.model->Draw(this, snapshot.instances, stream, drawView);
     }
 }
\ No newline at end of file
@@ -0,0 +1,30 @@
+#include "RenderStats.h"
+
+namespace RenderStats
+{
+    namespace
+    {
+        Counters counters;
+    }
+
+    const Counters &frame()
+    {
+        return counters;
+    }
+
+    void reset()
+    {
+        counters = Counters();
+    }
+
+    void addDraw(size_t triangles)
+    {
+        counters.drawCalls++;
+        counters.triangles += triangles;
+    }
+
+    void addStateChange(size_t count)
+    {
+        counters.stateChanges += count;
+    }
+}
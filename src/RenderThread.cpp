@@ -0,0 +1,182 @@
+#include "RenderThread.h"
+
+#include <algorithm>
+#include <iomanip>
+
+namespace
+{
+    double milliseconds(std::chrono::steady_clock::duration duration)
+    {
+        return std::chrono::duration<double, std::milli>(duration).count();
+    }
+}
+
+void RenderCommandList::execute()
+{
+    for (Command &command : commands)
+    {
+        command();
+    }
+}
+
+void FramePacingStats::print(std::ostream &out) const
+{
+    std::ios_base::fmtflags flags = out.flags();
+    out << std::fixed << std::setprecision(2)
+        << "frame " << frameMs << " ms (max " << maxFrameMs << ")"
+        << ", game " << gameMs << " ms + " << gameWaitMs << " ms waiting"
+        << ", render " << renderMs << " ms + " << renderIdleMs << " ms idle"
+        << ", " << frames << " frames" << std::endl;
+    out.flags(flags);
+}
+
+RenderThread::~RenderThread()
+{
+    stop();
+}
+
+void RenderThread::start(std::function<void()> acquire, std::function<void()> release)
+{
+    stop();
+    acquireContext = acquire;
+    releaseContext = release;
+
+    lists[0].clear();
+    lists[1].clear();
+    recording = 0;
+    pending = false;
+    stats = gameWindow = renderWindow = FramePacingStats();
+    lastSubmit = lastRenderEnd = clock::now();
+
+    running = true;
+    thread = std::thread(&RenderThread::renderLoop, this);
+}
+
+void RenderThread::stop()
+{
+    running = false;
+    if (thread.joinable())
+    {
+        thread.join();
+
+        // include the last, partial window
+        std::lock_guard<std::mutex> lock(statsMutex);
+        publishGame();
+        publishRender();
+    }
+}
+
+void RenderThread::publishGame()
+{
+    if (gameWindow.frames == 0)
+    {
+        return;
+    }
+    double frames = (double) gameWindow.frames;
+    stats.frames += gameWindow.frames;
+    stats.frameMs = gameWindow.frameMs / frames;
+    stats.maxFrameMs = gameWindow.maxFrameMs;
+    stats.gameWaitMs = gameWindow.gameWaitMs / frames;
+    stats.gameMs = (gameWindow.frameMs - gameWindow.gameWaitMs) / frames;
+    gameWindow = FramePacingStats();
+}
+
+void RenderThread::publishRender()
+{
+    if (renderWindow.frames == 0)
+    {
+        return;
+    }
+    double frames = (double) renderWindow.frames;
+    stats.renderMs = renderWindow.renderMs / frames;
+    stats.renderIdleMs = renderWindow.renderIdleMs / frames;
+    renderWindow = FramePacingStats();
+}
+
+void RenderThread::waitBackoff(int &spins)
+{
+    // yield first, the other side is usually almost done, then stop burning the core
+    if (++spins < 64)
+    {
+        std::this_thread::yield();
+    }
+    else
+    {
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+}
+
+void RenderThread::waitIdle()
+{
+    clock::time_point start = clock::now();
+    int spins = 0;
+    while (pending.load(std::memory_order_acquire) && running)
+    {
+        waitBackoff(spins);
+    }
+    gameWindow.gameWaitMs += milliseconds(clock::now() - start);
+}
+
+void RenderThread::submit()
+{
+    // the previous frame still has to be picked up
+    waitIdle();
+
+    clock::time_point now = clock::now();
+    submitted = recording;
+    recording ^= 1;
+    pending.store(true, std::memory_order_release);
+
+    gameWindow.frames++;
+    double frame = milliseconds(now - lastSubmit);
+    gameWindow.frameMs += frame;
+    gameWindow.maxFrameMs = std::max(gameWindow.maxFrameMs, frame);
+    lastSubmit = now;
+
+    if (gameWindow.frames == WINDOW)
+    {
+        std::lock_guard<std::mutex> lock(statsMutex);
+        publishGame();
+    }
+}
+
+FramePacingStats RenderThread::getStats()
+{
+    std::lock_guard<std::mutex> lock(statsMutex);
+    return stats;
+}
+
+void RenderThread::renderLoop()
+{
+    acquireContext();
+
+    int spins = 0;
+    while (running || pending.load(std::memory_order_acquire))
+    {
+        if (!pending.load(std::memory_order_acquire))
+        {
+            waitBackoff(spins);
+            continue;
+        }
+        spins = 0;
+
+        clock::time_point start = clock::now();
+        lists[submitted].execute();
+        lists[submitted].clear();
+        clock::time_point end = clock::now();
+        pending.store(false, std::memory_order_release);
+
+        renderWindow.frames++;
+        renderWindow.renderMs += milliseconds(end - start);
+        renderWindow.renderIdleMs += milliseconds(start - lastRenderEnd);
+        lastRenderEnd = end;
+
+        if (renderWindow.frames == WINDOW)
+        {
+            std::lock_guard<std::mutex> lock(statsMutex);
+            publishRender();
+        }
+    }
+
+    releaseContext();
+}
@@ -0,0 +1,132 @@
+#include "SceneGraph.h"
+#include "TransformKernels.h"
+
+#include <algorithm>
+#include <cassert>
+
+SceneGraph::NodeId SceneGraph::addNode(NodeId parent, const glm::vec3 &translation, const glm::quat &rotation, const glm::vec3 &scale)
+{
+    assert(parent < (NodeId) size());
+
+    NodeId node = (NodeId) size();
+    parents.push_back(parent);
+    translations.push_back(translation);
+    rotations.push_back(rotation);
+    scales.push_back(scale);
+    worlds.push_back(glm::mat4(1.0f));
+    dirty.push_back(1);
+    updated.push_back(0);
+    anyDirty = true;
+    return node;
+}
+
+void SceneGraph::clear()
+{
+    parents.clear();
+    translations.clear();
+    rotations.clear();
+    scales.clear();
+    worlds.clear();
+    dirty.clear();
+    updated.clear();
+    anyDirty = false;
+}
+
+void SceneGraph::markDirty(NodeId node)
+{
+    dirty[node] = 1;
+    anyDirty = true;
+}
+
+void SceneGraph::setTranslation(NodeId node, const glm::vec3 &translation)
+{
+    translations[node] = translation;
+    markDirty(node);
+}
+
+void SceneGraph::setRotation(NodeId node, const glm::quat &rotation)
+{
+    rotations[node] = rotation;
+    markDirty(node);
+}
+
+void SceneGraph::setScale(NodeId node, const glm::vec3 &scale)
+{
+    scales[node] = scale;
+    markDirty(node);
+}
+
+void SceneGraph::setLocal(NodeId node, const glm::vec3 &translation, const glm::quat &rotation, const glm::vec3 &scale)
+{
+    translations[node] = translation;
+    rotations[node] = rotation;
+    scales[node] = scale;
+    markDirty(node);
+}
+
+glm::mat4 SceneGraph::compose(const glm::vec3 &translation, const glm::quat &rotation, const glm::vec3 &scale)
+{
+    // rotation matrix with its columns scaled, translation in the last column
+    glm::mat3 r = glm::mat3_cast(rotation);
+    return glm::mat4(glm::vec4(r[0] * scale.x, 0.0f),
+                     glm::vec4(r[1] * scale.y, 0.0f),
+                     glm::vec4(r[2] * scale.z, 0.0f),
+                     glm::vec4(translation, 1.0f));
+}
+
+size_t SceneGraph::update()
+{
+    const size_t count = size();
+    if (!anyDirty)
+    {
+        std::fill(updated.begin(), updated.end(), 0);
+        return 0;
+    }
+
+    size_t recomputed = 0;
+    size_t i = 0;
+    while (i < count)
+    {
+        // find the next run of nodes to recompute, parents come first so their
+        // flag for this pass is already final
+        size_t begin = i;
+        for (; i < count; i++)
+        {
+            NodeId parent = parents[i];
+            uint8_t changed = dirty[i] | (parent != NONE ? updated[parent] : 0);
+            updated[i] = changed;
+            dirty[i] = 0;
+            if (!changed)
+            {
+                break;
+            }
+        }
+        size_t end = i;
+        if (end == begin)
+        {
+            i++;
+            continue;
+        }
+
+        // local matrices for the whole run at once, then the parents in order
+        TransformKernels::composeTRS(&translations[begin], &rotations[begin], &scales[begin], &worlds[begin], end - begin);
+        for (size_t node = begin; node < end; node++)
+        {
+            if (parents[node] != NONE)
+            {
+                worlds[node] = worlds[parents[node]] * worlds[node];
+            }
+        }
+        recomputed += end - begin;
+    }
+    anyDirty = false;
+    return recomputed;
+}
+
+void SceneGraph::copyWorld(const NodeId *nodes, size_t count, glm::mat4 *out) const
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        out[i] = worlds[nodes[i]];
+    }
+}
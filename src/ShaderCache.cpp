@@ -0,0 +1,181 @@
+#include "ShaderCache.h"
+#include "GLSL.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+namespace ShaderCache
+{
+    namespace
+    {
+        // file layout: magic, layout version, binary format, binary length, binary data
+        const uint32_t CACHE_MAGIC   = 0x4247474D; // "MGGB"
+        const uint32_t CACHE_VERSION = 1;
+
+        std::string cacheDirectory;
+
+        // 64 bit FNV-1a
+        uint64_t hashBytes(uint64_t hash, const void *data, size_t length)
+        {
+            const unsigned char *bytes = static_cast<const unsigned char *>(data);
+            for (size_t i = 0; i < length; i++)
+            {
+                hash ^= bytes[i];
+                hash *= 0x100000001B3ull;
+            }
+            return hash;
+        }
+
+        uint64_t hashString(uint64_t hash, const std::string &str)
+        {
+            hash = hashBytes(hash, str.data(), str.size());
+            // separator so that ("ab", "c") and ("a", "bc") hash differently
+            return hashBytes(hash, "\0", 1);
+        }
+
+        std::string glString(GLenum name)
+        {
+            const char *str = (const char *) glGetString(name);
+            return str ? std::string(str) : std::string();
+        }
+
+        std::string entryPath(const std::string &key)
+        {
+            return cacheDirectory + "/" + key + ".bin";
+        }
+
+        // best effort, a stale entry that cannot be removed (e.g. a read-only
+        // directory) is only recompiled from source again next time
+        void removeEntry(const std::string &key)
+        {
+            std::error_code ec;
+            std::filesystem::remove(entryPath(key), ec);
+        }
+    }
+
+    void setDirectory(const std::string &directory)
+    {
+        cacheDirectory = directory;
+    }
+
+    const std::string &getDirectory()
+    {
+        return cacheDirectory;
+    }
+
+    bool isSupported()
+    {
+        if (cacheDirectory.empty() || !GLAD_GL_VERSION_4_1)
+        {
+            return false;
+        }
+
+        GLint formats = 0;
+        CHECKED_GL_CALL(glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats));
+        return formats > 0;
+    }
+
+    std::string makeKey(const std::vector<std::string> &sources)
+    {
+        uint64_t hash = 0xCBF29CE484222325ull;
+
+        // binaries are only valid for the driver that produced them
+        hash = hashString(hash, glString(GL_VENDOR));
+        hash = hashString(hash, glString(GL_RENDERER));
+        hash = hashString(hash, glString(GL_VERSION));
+
+        for (const std::string &source : sources)
+        {
+            hash = hashString(hash, source);
+        }
+
+        char key[17];
+        snprintf(key, sizeof(key), "%016llx", (unsigned long long) hash);
+        return std::string(key);
+    }
+
+    bool load(const std::string &key, GLuint program)
+    {
+        std::ifstream file(entryPath(key), std::ios::binary);
+        if (!file.is_open())
+        {
+            return false;
+        }
+
+        uint32_t header[4] = {0, 0, 0, 0};
+        file.read(reinterpret_cast<char *>(header), sizeof(header));
+        if (!file || header[0] != CACHE_MAGIC || header[1] != CACHE_VERSION || header[3] == 0)
+        {
+            file.close();
+            removeEntry(key);
+            return false;
+        }
+
+        std::vector<char> binary(header[3]);
+        file.read(binary.data(), binary.size());
+        if (!file)
+        {
+            file.close();
+            removeEntry(key);
+            return false;
+        }
+        file.close();
+
+        CHECKED_GL_CALL(glProgramBinary(program, (GLenum) header[2], binary.data(), (GLsizei) binary.size()));
+
+        // the driver is free to reject a binary at any time (e.g. after an update),
+        // in which case the program is simply compiled from source again
+        GLint rc = 0;
+        CHECKED_GL_CALL(glGetProgramiv(program, GL_LINK_STATUS, &rc));
+        if (!rc)
+        {
+            removeEntry(key);
+            return false;
+        }
+
+        return true;
+    }
+
+    bool store(const std::string &key, GLuint program)
+    {
+        GLint length = 0;
+        CHECKED_GL_CALL(glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length));
+        if (length <= 0)
+        {
+            return false;
+        }
+
+        std::vector<char> binary(length);
+        GLenum format = 0;
+        CHECKED_GL_CALL(glGetProgramBinary(program, length, &length, &format, binary.data()));
+
+        std::error_code ec;
+        std::filesystem::create_directories(cacheDirectory, ec);
+
+        // write to a temporary file first so a crash never leaves a truncated entry behind
+        const std::string path = entryPath(key);
+        const std::string tmpPath = path + ".tmp";
+        std::ofstream file(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+        {
+            std::cerr << "Could not write shader cache file: '" << tmpPath << "'" << std::endl;
+            return false;
+        }
+
+        uint32_t header[4] = {CACHE_MAGIC, CACHE_VERSION, (uint32_t) format, (uint32_t) length};
+        file.write(reinterpret_cast<const char *>(header), sizeof(header));
+        file.write(binary.data(), length);
+        file.close();
+        if (!file)
+        {
+            std::filesystem::remove(tmpPath, ec);
+            return false;
+        }
+
+        std::filesystem::rename(tmpPath, path, ec);
+        return !ec;
+    }
+}
@@ -0,0 +1,477 @@
+#include "ShaderPreprocessor.h"
+
+#include <cctype>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <regex>
+#include <sstream>
+
+namespace
+{
+    const int MAX_INCLUDE_DEPTH = 32;
+
+    std::string trimLeft(const std::string &str)
+    {
+        size_t start = str.find_first_not_of(" \t");
+        return start == std::string::npos ? std::string() : str.substr(start);
+    }
+
+    // returns the directive name of a preprocessor line ("include", "define", ...) or an empty string
+    std::string directive(const std::string &line, std::string &rest)
+    {
+        std::string trimmed = trimLeft(line);
+        if (trimmed.empty() || trimmed[0] != '#')
+        {
+            return std::string();
+        }
+        trimmed = trimLeft(trimmed.substr(1));
+        size_t end = 0;
+        while (end < trimmed.size() && (std::isalnum((unsigned char) trimmed[end]) || trimmed[end] == '_'))
+        {
+            end++;
+        }
+        rest = trimLeft(trimmed.substr(end));
+        return trimmed.substr(0, end);
+    }
+
+    // the macro name at the start of a directive's arguments
+    std::string identifier(const std::string &rest)
+    {
+        size_t end = 0;
+        while (end < rest.size() && (std::isalnum((unsigned char) rest[end]) || rest[end] == '_'))
+        {
+            end++;
+        }
+        return rest.substr(0, end);
+    }
+
+    // recursive descent evaluator for integer constant expressions
+    class ExpressionParser
+    {
+    public:
+        ExpressionParser(const std::string &expression, const std::map<std::string, long long> &constants)
+            : str(expression), constants(constants) {}
+
+        bool parse(long long &value)
+        {
+            if (!parseBinary(0, value))
+            {
+                return false;
+            }
+            skipSpace();
+            return pos == str.size();
+        }
+
+    private:
+        const std::string &str;
+        const std::map<std::string, long long> &constants;
+        size_t pos = 0;
+
+        void skipSpace()
+        {
+            while (pos < str.size() && std::isspace((unsigned char) str[pos]))
+            {
+                pos++;
+            }
+        }
+
+        // binary operators from lowest to highest precedence
+        int precedence(const std::string &op)
+        {
+            static const std::map<std::string, int> table =
+            {
+                {"||", 1}, {"&&", 2}, {"|", 3}, {"^", 4}, {"&", 5},
+                {"==", 6}, {"!=", 6}, {"<", 7}, {">", 7}, {"<=", 7}, {">=", 7},
+                {"<<", 8}, {">>", 8}, {"+", 9}, {"-", 9}, {"*", 10}, {"/", 10}, {"%", 10}
+            };
+            auto it = table.find(op);
+            return it == table.end() ? -1 : it->second;
+        }
+
+        std::string peekOperator()
+        {
+            skipSpace();
+            static const char *ops[] = {"||", "&&", "==", "!=", "<=", ">=", "<<", ">>",
+                                        "|", "^", "&", "<", ">", "+", "-", "*", "/", "%"};
+            for (const char *op : ops)
+            {
+                if (str.compare(pos, strlen(op), op) == 0)
+                {
+                    return op;
+                }
+            }
+            return std::string();
+        }
+
+        bool parseBinary(int minPrecedence, long long &lhs)
+        {
+            if (!parseUnary(lhs))
+            {
+                return false;
+            }
+            while (true)
+            {
+                std::string op = peekOperator();
+                int prec = op.empty() ? -1 : precedence(op);
+                if (prec < minPrecedence || prec < 0)
+                {
+                    return true;
+                }
+                pos += op.size();
+
+                long long rhs;
+                if (!parseBinary(prec + 1, rhs))
+                {
+                    return false;
+                }
+                if ((op == "/" || op == "%") && rhs == 0)
+                {
+                    return false;
+                }
+
+                if (op == "||") lhs = lhs || rhs;
+                else if (op == "&&") lhs = lhs && rhs;
+                else if (op == "|") lhs = lhs | rhs;
+                else if (op == "^") lhs = lhs ^ rhs;
+                else if (op == "&") lhs = lhs & rhs;
+                else if (op == "==") lhs = lhs == rhs;
+                else if (op == "!=") lhs = lhs != rhs;
+                else if (op == "<") lhs = lhs < rhs;
+                else if (op == ">") lhs = lhs > rhs;
+                else if (op == "<=") lhs = lhs <= rhs;
+                else if (op == ">=") lhs = lhs >= rhs;
+                else if (op == "<<") lhs = lhs << rhs;
+                else if (op == ">>") lhs = lhs >> rhs;
+                else if (op == "+") lhs = lhs + rhs;
+                else if (op == "-") lhs = lhs - rhs;
+                else if (op == "*") lhs = lhs * rhs;
+                else if (op == "/") lhs = lhs / rhs;
+                else if (op == "%") lhs = lhs % rhs;
+            }
+        }
+
+        bool parseUnary(long long &value)
+        {
+            skipSpace();
+            if (pos >= str.size())
+            {
+                return false;
+            }
+
+            char c = str[pos];
+            if (c == '-' || c == '+' || c == '~' || c == '!')
+            {
+                pos++;
+                if (!parseUnary(value))
+                {
+                    return false;
+                }
+                if (c == '-') value = -value;
+                else if (c == '~') value = ~value;
+                else if (c == '!') value = !value;
+                return true;
+            }
+
+            if (c == '(')
+            {
+                pos++;
+                if (!parseBinary(0, value))
+                {
+                    return false;
+                }
+                skipSpace();
+                if (pos >= str.size() || str[pos] != ')')
+                {
+                    return false;
+                }
+                pos++;
+                return true;
+            }
+
+            if (std::isdigit((unsigned char) c))
+            {
+                size_t end = pos;
+                while (end < str.size() && std::isalnum((unsigned char) str[end]))
+                {
+                    end++;
+                }
+                std::string literal = str.substr(pos, end - pos);
+                // float literals are left to the driver
+                if (end < str.size() && str[end] == '.')
+                {
+                    return false;
+                }
+                while (!literal.empty() && (literal.back() == 'u' || literal.back() == 'U'))
+                {
+                    literal.pop_back();
+                }
+                size_t used = 0;
+                try
+                {
+                    value = std::stoll(literal, &used, 0);
+                }
+                catch (...)
+                {
+                    return false;
+                }
+                if (used != literal.size())
+                {
+                    return false;
+                }
+                pos = end;
+                return true;
+            }
+
+            if (std::isalpha((unsigned char) c) || c == '_')
+            {
+                size_t end = pos;
+                while (end < str.size() && (std::isalnum((unsigned char) str[end]) || str[end] == '_'))
+                {
+                    end++;
+                }
+                auto constant = constants.find(str.substr(pos, end - pos));
+                if (constant == constants.end())
+                {
+                    return false;
+                }
+                value = constant->second;
+                pos = end;
+                return true;
+            }
+
+            return false;
+        }
+    };
+}
+
+PreprocessedShader ShaderPreprocessor::process(const std::string &fileName, const Defines &defines)
+{
+    result = PreprocessedShader();
+    constants.clear();
+    unfoldable.clear();
+    conditionals.clear();
+
+    defineLines.clear();
+    for (const auto &define : defines)
+    {
+        defineLines.push_back(foldDefine("#define " + define.first + " " + define.second));
+    }
+
+    result.files.push_back(fileName);
+    if (!processFile(fileName, 0))
+    {
+        result.ok = false;
+    }
+
+    return result;
+}
+
+void ShaderPreprocessor::emit(const std::string &line, int file, int lineNumber)
+{
+    result.source += line + "\n";
+    result.lines.push_back(std::make_pair(file, lineNumber));
+}
+
+void ShaderPreprocessor::emitDefines()
+{
+    for (const std::string &define : defineLines)
+    {
+        emit(define, 0, 1);
+    }
+    defineLines.clear();
+}
+
+bool ShaderPreprocessor::processFile(const std::string &fileName, int depth)
+{
+    std::ifstream fileHandle(fileName);
+    if (!fileHandle.is_open())
+    {
+        std::cerr << "Could not open file: '" << fileName << "'" << std::endl;
+        return false;
+    }
+
+    const int fileIndex = (int) result.files.size() - 1;
+    const std::filesystem::path directory = std::filesystem::path(fileName).parent_path();
+    bool ok = true;
+
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(fileHandle, line))
+    {
+        lineNumber++;
+        if (!line.empty() && line.back() == '\r')
+        {
+            line.pop_back();
+        }
+
+        std::string rest;
+        std::string name = directive(line, rest);
+
+        if (depth == 0 && lineNumber == 1)
+        {
+            // #version has to stay the first line, the permutation's defines follow it
+            if (name == "version")
+            {
+                emit(line, fileIndex, lineNumber);
+                emitDefines();
+                continue;
+            }
+            emitDefines();
+        }
+
+        if (name == "include")
+        {
+            size_t open = rest.find('"');
+            size_t close = (open == std::string::npos) ? std::string::npos : rest.find('"', open + 1);
+            if (close == std::string::npos)
+            {
+                std::cerr << fileName << ":" << lineNumber << ": malformed #include" << std::endl;
+                ok = false;
+                continue;
+            }
+
+            std::string includeName = (directory / rest.substr(open + 1, close - open - 1)).lexically_normal().string();
+            bool included = false;
+            for (const std::string &file : result.files)
+            {
+                included |= (std::filesystem::path(file).lexically_normal() == std::filesystem::path(includeName));
+            }
+
+            // every file is included once, so no include guards are needed
+            if (included)
+            {
+                continue;
+            }
+            if (depth + 1 >= MAX_INCLUDE_DEPTH)
+            {
+                std::cerr << fileName << ":" << lineNumber << ": #include nested too deeply" << std::endl;
+                ok = false;
+                continue;
+            }
+
+            result.files.push_back(includeName);
+            ok &= processFile(includeName, depth + 1);
+        }
+        else if (name == "pragma" && rest.compare(0, 4, "once") == 0)
+        {
+            continue;
+        }
+        else if (name == "define")
+        {
+            emit(foldDefine(line), fileIndex, lineNumber);
+        }
+        else
+        {
+            // conditionals are not evaluated, only tracked so that definitions in
+            // them are not taken for known values
+            if (name == "if" || name == "ifdef")
+            {
+                conditionals.push_back(std::string());
+            }
+            else if (name == "ifndef")
+            {
+                conditionals.push_back(identifier(rest));
+            }
+            else if ((name == "elif" || name == "else") && !conditionals.empty())
+            {
+                conditionals.back().clear();
+            }
+            else if (name == "endif" && !conditionals.empty())
+            {
+                conditionals.pop_back();
+            }
+            else if (name == "undef")
+            {
+                constants.erase(identifier(rest));
+                unfoldable.insert(identifier(rest));
+            }
+            emit(line, fileIndex, lineNumber);
+        }
+    }
+
+    return ok;
+}
+
+std::string ShaderPreprocessor::foldDefine(const std::string &line)
+{
+    std::string rest;
+    directive(line, rest);
+
+    size_t nameEnd = 0;
+    while (nameEnd < rest.size() && (std::isalnum((unsigned char) rest[nameEnd]) || rest[nameEnd] == '_'))
+    {
+        nameEnd++;
+    }
+    // function-like macros and empty defines are passed through untouched
+    if (nameEnd == 0 || nameEnd == rest.size() || rest[nameEnd] == '(')
+    {
+        return line;
+    }
+
+    std::string name = rest.substr(0, nameEnd);
+    std::string value = rest.substr(nameEnd);
+    size_t comment = value.find("//");
+    if (comment != std::string::npos)
+    {
+        value = value.substr(0, comment);
+    }
+
+    long long folded;
+    bool constant = evaluate(value, constants, folded);
+
+    // Only a name defined once, outside of any conditional, has a known value. The
+    // exception is the fallback in "#ifndef NAME" of a known NAME, which is inactive.
+    bool fallback = !conditionals.empty() && conditionals.back() == name && constants.count(name);
+    if (!fallback)
+    {
+        if (!conditionals.empty() || constants.count(name) || unfoldable.count(name))
+        {
+            constants.erase(name);
+            unfoldable.insert(name);
+        }
+        else if (constant)
+        {
+            constants[name] = folded;
+        }
+        else
+        {
+            unfoldable.insert(name);
+        }
+    }
+    return constant ? "#define " + name + " " + std::to_string(folded) : line;
+}
+
+bool ShaderPreprocessor::evaluate(const std::string &expression, const std::map<std::string, long long> &constants, long long &result)
+{
+    ExpressionParser parser(expression, constants);
+    return parser.parse(result);
+}
+
+std::string ShaderPreprocessor::mapLog(const std::string &log, const PreprocessedShader &shader)
+{
+    // Mesa/Intel/AMD print "0:12(3):" or "ERROR: 0:12:", NVIDIA prints "0(12) :"
+    static const std::regex location(R"(^(\s*(?:ERROR|WARNING):\s*)?(\d+)([:(])(\d+))");
+
+    std::istringstream in(log);
+    std::string mapped;
+    std::string line;
+    while (std::getline(in, line))
+    {
+        std::smatch match;
+        if (std::regex_search(line, match, location))
+        {
+            // the driver counts lines of the expanded source, starting at 1
+            size_t outputLine = std::stoul(match[4].str());
+            if (outputLine >= 1 && outputLine <= shader.lines.size())
+            {
+                const std::pair<int, int> &origin = shader.lines[outputLine - 1];
+                std::string file = std::filesystem::path(shader.files[origin.first]).filename().string();
+                line = match[1].str() + file + match[3].str() + std::to_string(origin.second) + match.suffix().str();
+            }
+        }
+        mapped += line + "\n";
+    }
+    return mapped;
+}
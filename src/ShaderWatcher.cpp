@@ -0,0 +1,148 @@
+#include "ShaderWatcher.h"
+
+#include <chrono>
+#include <iostream>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+ShaderWatcher::~ShaderWatcher()
+{
+    stop();
+}
+
+bool ShaderWatcher::start(const std::string &watchDirectory)
+{
+    stop();
+    directory = watchDirectory;
+
+#ifdef __linux__
+    inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotifyFd < 0)
+    {
+        std::cerr << "Could not initialize inotify, shader hot-reload disabled" << std::endl;
+        return false;
+    }
+    // editors either write in place or write a temporary file and rename it over the original
+    watchFd = inotify_add_watch(inotifyFd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+    if (watchFd < 0)
+    {
+        std::cerr << "Could not watch shader directory: '" << directory << "'" << std::endl;
+        close(inotifyFd);
+        inotifyFd = -1;
+        return false;
+    }
+#else
+    std::error_code ec;
+    if (!std::filesystem::is_directory(directory, ec))
+    {
+        std::cerr << "Could not watch shader directory: '" << directory << "'" << std::endl;
+        return false;
+    }
+    scanDirectory(false);
+#endif
+
+    running = true;
+    thread = std::thread(&ShaderWatcher::watchLoop, this);
+    return true;
+}
+
+void ShaderWatcher::stop()
+{
+    running = false;
+    if (thread.joinable())
+    {
+        thread.join();
+    }
+
+#ifdef __linux__
+    if (inotifyFd >= 0)
+    {
+        close(inotifyFd);
+        inotifyFd = -1;
+        watchFd = -1;
+    }
+#endif
+}
+
+std::vector<std::string> ShaderWatcher::pollChanges()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<std::string> result(changed.begin(), changed.end());
+    changed.clear();
+    return result;
+}
+
+void ShaderWatcher::addChange(const std::string &path)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    changed.insert(path);
+}
+
+#ifdef __linux__
+
+void ShaderWatcher::watchLoop()
+{
+    alignas(struct inotify_event) char buffer[4096];
+
+    while (running)
+    {
+        // wake up regularly so stop() never has to wait long
+        struct pollfd pfd = {inotifyFd, POLLIN, 0};
+        if (poll(&pfd, 1, 100) <= 0)
+        {
+            continue;
+        }
+
+        ssize_t length = read(inotifyFd, buffer, sizeof(buffer));
+        for (ssize_t offset = 0; offset < length; )
+        {
+            const struct inotify_event *event = reinterpret_cast<const struct inotify_event *>(buffer + offset);
+            if (event->len > 0)
+            {
+                addChange(directory + "/" + event->name);
+            }
+            offset += sizeof(struct inotify_event) + event->len;
+        }
+    }
+}
+
+#else
+
+void ShaderWatcher::scanDirectory(bool notify)
+{
+    std::error_code ec;
+    for (const auto &entry : std::filesystem::directory_iterator(directory, ec))
+    {
+        if (!entry.is_regular_file(ec))
+        {
+            continue;
+        }
+
+        std::string path = entry.path().string();
+        std::filesystem::file_time_type time = entry.last_write_time(ec);
+        auto known = timestamps.find(path);
+        if (known == timestamps.end() || known->second != time)
+        {
+            timestamps[path] = time;
+            if (notify)
+            {
+                addChange(path);
+            }
+        }
+    }
+}
+
+void ShaderWatcher::watchLoop()
+{
+    while (running)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(250));
+        scanDirectory(true);
+    }
+}
+
+#endif
@@ -0,0 +1,108 @@
+#include "Simulation.h"
+
+#include <algorithm>
+
+FixedTimestep::FixedTimestep(double step, int maxSteps)
+    : step(step), maxSteps(maxSteps)
+{
+}
+
+int FixedTimestep::advance(double elapsed)
+{
+    accumulator += std::max(elapsed, 0.0);
+
+    int steps = (int) (accumulator / step);
+    if (steps > maxSteps)
+    {
+        // catch up as far as allowed and forget the rest
+        double dropped = (steps - maxSteps) * step;
+        accumulator -= dropped;
+        droppedTime += dropped;
+        steps = maxSteps;
+    }
+    accumulator -= steps * step;
+    return steps;
+}
+
+SimulationState interpolate(const SimulationState &previous, const SimulationState &current, double alpha)
+{
+    SimulationState result = current;
+    result.cameraPosition = glm::mix(previous.cameraPosition, current.cameraPosition, (float) alpha);
+    result.time = previous.time + (current.time - previous.time) * alpha;
+    return result;
+}
+
+SimulationThread::~SimulationThread()
+{
+    stop();
+}
+
+void SimulationThread::start(const SimulationState &initial, const SimulationSettings &simulationSettings, StepFunction function)
+{
+    stop();
+    settings = simulationSettings;
+    stepFunction = function;
+
+    published[0] = published[1] = initial;
+    publishTime = std::chrono::steady_clock::now();
+
+    running = true;
+    thread = std::thread(&SimulationThread::simulationLoop, this, initial);
+}
+
+void SimulationThread::stop()
+{
+    running = false;
+    if (thread.joinable())
+    {
+        thread.join();
+    }
+}
+
+SimulationState SimulationThread::read()
+{
+    SimulationState previous, current;
+    std::chrono::steady_clock::time_point time;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        previous = published[0];
+        current = published[1];
+        time = publishTime;
+    }
+
+    // the latest state becomes fully visible one step after it was published
+    double sincePublish = std::chrono::duration<double>(std::chrono::steady_clock::now() - time).count();
+    double alpha = std::min(std::max(sincePublish / settings.step, 0.0), 1.0);
+    return interpolate(previous, current, alpha);
+}
+
+void SimulationThread::simulationLoop(SimulationState state)
+{
+    typedef std::chrono::steady_clock clock;
+
+    FixedTimestep timestep(settings.step, settings.maxSteps);
+    clock::time_point last = clock::now();
+
+    while (running)
+    {
+        clock::time_point now = clock::now();
+        int steps = timestep.advance(std::chrono::duration<double>(now - last).count());
+        last = now;
+
+        for (int i = 0; i < steps; i++)
+        {
+            stepFunction(state, settings.step);
+            state.time += settings.step;
+            state.step++;
+
+            std::lock_guard<std::mutex> lock(mutex);
+            published[0] = published[1];
+            published[1] = state;
+            publishTime = clock::now();
+        }
+
+        // sleep until the next step is due
+        double wait = (1.0 - timestep.getAlpha()) * settings.step;
+        std::this_thread::sleep_for(std::chrono::duration<double>(wait));
+    }
+}
@@ -0,0 +1,147 @@
+#include "StreamBuffer.h"
+#include "GLSL.h"
+
+#include <iostream>
+
+bool StreamBuffer::init(GLsizeiptr size, int regions, bool allowPersistent)
+{
+    destroy();
+    regionSize = size;
+    region = 0;
+    used = 0;
+    fences.assign(regions, nullptr);
+
+    // GL_COPY_WRITE_BUFFER so creating and mapping never disturbs GL_ARRAY_BUFFER users
+    CHECKED_GL_CALL(glGenBuffers(1, &buffer));
+    CHECKED_GL_CALL(glBindBuffer(GL_COPY_WRITE_BUFFER, buffer));
+
+    const GLsizeiptr totalSize = regionSize * regions;
+    if (allowPersistent && GLAD_GL_VERSION_4_4 && glBufferStorage)
+    {
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        CHECKED_GL_CALL(glBufferStorage(GL_COPY_WRITE_BUFFER, totalSize, nullptr, flags));
+        persistentData = (char *) glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, totalSize, flags);
+        if (!persistentData)
+        {
+            std::cerr << "Could not map the stream buffer persistently" << std::endl;
+            CHECKED_GL_CALL(glBindBuffer(GL_COPY_WRITE_BUFFER, 0));
+            destroy();
+            return false;
+        }
+    }
+    else
+    {
+        CHECKED_GL_CALL(glBufferData(GL_COPY_WRITE_BUFFER, totalSize, nullptr, GL_STREAM_DRAW));
+    }
+
+    CHECKED_GL_CALL(glBindBuffer(GL_COPY_WRITE_BUFFER, 0));
+    return true;
+}
+
+void StreamBuffer::destroy()
+{
+    for (GLsync &fence : fences)
+    {
+        if (fence)
+        {
+            glDeleteSync(fence);
+            fence = nullptr;
+        }
+    }
+
+    if (buffer)
+    {
+        // deleting a buffer unmaps it
+        glDeleteBuffers(1, &buffer);
+        buffer = 0;
+    }
+    persistentData = nullptr;
+    mapped = false;
+    inFrame = false;
+}
+
+void StreamBuffer::beginFrame()
+{
+    if (!buffer)
+    {
+        return;
+    }
+
+    if (inFrame)
+    {
+        flush();
+        fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+    inFrame = true;
+
+    region = (region + 1) % (int) fences.size();
+    used = 0;
+
+    GLsync &fence = fences[region];
+    if (fence)
+    {
+        // only stalls if the GPU is more than a region count of frames behind
+        GLenum status = glClientWaitSync(fence, 0, 0);
+        if (status == GL_TIMEOUT_EXPIRED)
+        {
+            stalls++;
+            const GLuint64 timeout = 100000000; // 100 ms
+            do
+            {
+                status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout);
+            }
+            while (status == GL_TIMEOUT_EXPIRED);
+        }
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+}
+
+StreamBuffer::Allocation StreamBuffer::allocate(GLsizeiptr size, GLsizeiptr alignment)
+{
+    Allocation allocation;
+    if (!buffer)
+    {
+        return allocation;
+    }
+
+    GLsizeiptr start = (used + alignment - 1) / alignment * alignment;
+    if (start + size > regionSize)
+    {
+        if (!warnedFull)
+        {
+            std::cerr << "Stream buffer region of " << regionSize << " bytes is full" << std::endl;
+            warnedFull = true;
+        }
+        return allocation;
+    }
+    used = start + size;
+    allocation.offset = region * regionSize + start;
+
+    if (persistentData)
+    {
+        allocation.data = persistentData + allocation.offset;
+        return allocation;
+    }
+
+    // only one range is mapped at a time
+    flush();
+    CHECKED_GL_CALL(glBindBuffer(GL_COPY_WRITE_BUFFER, buffer));
+    allocation.data = glMapBufferRange(GL_COPY_WRITE_BUFFER, allocation.offset, size,
+                                       GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+    CHECKED_GL_CALL(glBindBuffer(GL_COPY_WRITE_BUFFER, 0));
+    mapped = allocation.data != nullptr;
+    return allocation;
+}
+
+void StreamBuffer::flush()
+{
+    if (!mapped)
+    {
+        return;
+    }
+    CHECKED_GL_CALL(glBindBuffer(GL_COPY_WRITE_BUFFER, buffer));
+    CHECKED_GL_CALL(glUnmapBuffer(GL_COPY_WRITE_BUFFER));
+    CHECKED_GL_CALL(glBindBuffer(GL_COPY_WRITE_BUFFER, 0));
+    mapped = false;
+}
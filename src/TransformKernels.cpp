@@ -0,0 +1,455 @@
+#include "TransformKernels.h"
+
+#include <atomic>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define TRANSFORM_KERNELS_SSE
+#endif
+
+// the AVX2 functions are compiled for AVX2 individually, the rest of the file is not
+#if defined(TRANSFORM_KERNELS_SSE) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define TRANSFORM_KERNELS_AVX2
+#define AVX2_TARGET __attribute__((target("avx2,fma")))
+#endif
+
+#ifdef GLM_FORCE_QUAT_DATA_WXYZ
+#error "the SIMD paths load quaternions as x, y, z, w"
+#endif
+
+namespace TransformKernels
+{
+    namespace
+    {
+        void normalMatrixScalar(const glm::mat4 &model, glm::mat3 &normal)
+        {
+            glm::vec3 c0 = glm::vec3(model[0]);
+            glm::vec3 c1 = glm::vec3(model[1]);
+            glm::vec3 c2 = glm::vec3(model[2]);
+
+            // the columns of the inverse transpose are the cofactors divided by the determinant
+            glm::vec3 r0 = glm::cross(c1, c2);
+            glm::vec3 r1 = glm::cross(c2, c0);
+            glm::vec3 r2 = glm::cross(c0, c1);
+            float invDet = 1.0f / glm::dot(c0, r0);
+
+            normal[0] = r0 * invDet;
+            normal[1] = r1 * invDet;
+            normal[2] = r2 * invDet;
+        }
+
+#ifdef TRANSFORM_KERNELS_SSE
+        // one component of one column for four matrices (structure of arrays)
+        struct Vec3x4
+        {
+            __m128 x, y, z;
+        };
+
+        inline Vec3x4 cross(const Vec3x4 &a, const Vec3x4 &b)
+        {
+            Vec3x4 r;
+            r.x = _mm_sub_ps(_mm_mul_ps(a.y, b.z), _mm_mul_ps(a.z, b.y));
+            r.y = _mm_sub_ps(_mm_mul_ps(a.z, b.x), _mm_mul_ps(a.x, b.z));
+            r.z = _mm_sub_ps(_mm_mul_ps(a.x, b.y), _mm_mul_ps(a.y, b.x));
+            return r;
+        }
+
+        inline __m128 dot(const Vec3x4 &a, const Vec3x4 &b)
+        {
+            return _mm_add_ps(_mm_add_ps(_mm_mul_ps(a.x, b.x), _mm_mul_ps(a.y, b.y)), _mm_mul_ps(a.z, b.z));
+        }
+
+        // loads column c of four consecutive matrices and transposes it to SoA
+        inline Vec3x4 loadColumn(const glm::mat4 *models, int c)
+        {
+            __m128 m0 = _mm_loadu_ps(&models[0][c][0]);
+            __m128 m1 = _mm_loadu_ps(&models[1][c][0]);
+            __m128 m2 = _mm_loadu_ps(&models[2][c][0]);
+            __m128 m3 = _mm_loadu_ps(&models[3][c][0]);
+            _MM_TRANSPOSE4_PS(m0, m1, m2, m3);
+            Vec3x4 r = {m0, m1, m2};
+            return r;
+        }
+
+        // writes column c of four consecutive normal matrices
+        inline void storeColumn(glm::mat3 *normals, int c, const Vec3x4 &v, __m128 scale)
+        {
+            alignas(16) float x[4], y[4], z[4];
+            _mm_store_ps(x, _mm_mul_ps(v.x, scale));
+            _mm_store_ps(y, _mm_mul_ps(v.y, scale));
+            _mm_store_ps(z, _mm_mul_ps(v.z, scale));
+            for (int i = 0; i < 4; i++)
+            {
+                normals[i][c] = glm::vec3(x[i], y[i], z[i]);
+            }
+        }
+#endif
+    }
+
+    void normalMatrices(const glm::mat4 *models, glm::mat3 *normals, size_t count)
+    {
+        size_t i = 0;
+
+#ifdef TRANSFORM_KERNELS_SSE
+        const __m128 one = _mm_set1_ps(1.0f);
+        for (; i + 4 <= count; i += 4)
+        {
+            Vec3x4 c0 = loadColumn(models + i, 0);
+            Vec3x4 c1 = loadColumn(models + i, 1);
+            Vec3x4 c2 = loadColumn(models + i, 2);
+
+            Vec3x4 r0 = cross(c1, c2);
+            Vec3x4 r1 = cross(c2, c0);
+            Vec3x4 r2 = cross(c0, c1);
+            __m128 invDet = _mm_div_ps(one, dot(c0, r0));
+
+            storeColumn(normals + i, 0, r0, invDet);
+            storeColumn(normals + i, 1, r1, invDet);
+            storeColumn(normals + i, 2, r2, invDet);
+        }
+#endif
+
+        for (; i < count; i++)
+        {
+            normalMatrixScalar(models[i], normals[i]);
+        }
+    }
+
+    // ------------------------------------------------------------------------
+    // mat4 kernels
+
+    namespace
+    {
+        typedef void (*MultiplyFunction)(const glm::mat4 *a, size_t aStride, const glm::mat4 *b, size_t bStride, glm::mat4 *out, size_t count);
+        typedef void (*ComposeFunction)(const glm::vec3 *translations, const glm::quat *rotations, const glm::vec3 *scales, glm::mat4 *out, size_t count);
+
+        // a stride of 0 uses the first matrix for every product, 1 steps through the array
+        void multiplyScalar(const glm::mat4 *a, size_t aStride, const glm::mat4 *b, size_t bStride, glm::mat4 *out, size_t count)
+        {
+            for (size_t i = 0; i < count; i++)
+            {
+                out[i] = a[i * aStride] * b[i * bStride];
+            }
+        }
+
+        void composeScalar(const glm::vec3 *translations, const glm::quat *rotations, const glm::vec3 *scales, glm::mat4 *out, size_t count)
+        {
+            for (size_t i = 0; i < count; i++)
+            {
+                // rotation matrix with its columns scaled, translation in the last column
+                glm::mat3 r = glm::mat3_cast(rotations[i]);
+                out[i] = glm::mat4(glm::vec4(r[0] * scales[i].x, 0.0f),
+                                   glm::vec4(r[1] * scales[i].y, 0.0f),
+                                   glm::vec4(r[2] * scales[i].z, 0.0f),
+                                   glm::vec4(translations[i], 1.0f));
+            }
+        }
+
+#ifdef TRANSFORM_KERNELS_SSE
+#define BROADCAST_LANE(v, lane) _mm_shuffle_ps(v, v, _MM_SHUFFLE(lane, lane, lane, lane))
+
+        inline __m128 multiplyColumn(__m128 a0, __m128 a1, __m128 a2, __m128 a3, __m128 column)
+        {
+            __m128 r = _mm_mul_ps(a0, BROADCAST_LANE(column, 0));
+            r = _mm_add_ps(r, _mm_mul_ps(a1, BROADCAST_LANE(column, 1)));
+            r = _mm_add_ps(r, _mm_mul_ps(a2, BROADCAST_LANE(column, 2)));
+            return _mm_add_ps(r, _mm_mul_ps(a3, BROADCAST_LANE(column, 3)));
+        }
+
+        void multiplySSE(const glm::mat4 *a, size_t aStride, const glm::mat4 *b, size_t bStride, glm::mat4 *out, size_t count)
+        {
+            for (size_t i = 0; i < count; i++)
+            {
+                const float *pa = &a[i * aStride][0][0];
+                const float *pb = &b[i * bStride][0][0];
+                __m128 a0 = _mm_loadu_ps(pa), a1 = _mm_loadu_ps(pa + 4), a2 = _mm_loadu_ps(pa + 8), a3 = _mm_loadu_ps(pa + 12);
+                // all of b is loaded before anything is stored, so out may alias it
+                __m128 b0 = _mm_loadu_ps(pb), b1 = _mm_loadu_ps(pb + 4), b2 = _mm_loadu_ps(pb + 8), b3 = _mm_loadu_ps(pb + 12);
+
+                float *po = &out[i][0][0];
+                _mm_storeu_ps(po, multiplyColumn(a0, a1, a2, a3, b0));
+                _mm_storeu_ps(po + 4, multiplyColumn(a0, a1, a2, a3, b1));
+                _mm_storeu_ps(po + 8, multiplyColumn(a0, a1, a2, a3, b2));
+                _mm_storeu_ps(po + 12, multiplyColumn(a0, a1, a2, a3, b3));
+            }
+        }
+
+        // the nine rotation matrix entries of four quaternions, as in glm::mat3_cast
+        struct Rotation4
+        {
+            __m128 m00, m01, m02, m10, m11, m12, m20, m21, m22;
+        };
+
+        inline Rotation4 quatToMat3(__m128 x, __m128 y, __m128 z, __m128 w)
+        {
+            const __m128 one = _mm_set1_ps(1.0f);
+            const __m128 two = _mm_set1_ps(2.0f);
+            __m128 xx = _mm_mul_ps(x, x), yy = _mm_mul_ps(y, y), zz = _mm_mul_ps(z, z);
+            __m128 xz = _mm_mul_ps(x, z), xy = _mm_mul_ps(x, y), yz = _mm_mul_ps(y, z);
+            __m128 wx = _mm_mul_ps(w, x), wy = _mm_mul_ps(w, y), wz = _mm_mul_ps(w, z);
+
+            Rotation4 r;
+            r.m00 = _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz)));
+            r.m01 = _mm_mul_ps(two, _mm_add_ps(xy, wz));
+            r.m02 = _mm_mul_ps(two, _mm_sub_ps(xz, wy));
+            r.m10 = _mm_mul_ps(two, _mm_sub_ps(xy, wz));
+            r.m11 = _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz)));
+            r.m12 = _mm_mul_ps(two, _mm_add_ps(yz, wx));
+            r.m20 = _mm_mul_ps(two, _mm_add_ps(xz, wy));
+            r.m21 = _mm_mul_ps(two, _mm_sub_ps(yz, wx));
+            r.m22 = _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy)));
+            return r;
+        }
+
+        // writes one column of four consecutive matrices from its components in SoA form
+        inline void storeColumn4(glm::mat4 *out, int c, __m128 x, __m128 y, __m128 z, __m128 w)
+        {
+            _MM_TRANSPOSE4_PS(x, y, z, w);
+            _mm_storeu_ps(&out[0][c][0], x);
+            _mm_storeu_ps(&out[1][c][0], y);
+            _mm_storeu_ps(&out[2][c][0], z);
+            _mm_storeu_ps(&out[3][c][0], w);
+        }
+
+        void composeSSE(const glm::vec3 *translations, const glm::quat *rotations, const glm::vec3 *scales, glm::mat4 *out, size_t count)
+        {
+            const __m128 zero = _mm_setzero_ps();
+            const __m128 one = _mm_set1_ps(1.0f);
+
+            size_t i = 0;
+            for (; i + 4 <= count; i += 4)
+            {
+                const glm::quat *q = rotations + i;
+                __m128 x = _mm_loadu_ps(&q[0].x), y = _mm_loadu_ps(&q[1].x), z = _mm_loadu_ps(&q[2].x), w = _mm_loadu_ps(&q[3].x);
+                _MM_TRANSPOSE4_PS(x, y, z, w);
+                Rotation4 r = quatToMat3(x, y, z, w);
+
+                const glm::vec3 *s = scales + i;
+                __m128 sx = _mm_setr_ps(s[0].x, s[1].x, s[2].x, s[3].x);
+                __m128 sy = _mm_setr_ps(s[0].y, s[1].y, s[2].y, s[3].y);
+                __m128 sz = _mm_setr_ps(s[0].z, s[1].z, s[2].z, s[3].z);
+                const glm::vec3 *t = translations + i;
+
+                storeColumn4(out + i, 0, _mm_mul_ps(r.m00, sx), _mm_mul_ps(r.m01, sx), _mm_mul_ps(r.m02, sx), zero);
+                storeColumn4(out + i, 1, _mm_mul_ps(r.m10, sy), _mm_mul_ps(r.m11, sy), _mm_mul_ps(r.m12, sy), zero);
+                storeColumn4(out + i, 2, _mm_mul_ps(r.m20, sz), _mm_mul_ps(r.m21, sz), _mm_mul_ps(r.m22, sz), zero);
+                storeColumn4(out + i, 3, _mm_setr_ps(t[0].x, t[1].x, t[2].x, t[3].x), _mm_setr_ps(t[0].y, t[1].y, t[2].y, t[3].y),
+                             _mm_setr_ps(t[0].z, t[1].z, t[2].z, t[3].z), one);
+            }
+            composeScalar(translations + i, rotations + i, scales + i, out + i, count - i);
+        }
+#endif
+
+#ifdef TRANSFORM_KERNELS_AVX2
+        // two columns of the result at a time: lane k of the low half is column c,
+        // of the high half column c + 1
+        AVX2_TARGET void multiplyAVX2(const glm::mat4 *a, size_t aStride, const glm::mat4 *b, size_t bStride, glm::mat4 *out, size_t count)
+        {
+            for (size_t i = 0; i < count; i++)
+            {
+                const float *pa = &a[i * aStride][0][0];
+                const float *pb = &b[i * bStride][0][0];
+                __m256 a0 = _mm256_broadcast_ps((const __m128 *) pa);
+                __m256 a1 = _mm256_broadcast_ps((const __m128 *) (pa + 4));
+                __m256 a2 = _mm256_broadcast_ps((const __m128 *) (pa + 8));
+                __m256 a3 = _mm256_broadcast_ps((const __m128 *) (pa + 12));
+                __m256 b01 = _mm256_loadu_ps(pb);
+                __m256 b23 = _mm256_loadu_ps(pb + 8);
+
+                __m256 r01 = _mm256_mul_ps(a0, _mm256_permute_ps(b01, 0x00));
+                r01 = _mm256_fmadd_ps(a1, _mm256_permute_ps(b01, 0x55), r01);
+                r01 = _mm256_fmadd_ps(a2, _mm256_permute_ps(b01, 0xAA), r01);
+                r01 = _mm256_fmadd_ps(a3, _mm256_permute_ps(b01, 0xFF), r01);
+                __m256 r23 = _mm256_mul_ps(a0, _mm256_permute_ps(b23, 0x00));
+                r23 = _mm256_fmadd_ps(a1, _mm256_permute_ps(b23, 0x55), r23);
+                r23 = _mm256_fmadd_ps(a2, _mm256_permute_ps(b23, 0xAA), r23);
+                r23 = _mm256_fmadd_ps(a3, _mm256_permute_ps(b23, 0xFF), r23);
+
+                float *po = &out[i][0][0];
+                _mm256_storeu_ps(po, r01);
+                _mm256_storeu_ps(po + 8, r23);
+            }
+        }
+
+        struct Rotation8
+        {
+            __m256 m00, m01, m02, m10, m11, m12, m20, m21, m22;
+        };
+
+        AVX2_TARGET inline void quatToMat3(const glm::quat *q, Rotation8 &r)
+        {
+            __m128 x0 = _mm_loadu_ps(&q[0].x), y0 = _mm_loadu_ps(&q[1].x), z0 = _mm_loadu_ps(&q[2].x), w0 = _mm_loadu_ps(&q[3].x);
+            __m128 x1 = _mm_loadu_ps(&q[4].x), y1 = _mm_loadu_ps(&q[5].x), z1 = _mm_loadu_ps(&q[6].x), w1 = _mm_loadu_ps(&q[7].x);
+            _MM_TRANSPOSE4_PS(x0, y0, z0, w0);
+            _MM_TRANSPOSE4_PS(x1, y1, z1, w1);
+            __m256 x = _mm256_set_m128(x1, x0), y = _mm256_set_m128(y1, y0), z = _mm256_set_m128(z1, z0), w = _mm256_set_m128(w1, w0);
+
+            const __m256 one = _mm256_set1_ps(1.0f);
+            const __m256 two = _mm256_set1_ps(2.0f);
+            __m256 xx = _mm256_mul_ps(x, x), yy = _mm256_mul_ps(y, y), zz = _mm256_mul_ps(z, z);
+            __m256 xz = _mm256_mul_ps(x, z), xy = _mm256_mul_ps(x, y), yz = _mm256_mul_ps(y, z);
+            __m256 wx = _mm256_mul_ps(w, x), wy = _mm256_mul_ps(w, y), wz = _mm256_mul_ps(w, z);
+
+            r.m00 = _mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(yy, zz)));
+            r.m01 = _mm256_mul_ps(two, _mm256_add_ps(xy, wz));
+            r.m02 = _mm256_mul_ps(two, _mm256_sub_ps(xz, wy));
+            r.m10 = _mm256_mul_ps(two, _mm256_sub_ps(xy, wz));
+            r.m11 = _mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(xx, zz)));
+            r.m12 = _mm256_mul_ps(two, _mm256_add_ps(yz, wx));
+            r.m20 = _mm256_mul_ps(two, _mm256_add_ps(xz, wy));
+            r.m21 = _mm256_mul_ps(two, _mm256_sub_ps(yz, wx));
+            r.m22 = _mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(xx, yy)));
+        }
+
+        AVX2_TARGET inline void storeColumn8(glm::mat4 *out, int c, __m256 x, __m256 y, __m256 z, __m256 w)
+        {
+            storeColumn4(out, c, _mm256_castps256_ps128(x), _mm256_castps256_ps128(y), _mm256_castps256_ps128(z), _mm256_castps256_ps128(w));
+            storeColumn4(out + 4, c, _mm256_extractf128_ps(x, 1), _mm256_extractf128_ps(y, 1), _mm256_extractf128_ps(z, 1), _mm256_extractf128_ps(w, 1));
+        }
+
+        // loads one component of a vec3 for eight elements
+        AVX2_TARGET inline __m256 gather8(const glm::vec3 *v, int component)
+        {
+            const __m256i index = _mm256_setr_epi32(0, 3, 6, 9, 12, 15, 18, 21);
+            return _mm256_i32gather_ps(&v[0][component], index, 4);
+        }
+
+        AVX2_TARGET void composeAVX2(const glm::vec3 *translations, const glm::quat *rotations, const glm::vec3 *scales, glm::mat4 *out, size_t count)
+        {
+            const __m256 zero = _mm256_setzero_ps();
+            const __m256 one = _mm256_set1_ps(1.0f);
+
+            size_t i = 0;
+            for (; i + 8 <= count; i += 8)
+            {
+                Rotation8 r;
+                quatToMat3(rotations + i, r);
+
+                __m256 sx = gather8(scales + i, 0), sy = gather8(scales + i, 1), sz = gather8(scales + i, 2);
+
+                storeColumn8(out + i, 0, _mm256_mul_ps(r.m00, sx), _mm256_mul_ps(r.m01, sx), _mm256_mul_ps(r.m02, sx), zero);
+                storeColumn8(out + i, 1, _mm256_mul_ps(r.m10, sy), _mm256_mul_ps(r.m11, sy), _mm256_mul_ps(r.m12, sy), zero);
+                storeColumn8(out + i, 2, _mm256_mul_ps(r.m20, sz), _mm256_mul_ps(r.m21, sz), _mm256_mul_ps(r.m22, sz), zero);
+                storeColumn8(out + i, 3, gather8(translations + i, 0), gather8(translations + i, 1), gather8(translations + i, 2), one);
+            }
+            composeSSE(translations + i, rotations + i, scales + i, out + i, count - i);
+        }
+
+        bool cpuHasAVX2()
+        {
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+        }
+#endif
+
+        struct Kernels
+        {
+            Isa isa;
+            MultiplyFunction multiply;
+            ComposeFunction compose;
+        };
+
+        Kernels kernelsFor(Isa isa)
+        {
+            switch (isa)
+            {
+#ifdef TRANSFORM_KERNELS_AVX2
+                case Isa::AVX2:
+                    return Kernels{Isa::AVX2, multiplyAVX2, composeAVX2};
+#endif
+#ifdef TRANSFORM_KERNELS_SSE
+                case Isa::SSE:
+                    return Kernels{Isa::SSE, multiplySSE, composeSSE};
+#endif
+                default:
+                    return Kernels{Isa::SCALAR, multiplyScalar, composeScalar};
+            }
+        }
+
+        std::atomic<const Kernels *> selected{nullptr};
+
+        const Kernels &kernels()
+        {
+            const Kernels *current = selected.load(std::memory_order_acquire);
+            if (!current)
+            {
+                static const Kernels best = kernelsFor(isSupported(Isa::AVX2) ? Isa::AVX2 : (isSupported(Isa::SSE) ? Isa::SSE : Isa::SCALAR));
+                selected.store(&best, std::memory_order_release);
+                current = &best;
+            }
+            return *current;
+        }
+    }
+
+    bool isSupported(Isa isa)
+    {
+        switch (isa)
+        {
+            case Isa::SCALAR:
+                return true;
+            case Isa::SSE:
+#ifdef TRANSFORM_KERNELS_SSE
+                return true;
+#else
+                return false;
+#endif
+            case Isa::AVX2:
+#ifdef TRANSFORM_KERNELS_AVX2
+                {
+                    static const bool supported = cpuHasAVX2();
+                    return supported;
+                }
+#else
+                return false;
+#endif
+        }
+        return false;
+    }
+
+    Isa getIsa()
+    {
+        return kernels().isa;
+    }
+
+    bool setIsa(Isa isa)
+    {
+        if (!isSupported(isa))
+        {
+            return false;
+        }
+        static const Kernels table[] = {kernelsFor(Isa::SCALAR), kernelsFor(Isa::SSE), kernelsFor(Isa::AVX2)};
+        selected.store(&table[(int) isa], std::memory_order_release);
+        return true;
+    }
+
+    const char *getIsaName(Isa isa)
+    {
+        switch (isa)
+        {
+            case Isa::SSE: return "sse";
+            case Isa::AVX2: return "avx2";
+            default: return "scalar";
+        }
+    }
+
+    void multiply(const glm::mat4 *a, const glm::mat4 *b, glm::mat4 *out, size_t count)
+    {
+        kernels().multiply(a, 1, b, 1, out, count);
+    }
+
+    void multiply(const glm::mat4 &a, const glm::mat4 *b, glm::mat4 *out, size_t count)
+    {
+        kernels().multiply(&a, 0, b, 1, out, count);
+    }
+
+    void multiply(const glm::mat4 *a, const glm::mat4 &b, glm::mat4 *out, size_t count)
+    {
+        kernels().multiply(a, 1, &b, 0, out, count);
+    }
+
+    void composeTRS(const glm::vec3 *translations, const glm::quat *rotations, const glm::vec3 *scales, glm::mat4 *out, size_t count)
+    {
+        kernels().compose(translations, rotations, scales, out, count);
+    }
+}
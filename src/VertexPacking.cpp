@@ -0,0 +1,273 @@
+#include "VertexPacking.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#include "glm/packing.hpp"
+
+namespace
+{
+    const float UNORM16_MAX = 65535.0f;
+    const float SNORM16_MAX = 32767.0f;
+    const float SNORM10_MAX = 511.0f;
+
+    // GL's snorm rule since 4.2, -max and -max - 1 both decode to -1
+    float snorm(int value, float maxValue)
+    {
+        return std::max(value / maxValue, -1.0f);
+    }
+
+    float signNotZero(float x)
+    {
+        return x >= 0.0f ? 1.0f : -1.0f;
+    }
+
+    // the unit sphere folded onto the square [-1, 1]^2
+    glm::vec2 octahedral(glm::vec3 n)
+    {
+        float l1 = std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+        if (l1 == 0.0f)
+        {
+            return glm::vec2(0.0f);
+        }
+        glm::vec2 p = glm::vec2(n.x, n.y) / l1;
+        if (n.z < 0.0f)
+        {
+            p = glm::vec2((1.0f - std::abs(p.y)) * signNotZero(p.x), (1.0f - std::abs(p.x)) * signNotZero(p.y));
+        }
+        return p;
+    }
+
+    // same as decodeOctahedral in simpleVertex.vs
+    glm::vec3 unoctahedral(glm::vec2 e)
+    {
+        glm::vec3 n(e.x, e.y, 1.0f - std::abs(e.x) - std::abs(e.y));
+        if (n.z < 0.0f)
+        {
+            n.x = (1.0f - std::abs(e.y)) * signNotZero(e.x);
+            n.y = (1.0f - std::abs(e.x)) * signNotZero(e.y);
+        }
+        return glm::normalize(n);
+    }
+
+    uint32_t packShorts(int x, int y)
+    {
+        return (uint32_t)(uint16_t)(int16_t) x | ((uint32_t)(uint16_t)(int16_t) y << 16);
+    }
+
+    // in degrees, atan2 stays accurate for the tiny angles acos(dot) loses
+    float angleBetween(glm::vec3 a, glm::vec3 b)
+    {
+        return glm::degrees(std::atan2(glm::length(glm::cross(a, b)), glm::dot(a, b)));
+    }
+
+    void setAttribute(VertexAttribute &attribute, GLint size, GLenum type, GLboolean normalized, GLsizei bytes, GLsizei &offset)
+    {
+        attribute = {size, type, normalized, 0, offset};
+        offset += bytes;
+    }
+}
+
+namespace VertexPacking
+{
+    uint32_t encodeOctahedral(glm::vec3 n)
+    {
+        float length = glm::length(n);
+        if (length == 0.0f)
+        {
+            return 0;
+        }
+        n /= length;
+
+        // rounding each component on its own is not the closest encoding, try all four neighbours
+        glm::vec2 base = glm::floor(octahedral(n) * SNORM16_MAX);
+        uint32_t best = 0;
+        float bestDot = -2.0f;
+        for (int i = 0; i < 4; i++)
+        {
+            int x = std::clamp((int) base.x + (i & 1), -32767, 32767);
+            int y = std::clamp((int) base.y + (i >> 1), -32767, 32767);
+            float d = glm::dot(n, unoctahedral(glm::vec2(snorm(x, SNORM16_MAX), snorm(y, SNORM16_MAX))));
+            if (d > bestDot)
+            {
+                bestDot = d;
+                best = packShorts(x, y);
+            }
+        }
+        return best;
+    }
+
+    glm::vec3 decodeOctahedral(uint32_t encoded)
+    {
+        int x = (int16_t)(encoded & 0xFFFF);
+        int y = (int16_t)(encoded >> 16);
+        return unoctahedral(glm::vec2(snorm(x, SNORM16_MAX), snorm(y, SNORM16_MAX)));
+    }
+
+    uint32_t encodeInt2101010(glm::vec3 n)
+    {
+        float length = glm::length(n);
+        if (length > 0.0f)
+        {
+            n /= length;
+        }
+        uint32_t encoded = 0;
+        for (int i = 0; i < 3; i++)
+        {
+            int value = (int) std::lround(std::clamp(n[i], -1.0f, 1.0f) * SNORM10_MAX);
+            encoded |= ((uint32_t) value & 0x3FF) << (10 * i);
+        }
+        return encoded;
+    }
+
+    glm::vec3 decodeInt2101010(uint32_t encoded)
+    {
+        glm::vec3 n;
+        for (int i = 0; i < 3; i++)
+        {
+            // sign extend the 10 bit field
+            int value = (int)((encoded >> (10 * i)) & 0x3FF);
+            value = value >= 512 ? value - 1024 : value;
+            n[i] = snorm(value, SNORM10_MAX);
+        }
+        return n;
+    }
+
+    void pack(const std::vector<Vertex> &vertices, const Options &options, PackedVertices &packed)
+    {
+        packed = PackedVertices();
+
+        // positions relative to the mesh's own bounds, tighter than the model's
+        glm::vec3 minimum(std::numeric_limits<float>::max());
+        glm::vec3 maximum(-std::numeric_limits<float>::max());
+        for (const Vertex &vertex : vertices)
+        {
+            minimum = glm::min(minimum, vertex.Position);
+            maximum = glm::max(maximum, vertex.Position);
+        }
+        if (vertices.empty())
+        {
+            minimum = maximum = glm::vec3(0.0f);
+        }
+        glm::vec3 extent = maximum - minimum;
+        float largestExtent = std::max(std::max(extent.x, extent.y), extent.z);
+        glm::vec3 quantize;
+        for (int i = 0; i < 3; i++)
+        {
+            quantize[i] = extent[i] > 0.0f ? UNORM16_MAX / extent[i] : 0.0f;
+        }
+
+        // encode everything once to measure the errors, then decide per attribute
+        size_t count = vertices.size();
+        std::vector<uint16_t> positions(4 * count, 0);
+        std::vector<uint32_t> normals(count);
+        std::vector<uint32_t> texCoords(count);
+        bool octahedral = options.normals == NormalEncoding::OCTAHEDRAL;
+        for (size_t v = 0; v < count; v++)
+        {
+            const Vertex &vertex = vertices[v];
+            for (int i = 0; i < 3; i++)
+            {
+                float q = std::round((vertex.Position[i] - minimum[i]) * quantize[i]);
+                positions[4 * v + i] = (uint16_t) std::clamp(q, 0.0f, UNORM16_MAX);
+                float decoded = minimum[i] + extent[i] * (positions[4 * v + i] / UNORM16_MAX);
+                if (largestExtent > 0.0f)
+                {
+                    packed.positionError = std::max(packed.positionError, std::abs(decoded - vertex.Position[i]) / largestExtent);
+                }
+            }
+
+            // zero normals (a file without them) decode to +z, nothing to compare against
+            normals[v] = octahedral ? encodeOctahedral(vertex.Normal) : encodeInt2101010(vertex.Normal);
+            if (glm::dot(vertex.Normal, vertex.Normal) > 0.0f)
+            {
+                glm::vec3 decoded = octahedral ? decodeOctahedral(normals[v]) : decodeInt2101010(normals[v]);
+                packed.normalError = std::max(packed.normalError, angleBetween(glm::normalize(vertex.Normal), decoded));
+            }
+
+            texCoords[v] = glm::packHalf2x16(vertex.TexCoord);
+            glm::vec2 error = glm::abs(glm::unpackHalf2x16(texCoords[v]) - vertex.TexCoord);
+            // coordinates out of half's range decode to infinity, NaN never passes either
+            float texCoordError = std::max(error.x, error.y);
+            packed.texCoordError = std::isnan(texCoordError) ? std::numeric_limits<float>::infinity()
+                                                             : std::max(packed.texCoordError, texCoordError);
+        }
+        bool packPositions = packed.positionError <= options.positionTolerance;
+        bool packNormals = packed.normalError <= options.normalTolerance;
+        bool packTexCoords = packed.texCoordError <= options.texCoordTolerance;
+
+        // every attribute stays 4 byte aligned, packed positions get a fourth unused component
+        GLsizei offset = 0;
+        if (packPositions)
+        {
+            setAttribute(packed.attributes[0], 3, GL_UNSIGNED_SHORT, GL_TRUE, 4 * sizeof(uint16_t), offset);
+            packed.positionOffset = minimum;
+            packed.positionScale = extent;
+        }
+        else
+        {
+            setAttribute(packed.attributes[0], 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), offset);
+        }
+        if (packNormals)
+        {
+            if (octahedral)
+            {
+                setAttribute(packed.attributes[1], 2, GL_SHORT, GL_TRUE, sizeof(uint32_t), offset);
+            }
+            else
+            {
+                setAttribute(packed.attributes[1], 4, GL_INT_2_10_10_10_REV, GL_TRUE, sizeof(uint32_t), offset);
+            }
+            packed.octahedralNormals = octahedral;
+        }
+        else
+        {
+            setAttribute(packed.attributes[1], 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), offset);
+        }
+        if (packTexCoords)
+        {
+            setAttribute(packed.attributes[2], 2, GL_HALF_FLOAT, GL_FALSE, sizeof(uint32_t), offset);
+        }
+        else
+        {
+            setAttribute(packed.attributes[2], 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2), offset);
+        }
+        packed.stride = offset;
+        for (VertexAttribute &attribute : packed.attributes)
+        {
+            attribute.stride = packed.stride;
+        }
+
+        packed.data.resize(count * packed.stride);
+        for (size_t v = 0; v < count; v++)
+        {
+            unsigned char *vertex = packed.data.data() + v * packed.stride;
+            if (packPositions)
+            {
+                std::memcpy(vertex + packed.attributes[0].offset, &positions[4 * v], 4 * sizeof(uint16_t));
+            }
+            else
+            {
+                std::memcpy(vertex + packed.attributes[0].offset, &vertices[v].Position, sizeof(glm::vec3));
+            }
+            if (packNormals)
+            {
+                std::memcpy(vertex + packed.attributes[1].offset, &normals[v], sizeof(uint32_t));
+            }
+            else
+            {
+                std::memcpy(vertex + packed.attributes[1].offset, &vertices[v].Normal, sizeof(glm::vec3));
+            }
+            if (packTexCoords)
+            {
+                std::memcpy(vertex + packed.attributes[2].offset, &texCoords[v], sizeof(uint32_t));
+            }
+            else
+            {
+                std::memcpy(vertex + packed.attributes[2].offset, &vertices[v].TexCoord, sizeof(glm::vec2));
+            }
+        }
+    }
+}
@@ -2,7 +2,15 @@
 #include "WindowManager.h"
 #include "GLSL.h"
 
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <thread>
+
+#ifdef WINDOW_ENABLE_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
 
 
 void error_callback(int error, const char *description)
@@ -31,6 +39,55 @@ WindowManager::~WindowManager()
 }
 
 bool WindowManager::init(int const width, int const height, const char *windowName)
+{
+	WindowSettings windowSettings;
+	windowSettings.width = width;
+	windowSettings.height = height;
+	return init(windowSettings, windowName);
+}
+
+bool WindowManager::init(const WindowSettings &windowSettings, const char *windowName)
+{
+	settings = windowSettings;
+	if (settings.lowLatency)
+	{
+		settings.maxFramesInFlight = 1;
+	}
+	startTime = std::chrono::steady_clock::now();
+	nextFrameTime = startTime;
+
+	if (settings.backend == WindowBackend::EGL_HEADLESS)
+	{
+		return initEGL();
+	}
+	return initGLFW(windowName);
+}
+
+bool WindowManager::initGL(GLADloadproc load)
+{
+	// Initialize GLAD
+	if (!gladLoadGLLoader(load))
+	{
+		std::cerr << "Failed to initialize GLAD" << std::endl;
+		return false;
+	}
+
+	GLSL::loadExtensions(load);
+	if (settings.debugContext)
+	{
+		GLSL::enableDebugOutput(load);
+	}
+
+	std::cout << "OpenGL version: " << glGetString(GL_VERSION) << std::endl;
+	std::cout << "GLSL version: " << glGetString(GL_SHADING_LANGUAGE_VERSION) << std::endl;
+	std::cout << "Renderer: " << glGetString(GL_RENDERER) << std::endl;
+
+	return true;
+}
+
+#ifndef WINDOW_NO_GLFW
+
+bool WindowManager::initGLFW(const char *windowName)
 {
 	glfwSetErrorCallback(error_callback);
 
@@ -45,9 +102,10 @@ bool WindowManager::init(int const width, int const height, const char *windowNa
 	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+	glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, settings.debugContext ? GLFW_TRUE : GLFW_FALSE);
 
 	// Create a windowed mode window and its OpenGL context.
-	windowHandle = glfwCreateWindow(width, height, windowName, nullptr, nullptr);
+	windowHandle = glfwCreateWindow(settings.width, settings.height, windowName, nullptr, nullptr);
 	if (! windowHandle)
 	{
 		glfwTerminate();
@@ -56,19 +114,13 @@ bool WindowManager::init(int const width, int const height, const char *windowNa
 
 	glfwMakeContextCurrent(windowHandle);
 
-	// Initialize GLAD
-	if (!gladLoadGL())
+	if (!initGL((GLADloadproc) glfwGetProcAddress))
 	{
-		std::cerr << "Failed to initialize GLAD" << std::endl;
 		return false;
 	}
 
-	std::cout << "OpenGL version: " << glGetString(GL_VERSION) << std::endl;
-	std::cout << "GLSL version: " << glGetString(GL_SHADING_LANGUAGE_VERSION) << std::endl;
+	setSwapInterval();
 
-	// Set vsync
-	glfwSwapInterval(1);
-	
 	glfwSetInputMode(windowHandle, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
 	glfwSetCursorPosCallback(windowHandle, cursor_callback);
 	glfwSetKeyCallback(windowHandle, key_callback);
@@ -79,10 +131,353 @@ bool WindowManager::init(int const width, int const height, const char *windowNa
 	return true;
 }
 
+void WindowManager::setSwapInterval()
+{
+	int interval = 0;
+	switch (settings.presentMode)
+	{
+		case PresentMode::IMMEDIATE:
+			interval = 0;
+			break;
+		case PresentMode::VSYNC:
+			interval = 1;
+			break;
+		case PresentMode::ADAPTIVE:
+			// a negative interval swaps immediately when the frame missed the blank
+			if (glfwExtensionSupported("GLX_EXT_swap_control_tear") || glfwExtensionSupported("WGL_EXT_swap_control_tear"))
+			{
+				interval = -1;
+			}
+			else
+			{
+				std::cerr << "Adaptive vsync is not supported, using vsync" << std::endl;
+				settings.presentMode = PresentMode::VSYNC;
+				interval = 1;
+			}
+			break;
+	}
+	glfwSwapInterval(interval);
+}
+
+#else
+
+void WindowManager::setSwapInterval()
+{
+}
+
+bool WindowManager::initGLFW(const char *windowName)
+{
+	std::cerr << "Built without GLFW, only the headless backend is available" << std::endl;
+	return false;
+}
+
+#endif
+
+#ifdef WINDOW_ENABLE_EGL
+
+bool WindowManager::initEGL()
+{
+	if (settings.softwareRendering)
+	{
+		// Mesa picks llvmpipe when hardware drivers are disabled
+		setenv("LIBGL_ALWAYS_SOFTWARE", "1", 1);
+	}
+
+	// prefer a display that needs neither a window system nor a GPU device,
+	// fall back to the default display with a pbuffer surface
+	EGLDisplay display = EGL_NO_DISPLAY;
+	const char *clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+	bool surfaceless = clientExtensions && strstr(clientExtensions, "EGL_MESA_platform_surfaceless");
+	if (surfaceless)
+	{
+		PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+			(PFNEGLGETPLATFORMDISPLAYEXTPROC) eglGetProcAddress("eglGetPlatformDisplayEXT");
+		if (getPlatformDisplay)
+		{
+			display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+		}
+	}
+	if (display == EGL_NO_DISPLAY)
+	{
+		surfaceless = false;
+		display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+	}
+
+	EGLint major, minor;
+	if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor))
+	{
+		std::cerr << "Failed to initialize EGL" << std::endl;
+		return false;
+	}
+	eglDisplay = display;
+
+	if (!eglBindAPI(EGL_OPENGL_API))
+	{
+		std::cerr << "EGL does not support desktop OpenGL" << std::endl;
+		return false;
+	}
+
+	const EGLint configAttribs[] =
+	{
+		EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+		EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8,
+		EGL_DEPTH_SIZE, 24, EGL_STENCIL_SIZE, 8,
+		EGL_NONE
+	};
+	EGLConfig config = nullptr;
+	EGLint numConfigs = 0;
+	if (!eglChooseConfig(display, configAttribs, &config, 1, &numConfigs) || numConfigs == 0)
+	{
+		// surfaceless contexts work without a config (EGL_KHR_no_config_context)
+		config = nullptr;
+		if (!surfaceless)
+		{
+			std::cerr << "No EGL pbuffer config available" << std::endl;
+			return false;
+		}
+	}
+
+	const EGLint contextAttribs[] =
+	{
+		EGL_CONTEXT_MAJOR_VERSION, 3,
+		EGL_CONTEXT_MINOR_VERSION, 3,
+		EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+		EGL_CONTEXT_OPENGL_DEBUG, settings.debugContext ? EGL_TRUE : EGL_FALSE,
+		EGL_NONE
+	};
+	EGLContext context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttribs);
+	if (context == EGL_NO_CONTEXT)
+	{
+		std::cerr << "Failed to create an EGL context" << std::endl;
+		return false;
+	}
+	eglContext = context;
+
+	// rendering goes to an FBO anyway, the pbuffer only exists for implementations
+	// that refuse to make a context current without a surface
+	EGLSurface surface = EGL_NO_SURFACE;
+	if (!surfaceless && config)
+	{
+		const EGLint pbufferAttribs[] = {EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE};
+		surface = eglCreatePbufferSurface(display, config, pbufferAttribs);
+		eglSurface = surface;
+	}
+
+	if (!eglMakeCurrent(display, surface, surface, context))
+	{
+		std::cerr << "Failed to make the EGL context current" << std::endl;
+		return false;
+	}
+
+	return initGL((GLADloadproc) eglGetProcAddress);
+}
+
+#else
+
+bool WindowManager::initEGL()
+{
+	std::cerr << "Built without EGL, the headless backend is not available" << std::endl;
+	return false;
+}
+
+#endif
+
 void WindowManager::shutdown()
 {
+	for (GLsync fence : frameFences)
+	{
+		glDeleteSync(fence);
+	}
+	frameFences.clear();
+
+#ifdef WINDOW_ENABLE_EGL
+	if (eglDisplay)
+	{
+		eglMakeCurrent((EGLDisplay) eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+		if (eglSurface)
+		{
+			eglDestroySurface((EGLDisplay) eglDisplay, (EGLSurface) eglSurface);
+		}
+		if (eglContext)
+		{
+			eglDestroyContext((EGLDisplay) eglDisplay, (EGLContext) eglContext);
+		}
+		eglTerminate((EGLDisplay) eglDisplay);
+		eglDisplay = eglContext = eglSurface = nullptr;
+		return;
+	}
+#endif
+
+#ifndef WINDOW_NO_GLFW
 	glfwDestroyWindow(windowHandle);
 	glfwTerminate();
+#endif
+}
+
+bool WindowManager::shouldClose()
+{
+#ifndef WINDOW_NO_GLFW
+	if (windowHandle)
+	{
+		return closeRequested || glfwWindowShouldClose(windowHandle);
+	}
+#endif
+	return closeRequested;
+}
+
+void WindowManager::setShouldClose(bool close)
+{
+	closeRequested = close;
+#ifndef WINDOW_NO_GLFW
+	if (windowHandle)
+	{
+		glfwSetWindowShouldClose(windowHandle, close ? GL_TRUE : GL_FALSE);
+	}
+#endif
+}
+
+void WindowManager::swapBuffers()
+{
+#ifndef WINDOW_NO_GLFW
+	if (windowHandle)
+	{
+		glfwSwapBuffers(windowHandle);
+	}
+	else
+#endif
+	{
+		// nothing to present, just make sure the frame is submitted
+		glFlush();
+	}
+	paceFrame();
+}
+
+void WindowManager::paceFrame()
+{
+	if (settings.maxFramesInFlight > 0)
+	{
+		frameFences.push_back(glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+		// wait on the oldest frame instead of letting the driver queue more of them
+		while ((int) frameFences.size() > settings.maxFramesInFlight)
+		{
+			GLsync fence = frameFences.front();
+			frameFences.pop_front();
+			const GLuint64 timeout = 100000000; // 100 ms
+			GLenum status;
+			do
+			{
+				status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout);
+			}
+			while (status == GL_TIMEOUT_EXPIRED);
+			glDeleteSync(fence);
+		}
+	}
+
+	if (settings.maxFrameRate > 0.0)
+	{
+		typedef std::chrono::steady_clock clock;
+		const clock::duration period = std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(1.0 / settings.maxFrameRate));
+
+		clock::time_point now = clock::now();
+		nextFrameTime += period;
+		// after a long frame start over instead of rushing to catch up
+		if (nextFrameTime < now - period)
+		{
+			nextFrameTime = now;
+		}
+		// sleep most of the way, the last millisecond is yielded away for precision
+		if (nextFrameTime - now > std::chrono::milliseconds(2))
+		{
+			std::this_thread::sleep_until(nextFrameTime - std::chrono::milliseconds(1));
+		}
+		while (clock::now() < nextFrameTime)
+		{
+			std::this_thread::yield();
+		}
+	}
+}
+
+void WindowManager::pollEvents()
+{
+#ifndef WINDOW_NO_GLFW
+	if (windowHandle)
+	{
+		glfwPollEvents();
+	}
+#endif
+}
+
+double WindowManager::getTime()
+{
+#ifndef WINDOW_NO_GLFW
+	if (windowHandle)
+	{
+		return glfwGetTime();
+	}
+#endif
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+bool WindowManager::makeContextCurrent()
+{
+#ifdef WINDOW_ENABLE_EGL
+	if (eglDisplay)
+	{
+		return eglMakeCurrent((EGLDisplay) eglDisplay, (EGLSurface) eglSurface, (EGLSurface) eglSurface, (EGLContext) eglContext);
+	}
+#endif
+#ifndef WINDOW_NO_GLFW
+	if (windowHandle)
+	{
+		glfwMakeContextCurrent(windowHandle);
+		return true;
+	}
+#endif
+	return false;
+}
+
+void WindowManager::releaseContext()
+{
+#ifdef WINDOW_ENABLE_EGL
+	if (eglDisplay)
+	{
+		eglMakeCurrent((EGLDisplay) eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+		return;
+	}
+#endif
+#ifndef WINDOW_NO_GLFW
+	if (windowHandle)
+	{
+		glfwMakeContextCurrent(nullptr);
+	}
+#endif
+}
+
+double WindowManager::getRefreshRate()
+{
+#ifndef WINDOW_NO_GLFW
+	if (windowHandle)
+	{
+		GLFWmonitor *monitor = glfwGetWindowMonitor(windowHandle);
+		const GLFWvidmode *mode = glfwGetVideoMode(monitor ? monitor : glfwGetPrimaryMonitor());
+		return mode ? mode->refreshRate : 0.0;
+	}
+#endif
+	return 0.0;
+}
+
+double WindowManager::getPresentLatency()
+{
+	double refreshRate = getRefreshRate();
+	if (refreshRate <= 0.0)
+	{
+		return 0.0;
+	}
+	double period = 1000.0 / refreshRate;
+	// on average half a refresh waiting for the blank with vsync, plus half a
+	// refresh of scanout until the middle of the screen is lit
+	return settings.presentMode == PresentMode::IMMEDIATE ? 0.5 * period : period;
 }
 
 void WindowManager::setEventCallbacks(EventCallbacks * callbacks_in)
@@ -1,7 +1,18 @@
 #include "Application.h"
+#include "Profiler.h"
 
-const std::string RESOURCE_DIR = "D:/my_games/resources/";
-const std::string SHADER_DIR = "D:/my_games/shaders/";
+#include <algorithm>
+
+// the CMake build points these at the source tree
+#ifndef MY_GAMES_RESOURCE_DIR
+#define MY_GAMES_RESOURCE_DIR "D:/my_games/resources/"
+#endif
+#ifndef MY_GAMES_SHADER_DIR
+#define MY_GAMES_SHADER_DIR "D:/my_games/shaders/"
+#endif
+
+const std::string RESOURCE_DIR = MY_GAMES_RESOURCE_DIR;
+const std::string SHADER_DIR = MY_GAMES_SHADER_DIR;
 
 enum class WalkAnimation
 {
@@ -29,19 +40,30 @@ std::vector<glm::vec3> pointLightPositions = {
 };
 
 /*
-void updateLegPositions(float currentTime)
-{
-    glm::mat4 &left = Models[0]->model_matrices[0];
-    glm::mat4 &right = Models[0]->model_matrices[1];
+// the player's legs as a small hierarchy: body -> hip -> leg. The leg's rest pose
+// (turned 200/180 degrees, moved to the pivot and scaled) is set once, a frame
+// only moves the body and the two hips and update() redoes just those subtrees.
+SceneGraph legGraph;
+SceneGraph::NodeId bodyNode, leftHipNode, rightHipNode, leftLegNode, rightLegNode;
 
-    left = glm::mat4(1.0f);
-    right = glm::mat4(1.0f);
+void initLegs()
+{
+    const glm::vec3 pivot(-0.062f, -0.5f, 0.129f);
+    const glm::quat leftTurn = glm::angleAxis(glm::radians(200.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    const glm::quat rightTurn = glm::angleAxis(glm::radians(180.0f), glm::vec3(0.0f, 1.0f, 0.0f));
 
-    left = glm::translate(left, camera.Position);
-    right = glm::translate(right, camera.Position);
+    bodyNode = legGraph.addNode();
+    leftHipNode = legGraph.addNode(bodyNode, glm::vec3(-0.2f, 0.0f, 0.2f));
+    rightHipNode = legGraph.addNode(bodyNode, glm::vec3(0.2f, 0.0f, 0.2f));
+    leftLegNode = legGraph.addNode(leftHipNode, leftTurn * pivot, leftTurn, glm::vec3(0.3f));
+    rightLegNode = legGraph.addNode(rightHipNode, rightTurn * pivot, rightTurn, glm::vec3(0.3f));
+    Models[0]->model_matrices.resize(2);
+}
 
-    left = glm::rotate(left, glm::radians(-1.0f * camera.Yaw - 90.0f), glm::vec3(0.0f, 1.0f, 0.0f));
-    right = glm::rotate(right, glm::radians(-1.0f * camera.Yaw - 90.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+void updateLegPositions(float currentTime)
+{
+    legGraph.setTranslation(bodyNode, camera.getPosition());
+    legGraph.setRotation(bodyNode, glm::angleAxis(glm::radians(-1.0f * camera.getYaw() - 90.0f), glm::vec3(0.0f, 1.0f, 0.0f)));
 
     const float walkAnimationFreq = 4.0f;
     const float walkAnimationAmp = 0.1f;
@@ -62,53 +84,276 @@ void updateLegPositions(float currentTime)
             footPosition2 = footPosition + glm::radians(180.0f);
         break;
         // case WalkAnimation::LEFT:
-        //     left = glm::rotate(left, glm::radians(-30.0f), glm::vec3(1.0f, 0.0f, 0.0f));
-        //     right = glm::rotate(right, glm::radians(-30.0f), glm::vec3(1.0f, 0.0f, 0.0f));
+        //     legGraph.setRotation(leftHipNode, glm::angleAxis(glm::radians(-30.0f), glm::vec3(1.0f, 0.0f, 0.0f)));
+        //     legGraph.setRotation(rightHipNode, glm::angleAxis(glm::radians(-30.0f), glm::vec3(1.0f, 0.0f, 0.0f)));
         // break;
         // case WalkAnimation::RIGHT:
-        //     left = glm::rotate(left, glm::radians(30.0f), glm::vec3(1.0f, 0.0f, 0.0f));
-        //     right = glm::rotate(right, glm::radians(30.0f), glm::vec3(1.0f, 0.0f, 0.0f));
+        //     legGraph.setRotation(leftHipNode, glm::angleAxis(glm::radians(30.0f), glm::vec3(1.0f, 0.0f, 0.0f)));
+        //     legGraph.setRotation(rightHipNode, glm::angleAxis(glm::radians(30.0f), glm::vec3(1.0f, 0.0f, 0.0f)));
         // break;
         default:
         break;
     }
-    left =  glm::translate(left, walkAnimationAmp * glm::vec3(0.0f,  -1.0f * glm::cos(footPosition) + 1.0, glm::sin(footPosition)));
-    right = glm::translate(right, walkAnimationAmp * glm::vec3(0.0f,  -1.0f * glm::cos(footPosition2) + 1.0, glm::sin(footPosition2)));
-
-
-    left = glm::translate(left, glm::vec3(-0.2f, 0.0f, 0.2f));
-    right = glm::translate(right, glm::vec3(0.2f, 0.0f, 0.2f));
-    left = glm::rotate(left, glm::radians(200.0f), glm::vec3(0.0f, 1.0f, 0.0f));
-    right = glm::rotate(right, glm::radians(180.0f), glm::vec3(0.0f, 1.0f, 0.0f));
-    left = glm::translate(left, glm::vec3(-0.062f, -0.5f, 0.129f));
-    right = glm::translate(right, glm::vec3(-0.062f, -0.5f, 0.129f));
-    left = glm::scale(left, glm::vec3(0.3f));
-    right = glm::scale(right, glm::vec3(0.3f));
+    legGraph.setTranslation(leftHipNode, glm::vec3(-0.2f, 0.0f, 0.2f) + walkAnimationAmp * glm::vec3(0.0f,  -1.0f * glm::cos(footPosition) + 1.0, glm::sin(footPosition)));
+    legGraph.setTranslation(rightHipNode, glm::vec3(0.2f, 0.0f, 0.2f) + walkAnimationAmp * glm::vec3(0.0f,  -1.0f * glm::cos(footPosition2) + 1.0, glm::sin(footPosition2)));
+
+    legGraph.update();
+    const SceneGraph::NodeId legs[] = {leftLegNode, rightLegNode};
+    legGraph.copyWorld(legs, 2, Models[0]->model_matrices.data());
 }
 */
 
+Camera_Type cameraType = Camera_Type::FREE_CAMERA;
+
 void init()
 {
-    application->setKeyBindSet(Camera_Type::FREE_CAMERA);
+    application->setCameraType(cameraType);
+    application->setKeyBindSet(cameraType);
     application->addModel("backpack/backpack.obj");
 }
 
+// number of frames to render before exiting, 0 runs until the window is closed
+int frameLimit = 0;
+int frameCount = 0;
+
 void loop()
 {
-
+    if (frameLimit > 0 && ++frameCount >= frameLimit)
+    {
+        application->requestClose();
+    }
 }
 
+void printUsage(const char *program)
+{
+    std::cout << "usage: " << program << " [--headless] [--software] [--width W] [--height H] [--gl-debug] [--reversed-z] [--frames N]"
+              << " [--vertex-format float|packed|packed-2-10-10-10] [--lod PIXELS] [--meshlets]"
+              << " [--present off|on|adaptive] [--no-vsync] [--fps-limit FPS] [--frames-in-flight N] [--low-latency]"
+              << " [--camera free|first|third] [--sim-rate HZ] [--max-sim-steps N] [--sim-thread] [--render-thread]"
+              << " [--benchmark scene] [--out report.json] [--record camera_path.txt] [--trace trace.json]" << std::endl;
+}
 
-int main()
+int main(int argc, char **argv)
 {
+    WindowSettings settings;
+    settings.width = SCR_WIDTH;
+    settings.height = SCR_HEIGHT;
+    std::string benchmarkScene;
+    std::string benchmarkReport;
+    std::string recordFile;
+    std::string traceFile;
+    RenderSettings render;
+    SimulationSettings simulation;
+    bool renderThread = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--headless")
+        {
+            settings.backend = WindowBackend::EGL_HEADLESS;
+        }
+        else if (arg == "--software")
+        {
+            settings.softwareRendering = true;
+        }
+        else if (arg == "--no-vsync")
+        {
+            settings.presentMode = PresentMode::IMMEDIATE;
+        }
+        else if (arg == "--present" && hasValue)
+        {
+            std::string mode = argv[++i];
+            if (mode == "off")
+            {
+                settings.presentMode = PresentMode::IMMEDIATE;
+            }
+            else if (mode == "on")
+            {
+                settings.presentMode = PresentMode::VSYNC;
+            }
+            else if (mode == "adaptive")
+            {
+                settings.presentMode = PresentMode::ADAPTIVE;
+            }
+            else
+            {
+                printUsage(argv[0]);
+                return 1;
+            }
+        }
+        else if (arg == "--fps-limit" && hasValue)
+        {
+            settings.maxFrameRate = std::max(std::atof(argv[++i]), 0.0);
+        }
+        else if (arg == "--frames-in-flight" && hasValue)
+        {
+            settings.maxFramesInFlight = std::max(std::atoi(argv[++i]), 0);
+        }
+        else if (arg == "--low-latency")
+        {
+            settings.lowLatency = true;
+        }
+        else if (arg == "--camera" && hasValue)
+        {
+            std::string type = argv[++i];
+            if (type == "free")
+            {
+                cameraType = Camera_Type::FREE_CAMERA;
+            }
+            else if (type == "first")
+            {
+                cameraType = Camera_Type::FIRST_PERSON;
+            }
+            else if (type == "third")
+            {
+                cameraType = Camera_Type::THIRD_PERSON;
+            }
+            else
+            {
+                printUsage(argv[0]);
+                return 1;
+            }
+        }
+        else if (arg == "--reversed-z")
+        {
+            settings.reversedZ = true;
+        }
+        else if (arg == "--vertex-format" && hasValue)
+        {
+            std::string format = argv[++i];
+            // 32 bytes per vertex, or 16 with octahedral or GL_INT_2_10_10_10_REV normals
+            render.modelImport.packVertices = format != "float";
+            if (format == "packed")
+            {
+                render.modelImport.packing.normals = VertexPacking::NormalEncoding::OCTAHEDRAL;
+            }
+            else if (format == "packed-2-10-10-10")
+            {
+                render.modelImport.packing.normals = VertexPacking::NormalEncoding::INT_2_10_10_10;
+            }
+            else if (format != "float")
+            {
+                printUsage(argv[0]);
+                return 1;
+            }
+        }
+        else if (arg == "--lod" && hasValue)
+        {
+            render.lodPixelError = std::max((float) std::atof(argv[++i]), 0.0f);
+        }
+        else if (arg == "--meshlets")
+        {
+            render.meshletCulling = true;
+        }
+        else if (arg == "--gl-debug")
+        {
+            settings.debugContext = true;
+        }
+        else if (arg == "--width" && hasValue)
+        {
+            settings.width = std::atoi(argv[++i]);
+        }
+        else if (arg == "--height" && hasValue)
+        {
+            settings.height = std::atoi(argv[++i]);
+        }
+        else if (arg == "--frames" && hasValue)
+        {
+            frameLimit = std::atoi(argv[++i]);
+        }
+        else if (arg == "--sim-rate" && hasValue)
+        {
+            simulation.step = 1.0 / std::max(std::atof(argv[++i]), 1.0);
+        }
+        else if (arg == "--max-sim-steps" && hasValue)
+        {
+            simulation.maxSteps = std::max(std::atoi(argv[++i]), 1);
+        }
+        else if (arg == "--sim-thread")
+        {
+            simulation.threaded = true;
+        }
+        else if (arg == "--render-thread")
+        {
+            renderThread = true;
+        }
+        else if (arg == "--benchmark" && hasValue)
+        {
+            benchmarkScene = argv[++i];
+        }
+        else if (arg == "--out" && hasValue)
+        {
+            benchmarkReport = argv[++i];
+        }
+        else if (arg == "--record" && hasValue)
+        {
+            recordFile = argv[++i];
+        }
+        else if (arg == "--trace" && hasValue)
+        {
+            traceFile = argv[++i];
+        }
+        else
+        {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (settings.width <= 0 || settings.height <= 0)
+    {
+        std::cerr << "Invalid resolution " << settings.width << "x" << settings.height << std::endl;
+        return 1;
+    }
+    // nothing is presented offscreen, so there is nothing to synchronize with
+    if (settings.backend == WindowBackend::EGL_HEADLESS)
+    {
+        settings.presentMode = PresentMode::IMMEDIATE;
+    }
 
     const std::string resourceDir = RESOURCE_DIR;
     const std::string shaderDir = SHADER_DIR;
-    application = new Application(shaderDir, resourceDir);
-    application->run(init, loop);
+    // benchmarks measure the renderer, not the display's refresh rate
+    if (!benchmarkScene.empty())
+    {
+        settings.presentMode = PresentMode::IMMEDIATE;
+    }
+
+    application = new Application(shaderDir, resourceDir, settings, render);
+    application->setSimulationSettings(simulation);
+    application->setRenderThreaded(renderThread);
+
+    if (!traceFile.empty())
+    {
+        Profiler::get().startTrace();
+    }
+
+    int result = 0;
+    if (!benchmarkScene.empty())
+    {
+        Benchmark benchmark;
+        if (!benchmark.load(benchmarkScene) || !application->runBenchmark(benchmark) || !benchmark.writeReport(benchmarkReport))
+        {
+            result = 1;
+        }
+    }
+    else
+    {
+        if (!recordFile.empty())
+        {
+            application->recordCameraPath(recordFile);
+        }
+        application->run(init, loop);
+    }
+
+    if (!traceFile.empty())
+    {
+        Profiler::get().writeTrace(traceFile);
+    }
 
-    // de-allocate all resources
+    // de-allocate all resources, this also destroys the window/context
     application->shutdown();
-    glfwTerminate();
-    return 0;
+    return result;
 }
\ No newline at end of file
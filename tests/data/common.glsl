@@ -0,0 +1,9 @@
+#pragma once
+#ifndef NR_LIGHTS
+#define NR_LIGHTS 4
+#endif
+
+vec3 shade()
+{
+    return vec3(0.5);
+}
@@ -0,0 +1,12 @@
+#version 330 core
+#ifdef HIGH
+#define N 8
+#else
+#define N 4
+#endif
+#define M (N * 2)
+#define K 3
+#undef K
+#define K 5
+#define L (K + 1)
+void main() {}
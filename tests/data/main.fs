@@ -0,0 +1,12 @@
+#version 330 core
+#include "common.glsl"
+#include "nested/extra.glsl"
+
+#define DOUBLE_LIGHTS (NR_LIGHTS * 2)
+
+out vec4 FragColor;
+
+void main()
+{
+    FragColor = vec4(shade(), 1.0);
+}
@@ -0,0 +1,3 @@
+// includes are resolved relative to this file
+#include "../common.glsl"
+float extra = 1.0;
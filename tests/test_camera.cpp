@@ -0,0 +1,123 @@
+#include <gtest/gtest.h>
+
+#include "Camera.h"
+#include "glm/gtc/matrix_transform.hpp"
+
+namespace
+{
+    void expectNear(const glm::mat4 &actual, const glm::mat4 &expected)
+    {
+        for (int c = 0; c < 4; c++)
+        {
+            for (int r = 0; r < 4; r++)
+            {
+                EXPECT_NEAR(actual[c][r], expected[c][r], 1e-4f) << "[" << c << "][" << r << "]";
+            }
+        }
+    }
+
+    // the Euler angle front vector the camera used before it stored a quaternion
+    glm::vec3 eulerFront(float yaw, float pitch)
+    {
+        return glm::normalize(glm::vec3(cos(glm::radians(yaw)) * cos(glm::radians(pitch)),
+                                        sin(glm::radians(pitch)),
+                                        sin(glm::radians(yaw)) * cos(glm::radians(pitch))));
+    }
+}
+
+TEST(Camera, ViewMatchesLookAt)
+{
+    Camera camera(Camera_Type::FREE_CAMERA, glm::vec3(1.0f, 2.0f, 3.0f));
+    for (float yaw : {-90.0f, 0.0f, 37.0f, 180.0f, -200.0f})
+    {
+        for (float pitch : {0.0f, 45.0f, -80.0f})
+        {
+            camera.setOrientation(yaw, pitch);
+            glm::vec3 front = eulerFront(yaw, pitch);
+            for (int i = 0; i < 3; i++)
+            {
+                EXPECT_NEAR(camera.getFront()[i], front[i], 1e-5f);
+            }
+            glm::mat4 expected = glm::lookAt(camera.getPosition(), camera.getPosition() + front, glm::vec3(0.0f, 1.0f, 0.0f));
+            expectNear(camera.GetViewMatrix(), expected);
+        }
+    }
+}
+
+TEST(Camera, CachedMatricesFollowChanges)
+{
+    Camera camera(Camera_Type::FREE_CAMERA);
+    camera.setViewport(800, 600);
+    glm::mat4 viewProjection = camera.GetViewProjectionMatrix();
+    expectNear(viewProjection, glm::perspective(glm::radians(ZOOM), 800.0f / 600.0f, NEAR_PLANE, FAR_PLANE) * camera.GetViewMatrix());
+
+    camera.setCameraPos(glm::vec3(0.0f, 0.0f, 5.0f));
+    camera.adjustZoom(10.0f);
+    glm::mat4 expected = glm::perspective(glm::radians(ZOOM - 10.0f), 800.0f / 600.0f, NEAR_PLANE, FAR_PLANE) *
+                         glm::lookAt(glm::vec3(0.0f, 0.0f, 5.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    expectNear(camera.GetViewProjectionMatrix(), expected);
+}
+
+TEST(Camera, FrustumCullsSpheres)
+{
+    Camera camera(Camera_Type::FREE_CAMERA);
+    camera.setViewport(100, 100);
+    const Frustum &frustum = camera.GetFrustum();
+
+    EXPECT_TRUE(frustum.intersectsSphere(glm::vec3(0.0f, 0.0f, -10.0f), 1.0f));
+    // behind the camera, beyond the far plane, far off to the side
+    EXPECT_FALSE(frustum.intersectsSphere(glm::vec3(0.0f, 0.0f, 10.0f), 1.0f));
+    EXPECT_FALSE(frustum.intersectsSphere(glm::vec3(0.0f, 0.0f, -FAR_PLANE - 10.0f), 1.0f));
+    EXPECT_FALSE(frustum.intersectsSphere(glm::vec3(50.0f, 0.0f, -10.0f), 1.0f));
+    // straddling the near plane
+    EXPECT_TRUE(frustum.intersectsSphere(glm::vec3(0.0f), 0.5f));
+}
+
+TEST(Camera, ThirdPersonOrbitsTarget)
+{
+    Camera camera(Camera_Type::THIRD_PERSON, glm::vec3(1.0f, 0.0f, 0.0f));
+    camera.setOrientation(0.0f, -30.0f);
+    glm::vec3 eye = camera.getEyePosition();
+    EXPECT_NEAR(glm::distance(eye, camera.getPosition()), FOLLOW_DISTANCE, 1e-4f);
+    // looking down at the target from behind and above
+    EXPECT_GT(eye.y, 0.0f);
+    EXPECT_LT(eye.x, 1.0f);
+    glm::vec4 target = camera.GetViewMatrix() * glm::vec4(camera.getPosition(), 1.0f);
+    EXPECT_NEAR(target.x, 0.0f, 1e-4f);
+    EXPECT_NEAR(target.y, 0.0f, 1e-4f);
+    EXPECT_NEAR(target.z, -FOLLOW_DISTANCE, 1e-4f);
+}
+
+TEST(Camera, WalkingStaysOnTheGround)
+{
+    Camera camera(Camera_Type::FIRST_PERSON);
+    camera.setOrientation(-90.0f, 60.0f);
+    camera.addMotion(glm::vec3(0.0f, 1.0f, -1.0f));
+    glm::vec3 position = camera.integrate(glm::vec3(0.0f), 1.0f);
+    EXPECT_FLOAT_EQ(position.y, 0.0f);
+    EXPECT_NEAR(position.z, -SPEED, 1e-5f);
+}
+
+TEST(Camera, ReversedZMapsNearToOneAndInfinityToZero)
+{
+    Camera camera(Camera_Type::FREE_CAMERA);
+    camera.setViewport(100, 100);
+    camera.setReversedZ(true);
+    const glm::mat4 &projection = camera.GetProjectionMatrix();
+
+    auto depth = [&](float distance)
+    {
+        glm::vec4 clip = projection * glm::vec4(0.0f, 0.0f, -distance, 1.0f);
+        return clip.z / clip.w;
+    };
+    EXPECT_NEAR(depth(NEAR_PLANE), 1.0f, 1e-6f);
+    EXPECT_GT(depth(1000.0f), 0.0f);
+    EXPECT_GT(depth(1000.0f), depth(1001.0f));
+    EXPECT_LT(depth(1e6f), 1e-6f);
+
+    // nothing is culled for being far away
+    const Frustum &frustum = camera.GetFrustum();
+    EXPECT_TRUE(frustum.intersectsSphere(glm::vec3(0.0f, 0.0f, -1e5f), 1.0f));
+    EXPECT_FALSE(frustum.intersectsSphere(glm::vec3(0.0f, 0.0f, 10.0f), 1.0f));
+    EXPECT_FALSE(frustum.intersectsSphere(glm::vec3(0.0f, 0.0f, -0.01f), 0.001f));
+}
@@ -0,0 +1,71 @@
+#include <gtest/gtest.h>
+
+#include <thread>
+
+#include "Simulation.h"
+
+TEST(FixedTimestep, AccumulatesPartialSteps)
+{
+    FixedTimestep timestep(0.01, 8);
+
+    EXPECT_EQ(timestep.advance(0.004), 0);
+    EXPECT_NEAR(timestep.getAlpha(), 0.4, 1e-9);
+    EXPECT_EQ(timestep.advance(0.007), 1);
+    EXPECT_NEAR(timestep.getAlpha(), 0.1, 1e-9);
+    EXPECT_EQ(timestep.advance(0.025), 2);
+    EXPECT_NEAR(timestep.getAlpha(), 0.6, 1e-9);
+}
+
+TEST(FixedTimestep, CapsCatchUpSteps)
+{
+    FixedTimestep timestep(0.01, 4);
+
+    // a one second hitch only runs the allowed steps and drops the rest
+    EXPECT_EQ(timestep.advance(1.0), 4);
+    EXPECT_NEAR(timestep.getDroppedTime(), 0.96, 1e-9);
+    EXPECT_LT(timestep.getAlpha(), 1.0);
+    EXPECT_EQ(timestep.advance(0.0), 0);
+}
+
+TEST(FixedTimestep, IgnoresNegativeTime)
+{
+    FixedTimestep timestep(0.01, 4);
+    EXPECT_EQ(timestep.advance(-1.0), 0);
+    EXPECT_EQ(timestep.getAlpha(), 0.0);
+}
+
+TEST(Simulation, InterpolatesBetweenStates)
+{
+    SimulationState previous, current;
+    previous.cameraPosition = glm::vec3(0.0f, 0.0f, 0.0f);
+    current.cameraPosition = glm::vec3(2.0f, 4.0f, -2.0f);
+    previous.time = 1.0;
+    current.time = 1.5;
+
+    SimulationState state = interpolate(previous, current, 0.25);
+    EXPECT_FLOAT_EQ(state.cameraPosition.x, 0.5f);
+    EXPECT_FLOAT_EQ(state.cameraPosition.y, 1.0f);
+    EXPECT_FLOAT_EQ(state.cameraPosition.z, -0.5f);
+    EXPECT_DOUBLE_EQ(state.time, 1.125);
+}
+
+TEST(SimulationThread, PublishesFixedSteps)
+{
+    SimulationSettings settings;
+    settings.step = 0.002;
+    settings.threaded = true;
+
+    SimulationThread thread;
+    thread.start(SimulationState(), settings, [](SimulationState &state, double step)
+    {
+        state.cameraPosition.x += (float) step;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    SimulationState state = thread.read();
+    thread.stop();
+
+    EXPECT_FALSE(thread.isRunning());
+    EXPECT_GT(state.step, 0u);
+    // every step moved by exactly one step length, the render state lags at most one step
+    EXPECT_NEAR(state.cameraPosition.x, state.step * settings.step, settings.step + 1e-6);
+}
@@ -0,0 +1,266 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "GltfLoader.h"
+
+namespace
+{
+    // a GLB container around json and bin, both padded to 4 bytes as the format wants
+    std::vector<char> makeGlb(std::string json, std::vector<char> bin)
+    {
+        json.resize((json.size() + 3) & ~(size_t) 3, ' ');
+        bin.resize((bin.size() + 3) & ~(size_t) 3, 0);
+        std::vector<char> glb;
+        auto put = [&glb](uint32_t value)
+        {
+            glb.insert(glb.end(), (const char *) &value, (const char *) &value + 4);
+        };
+        put(0x46546C67);
+        put(2);
+        put((uint32_t) (12 + 8 + json.size() + (bin.empty() ? 0 : 8 + bin.size())));
+        put((uint32_t) json.size());
+        put(0x4E4F534A);
+        glb.insert(glb.end(), json.begin(), json.end());
+        if (!bin.empty())
+        {
+            put((uint32_t) bin.size());
+            put(0x004E4942);
+            glb.insert(glb.end(), bin.begin(), bin.end());
+        }
+        return glb;
+    }
+
+    template<typename T>
+    void append(std::vector<char> &bin, const std::vector<T> &values)
+    {
+        bin.insert(bin.end(), (const char *) values.data(), (const char *) (values.data() + values.size()));
+    }
+
+    bool parse(const std::vector<char> &glb, GltfModel &model)
+    {
+        return GltfLoader::parseGlb(glb.data(), glb.size(), model);
+    }
+
+    // one triangle as position, normal, texcoord interleaved (32 byte stride) at offset 0,
+    // then three 16 bit indices at offset 96
+    std::vector<char> triangleBuffer()
+    {
+        std::vector<char> bin;
+        append(bin, std::vector<float>{0, 0, 0, 0, 0, 1, 0, 0,
+                                       1, 0, 0, 0, 0, 1, 1, 0,
+                                       0, 2, 0, 0, 0, 1, 0, 1});
+        append(bin, std::vector<uint16_t>{0, 1, 2, 0});
+        return bin;
+    }
+
+    std::string accessor(int view, int offset, int count, const char *type, int componentType = GL_FLOAT)
+    {
+        return "{\"bufferView\": " + std::to_string(view) + ", \"byteOffset\": " + std::to_string(offset) +
+               ", \"componentType\": " + std::to_string(componentType) + ", \"count\": " + std::to_string(count) +
+               ", \"type\": \"" + type + "\"}";
+    }
+
+    // views and accessors 0-3 (position, normal, texcoord, indices) of triangleBuffer(),
+    // vertexCount and indexAccessor replace the valid ones
+    std::string triangleAccessors(int vertexCount = 3, const std::string &indexAccessor = "", size_t byteLength = 104,
+                                  const std::string &extraViews = "")
+    {
+        return "\"buffers\": [{\"byteLength\": " + std::to_string(byteLength) + "}],"
+               "\"bufferViews\": [{\"buffer\": 0, \"byteLength\": 96, \"byteStride\": 32},"
+               "                  {\"buffer\": 0, \"byteOffset\": 96, \"byteLength\": 6}" + extraViews + "],"
+               "\"accessors\": [" + accessor(0, 0, vertexCount, "VEC3") + "," +
+                                 accessor(0, 12, vertexCount, "VEC3") + "," +
+                                 accessor(0, 24, vertexCount, "VEC2") + "," +
+                                 (indexAccessor.empty() ? accessor(1, 0, 3, "SCALAR", GL_UNSIGNED_SHORT) : indexAccessor) + "],";
+    }
+
+    const std::string TRIANGLE_MESH =
+        "\"meshes\": [{\"primitives\": [{\"attributes\": {\"POSITION\": 0, \"NORMAL\": 1, \"TEXCOORD_0\": 2}, \"indices\": 3}]}]";
+
+    std::string document(const std::string &body)
+    {
+        return "{\"asset\": {\"version\": \"2.0\"}," + body + "}";
+    }
+}
+
+TEST(GltfLoader, InterleavedAttributesAreUsedInPlace)
+{
+    std::vector<char> glb = makeGlb(document(triangleAccessors() + TRIANGLE_MESH + ", \"nodes\": [{\"mesh\": 0}]"), triangleBuffer());
+    GltfModel model;
+    ASSERT_TRUE(parse(glb, model));
+    ASSERT_EQ(model.primitives.size(), 1u);
+
+    const MeshBufferLayout &layout = model.primitives[0].layout;
+    EXPECT_EQ(layout.vertexCount, 3);
+    const GLintptr offsets[3] = {0, 12, 24};
+    const GLint sizes[3] = {3, 3, 2};
+    for (int i = 0; i < 3; i++)
+    {
+        EXPECT_EQ(layout.attributes[i].size, sizes[i]);
+        EXPECT_EQ(layout.attributes[i].type, (GLenum) GL_FLOAT);
+        EXPECT_EQ(layout.attributes[i].stride, 32);
+        EXPECT_EQ(layout.attributes[i].offset, offsets[i]);
+    }
+    EXPECT_EQ(layout.indexType, (GLenum) GL_UNSIGNED_SHORT);
+    EXPECT_EQ(layout.indexCount, 3);
+    EXPECT_EQ(layout.indexOffset, 96);
+    EXPECT_EQ(model.primitives[0].material, -1);
+
+    // the whole buffer is geometry, and it is not copied
+    EXPECT_EQ(model.vertexDataSize, 102u);
+    float position[3];
+    memcpy(position, model.vertexData + layout.attributes[0].offset + 32, sizeof(position));
+    EXPECT_EQ(position[0], 1.0f);
+    EXPECT_EQ(model.min, glm::vec3(0.0f));
+    EXPECT_EQ(model.max, glm::vec3(1.0f, 2.0f, 0.0f));
+}
+
+TEST(GltfLoader, SeparateAttributeArraysWithByteIndices)
+{
+    // a 64 byte image first, which is not part of the uploaded range
+    std::vector<char> bin(64, 'x');
+    append(bin, std::vector<float>{0, 0, 0, 1, 0, 0, 0, 1, 0});
+    append(bin, std::vector<uint16_t>{0, 0, 65535, 0, 0, 65535});
+    append(bin, std::vector<uint8_t>{2, 1, 0});
+    std::string json = document(
+        "\"buffers\": [{\"byteLength\": 115}],"
+        "\"bufferViews\": [{\"buffer\": 0, \"byteLength\": 64},"
+        "                  {\"buffer\": 0, \"byteOffset\": 64, \"byteLength\": 36},"
+        "                  {\"buffer\": 0, \"byteOffset\": 100, \"byteLength\": 12},"
+        "                  {\"buffer\": 0, \"byteOffset\": 112, \"byteLength\": 3}],"
+        "\"accessors\": [{\"bufferView\": 1, \"componentType\": 5126, \"count\": 3, \"type\": \"VEC3\"},"
+        "                {\"bufferView\": 2, \"componentType\": 5123, \"normalized\": true, \"count\": 3, \"type\": \"VEC2\"},"
+        "                {\"bufferView\": 3, \"componentType\": 5121, \"count\": 3, \"type\": \"SCALAR\"}],"
+        "\"meshes\": [{\"primitives\": [{\"attributes\": {\"POSITION\": 0, \"TEXCOORD_0\": 1}, \"indices\": 2}]}],"
+        "\"nodes\": [{\"mesh\": 0}]");
+    GltfModel model;
+    ASSERT_TRUE(parse(makeGlb(json, bin), model));
+    ASSERT_EQ(model.primitives.size(), 1u);
+
+    const MeshBufferLayout &layout = model.primitives[0].layout;
+    EXPECT_EQ(layout.attributes[0].offset, 0);
+    EXPECT_EQ(layout.attributes[0].stride, 12);
+    // no normals
+    EXPECT_EQ(layout.attributes[1].size, 0);
+    EXPECT_EQ(layout.attributes[2].type, (GLenum) GL_UNSIGNED_SHORT);
+    EXPECT_TRUE(layout.attributes[2].normalized);
+    EXPECT_EQ(layout.attributes[2].offset, 36);
+    EXPECT_EQ(layout.indexType, (GLenum) GL_UNSIGNED_BYTE);
+    EXPECT_EQ(layout.indexOffset, 48);
+    EXPECT_EQ(model.vertexDataSize, 51u);
+    // bounds without min and max come from the positions
+    EXPECT_EQ(model.max, glm::vec3(1.0f, 1.0f, 0.0f));
+}
+
+TEST(GltfLoader, NodeHierarchyPlacesMeshes)
+{
+    // parent moved by (1, 0, 0), one child scaled by 2 and one given as a matrix
+    // moving it by (0, 0, 3); a mesh used by two nodes is loaded for both
+    std::string json = document(triangleAccessors() + TRIANGLE_MESH + ","
+        "\"scene\": 0, \"scenes\": [{\"nodes\": [0]}],"
+        "\"nodes\": [{\"translation\": [1, 0, 0], \"children\": [1, 2]},"
+        "            {\"mesh\": 0, \"scale\": [2, 2, 2]},"
+        "            {\"mesh\": 0, \"matrix\": [1,0,0,0, 0,1,0,0, 0,0,1,0, 0,0,3,1]},"
+        "            {\"mesh\": 0, \"translation\": [100, 0, 0]}]");
+    GltfModel model;
+    ASSERT_TRUE(parse(makeGlb(json, triangleBuffer()), model));
+    // node 3 is not in the scene
+    ASSERT_EQ(model.primitives.size(), 2u);
+
+    glm::vec4 corner(1.0f, 2.0f, 0.0f, 1.0f);
+    EXPECT_EQ(model.primitives[0].transform * corner, glm::vec4(3.0f, 4.0f, 0.0f, 1.0f));
+    glm::vec4 moved = model.primitives[1].transform * corner;
+    EXPECT_NEAR(moved.x, 2.0f, 1e-6f);
+    EXPECT_NEAR(moved.z, 3.0f, 1e-6f);
+    EXPECT_EQ(model.min, glm::vec3(1.0f, 0.0f, 0.0f));
+    EXPECT_EQ(model.max, glm::vec3(3.0f, 4.0f, 3.0f));
+}
+
+TEST(GltfLoader, MaterialsMapOntoPhongTerms)
+{
+    std::vector<char> bin = triangleBuffer();
+    // stands in for a PNG, only decoded by Model
+    append(bin, std::vector<char>{'p', 'n', 'g', '!'});
+    std::string json = document(triangleAccessors(3, "", 108, ", {\"buffer\": 0, \"byteOffset\": 104, \"byteLength\": 4}") +
+        "\"meshes\": [{\"primitives\": [{\"attributes\": {\"POSITION\": 0}, \"indices\": 3, \"material\": 1}]}],"
+        "\"nodes\": [{\"mesh\": 0}],"
+        "\"images\": [{\"uri\": \"wall.png\"}, {\"bufferView\": 2, \"mimeType\": \"image/png\"}],"
+        "\"textures\": [{\"source\": 1}, {\"source\": 0}],"
+        "\"materials\": [{\"name\": \"plain\"},"
+        "                {\"name\": \"shiny\", \"emissiveFactor\": [0.5, 0, 0],"
+        "                 \"pbrMetallicRoughness\": {\"baseColorFactor\": [1, 0.5, 0.25, 1], \"baseColorTexture\": {\"index\": 0},"
+        "                                            \"metallicFactor\": 0, \"roughnessFactor\": 0.5},"
+        "                 \"emissiveTexture\": {\"index\": 1}}]");
+    GltfModel model;
+    ASSERT_TRUE(parse(makeGlb(json, bin), model));
+    ASSERT_EQ(model.primitives.size(), 1u);
+    EXPECT_EQ(model.primitives[0].material, 1);
+
+    ASSERT_EQ(model.images.size(), 2u);
+    EXPECT_EQ(model.images[0].name, "wall.png");
+    EXPECT_EQ(model.images[0].data, nullptr);
+    EXPECT_EQ(model.images[1].size, 4u);
+    EXPECT_EQ(memcmp(model.images[1].data, "png!", 4), 0);
+    // images are not part of the geometry
+    EXPECT_EQ(model.vertexDataSize, 102u);
+
+    ASSERT_EQ(model.materials.size(), 2u);
+    const tinyobj::material_t &plain = model.materials[0];
+    EXPECT_TRUE(plain.diffuse_texname.empty());
+    EXPECT_EQ(plain.shininess, 1.0f);
+    const tinyobj::material_t &shiny = model.materials[1];
+    EXPECT_EQ(shiny.name, "shiny");
+    EXPECT_EQ(shiny.diffuse_texname, model.images[1].name);
+    EXPECT_EQ(shiny.emissive_texname, "wall.png");
+    EXPECT_EQ(shiny.diffuse[1], 0.5f);
+    EXPECT_EQ(shiny.emission[0], 0.5f);
+    EXPECT_NEAR(shiny.specular[0], 0.04f, 1e-6f);
+    // 2 / 0.25^2 - 2
+    EXPECT_EQ(shiny.shininess, 30.0f);
+}
+
+TEST(GltfLoader, RejectsInvalidFiles)
+{
+    auto withAccessors = [](const std::string &accessors)
+    {
+        return makeGlb(document(accessors + TRIANGLE_MESH + ", \"nodes\": [{\"mesh\": 0}]"), triangleBuffer());
+    };
+
+    GltfModel valid;
+    ASSERT_TRUE(parse(withAccessors(triangleAccessors()), valid));
+
+    std::string misaligned = triangleAccessors();
+    misaligned.replace(misaligned.find("\"byteOffset\": 0"), 15, "\"byteOffset\": 2");
+    std::vector<std::vector<char>> invalid = {
+        // past the end of the buffer view
+        withAccessors(triangleAccessors(3, accessor(1, 0, 4, "SCALAR", GL_UNSIGNED_SHORT))),
+        // an index past the vertices
+        withAccessors(triangleAccessors(2)),
+        // float indices
+        withAccessors(triangleAccessors(3, accessor(1, 0, 1, "SCALAR", GL_FLOAT))),
+        // buffer shorter than the views
+        withAccessors(triangleAccessors(3, "", 200)),
+        withAccessors(misaligned),
+        makeGlb("{\"asset\": {\"version\": \"1.0\"}}", {}),
+        makeGlb("{\"asset\": ", {}),
+    };
+    for (size_t i = 0; i < invalid.size(); i++)
+    {
+        GltfModel model;
+        EXPECT_FALSE(parse(invalid[i], model)) << i;
+    }
+
+    // a node that is its own child
+    GltfModel cyclic;
+    EXPECT_FALSE(parse(makeGlb(document(triangleAccessors() + TRIANGLE_MESH +
+                                        ", \"scenes\": [{\"nodes\": [0]}], \"nodes\": [{\"children\": [0]}]"),
+                               triangleBuffer()), cyclic));
+
+    std::vector<char> glb = withAccessors(triangleAccessors());
+    glb[0] = 'x';
+    GltfModel notGlb;
+    EXPECT_FALSE(parse(glb, notGlb));
+}
@@ -0,0 +1,62 @@
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "Json.h"
+
+namespace
+{
+    bool parse(const std::string &text, Json::Value &value)
+    {
+        std::string error;
+        return Json::parse(text.data(), text.size(), value, error);
+    }
+}
+
+TEST(Json, ParsesNestedDocuments)
+{
+    Json::Value value;
+    ASSERT_TRUE(parse(" {\"a\": [1, -2.5e1, true, null], \"b\": {\"c\": \"d\"}, \"e\": false}\n", value));
+    ASSERT_TRUE(value.isObject());
+    EXPECT_EQ(value.getKeys(), (std::vector<std::string>{"a", "b", "e"}));
+    EXPECT_EQ(value["a"].size(), 4u);
+    EXPECT_EQ(value["a"][0].getNumber(), 1.0);
+    EXPECT_EQ(value["a"][1].getNumber(), -25.0);
+    EXPECT_TRUE(value["a"][2].getBool());
+    EXPECT_TRUE(value["a"][3].isNull());
+    EXPECT_EQ(value["b"]["c"].getString(), "d");
+    EXPECT_FALSE(value["e"].getBool(true));
+}
+
+TEST(Json, MissingMembersAreNull)
+{
+    Json::Value value;
+    ASSERT_TRUE(parse("{\"a\": [1]}", value));
+    EXPECT_FALSE(value.has("b"));
+    EXPECT_TRUE(value["b"]["c"][3].isNull());
+    EXPECT_EQ(value["a"][5].getNumber(7.0), 7.0);
+    EXPECT_EQ(value["a"]["x"].getString(), "");
+}
+
+TEST(Json, DecodesEscapes)
+{
+    Json::Value value;
+    ASSERT_TRUE(parse("\"a\\\"b\\\\c\\/\\n\\u00e9\\ud83d\\ude00\"", value));
+    EXPECT_EQ(value.getString(), "a\"b\\c/\n\xc3\xa9\xf0\x9f\x98\x80");
+}
+
+TEST(Json, RejectsInvalidText)
+{
+    const char *invalid[] = {"", "{", "[1,]", "{\"a\" 1}", "\"open", "tru", "1 2", "-", "\"\\x\"", "\"\\ud83d\""};
+    for (const char *text : invalid)
+    {
+        Json::Value value;
+        std::string error;
+        EXPECT_FALSE(Json::parse(text, strlen(text), value, error)) << text;
+        EXPECT_FALSE(error.empty()) << text;
+    }
+
+    // deep nesting fails instead of overflowing the stack
+    Json::Value value;
+    EXPECT_FALSE(parse(std::string(100000, '['), value));
+}
@@ -0,0 +1,207 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "MeshSimplifier.h"
+
+namespace
+{
+    struct TestMesh
+    {
+        std::vector<Vertex> vertices;
+        std::vector<uint32_t> indices;
+    };
+
+    // n x n quads in the z = 0 plane, (n + 1)^2 shared vertices
+    TestMesh grid(int n)
+    {
+        TestMesh mesh;
+        for (int y = 0; y <= n; y++)
+        {
+            for (int x = 0; x <= n; x++)
+            {
+                Vertex vertex = {};
+                vertex.Position = glm::vec3((float) x / n, (float) y / n, 0.0f);
+                vertex.Normal = glm::vec3(0.0f, 0.0f, 1.0f);
+                vertex.TexCoord = glm::vec2(vertex.Position);
+                mesh.vertices.push_back(vertex);
+            }
+        }
+        for (int y = 0; y < n; y++)
+        {
+            for (int x = 0; x < n; x++)
+            {
+                uint32_t a = y * (n + 1) + x, b = a + 1, c = a + n + 1, d = c + 1;
+                mesh.indices.insert(mesh.indices.end(), {a, b, d, a, d, c});
+            }
+        }
+        return mesh;
+    }
+
+    // closed unit sphere without seams: rings of vertices plus the two poles
+    TestMesh sphere(int rings, int segments)
+    {
+        TestMesh mesh;
+        auto add = [&](glm::vec3 p)
+        {
+            Vertex vertex = {};
+            vertex.Position = p;
+            vertex.Normal = p;
+            mesh.vertices.push_back(vertex);
+        };
+        add(glm::vec3(0, 0, 1));
+        for (int r = 1; r < rings; r++)
+        {
+            float theta = glm::pi<float>() * r / rings;
+            for (int s = 0; s < segments; s++)
+            {
+                float phi = 2.0f * glm::pi<float>() * s / segments;
+                add(glm::vec3(std::sin(theta) * std::cos(phi), std::sin(theta) * std::sin(phi), std::cos(theta)));
+            }
+        }
+        add(glm::vec3(0, 0, -1));
+        uint32_t south = (uint32_t) mesh.vertices.size() - 1;
+        auto ring = [&](int r, int s) { return (uint32_t)(1 + (r - 1) * segments + (s % segments)); };
+        for (int s = 0; s < segments; s++)
+        {
+            mesh.indices.insert(mesh.indices.end(), {0, ring(1, s), ring(1, s + 1)});
+            mesh.indices.insert(mesh.indices.end(), {south, ring(rings - 1, s + 1), ring(rings - 1, s)});
+            for (int r = 1; r < rings - 1; r++)
+            {
+                mesh.indices.insert(mesh.indices.end(), {ring(r, s), ring(r + 1, s), ring(r + 1, s + 1)});
+                mesh.indices.insert(mesh.indices.end(), {ring(r, s), ring(r + 1, s + 1), ring(r, s + 1)});
+            }
+        }
+        return mesh;
+    }
+
+    float area(const std::vector<Vertex> &vertices, const std::vector<uint32_t> &indices)
+    {
+        float total = 0.0f;
+        for (size_t t = 0; t < indices.size(); t += 3)
+        {
+            glm::vec3 p0 = vertices[indices[t]].Position;
+            total += 0.5f * glm::length(glm::cross(vertices[indices[t + 1]].Position - p0, vertices[indices[t + 2]].Position - p0));
+        }
+        return total;
+    }
+
+    // every edge of a closed mesh has a triangle on both sides
+    bool isClosed(const std::vector<uint32_t> &indices)
+    {
+        std::vector<std::pair<uint32_t, uint32_t>> edges;
+        for (size_t t = 0; t < indices.size(); t += 3)
+        {
+            for (int e = 0; e < 3; e++)
+            {
+                edges.push_back({indices[t + e], indices[t + (e + 1) % 3]});
+            }
+        }
+        std::sort(edges.begin(), edges.end());
+        for (const auto &edge : edges)
+        {
+            if (!std::binary_search(edges.begin(), edges.end(), std::make_pair(edge.second, edge.first)))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+TEST(MeshSimplifier, FlatGridCollapsesWithoutError)
+{
+    TestMesh mesh = grid(16);
+    // texture coordinates change across the grid, only the geometry is measured here
+    MeshSimplifier::Options options;
+    options.attributeWeight = 0.0f;
+    float error;
+    std::vector<uint32_t> simplified = MeshSimplifier::simplify(mesh.vertices, mesh.indices, mesh.indices.size() / 4, options, error);
+
+    EXPECT_LE(simplified.size(), mesh.indices.size() / 4);
+    EXPECT_EQ(simplified.size() % 3, 0u);
+    EXPECT_LT(error, 1e-4f);
+    // the locked border keeps the outline, so the area stays the same
+    EXPECT_NEAR(area(mesh.vertices, simplified), 1.0f, 1e-4f);
+    for (uint32_t v = 0; v <= 16; v++)
+    {
+        EXPECT_NE(std::find(simplified.begin(), simplified.end(), v), simplified.end()) << v;
+    }
+}
+
+TEST(MeshSimplifier, SphereStaysClosedWithinError)
+{
+    TestMesh mesh = sphere(24, 48);
+    ASSERT_TRUE(isClosed(mesh.indices));
+
+    MeshSimplifier::Options options;
+    float error;
+    std::vector<uint32_t> simplified = MeshSimplifier::simplify(mesh.vertices, mesh.indices, mesh.indices.size() / 2, options, error);
+
+    EXPECT_LE(simplified.size(), mesh.indices.size() / 2);
+    EXPECT_TRUE(isClosed(simplified));
+    EXPECT_GT(error, 0.0f);
+    // the sphere's extent is 2
+    EXPECT_LE(error, 2.0f * options.maxError);
+    // every kept vertex is on the sphere, what moves is the surface between them
+    float fullArea = area(mesh.vertices, mesh.indices);
+    EXPECT_NEAR(area(mesh.vertices, simplified), fullArea, 0.05f * fullArea);
+}
+
+TEST(MeshSimplifier, ErrorLimitStopsCollapses)
+{
+    TestMesh mesh = sphere(24, 48);
+    MeshSimplifier::Options options;
+    options.maxError = 0.0f;
+    float error;
+    std::vector<uint32_t> simplified = MeshSimplifier::simplify(mesh.vertices, mesh.indices, 0, options, error);
+    EXPECT_EQ(simplified, mesh.indices);
+    EXPECT_EQ(error, 0.0f);
+}
+
+TEST(MeshSimplifier, SeamVerticesStay)
+{
+    // split the grid's middle column like a texture seam: the right half gets its own copies
+    const int n = 8;
+    TestMesh mesh = grid(n);
+    std::vector<uint32_t> seam;
+    for (int y = 0; y <= n; y++)
+    {
+        uint32_t original = y * (n + 1) + n / 2;
+        Vertex copy = mesh.vertices[original];
+        copy.TexCoord.x += 0.5f;
+        seam.push_back(original);
+        seam.push_back((uint32_t) mesh.vertices.size());
+        mesh.vertices.push_back(copy);
+    }
+    for (size_t t = 0; t < mesh.indices.size(); t += 3)
+    {
+        bool right = false;
+        for (int c = 0; c < 3; c++)
+        {
+            right |= mesh.vertices[mesh.indices[t + c]].Position.x > 0.5f;
+        }
+        for (int c = 0; c < 3 && right; c++)
+        {
+            uint32_t &index = mesh.indices[t + c];
+            if (index % (n + 1) == n / 2 && index < (uint32_t)((n + 1) * (n + 1)))
+            {
+                index = (uint32_t)((n + 1) * (n + 1) + index / (n + 1));
+            }
+        }
+    }
+
+    MeshSimplifier::Options options;
+    options.lockBorders = false;
+    float error;
+    std::vector<uint32_t> simplified = MeshSimplifier::simplify(mesh.vertices, mesh.indices, 0, options, error);
+    EXPECT_LT(simplified.size(), mesh.indices.size() / 2);
+    for (uint32_t v : seam)
+    {
+        EXPECT_NE(std::find(simplified.begin(), simplified.end(), v), simplified.end()) << v;
+    }
+    // unlocked borders slide along the outline but do not shrink it
+    EXPECT_NEAR(area(mesh.vertices, simplified), 1.0f, 1e-4f);
+}
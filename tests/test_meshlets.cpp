@@ -0,0 +1,175 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <vector>
+
+#include "Mesh.h"
+#include "Meshlets.h"
+#include "glm/gtc/matrix_transform.hpp"
+
+namespace
+{
+    struct TestMesh
+    {
+        std::vector<Vertex> vertices;
+        std::vector<uint32_t> indices;
+    };
+
+    // closed unit sphere, counter-clockwise seen from outside
+    TestMesh sphere(int rings, int segments)
+    {
+        TestMesh mesh;
+        auto add = [&](glm::vec3 p)
+        {
+            Vertex vertex = {};
+            vertex.Position = p;
+            vertex.Normal = p;
+            mesh.vertices.push_back(vertex);
+        };
+        add(glm::vec3(0, 0, 1));
+        for (int r = 1; r < rings; r++)
+        {
+            float theta = glm::pi<float>() * r / rings;
+            for (int s = 0; s < segments; s++)
+            {
+                float phi = 2.0f * glm::pi<float>() * s / segments;
+                add(glm::vec3(std::sin(theta) * std::cos(phi), std::sin(theta) * std::sin(phi), std::cos(theta)));
+            }
+        }
+        add(glm::vec3(0, 0, -1));
+        uint32_t south = (uint32_t) mesh.vertices.size() - 1;
+        auto ring = [&](int r, int s) { return (uint32_t)(1 + (r - 1) * segments + (s % segments)); };
+        for (int s = 0; s < segments; s++)
+        {
+            mesh.indices.insert(mesh.indices.end(), {0, ring(1, s), ring(1, s + 1)});
+            mesh.indices.insert(mesh.indices.end(), {south, ring(rings - 1, s + 1), ring(rings - 1, s)});
+            for (int r = 1; r < rings - 1; r++)
+            {
+                mesh.indices.insert(mesh.indices.end(), {ring(r, s), ring(r + 1, s), ring(r + 1, s + 1)});
+                mesh.indices.insert(mesh.indices.end(), {ring(r, s), ring(r + 1, s + 1), ring(r, s + 1)});
+            }
+        }
+        return mesh;
+    }
+
+    // triangles rotated to start at their smallest index, sorted, to compare meshes up to order
+    std::vector<std::array<uint32_t, 3>> triangles(const std::vector<uint32_t> &indices)
+    {
+        std::vector<std::array<uint32_t, 3>> result;
+        for (size_t t = 0; t < indices.size(); t += 3)
+        {
+            std::array<uint32_t, 3> triangle = {indices[t], indices[t + 1], indices[t + 2]};
+            std::rotate(triangle.begin(), std::min_element(triangle.begin(), triangle.end()), triangle.end());
+            result.push_back(triangle);
+        }
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+
+    bool facesCamera(const TestMesh &mesh, const uint32_t *triangle, glm::vec3 camera)
+    {
+        glm::vec3 p0 = mesh.vertices[triangle[0]].Position;
+        glm::vec3 normal = glm::cross(mesh.vertices[triangle[1]].Position - p0, mesh.vertices[triangle[2]].Position - p0);
+        return glm::dot(camera - p0, normal) > 0.0f;
+    }
+}
+
+TEST(Meshlets, CoverEveryTriangleWithinLimits)
+{
+    TestMesh mesh = sphere(32, 64);
+    std::vector<uint32_t> indices = mesh.indices;
+    std::vector<Meshlets::Meshlet> meshlets = Meshlets::build(mesh.vertices, indices.data(), indices.size());
+
+    EXPECT_EQ(triangles(indices), triangles(mesh.indices));
+    uint32_t next = 0;
+    for (const Meshlets::Meshlet &meshlet : meshlets)
+    {
+        EXPECT_EQ(meshlet.firstTriangle, next);
+        next += meshlet.triangleCount;
+        EXPECT_GT(meshlet.triangleCount, 0u);
+        EXPECT_LE(meshlet.triangleCount, Meshlets::MAX_TRIANGLES);
+        EXPECT_LE(meshlet.vertexCount, Meshlets::MAX_VERTICES);
+
+        std::vector<uint32_t> used(indices.begin() + 3 * meshlet.firstTriangle,
+                                   indices.begin() + 3 * (meshlet.firstTriangle + meshlet.triangleCount));
+        std::sort(used.begin(), used.end());
+        EXPECT_EQ((size_t)(std::unique(used.begin(), used.end()) - used.begin()), meshlet.vertexCount);
+        for (uint32_t v : used)
+        {
+            EXPECT_LE(glm::length(mesh.vertices[v].Position - meshlet.center), meshlet.radius * 1.0001f);
+        }
+    }
+    EXPECT_EQ(next * 3, indices.size());
+    // compact meshlets fill up instead of leaving scraps behind
+    EXPECT_GT(indices.size() / 3 / meshlets.size(), Meshlets::MAX_TRIANGLES / 2);
+}
+
+TEST(Meshlets, BackFaceCullingIsConservative)
+{
+    TestMesh mesh = sphere(32, 64);
+    std::vector<uint32_t> indices = mesh.indices;
+    std::vector<Meshlets::Meshlet> meshlets = Meshlets::build(mesh.vertices, indices.data(), indices.size());
+
+    for (glm::vec3 camera : {glm::vec3(0, 0, 5), glm::vec3(3, -2, 1), glm::vec3(0, 1.5f, 0)})
+    {
+        size_t culled = 0;
+        for (const Meshlets::Meshlet &meshlet : meshlets)
+        {
+            if (!Meshlets::isBackFacing(meshlet, camera))
+            {
+                continue;
+            }
+            culled++;
+            for (uint32_t t = 0; t < meshlet.triangleCount; t++)
+            {
+                EXPECT_FALSE(facesCamera(mesh, &indices[3 * (meshlet.firstTriangle + t)], camera));
+            }
+        }
+        // the far side of a sphere faces away from any outside camera
+        EXPECT_GT(culled, meshlets.size() / 5) << camera.x << " " << camera.y << " " << camera.z;
+    }
+}
+
+TEST(Meshlets, CullLeavesRangesOfVisibleTriangles)
+{
+    TestMesh mesh = sphere(32, 64);
+    std::vector<uint32_t> indices = mesh.indices;
+    std::vector<Meshlets::Meshlet> meshlets = Meshlets::build(mesh.vertices, indices.data(), indices.size());
+    glm::mat4 projection = glm::perspective(glm::radians(90.0f), 1.0f, 0.01f, 100.0f);
+    const glm::vec3 camera(0, 0, 10);
+
+    // looking away from the sphere leaves nothing
+    std::vector<DrawElementsIndirectCommand> commands;
+    Frustum away = Frustum::fromMatrix(projection * glm::lookAt(camera, glm::vec3(0, 0, 20), glm::vec3(0, 1, 0)));
+    EXPECT_EQ(Meshlets::cull(meshlets, away, camera, 0, commands), 0u);
+    EXPECT_TRUE(commands.empty());
+
+    // looking at it, only the near side is drawn, in ranges of the index buffer
+    Frustum at = Frustum::fromMatrix(projection * glm::lookAt(camera, glm::vec3(0), glm::vec3(0, 1, 0)));
+    size_t drawn = Meshlets::cull(meshlets, at, camera, 7, commands);
+    EXPECT_LT(drawn, indices.size() / 3 * 3 / 4);
+    std::vector<char> covered(indices.size() / 3, 0);
+    size_t total = 0;
+    for (const DrawElementsIndirectCommand &command : commands)
+    {
+        EXPECT_EQ(command.count % 3, 0u);
+        EXPECT_EQ(command.firstIndex % 3, 0u);
+        EXPECT_LE(command.firstIndex + command.count, indices.size());
+        EXPECT_EQ(command.instanceCount, 1u);
+        EXPECT_EQ(command.baseInstance, 7u);
+        std::fill(covered.begin() + command.firstIndex / 3, covered.begin() + (command.firstIndex + command.count) / 3, 1);
+        total += command.count / 3;
+    }
+    EXPECT_EQ(total, drawn);
+    // neighbouring visible meshlets share a command
+    EXPECT_LT(commands.size(), drawn / Meshlets::MAX_TRIANGLES);
+    for (size_t t = 0; t < covered.size(); t++)
+    {
+        if (facesCamera(mesh, &indices[3 * t], camera))
+        {
+            EXPECT_TRUE(covered[t]) << t;
+        }
+    }
+}
@@ -0,0 +1,88 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "Model.h"
+#include "WindowManager.h"
+
+namespace
+{
+    struct Chunk
+    {
+        size_t first;
+        GLsizei count;
+        GLintptr modelOffset;
+        GLintptr normalOffset;
+    };
+
+    std::vector<Chunk> stream(StreamBuffer &buffer, size_t count, size_t &written)
+    {
+        std::vector<glm::mat4> models(count);
+        std::vector<glm::mat3> normals(count);
+        for (size_t m = 0; m < count; m++)
+        {
+            models[m] = glm::translate(glm::mat4(1.0f), glm::vec3((float) m, 0.0f, 0.0f));
+        }
+        std::vector<Chunk> chunks;
+        written = streamInstances(buffer, models.data(), normals.data(), count,
+                                  [&](size_t first, GLsizei chunkCount, GLintptr modelOffset, GLintptr normalOffset)
+        {
+            chunks.push_back({first, chunkCount, modelOffset, normalOffset});
+        });
+        return chunks;
+    }
+}
+
+TEST(ModelInstances, NothingIsDrawnWhenAllocationsFail)
+{
+    // a stream that was never initialized has no room at all, like a full one
+    StreamBuffer buffer;
+    size_t written;
+    EXPECT_TRUE(stream(buffer, 100, written).empty());
+    EXPECT_EQ(written, 0u);
+}
+
+TEST(ModelInstances, LargeSetsAreSplitToFitTheRegion)
+{
+    WindowSettings settings;
+    settings.backend = WindowBackend::EGL_HEADLESS;
+    settings.softwareRendering = true;
+    settings.width = settings.height = 16;
+    WindowManager window;
+    if (!window.init(settings, "test"))
+    {
+        GTEST_SKIP() << "no headless GL context";
+    }
+
+    // 24 instances fit a region, the second allocation takes the last one
+    const GLsizeiptr instanceBytes = sizeof(glm::mat4) + sizeof(glm::mat3);
+    StreamBuffer buffer;
+    ASSERT_TRUE(buffer.init(25 * instanceBytes, 1));
+    size_t written;
+    std::vector<Chunk> chunks = stream(buffer, 25, written);
+    EXPECT_EQ(written, 25u);
+    ASSERT_EQ(chunks.size(), 2u);
+    EXPECT_EQ(chunks[0].first, 0u);
+    EXPECT_EQ(chunks[0].count, 24);
+    EXPECT_EQ(chunks[1].first, 24u);
+    EXPECT_EQ(chunks[1].count, 1);
+
+    glm::mat4 model;
+    glBindBuffer(GL_COPY_READ_BUFFER, buffer.getBuffer());
+    glGetBufferSubData(GL_COPY_READ_BUFFER, chunks[1].modelOffset, sizeof(model), &model);
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    EXPECT_EQ(model[3].x, 24.0f);
+
+    // the region is full for the rest of the frame, the caller draws what is left itself
+    chunks = stream(buffer, 10, written);
+    EXPECT_TRUE(chunks.empty());
+    EXPECT_EQ(written, 0u);
+
+    buffer.beginFrame();
+    chunks = stream(buffer, 10, written);
+    EXPECT_EQ(written, 10u);
+    EXPECT_EQ(chunks.size(), 1u);
+
+    buffer.destroy();
+    window.shutdown();
+}
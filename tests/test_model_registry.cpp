@@ -0,0 +1,57 @@
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "ModelRegistry.h"
+
+namespace
+{
+    const std::string DATA_DIR = MY_GAMES_TEST_DATA_DIR;
+}
+
+// acquire needs a GL context for the buffers, the keys it shares assets under do not
+
+TEST(ModelRegistry, PathsToTheSameFileShareAKey)
+{
+    ModelImportOptions options;
+    std::string key = ModelRegistry::makeKey(DATA_DIR + "obj/two_boxes.obj", options);
+    EXPECT_EQ(ModelRegistry::makeKey(DATA_DIR + "obj/../obj/./two_boxes.obj", options), key);
+    EXPECT_EQ(ModelRegistry::makeKey(DATA_DIR + "nested/../obj//two_boxes.obj", options), key);
+    EXPECT_NE(ModelRegistry::makeKey(DATA_DIR + "obj/two_boxes.mtl", options), key);
+}
+
+TEST(ModelRegistry, ImportOptionsArePartOfTheKey)
+{
+    const std::string path = DATA_DIR + "obj/two_boxes.obj";
+    ModelImportOptions options;
+    std::string plain = ModelRegistry::makeKey(path, options);
+
+    ModelImportOptions packed;
+    packed.packVertices = true;
+    std::string packedKey = ModelRegistry::makeKey(path, packed);
+    EXPECT_NE(packedKey, plain);
+    packed.packing.normals = VertexPacking::NormalEncoding::INT_2_10_10_10;
+    EXPECT_NE(ModelRegistry::makeKey(path, packed), packedKey);
+
+    ModelImportOptions lods;
+    lods.generateLods = true;
+    std::string lodKey = ModelRegistry::makeKey(path, lods);
+    EXPECT_NE(lodKey, plain);
+    lods.lods.maxError *= 2.0f;
+    EXPECT_NE(ModelRegistry::makeKey(path, lods), lodKey);
+
+    ModelImportOptions meshlets;
+    meshlets.meshlets = true;
+    EXPECT_NE(ModelRegistry::makeKey(path, meshlets), plain);
+
+    // settings of steps that are off do not split assets
+    ModelImportOptions unused;
+    unused.packing.positionTolerance = 1.0f;
+    unused.lods.lockBorders = false;
+    EXPECT_EQ(ModelRegistry::makeKey(path, unused), plain);
+}
+
+TEST(ModelRegistry, NothingLoadedWithoutModels)
+{
+    EXPECT_EQ(ModelRegistry::getLoadedCount(), 0u);
+}
@@ -0,0 +1,174 @@
+#include <gtest/gtest.h>
+
+#include <sstream>
+#include <string>
+
+#include "ObjParser.h"
+
+namespace
+{
+    bool parse(const std::string &text, ObjModel &model, unsigned threads = 1, size_t minChunkSize = 1 << 20)
+    {
+        ObjParser::Options options;
+        options.threads = threads;
+        options.minChunkSize = minChunkSize;
+        return ObjParser::parse(text.data(), text.size(), model, options);
+    }
+
+    // a grid of quads with positions, texcoords and normals, written with
+    // relative indices when asked to so chunks refer back to earlier chunks
+    std::string makeGrid(int size, bool relative)
+    {
+        std::ostringstream obj;
+        obj << "o grid\n";
+        for (int y = 0; y <= size; y++)
+        {
+            for (int x = 0; x <= size; x++)
+            {
+                obj << "v " << x * 0.5f << " " << y * 0.25f << " " << (x * y) % 7 << "\n";
+                obj << "vt " << x / (float) size << " " << y / (float) size << "\n";
+            }
+        }
+        obj << "vn 0 0 1\nvn 0 1 0\n";
+        const int vertices = (size + 1) * (size + 1);
+        for (int y = 0; y < size; y++)
+        {
+            for (int x = 0; x < size; x++)
+            {
+                int corners[4] = {y * (size + 1) + x + 1, y * (size + 1) + x + 2, (y + 1) * (size + 1) + x + 2, (y + 1) * (size + 1) + x + 1};
+                obj << "f";
+                for (int c : corners)
+                {
+                    int v = relative ? c - vertices - 1 : c;
+                    obj << " " << v << "/" << v << "/" << (x % 2 + 1);
+                }
+                obj << "\n";
+            }
+        }
+        return obj.str();
+    }
+
+    // every triangle corner as tinyobj resolves it
+    std::vector<Vertex> expandWithTinyobj(const std::string &text)
+    {
+        tinyobj::attrib_t attrib;
+        std::vector<tinyobj::shape_t> shapes;
+        std::vector<tinyobj::material_t> materials;
+        std::string warning, error;
+        std::istringstream stream(text);
+        EXPECT_TRUE(tinyobj::LoadObj(&attrib, &shapes, &materials, &warning, &error, &stream));
+
+        std::vector<Vertex> corners;
+        for (const tinyobj::shape_t &shape : shapes)
+        {
+            for (const tinyobj::index_t &index : shape.mesh.indices)
+            {
+                Vertex vertex;
+                vertex.Position = glm::vec3(attrib.vertices[3 * index.vertex_index], attrib.vertices[3 * index.vertex_index + 1], attrib.vertices[3 * index.vertex_index + 2]);
+                vertex.Normal = index.normal_index >= 0 ? glm::vec3(attrib.normals[3 * index.normal_index], attrib.normals[3 * index.normal_index + 1], attrib.normals[3 * index.normal_index + 2]) : glm::vec3(0.0f);
+                vertex.TexCoord = index.texcoord_index >= 0 ? glm::vec2(attrib.texcoords[2 * index.texcoord_index], attrib.texcoords[2 * index.texcoord_index + 1]) : glm::vec2(0.0f);
+                corners.push_back(vertex);
+            }
+        }
+        return corners;
+    }
+
+    std::vector<Vertex> expand(const ObjModel &model)
+    {
+        std::vector<Vertex> corners;
+        for (const ObjShape &shape : model.shapes)
+        {
+            for (uint32_t index : shape.indices)
+            {
+                corners.push_back(shape.vertices[index]);
+            }
+        }
+        return corners;
+    }
+
+    void expectSameVertices(const std::vector<Vertex> &actual, const std::vector<Vertex> &expected)
+    {
+        ASSERT_EQ(actual.size(), expected.size());
+        for (size_t i = 0; i < actual.size(); i++)
+        {
+            EXPECT_EQ(actual[i].Position, expected[i].Position) << "corner " << i;
+            EXPECT_EQ(actual[i].Normal, expected[i].Normal) << "corner " << i;
+            EXPECT_EQ(actual[i].TexCoord, expected[i].TexCoord) << "corner " << i;
+        }
+    }
+}
+
+TEST(ObjParser, SharedCornersAreStoredOnce)
+{
+    ObjModel model;
+    ASSERT_TRUE(parse("v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\r\nvt 0 0\nvt 1 1\n"
+                      "f 1/1 2/1 3/2 4/2\n", model));
+    ASSERT_EQ(model.shapes.size(), 1u);
+    const ObjShape &shape = model.shapes[0];
+    EXPECT_EQ(shape.vertices.size(), 4u);
+    // both diagonals are equally long, which tinyobj splits as (0, 1, 3) (1, 2, 3)
+    EXPECT_EQ(shape.indices, (std::vector<uint32_t>{0, 1, 2, 1, 3, 2}));
+    EXPECT_EQ(shape.material_ids, (std::vector<int>{-1, -1}));
+    EXPECT_EQ(shape.vertices[3].Position, glm::vec3(1.0f, 1.0f, 0.0f));
+    EXPECT_EQ(shape.vertices[3].TexCoord, glm::vec2(1.0f, 1.0f));
+    EXPECT_EQ(model.min, glm::vec3(0.0f));
+    EXPECT_EQ(model.max, glm::vec3(1.0f, 1.0f, 0.0f));
+}
+
+TEST(ObjParser, MatchesTinyobj)
+{
+    for (bool relative : {false, true})
+    {
+        std::string text = makeGrid(16, relative);
+        ObjModel model;
+        ASSERT_TRUE(parse(text, model));
+        expectSameVertices(expand(model), expandWithTinyobj(text));
+        // (17 * 17) positions, each with one of two normals depending on the quad
+        EXPECT_LT(model.shapes[0].vertices.size(), model.shapes[0].indices.size());
+    }
+}
+
+TEST(ObjParser, ChunkedParseIsDeterministic)
+{
+    for (bool relative : {false, true})
+    {
+        std::string text = makeGrid(64, relative);
+        ObjModel single, chunked;
+        ASSERT_TRUE(parse(text, single, 1));
+        // many small chunks, so relative indices cross chunk boundaries
+        ASSERT_TRUE(parse(text, chunked, 4, 1024));
+        ASSERT_EQ(single.shapes.size(), chunked.shapes.size());
+        EXPECT_EQ(single.shapes[0].indices, chunked.shapes[0].indices);
+        expectSameVertices(chunked.shapes[0].vertices, single.shapes[0].vertices);
+    }
+}
+
+TEST(ObjParser, LoadsObjectsAndMaterials)
+{
+    ObjModel model;
+    ASSERT_TRUE(ObjParser::load(std::string(MY_GAMES_TEST_DATA_DIR) + "obj/two_boxes.obj", model));
+
+    ASSERT_EQ(model.materials.size(), 2u);
+    EXPECT_EQ(model.materials[1].diffuse_texname, "green.png");
+
+    ASSERT_EQ(model.shapes.size(), 2u);
+    EXPECT_EQ(model.shapes[0].name, "first");
+    EXPECT_EQ(model.shapes[0].material_ids, (std::vector<int>{0, 0}));
+    EXPECT_EQ(model.shapes[1].name, "second");
+    EXPECT_EQ(model.shapes[1].material_ids, (std::vector<int>{1, 1, -1}));
+    EXPECT_EQ(model.shapes[1].vertices[0].Position, glm::vec3(0.0f, 0.0f, -2.0f));
+    // 5//1 has no texture coordinate, so it is a different vertex than 5/1/1
+    EXPECT_EQ(model.shapes[1].vertices.size(), 7u);
+    EXPECT_EQ(model.min, glm::vec3(0.0f, 0.0f, -2.0f));
+    EXPECT_EQ(model.max, glm::vec3(2.0f, 2.0f, 0.0f));
+}
+
+TEST(ObjParser, RejectsBrokenFiles)
+{
+    ObjModel model;
+    EXPECT_FALSE(parse("v 0 0 0\nf 1 2 3\n", model));
+    EXPECT_FALSE(parse("v 0 zero 0\n", model));
+    EXPECT_FALSE(parse("v 0 0 0\nf 1/x 1 1\n", model));
+    EXPECT_TRUE(parse("", model));
+    EXPECT_TRUE(model.shapes.empty());
+}
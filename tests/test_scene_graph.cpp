@@ -0,0 +1,82 @@
+#include <gtest/gtest.h>
+
+#include "SceneGraph.h"
+#include "glm/gtc/matrix_transform.hpp"
+
+namespace
+{
+    void expectNear(const glm::mat4 &a, const glm::mat4 &b)
+    {
+        for (int c = 0; c < 4; c++)
+        {
+            for (int r = 0; r < 4; r++)
+            {
+                EXPECT_NEAR(a[c][r], b[c][r], 1e-5f) << "column " << c << " row " << r;
+            }
+        }
+    }
+}
+
+TEST(SceneGraph, ComposeMatchesTranslateRotateScale)
+{
+    glm::vec3 translation(1.0f, -2.0f, 3.0f);
+    glm::vec3 axis = glm::normalize(glm::vec3(0.3f, 1.0f, -0.2f));
+    float angle = glm::radians(70.0f);
+    glm::vec3 scale(0.5f, 2.0f, 1.5f);
+
+    glm::mat4 expected = glm::translate(glm::mat4(1.0f), translation);
+    expected = glm::rotate(expected, angle, axis);
+    expected = glm::scale(expected, scale);
+
+    expectNear(SceneGraph::compose(translation, glm::angleAxis(angle, axis), scale), expected);
+}
+
+TEST(SceneGraph, WorldIsParentTimesLocal)
+{
+    SceneGraph graph;
+    SceneGraph::NodeId root = graph.addNode(SceneGraph::NONE, glm::vec3(0.0f, 1.0f, 0.0f),
+                                            glm::angleAxis(glm::radians(90.0f), glm::vec3(0.0f, 1.0f, 0.0f)));
+    SceneGraph::NodeId child = graph.addNode(root, glm::vec3(2.0f, 0.0f, 0.0f));
+    SceneGraph::NodeId grandChild = graph.addNode(child, glm::vec3(0.0f, 0.0f, 0.0f), glm::quat(1.0f, 0.0f, 0.0f, 0.0f), glm::vec3(3.0f));
+
+    EXPECT_EQ(graph.update(), 3u);
+
+    glm::vec4 origin = graph.getWorld(child) * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+    EXPECT_NEAR(origin.x, 0.0f, 1e-5f);
+    EXPECT_NEAR(origin.y, 1.0f, 1e-5f);
+    EXPECT_NEAR(origin.z, -2.0f, 1e-5f);
+    expectNear(graph.getWorld(grandChild), graph.getWorld(child) * glm::scale(glm::mat4(1.0f), glm::vec3(3.0f)));
+}
+
+TEST(SceneGraph, OnlyRecomputesDirtySubtrees)
+{
+    SceneGraph graph;
+    SceneGraph::NodeId a = graph.addNode();
+    SceneGraph::NodeId a1 = graph.addNode(a);
+    SceneGraph::NodeId b = graph.addNode();
+    SceneGraph::NodeId b1 = graph.addNode(b);
+    SceneGraph::NodeId b2 = graph.addNode(b1);
+    graph.update();
+
+    EXPECT_EQ(graph.update(), 0u);
+
+    graph.setTranslation(b1, glm::vec3(1.0f, 0.0f, 0.0f));
+    EXPECT_EQ(graph.update(), 2u);
+    EXPECT_FALSE(graph.wasUpdated(a));
+    EXPECT_FALSE(graph.wasUpdated(a1));
+    EXPECT_FALSE(graph.wasUpdated(b));
+    EXPECT_TRUE(graph.wasUpdated(b1));
+    EXPECT_TRUE(graph.wasUpdated(b2));
+    EXPECT_NEAR(graph.getWorld(b2)[3].x, 1.0f, 1e-6f);
+
+    graph.setScale(a, glm::vec3(2.0f));
+    graph.setTranslation(a1, glm::vec3(1.0f, 0.0f, 0.0f));
+    EXPECT_EQ(graph.update(), 2u);
+    EXPECT_NEAR(graph.getWorld(a1)[3].x, 2.0f, 1e-6f);
+
+    SceneGraph::NodeId nodes[] = {b2, a1};
+    glm::mat4 gathered[2];
+    graph.copyWorld(nodes, 2, gathered);
+    expectNear(gathered[0], graph.getWorld(b2));
+    expectNear(gathered[1], graph.getWorld(a1));
+}
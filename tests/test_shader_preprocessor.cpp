@@ -0,0 +1,143 @@
+#include <gtest/gtest.h>
+
+#include "ShaderPreprocessor.h"
+
+namespace
+{
+    const std::string DATA_DIR = MY_GAMES_TEST_DATA_DIR;
+    const std::string SHADER_DIR = MY_GAMES_SHADER_DIR;
+
+    int countOccurrences(const std::string &str, const std::string &pattern)
+    {
+        int count = 0;
+        for (size_t pos = str.find(pattern); pos != std::string::npos; pos = str.find(pattern, pos + 1))
+        {
+            count++;
+        }
+        return count;
+    }
+
+    // returns the 1 based line of source that contains pattern, 0 if there is none
+    size_t lineOf(const std::string &source, const std::string &pattern)
+    {
+        size_t pos = source.find(pattern);
+        if (pos == std::string::npos)
+        {
+            return 0;
+        }
+        return std::count(source.begin(), source.begin() + pos, '\n') + 1;
+    }
+}
+
+TEST(ShaderPreprocessor, EvaluatesConstantExpressions)
+{
+    std::map<std::string, long long> constants = {{"N", 3}};
+    long long value = 0;
+
+    EXPECT_TRUE(ShaderPreprocessor::evaluate("1 + 2 * 3", constants, value));
+    EXPECT_EQ(value, 7);
+    EXPECT_TRUE(ShaderPreprocessor::evaluate("(1 << 4) | 1", constants, value));
+    EXPECT_EQ(value, 17);
+    EXPECT_TRUE(ShaderPreprocessor::evaluate("-(N * 2) + 0x10", constants, value));
+    EXPECT_EQ(value, 10);
+    EXPECT_TRUE(ShaderPreprocessor::evaluate("N > 2 && !0", constants, value));
+    EXPECT_EQ(value, 1);
+}
+
+TEST(ShaderPreprocessor, RejectsNonConstantExpressions)
+{
+    std::map<std::string, long long> constants;
+    long long value = 0;
+
+    EXPECT_FALSE(ShaderPreprocessor::evaluate("1.5", constants, value));
+    EXPECT_FALSE(ShaderPreprocessor::evaluate("1 / 0", constants, value));
+    EXPECT_FALSE(ShaderPreprocessor::evaluate("UNKNOWN + 1", constants, value));
+    EXPECT_FALSE(ShaderPreprocessor::evaluate("vec3(1)", constants, value));
+    EXPECT_FALSE(ShaderPreprocessor::evaluate("(1 + 2", constants, value));
+}
+
+TEST(ShaderPreprocessor, ResolvesIncludesOnce)
+{
+    ShaderPreprocessor preprocessor;
+    PreprocessedShader shader = preprocessor.process(DATA_DIR + "main.fs");
+
+    ASSERT_TRUE(shader.ok);
+    EXPECT_EQ(shader.files.size(), 3u);
+    EXPECT_EQ(countOccurrences(shader.source, "vec3 shade()"), 1);
+    EXPECT_EQ(countOccurrences(shader.source, "#include"), 0);
+    EXPECT_EQ(countOccurrences(shader.source, "#pragma once"), 0);
+    EXPECT_NE(shader.source.find("float extra = 1.0;"), std::string::npos);
+    EXPECT_EQ(shader.lines.size(), (size_t) std::count(shader.source.begin(), shader.source.end(), '\n'));
+}
+
+TEST(ShaderPreprocessor, InjectsAndFoldsDefines)
+{
+    ShaderPreprocessor preprocessor;
+    PreprocessedShader shader = preprocessor.process(DATA_DIR + "main.fs", {{"NR_LIGHTS", "2 + 6"}, {"USE_SHADOWS", ""}});
+
+    ASSERT_TRUE(shader.ok);
+    EXPECT_EQ(shader.source.compare(0, 17, "#version 330 core"), 0);
+    EXPECT_EQ(lineOf(shader.source, "#define NR_LIGHTS 8"), 2u);
+    EXPECT_EQ(lineOf(shader.source, "#define USE_SHADOWS"), 3u);
+    // the first definition wins over the #ifndef fallback in common.glsl
+    EXPECT_NE(shader.source.find("#define DOUBLE_LIGHTS 16"), std::string::npos);
+}
+
+TEST(ShaderPreprocessor, MapsLogLinesBackToFiles)
+{
+    ShaderPreprocessor preprocessor;
+    PreprocessedShader shader = preprocessor.process(DATA_DIR + "main.fs");
+    ASSERT_TRUE(shader.ok);
+
+    size_t shadeLine = lineOf(shader.source, "return vec3(0.5);");
+    size_t mainLine = lineOf(shader.source, "FragColor = vec4");
+    ASSERT_NE(shadeLine, 0u);
+    ASSERT_NE(mainLine, 0u);
+
+    std::string log = "0:" + std::to_string(shadeLine) + "(5): error: something\n"
+                      "ERROR: 0:" + std::to_string(mainLine) + ": other\n"
+                      "0(" + std::to_string(mainLine) + ") : nvidia style\n";
+    std::string mapped = ShaderPreprocessor::mapLog(log, shader);
+
+    EXPECT_NE(mapped.find("common.glsl:8(5): error: something"), std::string::npos);
+    EXPECT_NE(mapped.find("ERROR: main.fs:11: other"), std::string::npos);
+    EXPECT_NE(mapped.find("main.fs(11) : nvidia style"), std::string::npos);
+}
+
+TEST(ShaderPreprocessor, ReportsMissingFiles)
+{
+    ShaderPreprocessor preprocessor;
+    PreprocessedShader shader = preprocessor.process(DATA_DIR + "does_not_exist.fs");
+    EXPECT_FALSE(shader.ok);
+}
+
+TEST(ShaderPreprocessor, ProcessesGameShaders)
+{
+    for (const char *name : {"simpleFragment.fs", "chameleonShader.fs", "simpleVertex.vs"})
+    {
+        ShaderPreprocessor preprocessor;
+        PreprocessedShader shader = preprocessor.process(SHADER_DIR + name);
+        EXPECT_TRUE(shader.ok) << name;
+        EXPECT_EQ(shader.source.compare(0, 8, "#version"), 0) << name;
+    }
+}
+
+TEST(ShaderPreprocessor, DoesNotFoldConditionalDefines)
+{
+    ShaderPreprocessor preprocessor;
+    PreprocessedShader shader = preprocessor.process(DATA_DIR + "conditional.fs");
+    ASSERT_TRUE(shader.ok);
+
+    // the branches keep their own values, which of them is active is left to the compiler
+    EXPECT_NE(shader.source.find("#define N 8"), std::string::npos);
+    EXPECT_NE(shader.source.find("#define N 4"), std::string::npos);
+    EXPECT_NE(shader.source.find("#define M (N * 2)"), std::string::npos);
+    // neither is a redefinition after #undef
+    EXPECT_NE(shader.source.find("#define L (K + 1)"), std::string::npos);
+
+    // a permutation define does take the #ifdef branch, still without folding it
+    shader = preprocessor.process(DATA_DIR + "conditional.fs", {{"HIGH", ""}});
+    ASSERT_TRUE(shader.ok);
+    EXPECT_NE(shader.source.find("#define M (N * 2)"), std::string::npos);
+    EXPECT_EQ(shader.source.find("#define M 16"), std::string::npos);
+}
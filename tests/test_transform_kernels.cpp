@@ -0,0 +1,181 @@
+#include <gtest/gtest.h>
+
+#include <random>
+#include <vector>
+
+#include "TransformKernels.h"
+#include "glm/gtc/matrix_transform.hpp"
+
+namespace
+{
+    std::vector<glm::mat4> randomTransforms(size_t count, bool uniformScale)
+    {
+        std::mt19937 rng(1234);
+        std::uniform_real_distribution<float> position(-10.0f, 10.0f);
+        std::uniform_real_distribution<float> angle(-3.0f, 3.0f);
+        std::uniform_real_distribution<float> scale(0.2f, 4.0f);
+
+        std::vector<glm::mat4> transforms(count);
+        for (glm::mat4 &transform : transforms)
+        {
+            glm::vec3 axis = glm::normalize(glm::vec3(position(rng), position(rng), position(rng)) + glm::vec3(0.01f));
+            float s = scale(rng);
+            glm::vec3 scales = uniformScale ? glm::vec3(s) : glm::vec3(s, scale(rng), scale(rng));
+
+            transform = glm::translate(glm::mat4(1.0f), glm::vec3(position(rng), position(rng), position(rng)));
+            transform = glm::rotate(transform, angle(rng), axis);
+            transform = glm::scale(transform, scales);
+        }
+        return transforms;
+    }
+
+    void expectNear(const glm::mat3 &actual, const glm::mat3 &expected, size_t index)
+    {
+        for (int c = 0; c < 3; c++)
+        {
+            for (int r = 0; r < 3; r++)
+            {
+                float tolerance = 1e-4f * std::max(1.0f, std::abs(expected[c][r]));
+                EXPECT_NEAR(actual[c][r], expected[c][r], tolerance) << "matrix " << index << " [" << c << "][" << r << "]";
+            }
+        }
+    }
+}
+
+TEST(TransformKernels, NormalMatricesMatchInverseTranspose)
+{
+    // counts around the SIMD width exercise the remainder handling
+    for (size_t count : {0, 1, 3, 4, 5, 8, 13, 64})
+    {
+        std::vector<glm::mat4> models = randomTransforms(count, false);
+        std::vector<glm::mat3> normals(count);
+        TransformKernels::normalMatrices(models.data(), normals.data(), count);
+
+        for (size_t i = 0; i < count; i++)
+        {
+            expectNear(normals[i], glm::transpose(glm::inverse(glm::mat3(models[i]))), i);
+        }
+    }
+}
+
+namespace
+{
+    void expectNear(const glm::mat4 &actual, const glm::mat4 &expected, size_t index)
+    {
+        for (int c = 0; c < 4; c++)
+        {
+            for (int r = 0; r < 4; r++)
+            {
+                float tolerance = 1e-4f * std::max(1.0f, std::abs(expected[c][r]));
+                EXPECT_NEAR(actual[c][r], expected[c][r], tolerance) << "matrix " << index << " [" << c << "][" << r << "]";
+            }
+        }
+    }
+
+    // runs a test body once per instruction set this machine supports
+    template<typename Body>
+    void forEachIsa(Body body)
+    {
+        TransformKernels::Isa original = TransformKernels::getIsa();
+        for (TransformKernels::Isa isa : {TransformKernels::Isa::SCALAR, TransformKernels::Isa::SSE, TransformKernels::Isa::AVX2})
+        {
+            if (!TransformKernels::setIsa(isa))
+            {
+                continue;
+            }
+            SCOPED_TRACE(TransformKernels::getIsaName(isa));
+            body();
+        }
+        TransformKernels::setIsa(original);
+    }
+
+    const size_t kernelCounts[] = {0, 1, 3, 4, 5, 7, 8, 9, 13, 64};
+}
+
+TEST(TransformKernels, ScalarIsAlwaysSupported)
+{
+    EXPECT_TRUE(TransformKernels::isSupported(TransformKernels::Isa::SCALAR));
+    EXPECT_TRUE(TransformKernels::isSupported(TransformKernels::getIsa()));
+}
+
+TEST(TransformKernels, MultiplyMatchesGlm)
+{
+    forEachIsa([]
+    {
+        for (size_t count : kernelCounts)
+        {
+            std::vector<glm::mat4> a = randomTransforms(count, false);
+            std::vector<glm::mat4> b = randomTransforms(count + 1, false);
+            b.erase(b.begin());
+            std::vector<glm::mat4> out(count);
+            TransformKernels::multiply(a.data(), b.data(), out.data(), count);
+            for (size_t i = 0; i < count; i++)
+            {
+                expectNear(out[i], a[i] * b[i], i);
+            }
+
+            glm::mat4 parent = randomTransforms(1, false)[0];
+            TransformKernels::multiply(parent, b.data(), out.data(), count);
+            for (size_t i = 0; i < count; i++)
+            {
+                expectNear(out[i], parent * b[i], i);
+            }
+
+            TransformKernels::multiply(a.data(), parent, out.data(), count);
+            for (size_t i = 0; i < count; i++)
+            {
+                expectNear(out[i], a[i] * parent, i);
+            }
+        }
+    });
+}
+
+TEST(TransformKernels, MultiplyInPlace)
+{
+    forEachIsa([]
+    {
+        const size_t count = 13;
+        std::vector<glm::mat4> a = randomTransforms(count, false);
+        std::vector<glm::mat4> b = randomTransforms(count + 1, true);
+        b.erase(b.begin());
+        std::vector<glm::mat4> expected(count);
+        for (size_t i = 0; i < count; i++)
+        {
+            expected[i] = a[i] * b[i];
+        }
+
+        TransformKernels::multiply(a.data(), b.data(), b.data(), count);
+        for (size_t i = 0; i < count; i++)
+        {
+            expectNear(b[i], expected[i], i);
+        }
+    });
+}
+
+TEST(TransformKernels, ComposeMatchesGlm)
+{
+    forEachIsa([]
+    {
+        for (size_t count : kernelCounts)
+        {
+            std::mt19937 rng((unsigned) count);
+            std::uniform_real_distribution<float> value(-2.0f, 2.0f);
+            std::vector<glm::vec3> translations(count), scales(count);
+            std::vector<glm::quat> rotations(count);
+            for (size_t i = 0; i < count; i++)
+            {
+                translations[i] = glm::vec3(value(rng), value(rng), value(rng)) * 5.0f;
+                rotations[i] = glm::angleAxis(value(rng), glm::normalize(glm::vec3(value(rng), value(rng), value(rng)) + glm::vec3(0.01f)));
+                scales[i] = glm::abs(glm::vec3(value(rng), value(rng), value(rng))) + glm::vec3(0.1f);
+            }
+
+            std::vector<glm::mat4> out(count);
+            TransformKernels::composeTRS(translations.data(), rotations.data(), scales.data(), out.data(), count);
+            for (size_t i = 0; i < count; i++)
+            {
+                glm::mat4 expected = glm::translate(glm::mat4(1.0f), translations[i]) * glm::mat4_cast(rotations[i]) * glm::scale(glm::mat4(1.0f), scales[i]);
+                expectNear(out[i], expected, i);
+            }
+        }
+    });
+}
@@ -0,0 +1,160 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "VertexPacking.h"
+
+namespace
+{
+    std::vector<Vertex> randomVertices(size_t count)
+    {
+        std::mt19937 rng(1234);
+        std::uniform_real_distribution<float> position(-3.0f, 5.0f);
+        std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+        std::uniform_real_distribution<float> texCoord(0.0f, 1.0f);
+
+        std::vector<Vertex> vertices(count);
+        for (Vertex &vertex : vertices)
+        {
+            vertex.Position = glm::vec3(position(rng), position(rng), 0.1f * position(rng));
+            vertex.Normal = glm::normalize(glm::vec3(unit(rng), unit(rng), unit(rng)) + glm::vec3(0.001f));
+            vertex.TexCoord = glm::vec2(texCoord(rng), texCoord(rng));
+        }
+        return vertices;
+    }
+
+    float angle(glm::vec3 a, glm::vec3 b)
+    {
+        return glm::degrees(std::atan2(glm::length(glm::cross(a, b)), glm::dot(a, b)));
+    }
+
+    // what the vertex shader sees for a packed position
+    glm::vec3 decodePosition(const VertexPacking::PackedVertices &packed, size_t index)
+    {
+        const unsigned char *vertex = packed.data.data() + index * packed.stride + packed.attributes[0].offset;
+        if (packed.attributes[0].type == GL_FLOAT)
+        {
+            glm::vec3 position;
+            std::memcpy(&position, vertex, sizeof(position));
+            return position;
+        }
+        uint16_t q[3];
+        std::memcpy(q, vertex, sizeof(q));
+        return packed.positionOffset + packed.positionScale * glm::vec3(q[0], q[1], q[2]) / 65535.0f;
+    }
+}
+
+TEST(VertexPacking, NormalEncodingsRoundTrip)
+{
+    std::vector<glm::vec3> normals;
+    for (const Vertex &vertex : randomVertices(1000))
+    {
+        normals.push_back(vertex.Normal);
+    }
+    // the axes and the octahedron's folded edges
+    for (glm::vec3 axis : {glm::vec3(1, 0, 0), glm::vec3(-1, 0, 0), glm::vec3(0, 1, 0), glm::vec3(0, -1, 0),
+                           glm::vec3(0, 0, 1), glm::vec3(0, 0, -1), glm::vec3(1, 1, 0), glm::vec3(-1, 0, -1)})
+    {
+        normals.push_back(glm::normalize(axis));
+    }
+
+    for (glm::vec3 n : normals)
+    {
+        EXPECT_LT(angle(n, VertexPacking::decodeOctahedral(VertexPacking::encodeOctahedral(n))), 0.01f);
+        EXPECT_LT(angle(n, VertexPacking::decodeInt2101010(VertexPacking::encodeInt2101010(n))), 0.2f);
+    }
+    EXPECT_EQ(VertexPacking::decodeOctahedral(VertexPacking::encodeOctahedral(glm::vec3(0, 0, -1))), glm::vec3(0, 0, -1));
+}
+
+TEST(VertexPacking, PacksToSixteenBytesWithinTolerance)
+{
+    std::vector<Vertex> vertices = randomVertices(5000);
+    VertexPacking::Options options;
+    VertexPacking::PackedVertices packed;
+    VertexPacking::pack(vertices, options, packed);
+
+    EXPECT_EQ(packed.stride, 16);
+    EXPECT_EQ(packed.data.size(), vertices.size() * 16);
+    EXPECT_EQ(packed.attributes[0].type, (GLenum) GL_UNSIGNED_SHORT);
+    EXPECT_EQ(packed.attributes[1].type, (GLenum) GL_SHORT);
+    EXPECT_EQ(packed.attributes[2].type, (GLenum) GL_HALF_FLOAT);
+    EXPECT_TRUE(packed.octahedralNormals);
+    EXPECT_LE(packed.positionError, options.positionTolerance);
+    EXPECT_LE(packed.normalError, options.normalTolerance);
+    EXPECT_LE(packed.texCoordError, options.texCoordTolerance);
+
+    // positions decode to within the measured error of the largest extent (8)
+    for (size_t i = 0; i < vertices.size(); i++)
+    {
+        glm::vec3 position = decodePosition(packed, i);
+        for (int c = 0; c < 3; c++)
+        {
+            EXPECT_NEAR(position[c], vertices[i].Position[c], 8.0f * packed.positionError + 1e-6f) << i;
+        }
+    }
+
+    options.normals = VertexPacking::NormalEncoding::INT_2_10_10_10;
+    VertexPacking::pack(vertices, options, packed);
+    EXPECT_EQ(packed.stride, 16);
+    EXPECT_EQ(packed.attributes[1].type, (GLenum) GL_INT_2_10_10_10_REV);
+    EXPECT_FALSE(packed.octahedralNormals);
+    EXPECT_LE(packed.normalError, options.normalTolerance);
+}
+
+TEST(VertexPacking, AttributesOverToleranceStayFloats)
+{
+    std::vector<Vertex> vertices = randomVertices(100);
+    // tiled texture coordinates lose too much as half floats
+    vertices[7].TexCoord = glm::vec2(100.3f, 0.5f);
+
+    VertexPacking::Options options;
+    options.positionTolerance = 0.0f;
+    VertexPacking::PackedVertices packed;
+    VertexPacking::pack(vertices, options, packed);
+
+    EXPECT_EQ(packed.attributes[0].type, (GLenum) GL_FLOAT);
+    EXPECT_EQ(packed.attributes[1].type, (GLenum) GL_SHORT);
+    EXPECT_EQ(packed.attributes[2].type, (GLenum) GL_FLOAT);
+    EXPECT_EQ(packed.stride, 12 + 4 + 8);
+    EXPECT_GT(packed.texCoordError, options.texCoordTolerance);
+    // float positions decode with the identity
+    EXPECT_EQ(packed.positionScale, glm::vec3(1.0f));
+    EXPECT_EQ(packed.positionOffset, glm::vec3(0.0f));
+    for (size_t i = 0; i < vertices.size(); i++)
+    {
+        EXPECT_EQ(decodePosition(packed, i), vertices[i].Position);
+    }
+
+    glm::vec2 texCoord;
+    std::memcpy(&texCoord, packed.data.data() + 7 * packed.stride + packed.attributes[2].offset, sizeof(texCoord));
+    EXPECT_EQ(texCoord, vertices[7].TexCoord);
+}
+
+TEST(VertexPacking, FlatMeshesPackExactly)
+{
+    // a quad in the z = 2 plane, and no normals like an OBJ without vn
+    std::vector<Vertex> vertices(4);
+    vertices[0].Position = glm::vec3(0, 0, 2);
+    vertices[1].Position = glm::vec3(1, 0, 2);
+    vertices[2].Position = glm::vec3(1, 1, 2);
+    vertices[3].Position = glm::vec3(0, 1, 2);
+    for (Vertex &vertex : vertices)
+    {
+        vertex.Normal = glm::vec3(0.0f);
+    }
+
+    VertexPacking::PackedVertices packed;
+    VertexPacking::pack(vertices, VertexPacking::Options(), packed);
+    EXPECT_EQ(packed.stride, 16);
+    EXPECT_EQ(packed.positionError, 0.0f);
+    EXPECT_EQ(packed.normalError, 0.0f);
+    for (size_t i = 0; i < vertices.size(); i++)
+    {
+        EXPECT_EQ(decodePosition(packed, i), vertices[i].Position);
+    }
+
+    VertexPacking::pack(std::vector<Vertex>(), VertexPacking::Options(), packed);
+    EXPECT_TRUE(packed.data.empty());
+}